@@ -7,6 +7,7 @@
  * - Allocate ARAM space
  * - DMA data to/from ARAM
  * - Use ARQ for queued operations
+ * - Use an ARAM heap for blocks freed in any order
  */
 
 #include <dolphin/os.h>
@@ -14,6 +15,28 @@
 #include <stdio.h>
 #include <string.h>
 
+static volatile BOOL s_requestDone = FALSE;
+
+static void RequestCallback(ARQRequest* request) {
+    (void)request;
+    s_requestDone = TRUE;  // Runs on the ARQ dispatcher thread
+}
+
+// Sound bank table updated by heap compaction
+static u32 s_bankAddr[4];
+
+static BOOL RelocateBank(u32 oldAddr, u32 newAddr, u32 size, void* context) {
+    (void)size;
+    (void)context;
+    for (int i = 0; i < 4; i++) {
+        if (s_bankAddr[i] == oldAddr) {
+            s_bankAddr[i] = newAddr;
+            return TRUE;
+        }
+    }
+    return FALSE;  // Not ours; leave it where it is
+}
+
 int main(void) {
     u32 aramBase;
     u32 aramAddr;
@@ -47,7 +70,7 @@ int main(void) {
     
     // Test DMA to ARAM
     OSReport("\n[Test 3] DMA to ARAM...\n");
-    char testData[128];
+    ATTRIBUTE_ALIGN(32) char testData[128];
     strcpy(testData, "Hello from main RAM! This will be copied to ARAM via DMA.");
     
     OSReport("  Source data: '%s'\n", testData);
@@ -60,7 +83,7 @@ int main(void) {
     
     // Test DMA from ARAM
     OSReport("\n[Test 4] DMA from ARAM...\n");
-    char readBuffer[128];
+    ATTRIBUTE_ALIGN(32) char readBuffer[128];
     memset(readBuffer, 0, sizeof(readBuffer));
     
     OSReport("  Starting DMA: ARAM -> MRAM\n");
@@ -82,19 +105,30 @@ int main(void) {
     
     // Post a queued request
     ARQRequest request;
-    char queueData[64];
+    ATTRIBUTE_ALIGN(32) char queueData[64];
     strcpy(queueData, "Queued DMA transfer test");
     
     u32 aramAddr2 = ARAlloc(64);
     OSReport("  Allocated another ARAM block at: 0x%08X\n", aramAddr2);
     
     OSReport("  Posting ARQ request...\n");
-    ARQPostRequest(&request, 1, AR_MRAM_TO_ARAM, 0,
-                   (u32)queueData, aramAddr2, 64, NULL);
+    ARQPostRequest(&request, 1, AR_MRAM_TO_ARAM, ARQ_PRIORITY_HIGH,
+                   (u32)queueData, aramAddr2, 64, RequestCallback);
+    
+    // The copy runs on the ARQ DMA engine; wait for the callback
+    while (!s_requestDone) {
+        OSSleepTicks(OSMicrosecondsToTicks(100));
+    }
     OSReport("  ARQ request completed\n");
     
+    ARQStats stats;
+    ARQGetStats(&stats);
+    OSReport("  Engine: %u request(s), %llu bytes in %u chunk(s)\n",
+             stats.requestsCompleted, (unsigned long long)stats.bytesTransferred,
+             stats.chunks);
+    
     // Verify queued transfer
-    char verifyBuffer[64];
+    ATTRIBUTE_ALIGN(32) char verifyBuffer[64];
     memset(verifyBuffer, 0, sizeof(verifyBuffer));
     ARStartDMA(AR_ARAM_TO_MRAM, (u32)verifyBuffer, aramAddr2, 64);
     OSReport("  Verified: '%s'\n", verifyBuffer);
@@ -114,6 +148,28 @@ int main(void) {
     OSReport("  Allocation 2 (1MB):   0x%08X\n", addr2);
     OSReport("  Allocation 3 (2MB):   0x%08X\n", addr3);
     
+    // ARAM heap: free in any order, compact when fragmented
+    OSReport("\n[Test 8] ARAM heap...\n");
+    ARHeapHandle heap = ARCreateHeap(addr3, addr3 + 2048 * 1024);
+    for (int i = 0; i < 4; i++) {
+        s_bankAddr[i] = ARAllocFromHeap(heap, 256 * 1024);
+        OSReport("  Bank %d: 0x%08X\n", i, s_bankAddr[i]);
+    }
+    
+    ARFreeToHeap(heap, s_bankAddr[0]);
+    ARFreeToHeap(heap, s_bankAddr[2]);
+    s_bankAddr[0] = s_bankAddr[2] = 0;
+    
+    ARHeapStats heapStats;
+    ARGetHeapStats(heap, &heapStats);
+    OSReport("  After freeing banks 0 and 2: %u KB free, largest block %u KB\n",
+             heapStats.freeBytes / 1024, heapStats.largestFreeBlock / 1024);
+    
+    u32 largest = ARCompactHeap(heap, RelocateBank, NULL);
+    OSReport("  After compaction: largest block %u KB (banks 1, 3 at 0x%08X, 0x%08X)\n",
+             largest / 1024, s_bankAddr[1], s_bankAddr[3]);
+    ARDestroyHeap(heap);
+    
     OSReport("\n==============================================\n");
     OSReport("ARAM test completed successfully!\n");
     OSReport("==============================================\n\n");
@@ -121,7 +177,8 @@ int main(void) {
     OSReport("Summary:\n");
     OSReport("- ARAM is simulated using regular heap memory\n");
     OSReport("- DMA transfers are instant memcpy operations\n");
-    OSReport("- ARQ queued transfers execute immediately on PC\n");
+    OSReport("- ARQ transfers run on a background DMA engine in chunks\n");
+    OSReport("- ARAM heaps allow freeing blocks in any order\n");
     OSReport("- Games can use ARAM for audio data storage\n");
     OSReport("- Total ARAM: 16MB (matching GameCube hardware)\n");
     
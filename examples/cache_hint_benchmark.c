@@ -0,0 +1,299 @@
+/**
+ * @file cache_hint_benchmark.c
+ * @brief Effect of the host primitives behind DCTouchRange/DCZeroRange
+ *
+ * Each workload runs with the detected primitives and again with them
+ * turned off (OSSetCachePrimitives(0)), which is how the DC* calls behaved
+ * before they mapped onto host instructions:
+ *
+ *   touch   Walk 256 MB (more than most last-level caches) in shuffled
+ *           chunks of 256 bytes (records, display list packets) and
+ *           4 KB (asset blocks), touching the next chunk while the
+ *           current one is summed
+ *   zero    Per frame, clear a large buffer with DCZeroRange and then
+ *           work on a 256 KB working set; the time on the working set
+ *           shows whether the clear evicted it
+ *   store   DCStoreRange over 1 MB of shared MEM2 with a peer process
+ *           attached (POSIX), i.e. the cost of the line writeback
+ *
+ * Usage:  cache_hint_benchmark        (starts its own "peer" process)
+ */
+
+#include <dolphin/os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define STREAM_BYTES    (256 * 1024 * 1024)
+#define MIN_CHUNK_BYTES 256
+#define MAX_CHUNKS      (STREAM_BYTES / MIN_CHUNK_BYTES)
+#define WORK_BYTES      (256 * 1024)
+#define FRAMES          64
+#define SHARED_NAME     "porpoise_cache_bench"
+#define STORE_BYTES     (1024 * 1024)
+
+static u8* s_streamAlloc;
+static u8* s_stream;                // 32-byte aligned, as DCZeroRange needs
+static u32* s_order;
+static u8* s_work;
+
+static double Milliseconds(OSTime ticks) {
+    return (double)OSTicksToMicroseconds(ticks) / 1000.0;
+}
+
+static const char* PrimitiveNames(u32 prim, char* buf, size_t size) {
+    static const struct { u32 bit; const char* name; } names[] = {
+        { OS_CACHE_PRIM_PREFETCH,    "prefetch" },
+        { OS_CACHE_PRIM_STREAM_ZERO, "stream-zero" },
+        { OS_CACHE_PRIM_DC_ZVA,      "dc-zva" },
+        { OS_CACHE_PRIM_CLFLUSH,     "clflush" },
+        { OS_CACHE_PRIM_CLFLUSHOPT,  "clflushopt" },
+        { OS_CACHE_PRIM_CLWB,        "clwb" },
+        { OS_CACHE_PRIM_DC_CVAC,     "dc-cvac" },
+    };
+    
+    buf[0] = '\0';
+    for (u32 i = 0; i < ARRAY_LENGTH(names); i++) {
+        if (prim & names[i].bit) {
+            size_t len = strlen(buf);
+            snprintf(buf + len, size - len, "%s%s", len ? " " : "", names[i].name);
+        }
+    }
+    return buf[0] ? buf : "none";
+}
+
+/*---------------------------------------------------------------------------*
+    touch
+ *---------------------------------------------------------------------------*/
+
+/* Same shuffled order for every run; defeats the hardware prefetcher
+   across chunks, as real chunk lists do */
+static void Shuffle(u32 numChunks) {
+    u32 seed = 12345;
+    
+    for (u32 i = 0; i < numChunks; i++) {
+        s_order[i] = i;
+    }
+    for (u32 i = numChunks - 1; i > 0; i--) {
+        seed = seed * 1664525 + 1013904223;
+        u32 j = seed % (i + 1);
+        u32 t = s_order[i];
+        s_order[i] = s_order[j];
+        s_order[j] = t;
+    }
+}
+
+static u64 SumChunk(const u8* p, u32 chunkBytes) {
+    const u64* q = (const u64*)p;
+    u64 sum = 0;
+    
+    for (u32 i = 0; i < chunkBytes / 8; i++) {
+        sum += q[i] ^ (sum >> 7);
+    }
+    return sum;
+}
+
+static double RunTouch(u32 chunkBytes, u64* result) {
+    u32 numChunks = STREAM_BYTES / chunkBytes;
+    u64 sum = 0;
+    
+    Shuffle(numChunks);
+    OSTime start = OSGetTime();
+    for (u32 i = 0; i < numChunks; i++) {
+        if (i + 1 < numChunks) {
+            DCTouchRange(s_stream + (size_t)s_order[i + 1] * chunkBytes, chunkBytes);
+        }
+        sum += SumChunk(s_stream + (size_t)s_order[i] * chunkBytes, chunkBytes);
+    }
+    
+    *result = sum;
+    return Milliseconds(OSGetTime() - start);
+}
+
+/*---------------------------------------------------------------------------*
+    zero
+ *---------------------------------------------------------------------------*/
+
+static u64 WorkPass(void) {
+    u64 sum = 0;
+    
+    for (u32 i = 0; i < WORK_BYTES; i += 64) {
+        s_work[i] += 1;
+        sum += s_work[i];
+    }
+    return sum;
+}
+
+/* Returns the whole frame time; *workMs gets the working-set part */
+static double RunZero(u32 clearBytes, double* workMs) {
+    OSTime work = 0;
+    OSTime start = OSGetTime();
+    
+    for (u32 f = 0; f < FRAMES; f++) {
+        DCZeroRange(s_stream, clearBytes);
+        
+        OSTime t = OSGetTime();
+        for (u32 pass = 0; pass < 4; pass++) {
+            WorkPass();
+        }
+        work += OSGetTime() - t;
+    }
+    
+    *workMs = Milliseconds(work) / FRAMES;
+    return Milliseconds(OSGetTime() - start) / FRAMES;
+}
+
+/*---------------------------------------------------------------------------*
+    store
+ *---------------------------------------------------------------------------*/
+
+#ifndef _WIN32
+/* Stand-in consumer process: attach and wait to be told to quit */
+static int RunPeer(void) {
+    OSSharedMessage msg;
+    
+    if (!OSAttachSharedMemory(SHARED_NAME)) {
+        return 1;
+    }
+    while (!OSReceiveSharedMessage(&msg)) {
+        OSSleepTicks(OSMillisecondsToTicks(1));
+    }
+    OSDetachSharedMemory();
+    return 0;
+}
+
+static void RunStore(u32 prim, const char* exe) {
+    char line[160];
+    
+    if (!OSCreateSharedMemory(SHARED_NAME, OS_SHARED_MEM2)) {
+        OSReport("store: shared memory unavailable, skipped\n");
+        return;
+    }
+    
+    pid_t peer = fork();
+    if (peer == 0) {
+        execl(exe, exe, "peer", (char*)NULL);
+        _exit(1);
+    }
+    for (int i = 0; i < 10000 && !OSIsSharedPeerAttached(); i++) {
+        OSSleepTicks(OSMillisecondsToTicks(1));
+    }
+    if (!OSIsSharedPeerAttached()) {
+        OSReport("store: no peer attached, skipped\n");
+        OSDetachSharedMemory();
+        return;
+    }
+    
+    u8* buf = (u8*)OSGetSharedRegion(OS_SHARED_MEM2, NULL);
+    for (u32 pass = 0; pass < 2; pass++) {
+        OSSetCachePrimitives(pass == 0 ? 0 : prim);
+        
+        OSTime start = OSGetTime();
+        for (u32 f = 0; f < FRAMES; f++) {
+            memset(buf, (int)f, STORE_BYTES);
+            DCStoreRange(buf, STORE_BYTES);
+        }
+        double ms = Milliseconds(OSGetTime() - start) / FRAMES;
+        
+        snprintf(line, sizeof(line), "store  %-10s %8.3f ms per 1 MB frame",
+                 pass == 0 ? "fence only" : "writeback", ms);
+        OSReport("%s\n", line);
+    }
+    OSSetCachePrimitives(prim);
+    
+    OSSharedMessage quit = { 0 };
+    OSSendSharedMessage(&quit);
+    waitpid(peer, NULL, 0);
+    OSDetachSharedMemory();
+}
+#endif
+
+int main(int argc, char** argv) {
+    static const u32 clears[] = { 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+    char line[160];
+    char names[128];
+    
+#ifndef _WIN32
+    if (argc > 1 && strcmp(argv[1], "peer") == 0) {
+        return RunPeer();
+    }
+#endif
+    (void)argc;
+    (void)argv;
+    
+    OSInit();
+    
+    s_streamAlloc = (u8*)malloc(STREAM_BYTES + 32);
+    s_stream = (u8*)(((uintptr_t)s_streamAlloc + 31) & ~(uintptr_t)31);
+    s_order = (u32*)malloc(MAX_CHUNKS * sizeof(u32));
+    s_work = (u8*)malloc(WORK_BYTES);
+    if (!s_streamAlloc || !s_order || !s_work) {
+        OSReport("Out of memory\n");
+        return 1;
+    }
+    for (u32 i = 0; i < STREAM_BYTES; i++) {
+        s_stream[i] = (u8)(i * 2654435761u >> 11);
+    }
+    memset(s_work, 1, WORK_BYTES);
+    
+    u32 prim = OSGetCachePrimitives();
+    OSReport("Host primitives: %s (line %u bytes, stream threshold %u KB)\n\n",
+             PrimitiveNames(prim, names, sizeof(names)), OSGetHostCacheLineSize(),
+             OSGetCopyStreamThreshold() / 1024);
+    
+    // touch: same sum either way
+    static const u32 chunks[] = { MIN_CHUNK_BYTES, 4096 };
+    for (u32 c = 0; c < ARRAY_LENGTH(chunks); c++) {
+        u64 sumOff, sumOn;
+        
+        OSSetCachePrimitives(0);
+        double touchOff = RunTouch(chunks[c], &sumOff);
+        OSSetCachePrimitives(prim);
+        double touchOn = RunTouch(chunks[c], &sumOn);
+        if (sumOff != sumOn) {
+            OSReport("MISMATCH: touch workload results differ\n");
+            return 1;
+        }
+        snprintf(line, sizeof(line), "touch  %4u-byte chunks: %8.2f ms without, %8.2f ms with (%.2fx)",
+                 chunks[c], touchOff, touchOn, touchOn > 0 ? touchOff / touchOn : 0.0);
+        OSReport("%s\n", line);
+    }
+    OSReport("\n");
+    
+    // zero: the clear must leave zeros either way
+    OSReport("%-6s %10s %12s %12s %12s %12s\n", "zero", "clear", "frame off", "frame on", "work off", "work on");
+    for (u32 c = 0; c < ARRAY_LENGTH(clears); c++) {
+        double workOff, workOn;
+        
+        OSSetCachePrimitives(0);
+        double frameOff = RunZero(clears[c], &workOff);
+        OSSetCachePrimitives(prim);
+        memset(s_stream, 0xA5, clears[c]);
+        double frameOn = RunZero(clears[c], &workOn);
+        
+        for (u32 i = 0; i < clears[c]; i++) {
+            if (s_stream[i] != 0) {
+                OSReport("MISMATCH: DCZeroRange left byte %u nonzero\n", i);
+                return 1;
+            }
+        }
+        snprintf(line, sizeof(line), "%-6s %8uKB %10.3fms %10.3fms %10.3fms %10.3fms",
+                 "", clears[c] / 1024, frameOff, frameOn, workOff, workOn);
+        OSReport("%s\n", line);
+    }
+    OSReport("\n");
+
+#ifndef _WIN32
+    RunStore(prim, argv[0]);
+#endif
+
+    free(s_work);
+    free(s_order);
+    free(s_streamAlloc);
+    return 0;
+}
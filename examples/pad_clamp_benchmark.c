@@ -0,0 +1,287 @@
+/**
+ * @file pad_clamp_benchmark.c
+ * @brief Batch PADClamp: equivalence with the scalar clamps and throughput
+ *
+ * Every clamp function is checked against a scalar reference (the
+ * per-stick code PADClamp.c used before the batch kernels) on every
+ * stick and trigger value pair, with errored statuses mixed in and
+ * counts that leave a scalar tail. Then a large array of recorded-like
+ * input is clamped with the reference loop and with the batch functions.
+ */
+
+#include <dolphin/os.h>
+#include <dolphin/pad.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALL_PAIRS       65536
+#define BENCH_COUNT     (64 * 1024)
+#define BENCH_TOTAL     (64u * 1024 * 1024)     // Statuses clamped per measurement
+
+/*---------------------------------------------------------------------------*
+    Scalar reference
+ *---------------------------------------------------------------------------*/
+
+typedef struct Region {
+    u8 minTrigger, maxTrigger;
+    s8 minStick, maxStick, xyStick;
+    s8 minSubstick, maxSubstick, xySubstick;
+    s8 radStick, radSubstick;
+} Region;
+
+static const Region s_region   = { 30, 180, 15, 72, 40, 15, 59, 31, 56, 44 };
+static const Region s_region2  = { 30, 180, 15, 72, 47, 15, 59, 37, 62, 50 };
+static const Region s_region2x = {  0, 180,  0, 87, 62,  0, 74, 52, 80, 68 };
+
+static void RefStick(s8* px, s8* py, s8 max, s8 xy, s8 min) {
+    int x = *px, y = *py;
+    int signX = 1, signY = 1;
+    int d;
+    
+    if (x < 0) { signX = -1; x = -x; }
+    if (y < 0) { signY = -1; y = -y; }
+    x = (x <= min) ? 0 : x - min;
+    y = (y <= min) ? 0 : y - min;
+    if (x == 0 && y == 0) {
+        *px = *py = 0;
+        return;
+    }
+    
+    d = (xy * y <= xy * x) ? xy * x + (max - xy) * y : xy * y + (max - xy) * x;
+    if (xy * max < d) {
+        x = (s8)(xy * max * x / d);
+        y = (s8)(xy * max * y / d);
+    }
+    *px = (s8)(signX * x);
+    *py = (s8)(signY * y);
+}
+
+static void RefCircle(s8* px, s8* py, s8 radius, s8 min) {
+    int x = *px, y = *py;
+    
+    if (-min < x && x < min) x = 0; else if (x > 0) x -= min; else x += min;
+    if (-min < y && y < min) y = 0; else if (y > 0) y -= min; else y += min;
+    
+    int squared = x * x + y * y;
+    if (radius * radius < squared) {
+        int length = (int)sqrtf((float)squared);
+        x = (x * radius) / length;
+        y = (y * radius) / length;
+    }
+    *px = (s8)x;
+    *py = (s8)y;
+}
+
+static void RefTrigger(u8* t, u8 min, u8 max) {
+    if (*t <= min) {
+        *t = 0;
+    } else {
+        if (*t > max) *t = max;
+        *t -= min;
+    }
+}
+
+enum { OCTA, CIRCLE, OCTA2, CIRCLE2, TRIGGER, NUM_FUNCS };
+
+static const char* s_funcNames[NUM_FUNCS] = {
+    "PADClamp", "PADClampCircle", "PADClamp2", "PADClampCircle2", "PADClampTrigger"
+};
+
+static void RefClamp(PADStatus* st, u32 count, u32 func, u32 type) {
+    const Region* r;
+    
+    switch (func) {
+        case OCTA2:   r = (type == PAD_STICK_CLAMP_OCTA_WITH_MARGIN) ? &s_region2 : &s_region2x; break;
+        case CIRCLE2: r = (type == PAD_STICK_CLAMP_CIRCLE_WITH_MARGIN) ? &s_region2 : &s_region2x; break;
+        case TRIGGER: r = (type == PAD_TRIGGER_FIXED_BASE) ? &s_region2 : &s_region2x; break;
+        default:      r = &s_region; break;
+    }
+    
+    for (u32 i = 0; i < count; i++, st++) {
+        if (st->err != PAD_ERR_NONE) {
+            continue;
+        }
+        if (func == OCTA || func == OCTA2) {
+            RefStick(&st->stickX, &st->stickY, r->maxStick, r->xyStick, r->minStick);
+            RefStick(&st->substickX, &st->substickY, r->maxSubstick, r->xySubstick, r->minSubstick);
+        } else if (func == CIRCLE || func == CIRCLE2) {
+            RefCircle(&st->stickX, &st->stickY, r->radStick, r->minStick);
+            RefCircle(&st->substickX, &st->substickY, r->radSubstick, r->minSubstick);
+        }
+        if (func == OCTA || func == CIRCLE || func == TRIGGER) {
+            RefTrigger(&st->triggerLeft, r->minTrigger, r->maxTrigger);
+            RefTrigger(&st->triggerRight, r->minTrigger, r->maxTrigger);
+        }
+    }
+}
+
+static void BatchClamp(PADStatus* st, u32 count, u32 func, u32 type) {
+    switch (func) {
+        case OCTA:    PADClampBatch(st, count); break;
+        case CIRCLE:  PADClampCircleBatch(st, count); break;
+        case OCTA2:   PADClamp2Batch(st, count, type); break;
+        case CIRCLE2: PADClampCircle2Batch(st, count, type); break;
+        default:      PADClampTriggerBatch(st, count, type); break;
+    }
+}
+
+/* The four-channel entry points, PAD_MAX_CONTROLLERS at a time */
+static void ChannelClamp(PADStatus* st, u32 count, u32 func, u32 type) {
+    for (u32 i = 0; i + PAD_MAX_CONTROLLERS <= count; i += PAD_MAX_CONTROLLERS) {
+        switch (func) {
+            case OCTA:    PADClamp(st + i); break;
+            case CIRCLE:  PADClampCircle(st + i); break;
+            case OCTA2:   PADClamp2(st + i, type); break;
+            case CIRCLE2: PADClampCircle2(st + i, type); break;
+            default:      PADClampTrigger(st + i, type); break;
+        }
+    }
+}
+
+/* Clamp types of a function (the first one for the fixed-region ones) */
+static u32 TypeOf(u32 func, u32 variant) {
+    switch (func) {
+        case OCTA2:   return variant ? PAD_STICK_CLAMP_OCTA_NO_MARGIN : PAD_STICK_CLAMP_OCTA_WITH_MARGIN;
+        case CIRCLE2: return variant ? PAD_STICK_CLAMP_CIRCLE_NO_MARGIN : PAD_STICK_CLAMP_CIRCLE_WITH_MARGIN;
+        case TRIGGER: return variant ? PAD_TRIGGER_OPEN_BASE : PAD_TRIGGER_FIXED_BASE;
+        default:      return 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+    Equivalence
+ *---------------------------------------------------------------------------*/
+
+/* Every stick pair on both sticks, every trigger pair; every errEvery'th
+   status has an error (0 = none) */
+static void FillAllPairs(PADStatus* st, u32 count, u32 errEvery) {
+    for (u32 i = 0; i < count; i++) {
+        u32 v = i % ALL_PAIRS;
+        memset(&st[i], 0, sizeof(PADStatus));
+        st[i].button = (u16)i;
+        st[i].stickX = (s8)(v & 0xFF);
+        st[i].stickY = (s8)(v >> 8);
+        st[i].substickX = (s8)(v >> 8);
+        st[i].substickY = (s8)(v & 0xFF);
+        st[i].triggerLeft = (u8)v;
+        st[i].triggerRight = (u8)(v >> 8);
+        st[i].analogA = (u8)(v * 7);
+        st[i].analogB = (u8)(v * 13);
+        st[i].err = (errEvery && i % errEvery == 0) ? PAD_ERR_NO_CONTROLLER : PAD_ERR_NONE;
+    }
+}
+
+static BOOL CheckEquivalence(PADStatus* input, PADStatus* ref, PADStatus* out) {
+    static const u32 counts[] = { 0, 1, 3, 4, 5, 7, ALL_PAIRS, ALL_PAIRS + 3 };
+    static const u32 errEvery[] = { 0, 3 };
+    
+    for (u32 func = 0; func < NUM_FUNCS; func++) {
+        for (u32 variant = 0; variant < 2; variant++) {
+            u32 type = TypeOf(func, variant);
+            
+            for (u32 e = 0; e < ARRAY_LENGTH(errEvery); e++) {
+                for (u32 c = 0; c < ARRAY_LENGTH(counts); c++) {
+                    u32 count = counts[c];
+                    
+                    FillAllPairs(input, count, errEvery[e]);
+                    memcpy(ref, input, count * sizeof(PADStatus));
+                    RefClamp(ref, count, func, type);
+                    
+                    memcpy(out, input, count * sizeof(PADStatus));
+                    BatchClamp(out, count, func, type);
+                    for (u32 i = 0; i < count; i++) {
+                        if (memcmp(&out[i], &ref[i], sizeof(PADStatus)) != 0) {
+                            OSReport("MISMATCH: %sBatch type %u, count %u, status %u "
+                                     "(sticks %d,%d %d,%d -> %d,%d %d,%d, expected %d,%d %d,%d)\n",
+                                     s_funcNames[func], type, count, i,
+                                     input[i].stickX, input[i].stickY, input[i].substickX, input[i].substickY,
+                                     out[i].stickX, out[i].stickY, out[i].substickX, out[i].substickY,
+                                     ref[i].stickX, ref[i].stickY, ref[i].substickX, ref[i].substickY);
+                            return FALSE;
+                        }
+                    }
+                    
+                    memcpy(out, input, count * sizeof(PADStatus));
+                    ChannelClamp(out, count, func, type);
+                    u32 whole = count - count % PAD_MAX_CONTROLLERS;
+                    if (memcmp(out, ref, whole * sizeof(PADStatus)) != 0) {
+                        OSReport("MISMATCH: %s type %u, count %u\n", s_funcNames[func], type, count);
+                        return FALSE;
+                    }
+                }
+            }
+        }
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+    Throughput
+ *---------------------------------------------------------------------------*/
+
+/* Sticks mostly near the gate, some resting inside the dead zone */
+static void FillRecorded(PADStatus* st, u32 count) {
+    srand(1234);
+    for (u32 i = 0; i < count; i++) {
+        memset(&st[i], 0, sizeof(PADStatus));
+        BOOL rest = (rand() % 4) == 0;
+        st[i].stickX = (s8)(rest ? rand() % 21 - 10 : rand() % 256 - 128);
+        st[i].stickY = (s8)(rest ? rand() % 21 - 10 : rand() % 256 - 128);
+        st[i].substickX = (s8)(rand() % 256 - 128);
+        st[i].substickY = (s8)(rand() % 256 - 128);
+        st[i].triggerLeft = (u8)rand();
+        st[i].triggerRight = (u8)rand();
+        st[i].err = (rand() % 64) ? PAD_ERR_NONE : PAD_ERR_NO_CONTROLLER;
+    }
+}
+
+typedef void (*ClampFunc)(PADStatus* st, u32 count, u32 func, u32 type);
+
+static double Measure(ClampFunc clamp, PADStatus* work, const PADStatus* input, u32 func) {
+    u32 rounds = BENCH_TOTAL / BENCH_COUNT;
+    OSTime elapsed = 0;
+    
+    for (u32 r = 0; r < rounds; r++) {
+        memcpy(work, input, BENCH_COUNT * sizeof(PADStatus));
+        OSTime start = OSGetTime();
+        clamp(work, BENCH_COUNT, func, TypeOf(func, 0));
+        elapsed += OSGetTime() - start;
+    }
+    
+    double seconds = (double)OSTicksToMicroseconds(elapsed) / 1e6;
+    return (double)BENCH_TOTAL / seconds / 1e6;
+}
+
+int main(void) {
+    OSInit();
+    
+    u32 size = (ALL_PAIRS + 3) * sizeof(PADStatus);
+    PADStatus* input = (PADStatus*)malloc(size);
+    PADStatus* ref = (PADStatus*)malloc(size);
+    PADStatus* out = (PADStatus*)malloc(size);
+    if (!input || !ref || !out) {
+        OSReport("Out of memory\n");
+        return 1;
+    }
+    
+    OSReport("Checking batch clamps against the scalar reference...\n");
+    if (!CheckEquivalence(input, ref, out)) {
+        return 1;
+    }
+    OSReport("All clamp functions bit-identical (every stick and trigger pair)\n\n");
+    
+    FillRecorded(input, BENCH_COUNT);
+    OSReport("%-18s %14s %14s %8s\n", "Function", "Scalar (M/s)", "Batch (M/s)", "Speedup");
+    for (u32 func = 0; func < NUM_FUNCS; func++) {
+        double scalar = Measure(RefClamp, out, input, func);
+        double batch = Measure(BatchClamp, out, input, func);
+        OSReport("%-18s %14.1f %14.1f %7.2fx\n", s_funcNames[func], scalar, batch, batch / scalar);
+    }
+    
+    free(input);
+    free(ref);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,218 @@
+/**
+ * @file savestate_benchmark.c
+ * @brief Cost of a savestate per frame, full copy vs incremental
+ *
+ * A stand-in game fills MEM1, MEM2 and ARAM, then each frame rewrites a
+ * number of scattered pages. With a snapshot taken every frame it reports:
+ *
+ *   full copy   memcpy of every region, what a naive savestate costs
+ *   take        time GeckoSavestateTake spends on the game thread
+ *   frame       frame time with and without a snapshot per frame
+ *   cow         pages the game had to copy itself (written before the
+ *               background copy reached them)
+ *
+ * Then it rewinds 1, 10 and 30 frames and checks the memory against
+ * checksums taken at those frames, and round-trips a savestate file.
+ *
+ * Requires PORPOISE_USE_GECKO_MEMORY=ON.
+ */
+
+#include <dolphin/os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef PORPOISE_USE_GECKO_MEMORY
+#include <dolphin/gecko_memory.h>
+
+#define FRAMES          120
+#define DEPTH           60
+#define FILL_BYTES      (8 * 1024 * 1024)   // Per region, before the first snapshot
+#define STATE_FILE      "savestate_benchmark.sav"
+
+static GeckoMemory s_memory;
+static u32 s_seed = 12345;
+
+static const u32 s_rewinds[] = { 1, 10, 30 };
+
+static u32 Random(void) {
+    s_seed = s_seed * 1664525 + 1013904223;
+    return s_seed >> 8;
+}
+
+static double Milliseconds(OSTime ticks) {
+    return (double)OSTicksToMicroseconds(ticks) / 1000.0;
+}
+
+/* Checksum of every region */
+static u64 HashMemory(void) {
+    const u8* regions[] = { s_memory.mem1, s_memory.mem2, s_memory.aram, s_memory.locked_cache };
+    const u32 sizes[] = { GECKO_MEM1_SIZE, GECKO_MEM2_SIZE, GECKO_ARAM_SIZE, GECKO_LOCKED_CACHE_SIZE };
+    u64 hash = 1469598103934665603ull;
+    
+    for (u32 r = 0; r < ARRAY_LENGTH(regions); r++) {
+        const u64* p = (const u64*)regions[r];
+        for (u32 i = 0; i < sizes[r] / 8; i++) {
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+/* One frame of the stand-in game: dirty 'pages' 4 KB pages of MEM1/MEM2 */
+static void RunFrame(u32 frame, u32 pages) {
+    for (u32 i = 0; i < pages; i++) {
+        u8* region = (i & 1) ? s_memory.mem2 : s_memory.mem1;
+        u32 size = (i & 1) ? GECKO_MEM2_SIZE : GECKO_MEM1_SIZE;
+        u32* p = (u32*)(region + (Random() % (size / 4096)) * 4096);
+        for (u32 j = 0; j < 1024; j += 16) {
+            p[j] = frame * 2654435761u + j;
+        }
+    }
+}
+
+static double FullCopy(u8* dst) {
+    OSTime start = OSGetTime();
+    
+    memcpy(dst, s_memory.mem1, GECKO_MEM1_SIZE);
+    memcpy(dst + GECKO_MEM1_SIZE, s_memory.mem2, GECKO_MEM2_SIZE);
+    memcpy(dst + GECKO_MEM1_SIZE + GECKO_MEM2_SIZE, s_memory.aram, GECKO_ARAM_SIZE);
+    return Milliseconds(OSGetTime() - start);
+}
+
+/* Frames with a snapshot each; returns the mean frame time */
+static double RunFrames(GeckoSavestate* ss, u32 pages, double* takeMs, u64* hashes) {
+    OSTime total = 0;
+    OSTime take = 0;
+    
+    for (u32 f = 0; f < FRAMES; f++) {
+        OSTime start = OSGetTime();
+        RunFrame(f, pages);
+        if (ss) {
+            OSTime t = OSGetTime();
+            GeckoSavestateTake(ss);
+            take += OSGetTime() - t;
+        }
+        total += OSGetTime() - start;
+        
+        for (u32 i = 0; hashes && i < ARRAY_LENGTH(s_rewinds); i++) {
+            if (f == FRAMES - 1 - s_rewinds[i]) {
+                hashes[i] = HashMemory();
+            }
+        }
+    }
+    
+    *takeMs = Milliseconds(take) / FRAMES;
+    return Milliseconds(total) / FRAMES;
+}
+
+int main(void) {
+    static const u32 pagesPerFrame[] = { 64, 512, 2048 };
+    u64 hashes[ARRAY_LENGTH(s_rewinds)];
+    char line[160];
+    
+    GeckoMemoryInit(&s_memory, TRUE);
+    GeckoMemoryAllocARAM(&s_memory);
+    g_geckoMemory = &s_memory;
+    OSInit();
+    
+    for (u32 i = 0; i < FILL_BYTES; i++) {
+        u8 v = (u8)(i * 2654435761u >> 13);
+        s_memory.mem1[i] = v;
+        s_memory.mem2[i] = v ^ 0x5A;
+        s_memory.aram[i] = v ^ 0xA5;
+    }
+    
+    u8* copy = (u8*)malloc(GECKO_MEM1_SIZE + GECKO_MEM2_SIZE + GECKO_ARAM_SIZE);
+    if (!copy) {
+        OSReport("Out of memory\n");
+        return 1;
+    }
+    FullCopy(copy);  // Commit the destination
+    OSReport("Full copy of MEM1+MEM2+ARAM: %.2f ms\n", FullCopy(copy));
+    free(copy);
+    
+    // Frame times without savestates, before any page is protected
+    double off[ARRAY_LENGTH(pagesPerFrame)];
+    for (u32 i = 0; i < ARRAY_LENGTH(pagesPerFrame); i++) {
+        double takeMs;
+        off[i] = RunFrames(NULL, pagesPerFrame[i], &takeMs, NULL);
+    }
+    
+    GeckoSavestate* ss = GeckoSavestateCreate(&s_memory, DEPTH);
+    if (!ss) {
+        OSReport("Savestates unavailable\n");
+        return 1;
+    }
+    
+    GeckoSavestateStats stats;
+    OSTime start = OSGetTime();
+    GeckoSavestateTake(ss);
+    GeckoSavestateWait(ss);
+    GeckoSavestateGetStats(ss, &stats);
+    OSReport("First snapshot: %.2f ms, %u KB stored (%s)\n\n",
+             Milliseconds(OSGetTime() - start), (u32)(stats.storedBytes / 1024),
+             stats.tracking ? "write tracking" : "page compare");
+    
+    OSReport("%-8s %10s %10s %10s %10s %8s %10s\n",
+             "pages", "frame off", "frame on", "take", "per page", "cow", "held MB");
+    for (u32 i = 0; i < ARRAY_LENGTH(pagesPerFrame); i++) {
+        double takeMs;
+        u32 cowBefore = stats.cowPages;
+        
+        double on = RunFrames(ss, pagesPerFrame[i], &takeMs, NULL);
+        GeckoSavestateGetStats(ss, &stats);
+        
+        snprintf(line, sizeof(line), "%-8u %8.3fms %8.3fms %8.3fms %8.2fus %8u %10.1f",
+                 pagesPerFrame[i], off[i], on, takeMs, takeMs * 1000.0 / pagesPerFrame[i],
+                 stats.cowPages - cowBefore, (double)stats.storedBytes / (1024 * 1024));
+        OSReport("%s\n", line);
+    }
+    OSReport("\n");
+    
+    // Rewind: memory must match what it was at each frame
+    double takeMs;
+    RunFrames(ss, 512, &takeMs, hashes);
+    for (u32 i = 0; i < ARRAY_LENGTH(s_rewinds); i++) {
+        u32 back = s_rewinds[i] - (i > 0 ? s_rewinds[i - 1] : 0);
+        
+        start = OSGetTime();
+        BOOL ok = GeckoSavestateRestore(ss, back);
+        double ms = Milliseconds(OSGetTime() - start);
+        if (!ok || HashMemory() != hashes[i]) {
+            OSReport("MISMATCH: rewind of %u frames\n", s_rewinds[i]);
+            return 1;
+        }
+        OSReport("Rewind %2u frames: %.2f ms\n", s_rewinds[i], ms);
+    }
+    
+    // File round trip
+    u64 hash = HashMemory();
+    start = OSGetTime();
+    BOOL saved = GeckoSavestateSave(ss, 0, STATE_FILE);
+    double saveMs = Milliseconds(OSGetTime() - start);
+    RunFrame(FRAMES, 2048);
+    start = OSGetTime();
+    BOOL loaded = saved && GeckoSavestateLoad(ss, STATE_FILE);
+    double loadMs = Milliseconds(OSGetTime() - start);
+    remove(STATE_FILE);
+    if (!loaded || HashMemory() != hash) {
+        OSReport("MISMATCH: savestate file round trip\n");
+        return 1;
+    }
+    OSReport("Save to file: %.2f ms, load: %.2f ms\n", saveMs, loadMs);
+    
+    GeckoSavestateDestroy(ss);
+    GeckoMemoryFree(&s_memory);
+    return 0;
+}
+
+#else
+
+int main(void) {
+    OSInit();
+    OSReport("savestate_benchmark needs PORPOISE_USE_GECKO_MEMORY=ON\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file shared_aram_example.c
+ * @brief Out-of-process audio mixer reading ARAM through shared memory
+ *
+ * The game process puts ARAM in a named shared memory object, uploads a
+ * sample and sends "play" commands. The mixer process attaches to the
+ * same object, reads the sample in place (no copy) and answers with a
+ * notification per voice.
+ *
+ * Usage:  shared_aram_example          (game; starts the mixer on POSIX)
+ *         shared_aram_example mixer    (mixer; start it by hand on Windows)
+ */
+
+#include <dolphin/os.h>
+#include <dolphin/ar.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define SHARED_NAME     "porpoise_example"
+
+#define CMD_PLAY        1   // arg[0] = ARAM address, arg[1] = samples, arg[2] = voice
+#define CMD_QUIT        2
+#define NOTIFY_DONE     1   // arg[0] = voice, arg[1] = peak amplitude
+
+#define SAMPLE_COUNT    4800
+
+static void Sleep1ms(void) {
+    OSSleepTicks(OSMillisecondsToTicks(1));
+}
+
+/*---------------------------------------------------------------------------*
+    Mixer process
+ *---------------------------------------------------------------------------*/
+static int RunMixer(void) {
+    if (!OSAttachSharedMemory(SHARED_NAME)) {
+        OSReport("Mixer: Could not attach to '%s' (is the game running?)\n", SHARED_NAME);
+        return 1;
+    }
+    
+    u8* aram = (u8*)OSGetSharedRegion(OS_SHARED_ARAM, NULL);
+    OSReport("Mixer: Attached, ARAM mapped at %p\n", aram);
+    
+    for (;;) {
+        OSSharedMessage cmd;
+        if (!OSReceiveSharedMessage(&cmd)) {
+            if (!OSIsSharedPeerAttached()) {
+                break;  // Game went away
+            }
+            Sleep1ms();  // A real mixer would poll once per audio period
+            continue;
+        }
+        
+        if (cmd.type == CMD_QUIT) {
+            break;
+        }
+        
+        if (cmd.type == CMD_PLAY) {
+            // Read the sample straight out of shared ARAM
+            const s16* pcm = (const s16*)(aram + cmd.arg[0]);
+            s32 peak = 0;
+            for (u32 i = 0; i < cmd.arg[1]; i++) {
+                s32 v = pcm[i] < 0 ? -pcm[i] : pcm[i];
+                if (v > peak) peak = v;
+            }
+            
+            OSSharedMessage done = { NOTIFY_DONE, { cmd.arg[2], (u32)peak } };
+            while (!OSSendSharedMessage(&done)) {
+                Sleep1ms();
+            }
+        }
+    }
+    
+    OSReport("Mixer: Exiting\n");
+    OSDetachSharedMemory();
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*
+    Game process
+ *---------------------------------------------------------------------------*/
+static int RunGame(const char* exe) {
+    // Must come before ARInit (and OSInit, if MEM1/MEM2 are shared too)
+    if (!OSCreateSharedMemory(SHARED_NAME, OS_SHARED_ARAM)) {
+        return 1;
+    }
+    
+    OSInit();
+    ARInit(NULL, 0);
+    
+    // Upload a sample. ARAM is ordinary memory in this process as well;
+    // a game would ARStartDMA or ARQPostRequest its sound bank here.
+    u32 sampleAddr = ARAlloc(SAMPLE_COUNT * sizeof(s16));
+    s16* sample = (s16*)((u8*)OSGetSharedRegion(OS_SHARED_ARAM, NULL) + sampleAddr);
+    for (int i = 0; i < SAMPLE_COUNT; i++) {
+        sample[i] = (s16)((i % 100) * 300 - 15000);  // Saw wave
+    }
+
+#ifndef _WIN32
+    pid_t mixer = fork();
+    if (mixer == 0) {
+        execl(exe, exe, "mixer", (char*)NULL);
+        _exit(1);
+    }
+#else
+    (void)exe;
+    OSReport("Game: Start 'shared_aram_example mixer' in another console\n");
+#endif
+
+    OSReport("Game: Waiting for the mixer...\n");
+    for (int i = 0; i < 10000 && !OSIsSharedPeerAttached(); i++) {
+        Sleep1ms();
+    }
+    if (!OSIsSharedPeerAttached()) {
+        OSReport("Game: No mixer attached\n");
+        OSDetachSharedMemory();
+        return 1;
+    }
+    
+    // Play 8 voices; the game thread never waits on the mixer
+    for (u32 voice = 0; voice < 8; voice++) {
+        OSSharedMessage play = { CMD_PLAY, { sampleAddr, SAMPLE_COUNT, voice } };
+        OSSendSharedMessage(&play);
+    }
+    
+    u32 done = 0;
+    while (done < 8) {
+        OSSharedMessage note;
+        if (OSReceiveSharedMessage(&note)) {
+            OSReport("Game: Voice %u finished, peak %u\n", note.arg[0], note.arg[1]);
+            done++;
+        } else {
+            Sleep1ms();
+        }
+    }
+    
+    OSSharedMessage quit = { CMD_QUIT, { 0 } };
+    OSSendSharedMessage(&quit);
+
+#ifndef _WIN32
+    waitpid(mixer, NULL, 0);
+#endif
+
+    ARReset();
+    OSDetachSharedMemory();
+    OSReport("Game: Done\n");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "mixer") == 0) {
+        return RunMixer();
+    }
+    return RunGame(argv[0]);
+}
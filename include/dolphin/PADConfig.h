@@ -57,5 +57,25 @@ float PADGetSensitivity(BOOL is_c_stick);
  */
 float PADGetRumbleIntensity(void);
 
+/**
+ * @brief Get configured input trace file ([Trace] section)
+ * @param replay TRUE for the replay file, FALSE for the record file
+ * @return Path, or NULL if not set
+ */
+const char* PADGetTracePath(BOOL replay);
+
+/**
+ * @brief Get channels configured as virtual controllers ([Virtual] section)
+ * @return OR-ed PAD_CHANn_BIT
+ */
+u32 PADGetVirtualChannels(void);
+
+/**
+ * @brief Get configured virtual controller transport ([Virtual] section)
+ * @param ring TRUE for the shared memory ring name, FALSE for the socket path
+ * @return Name or path, or NULL if not set
+ */
+const char* PADGetVirtualPath(BOOL ring);
+
 #endif // PAD_CONFIG_H
 
@@ -30,6 +30,19 @@ extern "C" {
 // Reserved area (OS uses bottom 16KB)
 #define AR_OS_RESERVED      0x4000      // 16KB
 
+// ARQ request priorities
+#define ARQ_PRIORITY_LOW    0
+#define ARQ_PRIORITY_HIGH   1
+
+// ARQ request types
+#define ARQ_TYPE_MRAM_TO_ARAM   AR_MRAM_TO_ARAM
+#define ARQ_TYPE_ARAM_TO_MRAM   AR_ARAM_TO_MRAM
+
+#define ARQ_CHUNK_SIZE_DEFAULT  4096
+
+// ARAM heaps (PC extension, see ARCreateHeap)
+#define AR_MAX_HEAPS        8
+
 /*---------------------------------------------------------------------------*
     Types
  *---------------------------------------------------------------------------*/
@@ -46,13 +59,53 @@ typedef struct ARQRequest {
     struct ARQRequest* next;        ///< Next request in queue
     u32   owner;                    ///< Owner ID
     u32   type;                     ///< DMA type (MRAM_TO_ARAM or ARAM_TO_MRAM)
-    u32   priority;                 ///< Priority (0=high, 1=low)
+    u32   priority;                 ///< ARQ_PRIORITY_LOW or ARQ_PRIORITY_HIGH
     u32   source;                   ///< Source address
     u32   dest;                     ///< Destination address
     u32   length;                   ///< Transfer length
     void (*callback)(struct ARQRequest*);  ///< Completion callback
 } ARQRequest;
 
+/**
+ * @brief ARQ DMA engine counters (PC extension, see ARQGetStats)
+ */
+typedef struct ARQStats {
+    u32   queueDepthHi;             ///< High-priority requests not yet copied
+    u32   queueDepthLo;             ///< Low-priority requests not yet copied
+    u32   callbacksPending;         ///< Copied, callback not yet run
+    u32   maxQueueDepth;            ///< Deepest combined queue seen
+    u32   requestsCompleted;
+    u32   requestsRemoved;          ///< Dropped by ARQRemove*/ARQFlushQueue
+    u32   chunks;                   ///< Chunks copied
+    u64   bytesTransferred;
+    u64   busyTicks;                ///< OSTime the engine spent copying
+    u32   bytesPerSecond;           ///< Copy bandwidth while busy
+} ARQStats;
+
+/**
+ * @brief ARAM heap handle (PC extension)
+ */
+typedef int ARHeapHandle;
+
+/**
+ * @brief Asked before ARCompactHeap moves a block
+ * 
+ * Return TRUE to let the block move to newAddr, FALSE to pin it.
+ */
+typedef BOOL (*ARHeapRelocateCallback)(u32 oldAddr, u32 newAddr, u32 size, void* context);
+
+/**
+ * @brief ARAM heap occupancy (PC extension, see ARGetHeapStats)
+ */
+typedef struct ARHeapStats {
+    u32   size;                     ///< Heap size in bytes
+    u32   freeBytes;
+    u32   usedBytes;
+    u32   largestFreeBlock;         ///< Largest allocation that would succeed
+    u32   numFreeBlocks;
+    u32   numUsedBlocks;
+} ARHeapStats;
+
 /*---------------------------------------------------------------------------*
     Functions
  *---------------------------------------------------------------------------*/
@@ -97,13 +150,19 @@ u32 ARGetBaseAddress(void);
 /**
  * @brief Allocate ARAM space
  * 
+ * Stack allocator: blocks are freed in reverse order with ARFree. Use an
+ * ARAM heap (ARCreateHeap) for blocks freed in any order.
+ * 
  * @param length  Number of bytes to allocate
- * @return ARAM address, or 0 if allocation failed
+ * @return ARAM address, or 0xFFFFFFFF if allocation failed
  */
 u32 ARAlloc(u32 length);
 
 /**
- * @brief Free ARAM space
+ * @brief Free the most recent ARAlloc block
+ * 
+ * Without an allocation stack (ARInit with numEntries 0) this frees all
+ * blocks at once.
  * 
  * @param length  Pointer to receive size freed
  * @return ARAM address of freed block
@@ -159,6 +218,74 @@ void __ARClearInterrupt(void);
  */
 u32 __ARGetInterruptStatus(void);
 
+/*---------------------------------------------------------------------------*
+    ARAM Heaps (PC extension)
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @brief Create a heap over an ARAM range (usually taken with ARAlloc)
+ * 
+ * @param start  First ARAM address
+ * @param end    End address (exclusive)
+ * @return Heap handle, or -1 on failure
+ */
+ARHeapHandle ARCreateHeap(u32 start, u32 end);
+
+/**
+ * @brief Destroy a heap (its blocks become invalid)
+ * 
+ * @param heap  Heap handle
+ */
+void ARDestroyHeap(ARHeapHandle heap);
+
+/**
+ * @brief Allocate a 32-byte aligned block in O(1)
+ * 
+ * @param heap  Heap handle
+ * @param size  Bytes (rounded up to a multiple of 32)
+ * @return ARAM address, or 0xFFFFFFFF if no free block is large enough
+ */
+u32 ARAllocFromHeap(ARHeapHandle heap, u32 size);
+
+/**
+ * @brief Free a block in O(1), in any order
+ * 
+ * @param heap  Heap handle
+ * @param addr  Address returned by ARAllocFromHeap
+ */
+void ARFreeToHeap(ARHeapHandle heap, u32 addr);
+
+/**
+ * @brief Get the size of an allocated block
+ * 
+ * @param heap  Heap handle
+ * @param addr  Address returned by ARAllocFromHeap
+ * @return Block size in bytes, or 0 if not allocated
+ */
+u32 ARGetHeapBlockSize(ARHeapHandle heap, u32 addr);
+
+/**
+ * @brief Get free space and largest free block
+ * 
+ * @param heap   Heap handle
+ * @param stats  Receives the figures
+ */
+void ARGetHeapStats(ARHeapHandle heap, ARHeapStats* stats);
+
+/**
+ * @brief Move allocated blocks together to merge free space
+ * 
+ * The callback is asked before each move and may pin the block. It runs
+ * with the heap lock held and must not call ARAM heap functions. Blocks
+ * with ARQ transfers in flight must be pinned.
+ * 
+ * @param heap      Heap handle
+ * @param callback  Relocation callback (NULL: nothing moves)
+ * @param context   Passed to the callback
+ * @return Largest free block after compaction
+ */
+u32 ARCompactHeap(ARHeapHandle heap, ARHeapRelocateCallback callback, void* context);
+
 /*---------------------------------------------------------------------------*
     ARQ - ARAM Queue (for queued DMA operations)
  *---------------------------------------------------------------------------*/
@@ -176,10 +303,14 @@ void ARQReset(void);
 /**
  * @brief Post a DMA request to the queue
  * 
+ * Returns immediately; the copy runs on the ARQ DMA engine and the
+ * callback on the ARQ dispatcher thread. High-priority requests overtake
+ * low-priority ones at the next chunk boundary.
+ * 
  * @param request   ARQ request structure
  * @param owner     Owner ID
  * @param type      DMA type
- * @param priority  Priority (0=high, 1=low)
+ * @param priority  ARQ_PRIORITY_LOW or ARQ_PRIORITY_HIGH
  * @param source    Source address
  * @param dest      Destination address
  * @param length    Transfer length
@@ -192,6 +323,9 @@ void ARQPostRequest(ARQRequest* request, u32 owner, u32 type, u32 priority,
 /**
  * @brief Remove a request from the queue
  * 
+ * The callback is not called. On return the engine no longer touches the
+ * request or its buffers.
+ * 
  * @param request  Request to remove
  */
 void ARQRemoveRequest(ARQRequest* request);
@@ -204,7 +338,7 @@ void ARQRemoveRequest(ARQRequest* request);
 void ARQRemoveOwnerRequest(u32 owner);
 
 /**
- * @brief Flush all pending requests
+ * @brief Drop all pending requests (callbacks are not called)
  */
 void ARQFlushQueue(void);
 
@@ -222,6 +356,18 @@ void ARQSetChunkSize(u32 size);
  */
 u32 ARQGetChunkSize(void);
 
+/**
+ * @brief Get DMA engine queue depth and bandwidth counters
+ * 
+ * @param stats  Receives the counters
+ */
+void ARQGetStats(ARQStats* stats);
+
+/**
+ * @brief Clear the ARQ transfer counters
+ */
+void ARQResetStats(void);
+
 /**
  * @brief Check if ARQ is initialized
  * 
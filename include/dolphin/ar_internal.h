@@ -0,0 +1,54 @@
+/**
+ * @file ar_internal.h
+ * @brief Internal ARAM definitions
+ * 
+ * Shared between the AR, ARQ and ARAM heap implementation files, and
+ * the DVD reader for disc-to-ARAM transfers.
+ * Not part of public API.
+ */
+
+#ifndef DOLPHIN_AR_INTERNAL_H
+#define DOLPHIN_AR_INTERNAL_H
+
+#include <dolphin/ar.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    DMA Copy (AR.c)
+ *---------------------------------------------------------------------------*/
+
+// Copy between main RAM and ARAM without touching the DMA status or the
+// registered AR DMA callback (ARQ owns those for its transfers).
+// transferSize is the whole request, for the cached/streaming choice.
+BOOL __ARCopy(u32 type, u32 mainmemAddr, u32 aramAddr, u32 length, u32 transferSize);
+
+// Move data inside ARAM (ranges may overlap). Used by heap compaction.
+void __ARMove(u32 dstAddr, u32 srcAddr, u32 length);
+
+// Host address of an ARAM range, or NULL if it is out of bounds. Lets the
+// DVD reader fill ARAM directly (DVDReadToARAMAsync).
+void* __ARGetPointer(u32 aramAddr, u32 length);
+
+/*---------------------------------------------------------------------------*
+    ARQ (ARQ.c)
+ *---------------------------------------------------------------------------*/
+
+// Finish a request whose data was moved outside the DMA engine: the
+// callback runs on the ARQ dispatcher thread like any other request's.
+void __ARQComplete(ARQRequest* request);
+
+/*---------------------------------------------------------------------------*
+    ARAM Heaps (ARHeap.c)
+ *---------------------------------------------------------------------------*/
+
+// Destroy all heaps (called by ARReset)
+void __ARResetHeaps(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOLPHIN_AR_INTERNAL_H
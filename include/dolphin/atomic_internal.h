@@ -0,0 +1,118 @@
+/**
+ * @file atomic_internal.h
+ * @brief Internal atomic helpers shared by libPorpoise subsystems
+ * 
+ * Lock-free ring buffers and counters between game, audio and worker
+ * threads. Not part of public API.
+ */
+
+#ifndef DOLPHIN_ATOMIC_INTERNAL_H
+#define DOLPHIN_ATOMIC_INTERNAL_H
+
+#include <dolphin/types.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    32-bit
+ *---------------------------------------------------------------------------*/
+
+static inline u32 __AtomicLoad32(const volatile u32* p) {
+#if defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+    return (u32)_InterlockedOr((volatile long*)p, 0);
+#elif defined(_MSC_VER)
+    u32 v = *p;  // x86 loads are acquire
+    _ReadWriteBarrier();
+    return v;
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void __AtomicStore32(volatile u32* p, u32 v) {
+#if defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+    _InterlockedExchange((volatile long*)p, (long)v);
+#elif defined(_MSC_VER)
+    _ReadWriteBarrier();
+    *p = v;  // x86 stores are release
+#else
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#endif
+}
+
+// Returns the value before the add
+static inline u32 __AtomicAdd32(volatile u32* p, u32 v) {
+#ifdef _MSC_VER
+    return (u32)_InterlockedExchangeAdd((volatile long*)p, (long)v);
+#else
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+#endif
+}
+
+// Returns TRUE if *p was expected and is now desired
+static inline BOOL __AtomicCompareSwap32(volatile u32* p, u32 expected, u32 desired) {
+#ifdef _MSC_VER
+    return (u32)_InterlockedCompareExchange((volatile long*)p, (long)desired,
+                                           (long)expected) == expected;
+#else
+    return __atomic_compare_exchange_n(p, &expected, desired, FALSE,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+    64-bit (counters)
+ *---------------------------------------------------------------------------*/
+
+static inline u64 __AtomicLoad64(const volatile u64* p) {
+#ifdef _MSC_VER
+    return (u64)_InterlockedCompareExchange64((volatile __int64*)p, 0, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline u64 __AtomicAdd64(volatile u64* p, u64 v) {
+#ifdef _MSC_VER
+    return (u64)_InterlockedExchangeAdd64((volatile __int64*)p, (__int64)v);
+#else
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+    Fences
+ *---------------------------------------------------------------------------*/
+
+static inline void __AtomicFence(void) {
+#if defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+    __dmb(0xB);  // ISH
+#elif defined(_MSC_VER)
+    _mm_mfence();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+// Earlier stores become visible before later ones (no load ordering)
+static inline void __AtomicReleaseFence(void) {
+#if defined(_MSC_VER) && (defined(_M_ARM) || defined(_M_ARM64))
+    __dmb(0xB);  // ISH
+#elif defined(_MSC_VER)
+    _ReadWriteBarrier();  // x86 stores are not reordered with each other
+#else
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOLPHIN_ATOMIC_INTERNAL_H
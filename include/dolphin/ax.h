@@ -0,0 +1,205 @@
+/**
+ * @file ax.h
+ * @brief AX (DSP audio mixer) API for libPorpoise
+ *
+ * On GameCube the DSP runs the AX microcode: it reads samples from ARAM,
+ * decodes DSP-ADPCM, resamples and mixes up to 64 voices every 5 ms.
+ * On PC a software mixer does the same on a dedicated thread, reading
+ * sample data in place from simulated ARAM.
+ */
+
+#ifndef DOLPHIN_AX_H
+#define DOLPHIN_AX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <dolphin/types.h>
+
+/*---------------------------------------------------------------------------*
+    Constants
+ *---------------------------------------------------------------------------*/
+
+#define AX_MAX_VOICES           64
+#define AX_SAMPLE_RATE          32000   // Output rate (Hz)
+#define AX_FRAME_SAMPLES        160     // Stereo sample pairs per 5 ms frame
+
+// Sample formats (AXPBADDR.format)
+#define AX_PB_FORMAT_ADPCM      0x00    // DSP-ADPCM, addresses in nibbles
+#define AX_PB_FORMAT_PCM16      0x0A    // Big-endian s16, addresses in samples
+#define AX_PB_FORMAT_PCM8       0x19    // s8, addresses in bytes
+
+// Voice states
+#define AX_PB_STATE_STOP        0
+#define AX_PB_STATE_RUN         1
+
+// DSP-ADPCM frame layout: 1 header byte (predictor << 4 | scale) + 7
+// bytes of 4-bit samples. Nibble addresses count the header, so sample
+// addresses within a frame are 2..15.
+#define AX_ADPCM_FRAME_SIZE     8
+#define AX_ADPCM_FRAME_SAMPLES  14
+
+#define AX_SRC_RATIO_MAX        4.0f    // Highest pitch (source/output rate)
+
+// Mixer modes (AXInitEx)
+#define AX_MODE_THREAD          0       // Mixer thread; pull with AXReadOutput
+#define AX_MODE_MANUAL          1       // Caller mixes with AXMix
+
+#define AX_INVALID_VOICE        (-1)
+
+/*---------------------------------------------------------------------------*
+    Types
+ *---------------------------------------------------------------------------*/
+
+typedef s32 AXVoice;
+
+/**
+ * @brief Called on the mixer thread when a non-looping voice reaches its
+ *        end address (the voice has already stopped)
+ */
+typedef void (*AXVoiceCallback)(AXVoice voice, void* context);
+
+/**
+ * @brief Sample addresses, in format units (see AX_PB_FORMAT_*) from the
+ *        start of ARAM. endAddress is the last sample played.
+ */
+typedef struct AXPBADDR {
+    u16   loopFlag;                 ///< Nonzero: jump to loopAddress after end
+    u16   format;                   ///< AX_PB_FORMAT_*
+    u32   loopAddress;
+    u32   endAddress;
+    u32   currentAddress;           ///< First sample to play
+} AXPBADDR;
+
+/**
+ * @brief DSP-ADPCM decoder parameters (from the DSPADPCM header)
+ */
+typedef struct AXPBADPCM {
+    s16   coefs[16];                ///< 8 predictor pairs, 1.11 fixed point
+    s16   yn1;                      ///< History at currentAddress
+    s16   yn2;
+    s16   loopYn1;                  ///< History at loopAddress
+    s16   loopYn2;
+} AXPBADPCM;
+
+/**
+ * @brief Mixer counters (PC extension, see AXGetStats)
+ */
+typedef struct AXStats {
+    u32   activeVoices;             ///< Voices that ran in the last frame
+    u32   framesMixed;              ///< 5 ms frames produced
+    u64   voiceFrames;              ///< Sum of active voices over all frames
+    u64   mixNanoseconds;           ///< CPU time spent mixing
+    u32   maxFrameNanoseconds;      ///< Slowest frame
+    u32   commandsProcessed;
+    u32   commandsDropped;          ///< Queue was full (setter returned FALSE)
+    u32   underruns;                ///< AXReadOutput calls that ran dry
+    u32   bufferedSamples;          ///< Mixed output waiting to be read
+} AXStats;
+
+/*---------------------------------------------------------------------------*
+    Initialization
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @brief Start the mixer (AX_MODE_THREAD). ARInit must have been called.
+ */
+void AXInit(void);
+
+/**
+ * @brief Start the mixer in the given mode (AX_MODE_*)
+ */
+void AXInitEx(u32 mode);
+
+/**
+ * @brief Stop the mixer thread and release all voices
+ */
+void AXQuit(void);
+
+BOOL AXIsInit(void);
+
+/*---------------------------------------------------------------------------*
+    Voices
+    
+    Setters post a command to a lock-free queue and return at once; the
+    mixer applies them at the next 5 ms frame boundary, in the order they
+    were posted. They return FALSE if the voice is not acquired or the
+    queue is full. Any thread may post; each voice should be driven from
+    one thread so its commands stay in order.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @brief Allocate a voice (stopped, volume 1.0, centered, ratio 1.0)
+ * @return Voice, or AX_INVALID_VOICE if all are in use
+ */
+AXVoice AXAcquireVoice(AXVoiceCallback callback, void* context);
+
+/**
+ * @brief Stop and release a voice
+ */
+void AXFreeVoice(AXVoice voice);
+
+BOOL AXSetVoiceAddr(AXVoice voice, const AXPBADDR* addr);
+BOOL AXSetVoiceAdpcm(AXVoice voice, const AXPBADPCM* adpcm);
+
+/**
+ * @brief Set the pitch: source samples consumed per output sample
+ *        (sourceRate / AX_SAMPLE_RATE), up to AX_SRC_RATIO_MAX
+ */
+BOOL AXSetVoiceSrcRatio(AXVoice voice, f32 ratio);
+
+/**
+ * @brief Set volume (0.0 - 1.0) and pan (-1.0 left, 0.0 center, 1.0 right)
+ */
+BOOL AXSetVoiceMix(AXVoice voice, f32 volume, f32 pan);
+
+/**
+ * @brief Start (AX_PB_STATE_RUN) or stop (AX_PB_STATE_STOP) a voice
+ */
+BOOL AXSetVoiceState(AXVoice voice, u32 state);
+
+/**
+ * @brief State and position as of the last mixed frame (commands still
+ *        in the queue are not reflected)
+ */
+u32 AXGetVoiceState(AXVoice voice);
+u32 AXGetVoiceCurrentAddr(AXVoice voice);
+
+/*---------------------------------------------------------------------------*
+    Output (PC extension)
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @brief Read mixed audio (AX_MODE_THREAD)
+ *
+ * Never blocks: if the mixer has not produced enough, the rest is filled
+ * with silence and an underrun is counted. Safe to call from the audio
+ * backend's callback.
+ *
+ * @param pcm         Output, interleaved stereo s16 at AX_SAMPLE_RATE
+ * @param numSamples  Stereo sample pairs wanted
+ * @return Sample pairs taken from the mixer
+ */
+u32 AXReadOutput(s16* pcm, u32 numSamples);
+
+/**
+ * @brief Apply queued commands and mix on the calling thread
+ *        (AX_MODE_MANUAL). Voice callbacks run on the calling thread.
+ *
+ * @param pcm         Output, interleaved stereo s16 at AX_SAMPLE_RATE
+ * @param numSamples  Stereo sample pairs to mix
+ * @return FALSE if AX is not initialized in AX_MODE_MANUAL
+ */
+BOOL AXMix(s16* pcm, u32 numSamples);
+
+/**
+ * @brief Get mixer counters (PC extension)
+ */
+void AXGetStats(AXStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOLPHIN_AX_H
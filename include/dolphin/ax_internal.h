@@ -0,0 +1,59 @@
+/**
+ * @file ax_internal.h
+ * @brief Internal AX mixer definitions
+ *
+ * Decode and mix kernels shared between the voice/command code (AX.c)
+ * and their SIMD implementations (AXMix.c).
+ * Not part of public API.
+ */
+
+#ifndef DOLPHIN_AX_INTERNAL_H
+#define DOLPHIN_AX_INTERNAL_H
+
+#include <dolphin/ax.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    Decode (AXMix.c)
+    
+    Source pointers are ARAM host addresses; they need no alignment.
+ *---------------------------------------------------------------------------*/
+
+// Decode count samples of one DSP-ADPCM frame, starting at sample first
+// (0-13). frame points at the header byte; all 8 bytes are read. hist is
+// {yn1, yn2} and is updated.
+void __AXDecodeADPCM(const u8* frame, u32 first, u32 count, const s16* coefs,
+                     s16* hist, s16* out);
+
+// Big-endian s16 to host s16
+void __AXDecodePCM16(const u8* src, s16* out, u32 count);
+
+// s8 to s16 (<< 8)
+void __AXDecodePCM8(const u8* src, s16* out, u32 count);
+
+/*---------------------------------------------------------------------------*
+    Resample / Mix (AXMix.c)
+ *---------------------------------------------------------------------------*/
+
+// Linear interpolation. Output sample i is taken at 16.16 position
+// frac + i * ratio in "in", which must hold ((frac + (count - 1) * ratio)
+// >> 16) + 2 samples.
+void __AXResample(const s16* in, s16* out, u32 count, u32 frac, u32 ratio);
+
+// acc[2i] += in[i] * left >> 15, acc[2i + 1] += in[i] * right >> 15
+void __AXMixVoice(s32* acc, const s16* in, u32 count, s16 left, s16 right);
+
+// Saturate count stereo pairs to s16
+void __AXClampOutput(const s32* acc, s16* out, u32 count);
+
+// Name of the compiled-in kernel set ("SSE2", "NEON" or "Scalar")
+const char* __AXGetKernelName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOLPHIN_AX_INTERNAL_H
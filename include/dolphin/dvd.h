@@ -17,6 +17,7 @@ extern "C" {
 
 // Forward declarations
 typedef struct OSAlarm OSAlarm;
+struct ARQRequest;
 
 /*---------------------------------------------------------------------------*
     Constants
@@ -188,6 +189,9 @@ BOOL DVDReadAsync(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
 /**
  * @brief Read from file (asynchronous with priority)
  * 
+ * The read is queued and serviced by the DVD reader thread, higher
+ * priorities first. Only one command may be outstanding per file.
+ * 
  * @param fileInfo  Pointer to open file
  * @param addr      Destination buffer
  * @param length    Number of bytes to read
@@ -199,6 +203,29 @@ BOOL DVDReadAsync(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
 BOOL DVDReadAsyncPrio(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
                       DVDCallback callback, s32 prio);
 
+/**
+ * @brief Read a file range straight into ARAM (PC extension)
+ * 
+ * One copy from the file into ARAM, with no main RAM staging buffer. The
+ * request completes like an ARQ request: the callback runs on the ARQ
+ * dispatcher thread with request->length set to the bytes read. Shares
+ * the file's command slot with DVDReadAsync; DVDCancel drops the request
+ * without a callback.
+ * 
+ * @param fileInfo  Pointer to open file
+ * @param request   ARQ request (must stay valid until the callback)
+ * @param owner     Owner ID stored in the request
+ * @param aramAddr  ARAM destination (32-byte aligned)
+ * @param length    Number of bytes to read
+ * @param offset    Offset in file to start reading from
+ * @param callback  ARQ completion callback (or NULL)
+ * @param prio      Priority (DVD_PRIO_*)
+ * @return TRUE if read started successfully
+ */
+BOOL DVDReadToARAMAsync(DVDFileInfo* fileInfo, struct ARQRequest* request, u32 owner,
+                        u32 aramAddr, s32 length, s32 offset,
+                        void (*callback)(struct ARQRequest*), s32 prio);
+
 /**
  * @brief Seek to position in file (synchronous)
  * 
@@ -258,6 +285,8 @@ s32 DVDGetCommandBlockStatus(const DVDCommandBlock* block);
 /**
  * @brief Cancel a pending operation
  * 
+ * Blocks until the cancellation has completed (see DVDCancelAsync).
+ * 
  * @param fileInfo  Pointer to file with operation
  * @return TRUE if canceled successfully
  */
@@ -266,6 +295,10 @@ BOOL DVDCancel(DVDFileInfo* fileInfo);
 /**
  * @brief Cancel operation asynchronously
  * 
+ * A queued read is removed immediately; a read in progress stops at the
+ * next chunk boundary. The read callback receives DVD_RESULT_CANCELED,
+ * then @p callback fires.
+ * 
  * @param fileInfo  Pointer to file with operation
  * @param callback  Callback when cancel completes
  * @return TRUE if cancel initiated
@@ -380,6 +413,8 @@ BOOL DVDSetAutoInvalidation(BOOL autoInval);
 
 /**
  * @brief Cancel all operations (sync)
+ * 
+ * Returns once the read in progress, if any, has stopped.
  */
 s32 DVDCancelAll(void);
 
@@ -390,10 +425,25 @@ BOOL DVDCancelAllAsync(DVDCBCallback callback);
 
 /**
  * @brief Prepare audio streaming (async)
+ * 
+ * PC: Starts streaming ADP (DVD streaming ADPCM) data from the file the
+ * command block belongs to. offset is relative to the start of that file
+ * and is rounded down to a 32-byte ADP frame; length 0 streams to the end
+ * of the file. A background thread keeps a ring buffer filled and the
+ * callback fires from that thread once the buffer has been primed.
+ * Preparing a new stream replaces the current one.
  */
 BOOL DVDPrepareStreamAbsAsync(DVDCommandBlock* block, u32 length, u32 offset,
                                DVDCBCallback callback);
 
+/**
+ * @brief Prepare audio streaming from an open file (async)
+ * 
+ * Same as DVDPrepareStreamAbsAsync() using fileInfo's command block.
+ */
+BOOL DVDPrepareStreamAsync(DVDFileInfo* fileInfo, u32 length, u32 offset,
+                           DVDCallback callback);
+
 /**
  * @brief Cancel audio streaming (async)
  */
@@ -404,6 +454,52 @@ BOOL DVDCancelStreamAsync(DVDCommandBlock* block, DVDCBCallback callback);
  */
 s32 DVDCancelStream(DVDCommandBlock* block);
 
+/*---------------------------------------------------------------------------*
+    Audio Streaming (PC extension)
+    
+    On GC/Wii the drive decodes the ADP stream itself and feeds the audio
+    interface. On PC the audio backend pulls PCM with DVDStreamDecode().
+ *---------------------------------------------------------------------------*/
+
+#define DVD_STREAM_FRAME_SIZE       32  ///< Bytes per ADP frame
+#define DVD_STREAM_FRAME_SAMPLES    28  ///< Stereo sample pairs per ADP frame
+
+/**
+ * @brief Streaming statistics (see DVDGetStreamStats)
+ */
+typedef struct DVDStreamStats {
+    BOOL    active;             ///< A stream is prepared
+    BOOL    ended;              ///< Reader has reached the end of the region
+    u32     bufferSize;         ///< Ring buffer capacity in bytes
+    u32     bufferedBytes;      ///< ADP bytes waiting to be decoded
+    u32     underruns;          ///< DVDStreamDecode() calls that ran dry
+    u32     blocksDecoded;      ///< ADP frames decoded
+    u64     bytesRead;          ///< ADP bytes read from disc
+    u64     decodeNanoseconds;  ///< Total CPU time spent decoding
+    u32     avgBlockNanoseconds;///< Average decode time per ADP frame
+    u32     maxBlockNanoseconds;///< Worst average per frame seen in one call
+} DVDStreamStats;
+
+/**
+ * @brief Decode buffered stream audio (PC extension)
+ * 
+ * Never blocks: if the ring buffer runs dry the rest of the output is
+ * filled with silence and an underrun is counted (unless the stream has
+ * simply ended). Safe to call from the audio thread.
+ * 
+ * @param pcm        Output, interleaved stereo s16 (L, R, L, R, ...)
+ * @param numFrames  Number of stereo sample pairs wanted
+ * @return Number of sample pairs decoded from the stream
+ */
+u32 DVDStreamDecode(s16* pcm, u32 numFrames);
+
+/**
+ * @brief Get streaming statistics (PC extension)
+ * 
+ * @param stats  Receives current counters
+ */
+void DVDGetStreamStats(DVDStreamStats* stats);
+
 /**
  * @brief Read from absolute disc offset
  */
@@ -512,6 +608,162 @@ BOOL DVDChangeDir(const char* dirName);
  */
 DVDDiskID* DVDGetDiskID(void);
 
+/*---------------------------------------------------------------------------*
+    File System Layers (PC extension)
+    
+    The DVD root directory is layer 0. Patches and mods are mounted on top;
+    a file in a higher layer hides the same path in the layers below.
+ *---------------------------------------------------------------------------*/
+
+#define DVD_MAX_LAYERS          16
+
+#define DVD_LAYER_AUTO          0   ///< Detect from the path
+#define DVD_LAYER_DIRECTORY     1   ///< Loose files in a host directory
+#define DVD_LAYER_DISC_IMAGE    2   ///< GameCube disc image (.gcm/.iso)
+#define DVD_LAYER_ARCHIVE       3   ///< U8 archive (.arc)
+
+/**
+ * @brief Mount a layer on top of the file system
+ * 
+ * The layer's file table is merged into the index once, so lookups cost
+ * the same however many layers are mounted.
+ * 
+ * @param path  Directory, disc image or archive
+ * @param type  DVD_LAYER_* (DVD_LAYER_AUTO to detect)
+ * @return Layer ID, or -1 on failure
+ */
+s32 DVDMountLayer(const char* path, s32 type);
+
+/**
+ * @brief Unmount a layer (paths fall back to the layers below)
+ * 
+ * @param layerId  ID from DVDMountLayer
+ * @return TRUE if unmounted
+ */
+BOOL DVDUnmountLayer(s32 layerId);
+
+/**
+ * @brief Re-scan a layer whose contents changed on the host
+ * 
+ * Only the paths the layer adds or drops are re-indexed.
+ * 
+ * @param layerId  Layer ID (0 = DVD root directory)
+ * @return TRUE if refreshed
+ */
+BOOL DVDRefreshLayer(s32 layerId);
+
+/**
+ * @brief Get number of mounted layers, including the root directory
+ */
+s32 DVDGetNumLayers(void);
+
+/*---------------------------------------------------------------------------*
+    Hot Reload (PC extension, Linux)
+    
+    Watches the directory layers with inotify and updates the file system
+    as files are saved, so assets can be reloaded while the game runs.
+ *---------------------------------------------------------------------------*/
+
+#define DVD_HOTRELOAD_ADDED     0   ///< File appeared
+#define DVD_HOTRELOAD_MODIFIED  1   ///< File rewritten (or a layer now hides it)
+#define DVD_HOTRELOAD_REMOVED   2   ///< File is gone from every layer
+#define DVD_HOTRELOAD_LAYER     3   ///< Disc image/archive layer was rescanned
+
+/**
+ * @brief Hot reload notification
+ * 
+ * Called on the watcher thread. path is the DVD path of the file, or the
+ * host path of the image/archive for DVD_HOTRELOAD_LAYER.
+ */
+typedef void (*DVDHotReloadCallback)(s32 event, const char* path);
+
+/**
+ * @brief Start watching the layers for changes
+ * 
+ * Only the changed paths are re-indexed; nothing is rescanned. Layers
+ * mounted later are picked up automatically.
+ * 
+ * @param callback  Notification callback (can be NULL)
+ * @return TRUE if watching (FALSE if the platform has no inotify)
+ */
+BOOL DVDEnableHotReload(DVDHotReloadCallback callback);
+
+/**
+ * @brief Stop watching the layers
+ */
+void DVDDisableHotReload(void);
+
+/*---------------------------------------------------------------------------*
+    Drive Latency Model (PC extension)
+    
+    Optional: makes DVDReadPrio/DVDReadAsyncPrio take as long as the drive
+    would, so load hitches show up during PC development.
+ *---------------------------------------------------------------------------*/
+
+/**
+ * @brief Drive timing parameters (see DVDGetDefaultLatencyModel)
+ */
+typedef struct DVDLatencyModel {
+    u32     discSize;           ///< Disc capacity in bytes (seek distance scale)
+    u32     trackSeekUs;        ///< Seek time for the shortest move
+    u32     fullSeekUs;         ///< Seek time across the whole disc
+    u32     rpm;                ///< Spindle speed (rotational latency)
+    u32     numZones;           ///< Transfer rate zones, inner to outer
+    u32     innerRateKBps;      ///< Transfer rate of the innermost zone
+    u32     outerRateKBps;      ///< Transfer rate of the outermost zone
+    u32     stallThresholdMs;   ///< Reads slower than this are reported
+} DVDLatencyModel;
+
+#define DVD_LATENCY_PATH_MAX    128     ///< Stall path buffer, including the NUL
+
+/**
+ * @brief A read that took longer than the stall threshold
+ */
+typedef struct DVDLatencyStall {
+    char        path[DVD_LATENCY_PATH_MAX]; ///< DVD path ("" if unknown; long paths truncated)
+    u32         discAddr;       ///< Modeled disc address of the read
+    s32         offset;         ///< Offset of the read in the file
+    s32         length;         ///< Bytes read
+    BOOL        async;          ///< Issued with DVDReadAsync*
+    u32         queueUs;        ///< Time spent waiting for the head
+    u32         seekUs;         ///< Seek time
+    u32         rotationUs;     ///< Rotational latency
+    u32         transferUs;     ///< Transfer time
+    u32         totalMs;        ///< Issue to completion
+} DVDLatencyStall;
+
+/**
+ * @brief Get parameters approximating the GameCube drive
+ */
+void DVDGetDefaultLatencyModel(DVDLatencyModel* model);
+
+/**
+ * @brief Enable or disable the drive latency model
+ * 
+ * Files get modeled disc addresses in FST order (sorted, depth first) from
+ * the merged file system, so enable before opening files.
+ * 
+ * @param model  Parameters, or NULL to disable
+ * @return TRUE if enabled
+ */
+BOOL DVDSetLatencyModel(const DVDLatencyModel* model);
+
+/**
+ * @brief Get stalls recorded so far in the current frame
+ * 
+ * @param stalls     Destination (may be NULL to just count)
+ * @param maxStalls  Capacity of stalls
+ * @return Number of stalls this frame
+ */
+u32 DVDGetLatencyStalls(DVDLatencyStall* stalls, u32 maxStalls);
+
+/**
+ * @brief Report this frame's stalls with OSReport and start a new frame
+ * 
+ * @return Number of stalls in the frame that ended
+ */
+u32 DVDLatencyEndFrame(void);
+
 /**
  * @brief Set DVD root directory path
  * 
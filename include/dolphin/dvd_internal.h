@@ -10,20 +10,20 @@
 #define DVD_INTERNAL_H
 
 #include <dolphin/dvd.h>
+#include <dolphin/os.h>
 #include <stdio.h>
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <pthread.h>
-#endif
-
 /*---------------------------------------------------------------------------*
     Internal Command Block Structure
  *---------------------------------------------------------------------------*/
 
-// Full command block definition (used by queue system)
+// Full command block definition (used by queue system).
+// Queue links must come first: DVDQueue.c treats its list heads as blocks.
 struct DVDCommandBlock {
+    // Queue links
+    struct DVDCommandBlock* next;   // Next in queue
+    struct DVDCommandBlock* prev;   // Previous in queue
+    
     DVDFileInfo*  fileInfo;         // Associated file info
     void*         addr;             // Destination buffer
     s32           length;           // Bytes to read
@@ -32,18 +32,81 @@ struct DVDCommandBlock {
     s32           state;            // Current state
     s32           result;           // Result code
     FILE*         file;             // OS file handle
-    
-    // Queue links
-    struct DVDCommandBlock* next;   // Next in queue
-    struct DVDCommandBlock* prev;   // Previous in queue
+    u32           baseOffset;       // Start of file data in file (images/archives)
     
     // For async operations
+    s32           prio;             // Waiting queue index (0 = highest)
+    volatile s32  transferredSize;  // Bytes read so far
+    volatile BOOL cancelRequested;  // Checked by reader between chunks
+    DVDCallback   cancelCallback;   // Fired once cancellation completes
+    OSTime        issueTime;        // When queued (latency model)
+    
+    // Disc-to-ARAM reads (DVDReadToARAMAsync): completes through ARQ
+    struct ARQRequest* aramRequest;
+};
+
+/*---------------------------------------------------------------------------*
+    Async Read Tuning
+ *---------------------------------------------------------------------------*/
+
+// Async reads are split into chunks of this size. The reader thread checks
+// for cancellation between chunks, so this bounds how long a canceled read
+// keeps the I/O pipeline busy.
+#define DVD_ASYNC_CHUNK_SIZE    (64 * 1024)
+
+/*---------------------------------------------------------------------------*
+    Audio Streaming (DVDStream.c)
+ *---------------------------------------------------------------------------*/
+
+// Stops the audio stream if it reads from this block's file
+void __DVDStreamBlockClosed(DVDCommandBlock* block);
+
+/*---------------------------------------------------------------------------*
+    Layered File System (DVDOverlay.c)
+ *---------------------------------------------------------------------------*/
+
 #ifdef _WIN32
-    HANDLE        thread;
+#define PATH_SEPARATOR '\\'
 #else
-    pthread_t     thread;
+#define PATH_SEPARATOR '/'
 #endif
-};
 
-#endif // DVD_INTERNAL_H
+// Where to read a resolved DVD path from
+typedef struct DVDOverlayFile {
+    char    hostPath[512];          // Loose file, or image/archive containing it
+    u32     baseOffset;             // Offset of the data in hostPath
+    u32     length;                 // File size
+    BOOL    isDir;                  // TRUE for directories
+    s32     layer;                  // Winning layer
+} DVDOverlayFile;
+
+typedef struct DVDOverlayDirEntry {
+    char*   name;
+    BOOL    isDir;
+} DVDOverlayDirEntry;
 
+// FNV-1a hash of a DVD path (overlay index and latency layout)
+u32  __DVDHashPath(const char* path);
+
+void __DVDOverlaySetBase(const char* rootPath);
+BOOL __DVDOverlayLookup(const char* dvdPath, DVDOverlayFile* out);
+DVDOverlayDirEntry* __DVDOverlayListDir(const char* dvdPath, u32* count);
+void __DVDOverlayWalkFiles(void (*visit)(const char* dvdPath, u32 length, void* arg), void* arg);
+u32  __DVDOverlayGetGeneration(void);
+
+// Reports a file whose visible version changed (DVD_HOTRELOAD_* event)
+typedef void (*DVDOverlayChangeFunc)(const char* dvdPath, s32 event, void* arg);
+
+BOOL __DVDOverlayGetLayer(s32 layerId, char* path, u32 size, s32* type, u32* stamp);
+void __DVDOverlayUpdatePath(s32 layerId, u32 stamp, const char* dvdPath,
+                            DVDOverlayChangeFunc changed, void* arg);
+
+/*---------------------------------------------------------------------------*
+    Drive Latency Model (DVDLatency.c)
+ *---------------------------------------------------------------------------*/
+
+u32  __DVDLatencyGetDiscAddress(const char* path, u32 length);
+void __DVDLatencyWait(DVDFileInfo* fileInfo, s32 offset, s32 length,
+                      OSTime issueTime, BOOL async, volatile BOOL* abort);
+
+#endif // DVD_INTERNAL_H
@@ -34,10 +34,12 @@ extern "C" {
  * @brief Complete memory structure for GC/Wii emulation
  */
 typedef struct GeckoMemory {
-    u8  mem1[GECKO_MEM1_SIZE];          // Main RAM
+    u8* mem1;                            // Main RAM
     u8* mem2;                            // External RAM (Wii only)
     u8* aram;                            // Audio RAM
-    u8  locked_cache[GECKO_LOCKED_CACHE_SIZE]; // Scratchpad
+    u8* locked_cache;                    // Scratchpad
+    u8* fastmem;                         // Guest address 0 in the fastmem view, or NULL
+    u32 flags;                           // GECKO_MEMORY_* given to GeckoMemoryInitEx
     
     BOOL is_wii;
     BOOL mem2_enabled;
@@ -45,24 +47,93 @@ typedef struct GeckoMemory {
     BOOL locked_cache_enabled;
 } GeckoMemory;
 
-/* Initialize memory structure */
+/**
+ * @brief Resident (physically backed) bytes per region
+ */
+typedef struct GeckoMemoryUsage {
+    u32 mem1Resident;
+    u32 mem2Resident;
+    u32 aramResident;
+    u32 lockedCacheResident;
+} GeckoMemoryUsage;
+
+/* GeckoMemoryInitEx flags */
+#define GECKO_MEMORY_HUGE_PAGES 0x1     // Ask for transparent huge pages (Linux)
+
+/* Initialize memory structure. Regions are committed on first touch and
+   read as zero until written. */
 void  GeckoMemoryInit(GeckoMemory* mem, BOOL is_wii);
+void  GeckoMemoryInitEx(GeckoMemory* mem, BOOL is_wii, u32 flags);
 void  GeckoMemoryFree(GeckoMemory* mem);
 void  GeckoMemoryAllocARAM(GeckoMemory* mem);
+void  GeckoMemoryGetUsage(const GeckoMemory* mem, GeckoMemoryUsage* usage);
 
 /* Address translation */
 u32   GeckoTranslateAddress(u32 vaddr);
 BOOL  GeckoIsLockedCacheAddress(u32 addr);
 
-/* Memory access (big-endian) */
+/* Memory access (big-endian). Unaligned accesses are allowed; an access
+   that crosses out of its region reads/writes byte by byte (unmapped
+   bytes read as 0xFF). */
 u8    GeckoRead8(const GeckoMemory* mem, u32 vaddr);
 u16   GeckoRead16(const GeckoMemory* mem, u32 vaddr);
 u32   GeckoRead32(const GeckoMemory* mem, u32 vaddr);
+u64   GeckoRead64(const GeckoMemory* mem, u32 vaddr);
 void  GeckoWrite8(GeckoMemory* mem, u32 vaddr, u8 value);
 void  GeckoWrite16(GeckoMemory* mem, u32 vaddr, u16 value);
 void  GeckoWrite32(GeckoMemory* mem, u32 vaddr, u32 value);
+void  GeckoWrite64(GeckoMemory* mem, u32 vaddr, u64 value);
+
+/* Block copy between guest and host memory, converting each element of
+   'width' bytes (1, 2, 4 or 8; 1 copies as-is) between big-endian guest
+   and host order. size must be a multiple of width. */
+BOOL  GeckoReadBlock(const GeckoMemory* mem, void* dst, u32 vaddr, u32 size, u32 width);
+BOOL  GeckoWriteBlock(GeckoMemory* mem, u32 vaddr, const void* src, u32 size, u32 width);
 void* GeckoGetPointer(GeckoMemory* mem, u32 vaddr);
 
+/* Fastmem (Linux, 64-bit hosts): the whole 32-bit guest space is mirrored
+   in host address space, so translation is fastmem + vaddr. Stores go
+   through a second view GECKO_FASTMEM_STORE_VIEW bytes higher, where
+   unmapped pages discard writes (loads from them read 0xFF). Contents
+   are kept across enable/disable. One GeckoMemory at a time. */
+#define GECKO_FASTMEM_STORE_VIEW 0x100000000ull
+
+BOOL  GeckoMemoryEnableFastmem(GeckoMemory* mem);
+void  GeckoMemoryDisableFastmem(GeckoMemory* mem);
+
+/* Savestates: snapshots of MEM1, MEM2, ARAM, the locked cache and SRAM,
+   the last 'depth' of them kept for rewind. After the first, a snapshot
+   copies only the pages written since the previous one. On Linux writes
+   are found by write-protecting the regions and the copy runs on a
+   worker thread, copy-on-write; elsewhere pages are compared on the
+   calling thread. Needs fastmem off. One savestate at a time. */
+typedef struct GeckoSavestate GeckoSavestate;
+
+typedef struct GeckoSavestateStats {
+    u32  snapshots;                      // Snapshots held
+    u32  pageSize;                       // Tracking granule
+    u32  lastPages;                      // Pages copied by the latest snapshot
+    u32  cowPages;                       // Pages copied by a writing thread, total
+    u32  lastTakeUs;                     // Time in the latest GeckoSavestateTake
+    u64  storedBytes;                    // Page data held by all snapshots
+    BOOL tracking;                       // Write protection (else page compare)
+} GeckoSavestateStats;
+
+GeckoSavestate* GeckoSavestateCreate(GeckoMemory* mem, u32 depth);
+void  GeckoSavestateDestroy(GeckoSavestate* ss);
+BOOL  GeckoSavestateTake(GeckoSavestate* ss);
+BOOL  GeckoSavestateRestore(GeckoSavestate* ss, u32 age);   // 0 = latest; newer ones are dropped
+void  GeckoSavestateWait(GeckoSavestate* ss);
+BOOL  GeckoSavestateSave(GeckoSavestate* ss, u32 age, const char* path);
+BOOL  GeckoSavestateLoad(GeckoSavestate* ss, const char* path);
+void  GeckoSavestateGetStats(const GeckoSavestate* ss, GeckoSavestateStats* stats);
+
+/* Bracket a system call (read, fread) that writes into emulated memory:
+   the kernel fails on protected pages instead of faulting. Snapshots
+   wait for the call to end rather than protect its pages again. */
+void  GeckoSavestatePrepareWrite(void* addr, u32 size);
+void  GeckoSavestateEndWrite(void);
+
 /* Global memory instance (when full emulation is enabled) */
 #ifdef PORPOISE_USE_GECKO_MEMORY
 extern GeckoMemory* g_geckoMemory;
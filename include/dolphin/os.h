@@ -15,6 +15,9 @@
 #include "dolphin/os/OSFont.h"
 #include "dolphin/os/OSInterrupt.h"
 #include "dolphin/os/OSMemory.h"
+#include "dolphin/os/OSMemCopy.h"
+#include "dolphin/os/OSByteSwap.h"
+#include "dolphin/os/OSSharedMemory.h"
 #include "dolphin/os/OSReset.h"
 #include "dolphin/os/OSResetSW.h"
 #include "dolphin/os/OSRtc.h"
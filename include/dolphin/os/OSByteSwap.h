@@ -0,0 +1,38 @@
+#ifndef DOLPHIN_OSBYTESWAP_H
+#define DOLPHIN_OSBYTESWAP_H
+
+#include <dolphin/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    Bulk Byte Swap (PC extension)
+    
+    Converts arrays of big-endian 16/32/64-bit values (disc assets, guest
+    memory) to host order and back. dst may equal src for an in-place
+    swap; other overlaps are not allowed. No alignment is required.
+ *---------------------------------------------------------------------------*/
+
+#define OS_SWAP_KERNEL_SCALAR   0
+#define OS_SWAP_KERNEL_SSSE3    1   /* pshufb, 16 bytes per step */
+#define OS_SWAP_KERNEL_AVX2     2   /* vpshufb, 32 bytes per step */
+#define OS_SWAP_KERNEL_NEON     3   /* rev16/rev32/rev64 */
+
+/* count is in elements, not bytes */
+void OSSwapBytes16(void* dst, const void* src, u32 count);
+void OSSwapBytes32(void* dst, const void* src, u32 count);
+void OSSwapBytes64(void* dst, const void* src, u32 count);
+
+/* Kernel selection (best supported kernel by default) */
+u32         OSGetSwapKernel(void);
+BOOL        OSSetSwapKernel(u32 kernel);
+BOOL        OSIsSwapKernelSupported(u32 kernel);
+const char* OSGetSwapKernelName(u32 kernel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DOLPHIN_OSBYTESWAP_H */
@@ -28,6 +28,19 @@ void DCBlockStore       (void* addr);
 void DCBlockFlush       (void* addr);
 void DCBlockInvalidate  (void* addr);
 
+/* Host primitives behind the DC* calls (PC extension) */
+#define OS_CACHE_PRIM_PREFETCH      0x01    /* DCTouchRange: prefetcht0 / prfm */
+#define OS_CACHE_PRIM_STREAM_ZERO   0x02    /* DCZeroRange: movntdq (large ranges) */
+#define OS_CACHE_PRIM_DC_ZVA        0x04    /* DCZeroRange: dc zva */
+#define OS_CACHE_PRIM_CLFLUSH       0x08    /* DCStore/FlushRange on shared memory */
+#define OS_CACHE_PRIM_CLFLUSHOPT    0x10
+#define OS_CACHE_PRIM_CLWB          0x20
+#define OS_CACHE_PRIM_DC_CVAC       0x40    /* dc cvac / dc civac */
+
+u32  OSGetCachePrimitives   (void);
+u32  OSSetCachePrimitives   (u32 mask);     /* Returns the bits in effect */
+u32  OSGetHostCacheLineSize (void);
+
 /* L1 Instruction Cache Operations */
 void ICInvalidateRange  (void* addr, u32 nBytes);
 void ICSync             (void);
@@ -0,0 +1,43 @@
+#ifndef DOLPHIN_OSMEMCOPY_H
+#define DOLPHIN_OSMEMCOPY_H
+
+#include <dolphin/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    Bulk Copy Engine (PC extension)
+    
+    Used for simulated DMA (ARStartDMA, ARQ, locked cache). Transfers at or
+    above the streaming threshold use non-temporal stores so multi-megabyte
+    uploads do not evict the game thread's working set.
+ *---------------------------------------------------------------------------*/
+
+#define OS_COPY_KERNEL_SCALAR   0   /* memcpy */
+#define OS_COPY_KERNEL_SSE2     1
+#define OS_COPY_KERNEL_AVX2     2
+#define OS_COPY_KERNEL_AVX512   3
+
+/* Copy with cached or streaming stores chosen by size */
+void OSCopyMemory(void* dst, const void* src, u32 size);
+
+/* Copy one piece of a larger transfer; transferSize picks the store type */
+void OSCopyMemoryPart(void* dst, const void* src, u32 size, u32 transferSize);
+
+/* Kernel selection (best supported kernel by default) */
+u32         OSGetCopyKernel(void);
+BOOL        OSSetCopyKernel(u32 kernel);
+BOOL        OSIsCopyKernelSupported(u32 kernel);
+const char* OSGetCopyKernelName(u32 kernel);
+
+/* Transfers of at least this many bytes use streaming stores */
+u32  OSGetCopyStreamThreshold(void);
+void OSSetCopyStreamThreshold(u32 bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DOLPHIN_OSMEMCOPY_H */
@@ -33,8 +33,23 @@ u32 OSGetConsoleSimulatedMem2Size(void);
 #define OS_PROTECT3_BIT             0x00000008
 #define OS_PROTECT_ADDRERR_BIT      0x00000010
 
+/* control is the access still permitted; RDWR turns the channel off */
 void OSProtectRange(u32 chan, void* addr, u32 nBytes, u32 control);
 
+/* Watchpoint statistics (PC extension). On Linux x86-64 the channels are
+   enforced with page protection; see OSMemory.c. */
+typedef struct OSProtectFault {
+    void* addr;         /* Data address of the access */
+    void* pc;           /* Host instruction that made it */
+    u32   cause;        /* OS_PROTECTn_BIT */
+    BOOL  write;
+} OSProtectFault;
+
+u32  OSGetProtectFaultCount(u32 chan);
+BOOL OSGetLastProtectFault(u32 chan, OSProtectFault* fault);
+u32  OSGetProtectPageFaultCount(void);
+void OSResetProtectStats(void);
+
 #ifdef __cplusplus
 }
 #endif
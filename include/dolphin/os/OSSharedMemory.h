@@ -0,0 +1,60 @@
+#ifndef DOLPHIN_OSSHAREDMEMORY_H
+#define DOLPHIN_OSSHAREDMEMORY_H
+
+#include <dolphin/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    Shared Memory (PC extension)
+    
+    Backs ARAM, and optionally MEM1/MEM2, with a named shared memory object
+    so another local process (e.g. a real-time audio mixer) can map the
+    same pages and read sample data without copies. Two lock-free message
+    rings connect the processes: the creator's messages are commands, the
+    attached process's messages are notifications.
+    
+    Game:   OSCreateSharedMemory("porpoise", OS_SHARED_ARAM) before ARInit
+            (and before OSInit for OS_SHARED_MEM1/MEM2).
+    Mixer:  OSAttachSharedMemory("porpoise"), then OSGetSharedRegion.
+ *---------------------------------------------------------------------------*/
+
+#define OS_SHARED_MEM1          0x1
+#define OS_SHARED_MEM2          0x2
+#define OS_SHARED_ARAM          0x4
+
+#define OS_SHARED_RING_ENTRIES  256     /* Messages per direction */
+
+/* One message; type and arguments are defined by the two processes */
+typedef struct OSSharedMessage {
+    u32 type;
+    u32 arg[7];
+} OSSharedMessage;
+
+/* Create the object and the requested regions (zero-filled) */
+BOOL  OSCreateSharedMemory(const char* name, u32 regions);
+
+/* Map an object created by another process */
+BOOL  OSAttachSharedMemory(const char* name);
+
+/* Unmap (the creator also removes the name) */
+void  OSDetachSharedMemory(void);
+
+/* Region base in this process, or NULL if not shared */
+void* OSGetSharedRegion(u32 region, u32* size);
+
+/* Creator: another process has attached. Attached process: the creator
+   has not detached yet. */
+BOOL  OSIsSharedPeerAttached(void);
+
+/* Non-blocking; FALSE if the ring is full / empty */
+BOOL  OSSendSharedMessage(const OSSharedMessage* msg);
+BOOL  OSReceiveSharedMessage(OSSharedMessage* msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DOLPHIN_OSSHAREDMEMORY_H */
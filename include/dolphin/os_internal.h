@@ -0,0 +1,86 @@
+/**
+ * @file os_internal.h
+ * @brief Internal OS definitions
+ *
+ * Shared between the OS implementation files and the subsystems that
+ * map named shared memory of their own (PAD virtual controllers).
+ * Not part of public API.
+ */
+
+#ifndef DOLPHIN_OS_INTERNAL_H
+#define DOLPHIN_OS_INTERNAL_H
+
+#include <dolphin/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    Simulated Memory (OS.c)
+ *---------------------------------------------------------------------------*/
+
+#define SIMULATED_MEM1_SIZE (24 * 1024 * 1024)  // 24 MB like GameCube/Wii
+#define SIMULATED_MEM2_SIZE (64 * 1024 * 1024)  // 64 MB like Wii
+
+/*---------------------------------------------------------------------------*
+    Named Shared Memory (OSSharedMemory.c)
+ *---------------------------------------------------------------------------*/
+
+// One mapped object: POSIX shm_open on Linux/macOS, a named file
+// mapping on Windows
+typedef struct __OSNamedMemory {
+    void*   base;               // NULL when not mapped
+    u32     size;               // Bytes mapped
+    BOOL    creator;            // Created by this process
+    void*   mapping;            // Windows file mapping handle
+    char    name[64];           // "/name" or "Local\name"
+} __OSNamedMemory;
+
+// Create a zero-filled object of size bytes. An object left under the
+// name is replaced: POSIX unlinks it; on Windows (where it is still open
+// in another process) it is reused and cleared, if large enough.
+BOOL __OSCreateNamedMemory(__OSNamedMemory* mem, const char* name, u32 size);
+
+// Map a whole object created by another process; mem->size is its size
+BOOL __OSOpenNamedMemory(__OSNamedMemory* mem, const char* name);
+
+// Unmap; the creator also removes the name
+void __OSCloseNamedMemory(__OSNamedMemory* mem);
+
+/*---------------------------------------------------------------------------*
+    Memory Protection (OSMemory.c)
+ *---------------------------------------------------------------------------*/
+
+// TRUE if an OSProtectRange watchpoint protects any page of
+// [addr, addr+size). Savestate tracking refuses such regions.
+BOOL __OSIsRangeWatched(const void* addr, u32 size);
+
+/*---------------------------------------------------------------------------*
+    Savestate Write Tracking (GeckoSavestate.c)
+ *---------------------------------------------------------------------------*/
+
+// TRUE if savestate tracking write-protects any page of [addr, addr+size).
+// OSProtectRange watchpoints mprotect the same pages, so they refuse
+// such ranges rather than undo each other's protection.
+BOOL __GeckoSavestateIsTracked(const void* addr, u32 size);
+
+/*---------------------------------------------------------------------------*
+    x86 Feature Detection (OSMemCopy.c)
+ *---------------------------------------------------------------------------*/
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+// CPUID leaf/subleaf; regs receives EAX, EBX, ECX, EDX
+void __OSCPUID(u32 leaf, u32 subleaf, u32 regs[4]);
+
+// Register state the OS saves (check CPUID.1:ECX.OSXSAVE first)
+u64  __OSReadXCR0(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOLPHIN_OS_INTERNAL_H
@@ -14,6 +14,7 @@ extern "C" {
 #endif
 
 #include <dolphin/types.h>
+#include <dolphin/os/OSTime.h>
 
 /*---------------------------------------------------------------------------*
     Constants
@@ -78,6 +79,10 @@ extern "C" {
 #define PAD_TRIGGER_FIXED_BASE              4
 #define PAD_TRIGGER_OPEN_BASE               5
 
+// Channel input sources (PC extension)
+#define PAD_SOURCE_DEFAULT     0  // SDL gamepad (keyboard fallback on channel 0)
+#define PAD_SOURCE_VIRTUAL     1  // Frames from a test harness (PADOpenVirtual*)
+
 /*---------------------------------------------------------------------------*
     Types
  *---------------------------------------------------------------------------*/
@@ -106,6 +111,90 @@ typedef struct PADStatus
  */
 typedef void (*PADSamplingCallback)(void);
 
+/**
+ * @brief Percentiles of one latency measure, in microseconds (PC extension)
+ */
+typedef struct PADLatencyPercentiles
+{
+    u32 count;            ///< Measurements in the window
+    u32 mean;
+    u32 p50;
+    u32 p90;
+    u32 p99;
+    u32 max;
+} PADLatencyPercentiles;
+
+/**
+ * @brief Input latency statistics (PC extension)
+ * 
+ * An input event is a button change or a stick/trigger move, timed when
+ * the sampling thread first sees it. Each measure covers the most recent
+ * PAD_LATENCY_WINDOW measurements.
+ */
+typedef struct PADLatencyStats
+{
+    PADLatencyPercentiles inputAge;       ///< Sample age when PADRead returns it
+    PADLatencyPercentiles eventToRead;    ///< Event to the first PADRead returning it
+    PADLatencyPercentiles eventToFlush;   ///< Event to the VIFlush of that frame
+    u32 frames;                           ///< VIFlush calls while tracking
+} PADLatencyStats;
+
+#define PAD_LATENCY_WINDOW     4096
+
+/**
+ * @brief Input trace recording/replay state (PC extension)
+ */
+typedef struct PADTraceInfo
+{
+    BOOL recording;
+    BOOL replaying;
+    BOOL ended;           ///< Replay has returned its last record
+    u32  reads;           ///< PADRead results recorded or replayed
+    u32  retrace;         ///< VI retrace count of the latest one
+} PADTraceInfo;
+
+/**
+ * @brief One virtual controller frame (PC extension)
+ * 
+ * Written by a test harness, over the socket or the shared-memory ring.
+ * The status is returned by PADRead as is, err included.
+ */
+typedef struct PADVirtualFrame
+{
+    u32       chan;       ///< PAD_CHANn
+    PADStatus status;
+} PADVirtualFrame;
+
+#define PAD_VIRTUAL_MAGIC          0x50414456  // 'PADV'
+#define PAD_VIRTUAL_VERSION        1
+#define PAD_VIRTUAL_RING_ENTRIES   64          // Power of 2
+
+/**
+ * @brief Ring slot; seq is the frame's index + 1, stored after the frame
+ */
+typedef struct PADVirtualSlot
+{
+    volatile u32    seq;
+    PADVirtualFrame frame;
+} PADVirtualSlot;
+
+/**
+ * @brief Shared-memory ring created by PADOpenVirtualRing (PC extension)
+ * 
+ * One writer (the harness) fills slots[head % PAD_VIRTUAL_RING_ENTRIES]:
+ * seq = 0, the frame, seq = head + 1, then head + 1, each store a
+ * release. The PAD layer reads it without system calls.
+ */
+typedef struct PADVirtualRing
+{
+    u32            magic;
+    u32            version;
+    u32            entries;
+    volatile u32   head;      ///< Frames written
+    u8             pad[48];
+    PADVirtualSlot slots[PAD_VIRTUAL_RING_ENTRIES];
+} PADVirtualRing;
+
 /*---------------------------------------------------------------------------*
     Functions
  *---------------------------------------------------------------------------*/
@@ -142,14 +231,23 @@ BOOL PADRecalibrate(u32 mask);
 /**
  * @brief Read controller status for all channels
  * 
- * Fills in the status array with current controller state.
- * Should be called once per frame.
+ * Fills in the status array with the latest sample taken by the
+ * sampling thread. Should be called once per frame.
  * 
  * @param status Array of PAD_MAX_CONTROLLERS PADStatus structures to fill
  * @return Bit mask of controllers that support rumble (PAD_CHANn_BIT)
  */
 u32 PADRead(PADStatus* status);
 
+/**
+ * @brief Read controller status and when it was sampled (PC extension)
+ * 
+ * @param status Array of PAD_MAX_CONTROLLERS PADStatus structures to fill
+ * @param sampleTime Receives the OSGetTime() of the sample (may be NULL)
+ * @return Bit mask of controllers that support rumble (PAD_CHANn_BIT)
+ */
+u32 PADReadEx(PADStatus* status, OSTime* sampleTime);
+
 /**
  * @brief Control rumble motor for a single controller
  * 
@@ -206,6 +304,52 @@ void PADClampCircle2(PADStatus* status, u32 type);
  */
 void PADClampTrigger(PADStatus* status, u32 type);
 
+/**
+ * @brief PADClamp for an array of any length (PC extension)
+ * 
+ * Clamps four statuses per SSE2/NEON pass, bit-identical to PADClamp.
+ * For recorded inputs and simulation, where thousands are clamped.
+ * 
+ * @param status Array of PADStatus structures
+ * @param count Number of structures
+ */
+void PADClampBatch(PADStatus* status, u32 count);
+
+/**
+ * @brief PADClampCircle for an array of any length (PC extension)
+ * 
+ * @param status Array of PADStatus structures
+ * @param count Number of structures
+ */
+void PADClampCircleBatch(PADStatus* status, u32 count);
+
+/**
+ * @brief PADClamp2 for an array of any length (PC extension)
+ * 
+ * @param status Array of PADStatus structures
+ * @param count Number of structures
+ * @param type Clamp type (PAD_STICK_CLAMP_OCTA_*)
+ */
+void PADClamp2Batch(PADStatus* status, u32 count, u32 type);
+
+/**
+ * @brief PADClampCircle2 for an array of any length (PC extension)
+ * 
+ * @param status Array of PADStatus structures
+ * @param count Number of structures
+ * @param type Clamp type (PAD_STICK_CLAMP_CIRCLE_*)
+ */
+void PADClampCircle2Batch(PADStatus* status, u32 count, u32 type);
+
+/**
+ * @brief PADClampTrigger for an array of any length (PC extension)
+ * 
+ * @param status Array of PADStatus structures
+ * @param count Number of structures
+ * @param type Clamp type (PAD_TRIGGER_*)
+ */
+void PADClampTriggerBatch(PADStatus* status, u32 count, u32 type);
+
 /**
  * @brief Get controller type information
  * 
@@ -233,12 +377,12 @@ BOOL PADSync(void);
 void PADSetAnalogMode(u32 mode);
 
 /**
- * @brief Set sampling rate (obsolete, for compatibility)
+ * @brief Set sampling rate
  * 
- * On PC, sampling is tied to frame rate via PADRead().
- * This function exists for API compatibility but has no effect.
+ * On PC, sets how often the sampling thread polls the controllers.
+ * 0 samples once per field; the default is 1 ms.
  * 
- * @param msec Desired sampling rate in milliseconds (ignored)
+ * @param msec Sampling period in milliseconds (0-11)
  */
 void PADSetSamplingRate(u32 msec);
 
@@ -246,13 +390,130 @@ void PADSetSamplingRate(u32 msec);
  * @brief Set sampling callback
  * 
  * Installs a callback function that is called when controller
- * data is sampled. Pass NULL to remove callback.
+ * data is sampled. On PC it runs on the sampling thread.
+ * Pass NULL to remove callback.
  * 
  * @param callback Callback function pointer
  * @return Previous callback function
  */
 PADSamplingCallback PADSetSamplingCallback(PADSamplingCallback callback);
 
+/**
+ * @brief Turn input latency tracking on or off (PC extension)
+ * 
+ * Off by default. Turning it on clears the statistics.
+ * 
+ * @param enable TRUE to track
+ */
+void PADSetLatencyTracking(BOOL enable);
+
+/**
+ * @brief Get input latency percentiles (PC extension)
+ * 
+ * @param stats Receives the statistics
+ */
+void PADGetLatencyStats(PADLatencyStats* stats);
+
+/**
+ * @brief Log input latency per frame to a CSV file (PC extension)
+ * 
+ * Writes one row per VIFlush and turns tracking on. NULL closes the log.
+ * 
+ * @param path File to create, or NULL
+ * @return TRUE if the file was opened
+ */
+BOOL PADSetLatencyLog(const char* path);
+
+/**
+ * @brief Record every PADRead result to a file (PC extension)
+ * 
+ * Stores all four channels, the rumble mask and the VI retrace count,
+ * delta-encoded (about 1 byte per idle frame).
+ * 
+ * @param path File to create
+ * @return TRUE if recording started
+ */
+BOOL PADStartRecording(const char* path);
+
+/**
+ * @brief Stop recording and close the file (PC extension)
+ */
+void PADStopRecording(void);
+
+/**
+ * @brief Replay a recorded file through PADRead (PC extension)
+ * 
+ * The Nth PADRead returns the Nth recorded result; after the last one
+ * all channels read PAD_ERR_NO_CONTROLLER. Called before PADInit, no
+ * SDL is used at all.
+ * 
+ * @param path Recorded file
+ * @return TRUE if the file was loaded
+ */
+BOOL PADStartReplay(const char* path);
+
+/**
+ * @brief Stop replaying and go back to the controllers (PC extension)
+ */
+void PADStopReplay(void);
+
+/**
+ * @brief Get recording/replay state (PC extension)
+ * 
+ * @param info Receives the state
+ */
+void PADGetTraceInfo(PADTraceInfo* info);
+
+/**
+ * @brief Select where a channel's input comes from (PC extension)
+ * 
+ * PAD_SOURCE_VIRTUAL channels read the latest frame a test harness sent
+ * for them (PAD_ERR_NO_CONTROLLER until the first one) and never touch
+ * SDL. Also set by [Virtual] channels= in pad_config.ini.
+ * 
+ * @param chan Channel number (PAD_CHANn)
+ * @param source PAD_SOURCE_DEFAULT or PAD_SOURCE_VIRTUAL
+ */
+void PADSetChannelSource(s32 chan, u32 source);
+
+/**
+ * @brief Get a channel's input source (PC extension)
+ * 
+ * @param chan Channel number (PAD_CHANn)
+ * @return PAD_SOURCE_DEFAULT or PAD_SOURCE_VIRTUAL
+ */
+u32 PADGetChannelSource(s32 chan);
+
+/**
+ * @brief Receive virtual controller frames on a Unix-domain socket (PC extension)
+ * 
+ * Binds a datagram socket at path (replacing a stale one). Each datagram
+ * holds one or more PADVirtualFrame. A receiver thread waits on the
+ * socket, so PADRead makes no system calls. Not available on Windows.
+ * 
+ * @param path Socket path
+ * @return TRUE if the socket is bound
+ */
+BOOL PADOpenVirtualSocket(const char* path);
+
+/**
+ * @brief Receive virtual controller frames through shared memory (PC extension)
+ * 
+ * Creates a named PADVirtualRing for the harness to map and write. The
+ * sampling thread drains it; no thread, no system calls.
+ * 
+ * @param name Shared memory name (e.g. "porpoise_pad")
+ * @return TRUE if the ring was created
+ */
+BOOL PADOpenVirtualRing(const char* name);
+
+/**
+ * @brief Close the virtual controller socket or ring (PC extension)
+ * 
+ * Virtual channels read PAD_ERR_NO_CONTROLLER afterwards.
+ */
+void PADCloseVirtual(void);
+
 #ifdef __cplusplus
 }
 #endif
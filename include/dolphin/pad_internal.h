@@ -0,0 +1,95 @@
+/**
+ * @file pad_internal.h
+ * @brief Internal PAD definitions
+ * 
+ * Shared between the PAD implementation files and VI, which reports
+ * frame flushes for the latency statistics.
+ * Not part of public API.
+ */
+
+#ifndef DOLPHIN_PAD_INTERNAL_H
+#define DOLPHIN_PAD_INTERNAL_H
+
+#include <dolphin/pad.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*---------------------------------------------------------------------------*
+    Locks (PAD.c)
+ *---------------------------------------------------------------------------*/
+
+// Guards PAD state that several threads reach (OSDisableInterrupts does
+// not exclude other threads): a CRITICAL_SECTION set up on first use on
+// Windows, a pthread mutex elsewhere. Define with __PAD_MUTEX_INIT.
+typedef struct __PADMutex {
+#ifdef _WIN32
+    volatile u32     state;              // 0 = unused, 1 = initializing, 2 = ready
+    CRITICAL_SECTION section;
+#else
+    pthread_mutex_t  mutex;
+#endif
+} __PADMutex;
+
+#ifdef _WIN32
+#define __PAD_MUTEX_INIT    { 0 }
+#else
+#define __PAD_MUTEX_INIT    { PTHREAD_MUTEX_INITIALIZER }
+#endif
+
+void __PADLock(__PADMutex* mutex);
+void __PADUnlock(__PADMutex* mutex);
+
+/*---------------------------------------------------------------------------*
+    Latency Tracking (PADLatency.c)
+ *---------------------------------------------------------------------------*/
+
+// TRUE while PADSetLatencyTracking is on; callers skip the hooks otherwise
+extern volatile BOOL __PADLatencyTracking;
+
+// PADRead returned a sample taken at sampleTime. eventSeq counts input
+// events so far; eventTime is when the latest one was sampled.
+void __PADLatencyRead(OSTime sampleTime, u32 eventSeq, OSTime eventTime);
+
+// VIFlush presented the frame that the PADRead calls since the last
+// flush belong to
+void __PADLatencyFlush(void);
+
+/*---------------------------------------------------------------------------*
+    Input Traces (PADTrace.c)
+ *---------------------------------------------------------------------------*/
+
+// TRUE while recording or replaying
+extern volatile BOOL __PADRecording;
+extern volatile BOOL __PADReplaying;
+
+// Append a PADRead result to the recording
+void __PADTraceRecord(const PADStatus* status, u32 motor);
+
+// Fill in the next replayed PADRead result; returns its rumble mask
+u32  __PADTraceReplay(PADStatus* status);
+
+// Fill in the latest replayed result again, for reads made by the
+// sampling callback; returns its rumble mask
+u32  __PADTraceLatest(PADStatus* status);
+
+/*---------------------------------------------------------------------------*
+    Virtual Controllers (PADVirtual.c)
+ *---------------------------------------------------------------------------*/
+
+// Fill in the latest harness frame of every channel (PAD_ERR_NO_CONTROLLER
+// for channels without one). Called with the PAD lock held.
+void __PADVirtualRead(PADStatus* status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DOLPHIN_PAD_INTERNAL_H
@@ -16,8 +16,11 @@
   
   On PC (Simulated ARAM):
   -----------------------
-  - Allocate 16MB from regular heap as "ARAM"
-  - DMA operations are just memcpy()
+  - Allocate 16MB from regular heap as "ARAM", or map it from shared
+    memory (OSCreateSharedMemory) so an audio mixer in another process
+    can read samples in place
+  - DMA operations are CPU copies (OSCopyMemory; large ones bypass the
+    cache with streaming stores)
   - No real separation from main RAM
   - Audio data can be in regular memory
   - Instant transfers (no DMA latency)
@@ -33,28 +36,39 @@
   - Same API (ARInit, ARAlloc, ARStartDMA, etc.)
   - 16MB size
   - OS reserved area (16KB)
-  - Allocation/free system
+  - Stack allocation/free system (ARAlloc/ARFree)
   - 32-byte alignment requirements
   
   WHAT'S DIFFERENT:
   - No real hardware - just heap allocation
-  - DMA is instant memcpy (not asynchronous DMA)
+  - DMA is an instant CPU copy (ARQ runs it on a background thread)
   - No DSP integration (PC audio uses different system)
+  - ARAM heaps (ARHeap.c) for blocks freed in any order
  *---------------------------------------------------------------------------*/
 
 #include <dolphin/ar.h>
+#include <dolphin/ar_internal.h>
 #include <dolphin/os.h>
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef PORPOISE_USE_GECKO_MEMORY
+#include <dolphin/gecko_memory.h>
+#endif
+
 /*---------------------------------------------------------------------------*
     Internal State
  *---------------------------------------------------------------------------*/
 
 static BOOL s_initialized = FALSE;
 static void* s_aramBase = NULL;              // Simulated ARAM memory
+static BOOL s_aramShared = FALSE;            // s_aramBase is shared memory
+static BOOL s_aramGecko = FALSE;             // s_aramBase is g_geckoMemory->aram
 static u32 s_aramSize = AR_INTERNAL_SIZE;    // 16MB
 static u32 s_aramAllocated = AR_OS_RESERVED; // Start after OS area
+static u32* s_allocStack = NULL;             // Start of each ARAlloc block
+static u32 s_allocStackSize = 0;
+static u32 s_allocStackDepth = 0;
 static ARCallback s_dmaCallback = NULL;
 static volatile BOOL s_dmaBusy = FALSE;
 
@@ -65,17 +79,17 @@ static volatile BOOL s_dmaBusy = FALSE;
                 heap and sets up allocation tracking.
                 
                 On GC/Wii: Probes ARAM size, sets up DSP registers
-                On PC: Allocates 16MB buffer from heap
+                On PC: Allocates 16MB buffer from heap, or uses the
+                       shared ARAM region if OSCreateSharedMemory made one
 
-  Arguments:    stackIndexAddr  Pointer for allocation stack (can be NULL)
-                numEntries      Number of allocation entries (unused on PC)
+  Arguments:    stackIndexAddr  Allocation stack, one u32 per ARAlloc
+                                block that can be live at once (NULL:
+                                ARFree releases everything)
+                numEntries      Number of entries in stackIndexAddr
 
   Returns:      Base address of user ARAM (after OS reserved area)
  *---------------------------------------------------------------------------*/
 u32 ARInit(u32* stackIndexAddr, u32 numEntries) {
-    (void)stackIndexAddr;
-    (void)numEntries;
-    
     if (s_initialized) {
         return AR_OS_RESERVED;  // Return user base
     }
@@ -83,20 +97,41 @@ u32 ARInit(u32* stackIndexAddr, u32 numEntries) {
     OSReport("AR: Initializing ARAM subsystem...\n");
     
     // Allocate simulated ARAM
-    s_aramBase = malloc(s_aramSize);
+    s_aramBase = OSGetSharedRegion(OS_SHARED_ARAM, NULL);
+    s_aramShared = (s_aramBase != NULL);
+    BOOL zeroed = FALSE;
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    /* Use the emulated ARAM region, so savestates include it */
+    if (!s_aramBase && g_geckoMemory) {
+        /* A region mapped just now reads as zero; clearing it would commit
+           all 16 MB. Mapped before (ARInit after ARReset), it may not. */
+        zeroed = !g_geckoMemory->aram_enabled;
+        GeckoMemoryAllocARAM(g_geckoMemory);
+        s_aramBase = g_geckoMemory->aram;
+        s_aramGecko = (s_aramBase != NULL);
+    }
+#endif
+    if (!s_aramBase) {
+        s_aramBase = malloc(s_aramSize);
+    }
     if (!s_aramBase) {
         OSReport("AR: Failed to allocate ARAM!\n");
         return 0;
     }
     
     // Clear ARAM
-    memset(s_aramBase, 0, s_aramSize);
+    if (!zeroed) {
+        memset(s_aramBase, 0, s_aramSize);
+    }
     
     s_aramAllocated = AR_OS_RESERVED;  // OS uses first 16KB
+    s_allocStack = stackIndexAddr;
+    s_allocStackSize = stackIndexAddr ? numEntries : 0;
+    s_allocStackDepth = 0;
     s_initialized = TRUE;
     
-    OSReport("AR: ARAM initialized - %u bytes (%u MB)\n", 
-             s_aramSize, s_aramSize / (1024 * 1024));
+    OSReport("AR: ARAM initialized - %u bytes (%u MB)%s\n", 
+             s_aramSize, s_aramSize / (1024 * 1024), s_aramShared ? " in shared memory" : "");
     OSReport("AR: User base address: 0x%08X\n", AR_OS_RESERVED);
     
     return AR_OS_RESERVED;
@@ -112,13 +147,20 @@ u32 ARInit(u32* stackIndexAddr, u32 numEntries) {
   Returns:      None
  *---------------------------------------------------------------------------*/
 void ARReset(void) {
-    if (s_aramBase) {
+    __ARResetHeaps();
+    
+    if (s_aramBase && !s_aramShared && !s_aramGecko) {
         free(s_aramBase);
-        s_aramBase = NULL;
     }
+    s_aramBase = NULL;
+    s_aramShared = FALSE;
+    s_aramGecko = FALSE;
     
     s_initialized = FALSE;
     s_aramAllocated = AR_OS_RESERVED;
+    s_allocStack = NULL;
+    s_allocStackSize = 0;
+    s_allocStackDepth = 0;
     s_dmaCallback = NULL;
     s_dmaBusy = FALSE;
 }
@@ -179,7 +221,8 @@ BOOL ARCheckInit(void) {
 /*---------------------------------------------------------------------------*
   Name:         ARAlloc
 
-  Description:  Allocate ARAM space. Simple bump allocator.
+  Description:  Allocate ARAM space. Stack allocator: the block's start
+                is pushed on the allocation stack so ARFree can pop it.
                 
                 On GC/Wii: Allocates from ARAM address space
                 On PC: Allocates from simulated ARAM buffer
@@ -201,6 +244,14 @@ u32 ARAlloc(u32 length) {
         return 0xFFFFFFFF;
     }
     
+    if (s_allocStack) {
+        if (s_allocStackDepth == s_allocStackSize) {
+            OSReport("AR: Allocation stack full (%u entries)\n", s_allocStackSize);
+            return 0xFFFFFFFF;
+        }
+        s_allocStack[s_allocStackDepth++] = s_aramAllocated;
+    }
+    
     u32 addr = s_aramAllocated;
     s_aramAllocated += length;
     
@@ -210,8 +261,8 @@ u32 ARAlloc(u32 length) {
 /*---------------------------------------------------------------------------*
   Name:         ARFree
 
-  Description:  Free ARAM space (simple stack-based free).
-                Only frees from top of allocation stack.
+  Description:  Free the most recent ARAlloc block. Without an
+                allocation stack (see ARInit), frees every block.
 
   Arguments:    length  Pointer to receive size freed
 
@@ -223,14 +274,19 @@ u32 ARFree(u32* length) {
         return 0;
     }
     
-    u32 freed = s_aramAllocated - AR_OS_RESERVED;
-    s_aramAllocated = AR_OS_RESERVED;
+    u32 addr = AR_OS_RESERVED;
+    if (s_allocStack && s_allocStackDepth > 0) {
+        addr = s_allocStack[--s_allocStackDepth];
+    }
+    
+    u32 freed = s_aramAllocated - addr;
+    s_aramAllocated = addr;
     
     if (length) {
         *length = freed;
     }
     
-    return AR_OS_RESERVED;
+    return addr;
 }
 
 /*---------------------------------------------------------------------------*
@@ -250,13 +306,95 @@ void ARClear(u32 flag) {
     memset(s_aramBase, 0, s_aramSize);
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         __ARCopy
+
+  Description:  Move data between main RAM and ARAM. Shared by ARStartDMA
+                and the ARQ DMA engine; does not touch the DMA status or
+                call the AR DMA callback.
+
+  Arguments:    type          DMA type (AR_MRAM_TO_ARAM or AR_ARAM_TO_MRAM)
+                mainmemAddr   Main memory address
+                aramAddr      ARAM address
+                length        Bytes to copy now
+                transferSize  Size of the whole transfer (picks cached or
+                              streaming stores, see OSCopyMemoryPart)
+
+  Returns:      TRUE if copied, FALSE if the ARAM range is invalid
+ *---------------------------------------------------------------------------*/
+BOOL __ARCopy(u32 type, u32 mainmemAddr, u32 aramAddr, u32 length, u32 transferSize) {
+    if (!s_initialized || !s_aramBase) {
+        return FALSE;
+    }
+    
+    // Verify ARAM bounds
+    if (aramAddr > s_aramSize || length > s_aramSize - aramAddr) {
+        OSReport("AR: DMA would exceed ARAM bounds!\n");
+        return FALSE;
+    }
+    
+    void* aramPtr = (u8*)s_aramBase + aramAddr;
+    void* mramPtr = (void*)mainmemAddr;
+    
+    if (type == AR_MRAM_TO_ARAM) {
+        // Copy from main RAM to ARAM
+        OSCopyMemoryPart(aramPtr, mramPtr, length, transferSize);
+    } else {
+        // Copy from ARAM to main RAM
+        OSCopyMemoryPart(mramPtr, aramPtr, length, transferSize);
+    }
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __ARMove
+  
+  Description:  Move data inside ARAM (ARAM heap compaction).
+  
+  Arguments:    dstAddr  Destination ARAM address
+                srcAddr  Source ARAM address (may overlap the destination)
+                length   Bytes to move
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __ARMove(u32 dstAddr, u32 srcAddr, u32 length) {
+    if (!s_aramBase || dstAddr > s_aramSize || srcAddr > s_aramSize ||
+        length > s_aramSize - dstAddr || length > s_aramSize - srcAddr) {
+        return;
+    }
+    
+    memmove((u8*)s_aramBase + dstAddr, (u8*)s_aramBase + srcAddr, length);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __ARGetPointer
+  
+  Description:  Translate an ARAM range to a host address (direct disc to
+                ARAM reads).
+  
+  Arguments:    aramAddr  ARAM address
+                length    Bytes that will be accessed
+  
+  Returns:      Host address, or NULL if ARAM is not initialized or the
+                range is out of bounds
+ *---------------------------------------------------------------------------*/
+void* __ARGetPointer(u32 aramAddr, u32 length) {
+    if (!s_initialized || !s_aramBase || aramAddr > s_aramSize ||
+        length > s_aramSize - aramAddr) {
+        return NULL;
+    }
+    
+    return (u8*)s_aramBase + aramAddr;
+}
+
 /*---------------------------------------------------------------------------*
   Name:         ARStartDMA
 
   Description:  Start DMA transfer between ARAM and main RAM.
                 
                 On GC/Wii: Configures DSP DMA registers, starts transfer
-                On PC: Performs immediate memcpy, calls callback
+                On PC: Performs immediate copy, calls callback
 
   Arguments:    type         DMA type (AR_MRAM_TO_ARAM or AR_ARAM_TO_MRAM)
                 mainmemAddr  Main memory address (must be 32-byte aligned)
@@ -276,30 +414,15 @@ void ARStartDMA(u32 type, u32 mainmemAddr, u32 aramAddr, u32 length) {
         return;
     }
     
-    // Verify ARAM bounds
-    if (aramAddr + length > s_aramSize) {
-        OSReport("AR: DMA would exceed ARAM bounds!\n");
-        return;
-    }
-    
     s_dmaBusy = TRUE;
     
-    // Perform DMA (instant memcpy on PC)
-    void* aramPtr = (u8*)s_aramBase + aramAddr;
-    void* mramPtr = (void*)mainmemAddr;
-    
-    if (type == AR_MRAM_TO_ARAM) {
-        // Copy from main RAM to ARAM
-        memcpy(aramPtr, mramPtr, length);
-    } else {
-        // Copy from ARAM to main RAM
-        memcpy(mramPtr, aramPtr, length);
-    }
+    // Perform DMA (instant copy on PC)
+    BOOL copied = __ARCopy(type, mainmemAddr, aramAddr, length, length);
     
     s_dmaBusy = FALSE;
     
     // Call callback if registered
-    if (s_dmaCallback) {
+    if (copied && s_dmaCallback) {
         s_dmaCallback();
     }
 }
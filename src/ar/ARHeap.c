@@ -0,0 +1,815 @@
+/*---------------------------------------------------------------------------*
+  ARHeap.c - ARAM Heap Allocator
+  
+  On GC/Wii: ARAlloc/ARFree are a stack. Games that load and unload
+             sound banks at runtime build their own ARAM managers on top
+             of a region taken from that stack.
+  
+  On PC: This is such a manager, shared by everyone. A heap covers an
+         ARAM range (usually one taken with ARAlloc) and supports freeing
+         any block in any order.
+  
+  DESIGN:
+  - Two-level segregated free lists (TLSF style): the first level is the
+    power of two of the block size, the second splits each power of two
+    into 16 classes. Bitmaps of non-empty lists make both allocation and
+    free O(1).
+  - Block bookkeeping lives in host memory, not in ARAM. ARAM is only
+    reachable by DMA on real hardware, and keeping it free of headers
+    means every byte of a block belongs to the game.
+  - Allocated blocks are found by address through a small hash table.
+  - All blocks are 32-byte aligned and a multiple of 32 bytes (the DMA
+    granularity). Neighbouring free blocks are merged on free.
+  
+  COMPACTION:
+  ARCompactHeap slides allocated blocks down to close the gaps between
+  them. The owner of each block is asked first through a relocation
+  callback; returning FALSE pins the block (e.g. while a DMA or a voice
+  is still using it). The data is moved inside ARAM and the block's
+  address changes to the one passed to the callback.
+  
+  All heap functions are thread-safe (one lock for all ARAM heaps).
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/ar.h>
+#include <dolphin/ar_internal.h>
+#include <dolphin/os.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <pthread.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Constants
+ *---------------------------------------------------------------------------*/
+
+#define HEAP_ALIGN      32
+#define SL_LOG2         4                   // 16 classes per power of two
+#define SL_COUNT        (1 << SL_LOG2)
+#define FL_COUNT        25                  // Enough for 4 GB in 32-byte units
+#define NIL             0xFFFFFFFF
+
+/*---------------------------------------------------------------------------*
+    Types
+ *---------------------------------------------------------------------------*/
+
+typedef struct HeapBlock {
+    u32  addr;          // ARAM address
+    u32  size;          // Bytes (multiple of HEAP_ALIGN)
+    u32  prevPhys;      // Neighbours in address order
+    u32  nextPhys;
+    u32  prevFree;      // Free list links (free blocks only)
+    u32  nextFree;
+    u32  hashNext;      // Address hash chain (used blocks), or spare list
+    BOOL free;
+} HeapBlock;
+
+typedef struct HeapDesc {
+    BOOL       active;
+    u32        start;
+    u32        end;
+    u32        first;               // Block at start (address order head)
+    
+    HeapBlock* blocks;              // Descriptor pool (indices, may move)
+    u32        numBlocks;           // Descriptors ever created
+    u32        capBlocks;
+    u32        spare;               // Unused descriptors
+    
+    u32*       hash;                // Used blocks by address
+    u32        hashMask;
+    
+    u32        flBitmap;
+    u32        slBitmap[FL_COUNT];
+    u32        freeLists[FL_COUNT][SL_COUNT];
+    
+    u32        freeBytes;
+    u32        numFree;
+    u32        numUsed;
+} HeapDesc;
+
+/*---------------------------------------------------------------------------*
+    Internal State
+ *---------------------------------------------------------------------------*/
+
+static HeapDesc s_heaps[AR_MAX_HEAPS];
+
+#ifdef _WIN32
+static CRITICAL_SECTION s_heapLock;
+static BOOL s_lockInit = FALSE;
+#else
+static pthread_mutex_t s_heapLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void LockHeaps(void) {
+#ifdef _WIN32
+    if (!s_lockInit) {
+        InitializeCriticalSection(&s_heapLock);
+        s_lockInit = TRUE;
+    }
+    EnterCriticalSection(&s_heapLock);
+#else
+    pthread_mutex_lock(&s_heapLock);
+#endif
+}
+
+static void UnlockHeaps(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_heapLock);
+#else
+    pthread_mutex_unlock(&s_heapLock);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+    Bit Helpers
+ *---------------------------------------------------------------------------*/
+
+static u32 HighBit(u32 x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, x);
+    return (u32)index;
+#else
+    return 31 - (u32)__builtin_clz(x);
+#endif
+}
+
+static u32 LowBit(u32 x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (u32)index;
+#else
+    return (u32)__builtin_ctz(x);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         MapClass
+  
+  Description:  Size class of a block. Sizes below 16 units map one class
+                per unit; above that, 16 classes per power of two.
+  
+  Arguments:    size  Block size in bytes
+                fl    Receives first-level index
+                sl    Receives second-level index
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void MapClass(u32 size, u32* fl, u32* sl) {
+    u32 units = size / HEAP_ALIGN;
+    
+    if (units < SL_COUNT) {
+        *fl = 0;
+        *sl = units;
+    } else {
+        u32 log2 = HighBit(units);
+        *fl = log2 - (SL_LOG2 - 1);
+        *sl = (units >> (log2 - SL_LOG2)) - SL_COUNT;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+    Block Descriptors
+ *---------------------------------------------------------------------------*/
+
+/* Make room for 'count' more descriptors than ever created (not counting
+   spares), so that many NewBlock calls cannot fail */
+static BOOL ReserveBlocks(HeapDesc* hd, u32 count) {
+    if (hd->capBlocks - hd->numBlocks >= count) {
+        return TRUE;
+    }
+    
+    u32 cap = hd->capBlocks ? hd->capBlocks * 2 : 64;
+    while (cap - hd->numBlocks < count) {
+        cap *= 2;
+    }
+    HeapBlock* blocks = (HeapBlock*)realloc(hd->blocks, cap * sizeof(HeapBlock));
+    if (!blocks) {
+        return FALSE;
+    }
+    hd->blocks = blocks;
+    hd->capBlocks = cap;
+    return TRUE;
+}
+
+static u32 NewBlock(HeapDesc* hd) {
+    if (hd->spare != NIL) {
+        u32 index = hd->spare;
+        hd->spare = hd->blocks[index].hashNext;
+        return index;
+    }
+    
+    if (!ReserveBlocks(hd, 1)) {
+        return NIL;
+    }
+    return hd->numBlocks++;
+}
+
+static void ReleaseBlock(HeapDesc* hd, u32 index) {
+    hd->blocks[index].hashNext = hd->spare;
+    hd->spare = index;
+}
+
+static void InsertFree(HeapDesc* hd, u32 index) {
+    HeapBlock* b = &hd->blocks[index];
+    u32 fl, sl;
+    
+    MapClass(b->size, &fl, &sl);
+    b->free = TRUE;
+    b->prevFree = NIL;
+    b->nextFree = hd->freeLists[fl][sl];
+    if (b->nextFree != NIL) {
+        hd->blocks[b->nextFree].prevFree = index;
+    }
+    hd->freeLists[fl][sl] = index;
+    hd->flBitmap |= 1u << fl;
+    hd->slBitmap[fl] |= 1u << sl;
+    
+    hd->freeBytes += b->size;
+    hd->numFree++;
+}
+
+static void RemoveFree(HeapDesc* hd, u32 index) {
+    HeapBlock* b = &hd->blocks[index];
+    u32 fl, sl;
+    
+    MapClass(b->size, &fl, &sl);
+    if (b->prevFree != NIL) {
+        hd->blocks[b->prevFree].nextFree = b->nextFree;
+    } else {
+        hd->freeLists[fl][sl] = b->nextFree;
+        if (b->nextFree == NIL) {
+            hd->slBitmap[fl] &= ~(1u << sl);
+            if (hd->slBitmap[fl] == 0) {
+                hd->flBitmap &= ~(1u << fl);
+            }
+        }
+    }
+    if (b->nextFree != NIL) {
+        hd->blocks[b->nextFree].prevFree = b->prevFree;
+    }
+    b->free = FALSE;
+    
+    hd->freeBytes -= b->size;
+    hd->numFree--;
+}
+
+/*---------------------------------------------------------------------------*
+    Address Hash (used blocks)
+ *---------------------------------------------------------------------------*/
+
+static u32 HashSlot(HeapDesc* hd, u32 addr) {
+    return ((addr - hd->start) / HEAP_ALIGN) & hd->hashMask;
+}
+
+static void HashInsert(HeapDesc* hd, u32 index) {
+    u32 slot = HashSlot(hd, hd->blocks[index].addr);
+    hd->blocks[index].hashNext = hd->hash[slot];
+    hd->hash[slot] = index;
+}
+
+static u32 HashRemove(HeapDesc* hd, u32 addr) {
+    u32* link = &hd->hash[HashSlot(hd, addr)];
+    
+    while (*link != NIL) {
+        u32 index = *link;
+        if (hd->blocks[index].addr == addr) {
+            *link = hd->blocks[index].hashNext;
+            return index;
+        }
+        link = &hd->blocks[index].hashNext;
+    }
+    return NIL;
+}
+
+static u32 HashFind(HeapDesc* hd, u32 addr) {
+    u32 index = hd->hash[HashSlot(hd, addr)];
+    
+    while (index != NIL && hd->blocks[index].addr != addr) {
+        index = hd->blocks[index].hashNext;
+    }
+    return index;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GrowHash
+  
+  Description:  Double the hash table once the average chain exceeds two
+                blocks. Failure is harmless (chains just get longer).
+  
+  Arguments:    hd  Heap
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void GrowHash(HeapDesc* hd) {
+    u32 oldSize = hd->hashMask + 1;
+    if (hd->numUsed <= oldSize * 2) {
+        return;
+    }
+    
+    u32* hash = (u32*)malloc(oldSize * 2 * sizeof(u32));
+    if (!hash) {
+        return;
+    }
+    
+    u32* old = hd->hash;
+    hd->hash = hash;
+    hd->hashMask = oldSize * 2 - 1;
+    memset(hash, 0xFF, oldSize * 2 * sizeof(u32));
+    
+    for (u32 slot = 0; slot < oldSize; slot++) {
+        u32 index = old[slot];
+        while (index != NIL) {
+            u32 next = hd->blocks[index].hashNext;
+            HashInsert(hd, index);
+            index = next;
+        }
+    }
+    free(old);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         FindFree
+  
+  Description:  Find a free block of at least size bytes. The request is
+                rounded up to the next class boundary so any block in the
+                chosen list fits; if that finds nothing, the list the size
+                itself maps to is searched, so a fitting block is never
+                missed.
+  
+  Arguments:    hd    Heap
+                size  Bytes (multiple of HEAP_ALIGN)
+  
+  Returns:      Block index, or NIL
+ *---------------------------------------------------------------------------*/
+static u32 FindFree(HeapDesc* hd, u32 size) {
+    u32 units = size / HEAP_ALIGN;
+    u32 fl, sl;
+    
+    if (units >= SL_COUNT) {
+        units += (1u << (HighBit(units) - SL_LOG2)) - 1;
+    }
+    MapClass(units * HEAP_ALIGN, &fl, &sl);
+    
+    if (fl < FL_COUNT) {
+        u32 slMap = hd->slBitmap[fl] & (~0u << sl);
+        if (!slMap && fl + 1 < FL_COUNT) {
+            u32 flMap = hd->flBitmap & (~0u << (fl + 1));
+            if (flMap) {
+                fl = LowBit(flMap);
+                slMap = hd->slBitmap[fl];
+            }
+        }
+        if (slMap) {
+            return hd->freeLists[fl][LowBit(slMap)];
+        }
+    }
+    
+    MapClass(size, &fl, &sl);
+    for (u32 index = hd->freeLists[fl][sl]; index != NIL; index = hd->blocks[index].nextFree) {
+        if (hd->blocks[index].size >= size) {
+            return index;
+        }
+    }
+    return NIL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         LargestFree
+  
+  Description:  Size of the largest free block: the longest block in the
+                highest non-empty class.
+  
+  Arguments:    hd  Heap
+  
+  Returns:      Bytes (0 if the heap is full)
+ *---------------------------------------------------------------------------*/
+static u32 LargestFree(HeapDesc* hd) {
+    if (!hd->flBitmap) {
+        return 0;
+    }
+    
+    u32 fl = HighBit(hd->flBitmap);
+    u32 sl = HighBit(hd->slBitmap[fl]);
+    u32 largest = 0;
+    
+    for (u32 index = hd->freeLists[fl][sl]; index != NIL; index = hd->blocks[index].nextFree) {
+        if (hd->blocks[index].size > largest) {
+            largest = hd->blocks[index].size;
+        }
+    }
+    return largest;
+}
+
+static HeapDesc* GetHeap(ARHeapHandle heap, const char* caller) {
+    if (heap < 0 || heap >= AR_MAX_HEAPS || !s_heaps[heap].active) {
+        OSReport("AR: %s: Invalid heap %d\n", caller, heap);
+        return NULL;
+    }
+    return &s_heaps[heap];
+}
+
+static void FreeHeapDesc(HeapDesc* hd) {
+    free(hd->blocks);
+    free(hd->hash);
+    memset(hd, 0, sizeof(*hd));
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARCreateHeap
+  
+  Description:  Create a heap over an ARAM range. The range is usually
+                taken from ARAlloc and must not overlap another heap.
+  
+  Arguments:    start  First ARAM address (rounded up to 32 bytes)
+                end    End address, exclusive (rounded down to 32 bytes)
+  
+  Returns:      Heap handle, or -1 on failure
+ *---------------------------------------------------------------------------*/
+ARHeapHandle ARCreateHeap(u32 start, u32 end) {
+    if (!ARCheckInit()) {
+        OSReport("AR: ARCreateHeap: Call ARInit first\n");
+        return -1;
+    }
+    
+    start = ROUND_UP(start, HEAP_ALIGN);
+    end = ROUND_DOWN(end, HEAP_ALIGN);
+    if (start < AR_OS_RESERVED || start >= end || end > ARGetSize()) {
+        OSReport("AR: ARCreateHeap: Invalid range 0x%08X-0x%08X\n", start, end);
+        return -1;
+    }
+    
+    LockHeaps();
+    
+    ARHeapHandle heap;
+    for (heap = 0; heap < AR_MAX_HEAPS; heap++) {
+        HeapDesc* other = &s_heaps[heap];
+        if (other->active && start < other->end && other->start < end) {
+            UnlockHeaps();
+            OSReport("AR: ARCreateHeap: Range overlaps heap %d\n", heap);
+            return -1;
+        }
+    }
+    for (heap = 0; heap < AR_MAX_HEAPS && s_heaps[heap].active; heap++) {
+    }
+    if (heap == AR_MAX_HEAPS) {
+        UnlockHeaps();
+        OSReport("AR: ARCreateHeap: No free heap descriptors\n");
+        return -1;
+    }
+    
+    HeapDesc* hd = &s_heaps[heap];
+    memset(hd, 0, sizeof(*hd));
+    memset(hd->freeLists, 0xFF, sizeof(hd->freeLists));
+    hd->start = start;
+    hd->end = end;
+    hd->spare = NIL;
+    
+    // One bucket per 4 KB of heap to start with (64 minimum)
+    u32 buckets = 64;
+    while (buckets < (end - start) / 4096 && buckets < 65536) {
+        buckets *= 2;
+    }
+    hd->hash = (u32*)malloc(buckets * sizeof(u32));
+    u32 index = NewBlock(hd);
+    if (!hd->hash || index == NIL) {
+        FreeHeapDesc(hd);
+        UnlockHeaps();
+        OSReport("AR: ARCreateHeap: Out of host memory\n");
+        return -1;
+    }
+    memset(hd->hash, 0xFF, buckets * sizeof(u32));
+    hd->hashMask = buckets - 1;
+    
+    HeapBlock* b = &hd->blocks[index];
+    b->addr = start;
+    b->size = end - start;
+    b->prevPhys = NIL;
+    b->nextPhys = NIL;
+    InsertFree(hd, index);
+    hd->first = index;
+    
+    hd->active = TRUE;
+    UnlockHeaps();
+    return heap;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARDestroyHeap
+  
+  Description:  Destroy a heap. Its ARAM range is not touched; addresses
+                allocated from it become invalid.
+  
+  Arguments:    heap  Heap handle
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void ARDestroyHeap(ARHeapHandle heap) {
+    LockHeaps();
+    HeapDesc* hd = GetHeap(heap, "ARDestroyHeap");
+    if (hd) {
+        FreeHeapDesc(hd);
+    }
+    UnlockHeaps();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARAllocFromHeap
+  
+  Description:  Allocate an ARAM block in O(1).
+  
+  Arguments:    heap  Heap handle
+                size  Bytes (rounded up to a multiple of 32)
+  
+  Returns:      32-byte aligned ARAM address, or 0xFFFFFFFF if no free
+                block is large enough (same as ARAlloc)
+ *---------------------------------------------------------------------------*/
+u32 ARAllocFromHeap(ARHeapHandle heap, u32 size) {
+    if (size == 0 || size > 0xFFFFFFFF - HEAP_ALIGN) {
+        return 0xFFFFFFFF;
+    }
+    size = ROUND_UP(size, HEAP_ALIGN);
+    
+    LockHeaps();
+    
+    HeapDesc* hd = GetHeap(heap, "ARAllocFromHeap");
+    u32 index = hd ? FindFree(hd, size) : NIL;
+    if (index == NIL) {
+        UnlockHeaps();
+        return 0xFFFFFFFF;
+    }
+    
+    RemoveFree(hd, index);
+    
+    // Split off the tail (NewBlock may move the pool, so index from here)
+    if (hd->blocks[index].size - size >= HEAP_ALIGN) {
+        u32 rest = NewBlock(hd);
+        if (rest != NIL) {
+            HeapBlock* b = &hd->blocks[index];
+            HeapBlock* r = &hd->blocks[rest];
+            r->addr = b->addr + size;
+            r->size = b->size - size;
+            r->prevPhys = index;
+            r->nextPhys = b->nextPhys;
+            if (b->nextPhys != NIL) {
+                hd->blocks[b->nextPhys].prevPhys = rest;
+            }
+            b->nextPhys = rest;
+            b->size = size;
+            InsertFree(hd, rest);
+        }
+    }
+    
+    HashInsert(hd, index);
+    hd->numUsed++;
+    GrowHash(hd);
+    
+    u32 addr = hd->blocks[index].addr;
+    UnlockHeaps();
+    return addr;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARFreeToHeap
+  
+  Description:  Free a block in O(1), merging it with free neighbours.
+  
+  Arguments:    heap  Heap handle
+                addr  Address returned by ARAllocFromHeap
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void ARFreeToHeap(ARHeapHandle heap, u32 addr) {
+    LockHeaps();
+    
+    HeapDesc* hd = GetHeap(heap, "ARFreeToHeap");
+    u32 index = hd ? HashRemove(hd, addr) : NIL;
+    if (index == NIL) {
+        UnlockHeaps();
+        if (hd) {
+            OSReport("AR: ARFreeToHeap: 0x%08X is not allocated from heap %d\n", addr, heap);
+        }
+        return;
+    }
+    hd->numUsed--;
+    
+    HeapBlock* b = &hd->blocks[index];
+    
+    u32 next = b->nextPhys;
+    if (next != NIL && hd->blocks[next].free) {
+        RemoveFree(hd, next);
+        b->size += hd->blocks[next].size;
+        b->nextPhys = hd->blocks[next].nextPhys;
+        if (b->nextPhys != NIL) {
+            hd->blocks[b->nextPhys].prevPhys = index;
+        }
+        ReleaseBlock(hd, next);
+    }
+    
+    u32 prev = b->prevPhys;
+    if (prev != NIL && hd->blocks[prev].free) {
+        HeapBlock* p = &hd->blocks[prev];
+        RemoveFree(hd, prev);
+        p->size += b->size;
+        p->nextPhys = b->nextPhys;
+        if (p->nextPhys != NIL) {
+            hd->blocks[p->nextPhys].prevPhys = prev;
+        }
+        ReleaseBlock(hd, index);
+        index = prev;
+    }
+    
+    InsertFree(hd, index);
+    UnlockHeaps();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARGetHeapBlockSize
+  
+  Description:  Get the size of an allocated block.
+  
+  Arguments:    heap  Heap handle
+                addr  Address returned by ARAllocFromHeap
+  
+  Returns:      Block size in bytes, or 0 if addr is not allocated
+ *---------------------------------------------------------------------------*/
+u32 ARGetHeapBlockSize(ARHeapHandle heap, u32 addr) {
+    u32 size = 0;
+    
+    LockHeaps();
+    HeapDesc* hd = GetHeap(heap, "ARGetHeapBlockSize");
+    if (hd) {
+        u32 index = HashFind(hd, addr);
+        if (index != NIL) {
+            size = hd->blocks[index].size;
+        }
+    }
+    UnlockHeaps();
+    return size;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARGetHeapStats
+  
+  Description:  Get free space and fragmentation figures for a heap.
+  
+  Arguments:    heap   Heap handle
+                stats  Receives the figures (zeroed for invalid heaps)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void ARGetHeapStats(ARHeapHandle heap, ARHeapStats* stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    
+    LockHeaps();
+    HeapDesc* hd = GetHeap(heap, "ARGetHeapStats");
+    if (hd) {
+        stats->size = hd->end - hd->start;
+        stats->freeBytes = hd->freeBytes;
+        stats->usedBytes = stats->size - hd->freeBytes;
+        stats->largestFreeBlock = LargestFree(hd);
+        stats->numFreeBlocks = hd->numFree;
+        stats->numUsedBlocks = hd->numUsed;
+    }
+    UnlockHeaps();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARCompactHeap
+  
+  Description:  Move allocated blocks down to merge the free space.
+  
+                Blocks are visited in address order. For each block that
+                can move, callback(oldAddr, newAddr, size, context) is
+                called first; TRUE moves it (ARAM contents included),
+                FALSE pins it where it is. The callback runs with the
+                heap lock held and must not call other ARAM heap functions.
+                
+                Blocks with ARQ transfers in flight must be pinned.
+                Out of host memory, nothing moves and a message is
+                printed.
+  
+  Arguments:    heap      Heap handle
+                callback  Relocation callback (NULL: nothing moves)
+                context   Passed to the callback
+  
+  Returns:      Largest free block after compaction, in bytes
+ *---------------------------------------------------------------------------*/
+u32 ARCompactHeap(ARHeapHandle heap, ARHeapRelocateCallback callback, void* context) {
+    LockHeaps();
+    
+    HeapDesc* hd = GetHeap(heap, "ARCompactHeap");
+    if (!hd) {
+        UnlockHeaps();
+        return 0;
+    }
+    if (!callback || hd->numUsed == 0) {
+        u32 largest = LargestFree(hd);
+        UnlockHeaps();
+        return largest;
+    }
+    
+    /* Every gap of the rebuilt heap needs a descriptor: take them all up
+       front so free space cannot drop out after blocks have moved */
+    u32* used = (u32*)malloc(hd->numUsed * sizeof(u32));
+    if (!used || !ReserveBlocks(hd, hd->numUsed + 1)) {
+        free(used);
+        u32 largest = LargestFree(hd);
+        UnlockHeaps();
+        OSReport("AR: ARCompactHeap: Out of host memory\n");
+        return largest;
+    }
+    
+    // Slide used blocks down; free blocks are dropped and rebuilt below
+    u32 numUsed = 0;
+    u32 cursor = hd->start;
+    u32 index = hd->first;
+    while (index != NIL) {
+        HeapBlock* b = &hd->blocks[index];
+        u32 next = b->nextPhys;
+        
+        if (b->free) {
+            RemoveFree(hd, index);
+            ReleaseBlock(hd, index);
+        } else {
+            if (b->addr != cursor && callback(b->addr, cursor, b->size, context)) {
+                HashRemove(hd, b->addr);
+                __ARMove(cursor, b->addr, b->size);
+                b->addr = cursor;
+                HashInsert(hd, index);
+            }
+            cursor = b->addr + b->size;
+            used[numUsed++] = index;
+        }
+        index = next;
+    }
+    
+    // Relink in address order with one free block per remaining gap
+    u32 prev = NIL;
+    cursor = hd->start;
+    for (u32 i = 0; i <= numUsed; i++) {
+        u32 gapEnd = i < numUsed ? hd->blocks[used[i]].addr : hd->end;
+        
+        if (gapEnd > cursor) {
+            u32 gap = NewBlock(hd);     // Reserved above
+            HeapBlock* g = &hd->blocks[gap];
+            g->addr = cursor;
+            g->size = gapEnd - cursor;
+            g->prevPhys = prev;
+            g->nextPhys = NIL;
+            if (prev != NIL) {
+                hd->blocks[prev].nextPhys = gap;
+            } else {
+                hd->first = gap;
+            }
+            InsertFree(hd, gap);
+            prev = gap;
+        }
+        
+        if (i < numUsed) {
+            HeapBlock* b = &hd->blocks[used[i]];
+            b->prevPhys = prev;
+            b->nextPhys = NIL;
+            if (prev != NIL) {
+                hd->blocks[prev].nextPhys = used[i];
+            } else {
+                hd->first = used[i];
+            }
+            prev = used[i];
+            cursor = b->addr + b->size;
+        }
+    }
+    
+    free(used);
+    u32 largest = LargestFree(hd);
+    UnlockHeaps();
+    return largest;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __ARResetHeaps
+  
+  Description:  Destroy all heaps (ARReset).
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __ARResetHeaps(void) {
+    LockHeaps();
+    for (int heap = 0; heap < AR_MAX_HEAPS; heap++) {
+        if (s_heaps[heap].active) {
+            FreeHeapDesc(&s_heaps[heap]);
+        }
+    }
+    UnlockHeaps();
+}
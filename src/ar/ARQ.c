@@ -4,28 +4,465 @@
   Manages queued DMA transfers between ARAM and main RAM.
   
   On GC/Wii: Queues large transfers, breaks into chunks
-  On PC: Executes immediately (simulated DMA is instant)
+  On PC: A background DMA engine works through the queues in chunks, so
+         posting a multi-megabyte upload does not stall the caller.
+  
+  DMA ENGINE:
+  - Two FIFO queues, high and low priority.
+  - Every request is copied in ARQGetChunkSize() pieces. Between chunks
+    the engine looks at the high-priority queue first, so a high-priority
+    request waits at most one chunk behind a large low-priority upload.
+    The preempted request resumes where it left off afterwards.
+  - Finished requests go to a dispatcher thread that runs the callbacks,
+    so a slow callback never holds up the copies.
+  
+  REMOVAL:
+  ARQRemoveRequest/ARQRemoveOwnerRequest/ARQFlushQueue drop requests that
+  are queued, partially copied or waiting for their callback. The callback
+  of a removed request is not called, and once the call returns the engine
+  no longer touches the request or its buffers.
  *---------------------------------------------------------------------------*/
 
 #include <dolphin/ar.h>
+#include <dolphin/ar_internal.h>
 #include <dolphin/os.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 /*---------------------------------------------------------------------------*
     Internal State
  *---------------------------------------------------------------------------*/
 
+#define NUM_QUEUES 2  // Indexed by ARQ_PRIORITY_*
+
+typedef struct Queue {
+    ARQRequest* head;
+    ARQRequest* tail;
+    u32         depth;
+} Queue;
+
 static BOOL s_arqInitialized = FALSE;
-static u32 s_chunkSize = 4096;  // Default chunk size
+static u32 s_chunkSize = ARQ_CHUNK_SIZE_DEFAULT;
+
+// Priority queues (high and low); the head is the request being copied
+static Queue s_queue[NUM_QUEUES];
+static u32 s_progress[NUM_QUEUES];          // Bytes of the head request done
+
+static Queue s_doneQueue;                   // Waiting for their callback
+
+static ARQRequest* s_copying = NULL;        // Request of the chunk in flight
+static ARQRequest* s_dispatching = NULL;    // Request whose callback runs
+static u32 s_dispatchingOwner = 0;          // Its owner (the callback may free it)
+
+static ARQStats s_stats;
+
+#ifdef _WIN32
+static CRITICAL_SECTION s_arqLock;
+static CONDITION_VARIABLE s_workCond;      // Wakes the DMA engine
+static CONDITION_VARIABLE s_doneCond;      // Wakes the dispatcher
+static CONDITION_VARIABLE s_idleCond;      // Chunk or callback finished
+static BOOL s_lockInit = FALSE;
+static HANDLE s_engineThread = NULL;
+static HANDLE s_dispatchThread = NULL;
+static DWORD s_dispatchThreadId = 0;
+#else
+static pthread_mutex_t s_arqLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_workCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t s_doneCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t s_idleCond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_engineThread;
+static pthread_t s_dispatchThread;
+#endif
+static BOOL s_threadsRunning = FALSE;
+static BOOL s_stopRequested = FALSE;
+
+static void LockARQ(void) {
+#ifdef _WIN32
+    if (!s_lockInit) {
+        InitializeCriticalSection(&s_arqLock);
+        InitializeConditionVariable(&s_workCond);
+        InitializeConditionVariable(&s_doneCond);
+        InitializeConditionVariable(&s_idleCond);
+        s_lockInit = TRUE;
+    }
+    EnterCriticalSection(&s_arqLock);
+#else
+    pthread_mutex_lock(&s_arqLock);
+#endif
+}
+
+static void UnlockARQ(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_arqLock);
+#else
+    pthread_mutex_unlock(&s_arqLock);
+#endif
+}
+
+// Wait on a condition; caller holds the ARQ lock
+static void WaitARQ(void* cond) {
+#ifdef _WIN32
+    SleepConditionVariableCS((CONDITION_VARIABLE*)cond, &s_arqLock, INFINITE);
+#else
+    pthread_cond_wait((pthread_cond_t*)cond, &s_arqLock);
+#endif
+}
+
+static void SignalARQ(void* cond) {
+#ifdef _WIN32
+    WakeAllConditionVariable((CONDITION_VARIABLE*)cond);
+#else
+    pthread_cond_broadcast((pthread_cond_t*)cond);
+#endif
+}
+
+// TRUE on the dispatcher, i.e. inside a completion callback
+static BOOL OnDispatchThread(void) {
+    if (!s_threadsRunning) {
+        return FALSE;
+    }
+#ifdef _WIN32
+    return GetCurrentThreadId() == s_dispatchThreadId;
+#else
+    return pthread_equal(pthread_self(), s_dispatchThread);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+    Queue Helpers (caller holds the ARQ lock)
+ *---------------------------------------------------------------------------*/
+
+static void QueuePush(Queue* q, ARQRequest* request) {
+    request->next = NULL;
+    if (q->tail) {
+        q->tail->next = request;
+    } else {
+        q->head = request;
+    }
+    q->tail = request;
+    q->depth++;
+}
+
+static ARQRequest* QueuePop(Queue* q) {
+    ARQRequest* request = q->head;
+    
+    if (request) {
+        q->head = request->next;
+        if (!q->head) {
+            q->tail = NULL;
+        }
+        q->depth--;
+        request->next = NULL;
+    }
+    return request;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         QueueRemove
+
+  Description:  Unlink the requests matching a request pointer or owner.
+
+  Arguments:    q        Queue
+                request  Request to remove, or NULL to match by owner
+                owner    Owner to match when request is NULL
+
+  Returns:      Number of requests removed
+ *---------------------------------------------------------------------------*/
+static u32 QueueRemove(Queue* q, ARQRequest* request, u32 owner) {
+    ARQRequest* prev = NULL;
+    ARQRequest* cur = q->head;
+    u32 removed = 0;
+    
+    while (cur) {
+        ARQRequest* next = cur->next;
+        
+        if (request ? (cur == request) : (cur->owner == owner)) {
+            if (prev) {
+                prev->next = next;
+            } else {
+                q->head = next;
+            }
+            if (q->tail == cur) {
+                q->tail = prev;
+            }
+            cur->next = NULL;
+            q->depth--;
+            removed++;
+        } else {
+            prev = cur;
+        }
+        cur = next;
+    }
+    return removed;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         RemoveMatching
+
+  Description:  Drop matching requests from every queue, then wait until
+                neither thread is still using one of them. Called from a
+                completion callback, it does not wait for that callback.
+
+  Arguments:    request  Request to remove, or NULL to match by owner
+                owner    Owner to match when request is NULL
+                all      TRUE to remove everything (request/owner ignored)
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void RemoveMatching(ARQRequest* request, u32 owner, BOOL all) {
+    LockARQ();
+    
+    for (u32 prio = 0; prio < NUM_QUEUES; prio++) {
+        ARQRequest* head = s_queue[prio].head;
+        u32 removed;
+        
+        if (all) {
+            removed = s_queue[prio].depth;
+            s_queue[prio].head = NULL;
+            s_queue[prio].tail = NULL;
+            s_queue[prio].depth = 0;
+        } else {
+            removed = QueueRemove(&s_queue[prio], request, owner);
+        }
+        
+        // A partially copied head is abandoned with the rest
+        if (s_queue[prio].head != head) {
+            s_progress[prio] = 0;
+        }
+        s_stats.requestsRemoved += removed;
+    }
+    
+    if (all) {
+        s_stats.requestsRemoved += s_doneQueue.depth;
+        s_doneQueue.head = NULL;
+        s_doneQueue.tail = NULL;
+        s_doneQueue.depth = 0;
+    } else {
+        s_stats.requestsRemoved += QueueRemove(&s_doneQueue, request, owner);
+    }
+    
+    // Let an in-flight chunk finish; its request is no longer queued, so
+    // the engine drops it afterwards
+    while (s_copying &&
+           (all || (request ? s_copying == request : s_copying->owner == owner))) {
+        WaitARQ(&s_idleCond);
+    }
+    
+    // Likewise a running callback; the dispatcher itself can't wait for it
+    if (!OnDispatchThread()) {
+        while (s_dispatching &&
+               (all || (request ? s_dispatching == request : s_dispatchingOwner == owner))) {
+            WaitARQ(&s_idleCond);
+        }
+    }
+    
+    UnlockARQ();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         EngineThread
+
+  Description:  DMA engine. Copies one chunk at a time from the head of the
+                high-priority queue, or of the low-priority queue when the
+                high one is empty, and hands finished requests to the
+                dispatcher.
+
+  Arguments:    arg  Unused
+
+  Returns:      0 (thread return value)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI EngineThread(LPVOID arg)
+#else
+static void* EngineThread(void* arg)
+#endif
+{
+    (void)arg;
+    
+    LockARQ();
+    
+    while (!s_stopRequested) {
+        u32 prio;
+        
+        if (s_queue[ARQ_PRIORITY_HIGH].head) {
+            prio = ARQ_PRIORITY_HIGH;
+        } else if (s_queue[ARQ_PRIORITY_LOW].head) {
+            prio = ARQ_PRIORITY_LOW;
+        } else {
+            WaitARQ(&s_workCond);
+            continue;
+        }
+        
+        ARQRequest* request = s_queue[prio].head;
+        u32 done = s_progress[prio];
+        u32 chunk = request->length - done;
+        if (s_chunkSize > 0 && chunk > s_chunkSize) {
+            chunk = s_chunkSize;
+        }
+        
+        u32 source = request->source + done;
+        u32 dest = request->dest + done;
+        u32 type = request->type;
+        u32 total = request->length;
+        
+        s_copying = request;
+        UnlockARQ();
+        
+        OSTime start = OSGetTime();
+        if (type == AR_MRAM_TO_ARAM) {
+            __ARCopy(type, source, dest, chunk, total);
+        } else {
+            __ARCopy(type, dest, source, chunk, total);
+        }
+        OSTime elapsed = OSGetTime() - start;
+        
+        LockARQ();
+        s_copying = NULL;
+        s_stats.chunks++;
+        s_stats.bytesTransferred += chunk;
+        s_stats.busyTicks += (u64)elapsed;
+        
+        // Removed while the chunk was in flight - nothing left to do
+        if (s_queue[prio].head == request) {
+            s_progress[prio] = done + chunk;
+            if (s_progress[prio] >= request->length) {
+                QueuePop(&s_queue[prio]);
+                s_progress[prio] = 0;
+                if (request->callback) {
+                    QueuePush(&s_doneQueue, request);
+                    SignalARQ(&s_doneCond);
+                } else {
+                    s_stats.requestsCompleted++;
+                }
+            }
+        }
+        SignalARQ(&s_idleCond);
+    }
+    
+    UnlockARQ();
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DispatchThread
+
+  Description:  Runs completion callbacks in completion order.
+
+  Arguments:    arg  Unused
+
+  Returns:      0 (thread return value)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI DispatchThread(LPVOID arg)
+#else
+static void* DispatchThread(void* arg)
+#endif
+{
+    (void)arg;
+    
+    LockARQ();
+    
+    while (!s_stopRequested) {
+        ARQRequest* request = QueuePop(&s_doneQueue);
+        if (!request) {
+            WaitARQ(&s_doneCond);
+            continue;
+        }
+        
+        void (*callback)(ARQRequest*) = request->callback;
+        s_dispatching = request;
+        s_dispatchingOwner = request->owner;
+        s_stats.requestsCompleted++;
+        UnlockARQ();
+        
+        callback(request);
+        
+        LockARQ();
+        s_dispatching = NULL;
+        SignalARQ(&s_idleCond);
+    }
+    
+    UnlockARQ();
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StartThreads
+
+  Description:  Start the DMA engine and dispatcher threads.
+
+  Arguments:    None
+
+  Returns:      TRUE if both are running
+ *---------------------------------------------------------------------------*/
+static BOOL StartThreads(void) {
+    s_stopRequested = FALSE;
+
+#ifdef _WIN32
+    s_engineThread = CreateThread(NULL, 0, EngineThread, NULL, 0, NULL);
+    s_dispatchThread = CreateThread(NULL, 0, DispatchThread, NULL, 0, &s_dispatchThreadId);
+    s_threadsRunning = (s_engineThread != NULL && s_dispatchThread != NULL);
+#else
+    BOOL engine = (pthread_create(&s_engineThread, NULL, EngineThread, NULL) == 0);
+    BOOL dispatch = engine &&
+                    (pthread_create(&s_dispatchThread, NULL, DispatchThread, NULL) == 0);
+    if (engine && !dispatch) {
+        LockARQ();
+        s_stopRequested = TRUE;
+        SignalARQ(&s_workCond);
+        UnlockARQ();
+        pthread_join(s_engineThread, NULL);
+    }
+    s_threadsRunning = dispatch;
+#endif
+
+    return s_threadsRunning;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StopThreads
+
+  Description:  Stop the DMA engine and dispatcher threads. Work still in
+                the queues is dropped.
 
-// Priority queues (high and low)
-static ARQRequest* s_queueHi = NULL;
-static ARQRequest* s_queueLo = NULL;
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StopThreads(void) {
+    if (!s_threadsRunning) {
+        return;
+    }
+    
+    LockARQ();
+    s_stopRequested = TRUE;
+    SignalARQ(&s_workCond);
+    SignalARQ(&s_doneCond);
+    UnlockARQ();
+
+#ifdef _WIN32
+    WaitForSingleObject(s_engineThread, INFINITE);
+    WaitForSingleObject(s_dispatchThread, INFINITE);
+    CloseHandle(s_engineThread);
+    CloseHandle(s_dispatchThread);
+    s_engineThread = NULL;
+    s_dispatchThread = NULL;
+#else
+    pthread_join(s_engineThread, NULL);
+    pthread_join(s_dispatchThread, NULL);
+#endif
+    s_threadsRunning = FALSE;
+}
 
 /*---------------------------------------------------------------------------*
   Name:         ARQInit
 
-  Description:  Initialize ARAM Queue subsystem.
+  Description:  Initialize ARAM Queue subsystem and start the DMA engine.
 
   Arguments:    None
 
@@ -36,9 +473,17 @@ void ARQInit(void) {
         return;
     }
     
-    s_queueHi = NULL;
-    s_queueLo = NULL;
-    s_chunkSize = 4096;
+    memset(s_queue, 0, sizeof(s_queue));
+    memset(s_progress, 0, sizeof(s_progress));
+    memset(&s_doneQueue, 0, sizeof(s_doneQueue));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_chunkSize = ARQ_CHUNK_SIZE_DEFAULT;
+    
+    if (!StartThreads()) {
+        OSReport("ARQ: Failed to start DMA engine\n");
+        return;
+    }
+    
     s_arqInitialized = TRUE;
     
     OSReport("ARQ: Queue system initialized\n");
@@ -47,15 +492,23 @@ void ARQInit(void) {
 /*---------------------------------------------------------------------------*
   Name:         ARQReset
 
-  Description:  Reset ARAM Queue subsystem.
+  Description:  Reset ARAM Queue subsystem. Pending requests are dropped
+                without their callbacks.
 
   Arguments:    None
 
   Returns:      None
  *---------------------------------------------------------------------------*/
 void ARQReset(void) {
-    s_queueHi = NULL;
-    s_queueLo = NULL;
+    if (!s_arqInitialized) {
+        return;
+    }
+    
+    StopThreads();
+    
+    memset(s_queue, 0, sizeof(s_queue));
+    memset(s_progress, 0, sizeof(s_progress));
+    memset(&s_doneQueue, 0, sizeof(s_doneQueue));
     s_arqInitialized = FALSE;
 }
 
@@ -75,19 +528,20 @@ BOOL ARQCheckInit(void) {
 /*---------------------------------------------------------------------------*
   Name:         ARQPostRequest
 
-  Description:  Post a DMA request to the queue. On PC, executes immediately
-                since simulated DMA is instant.
-                
+  Description:  Post a DMA request to the queue and return immediately.
+
                 On GC/Wii: Adds to queue, processes in chunks
-                On PC: Executes DMA immediately, calls callback
+                On PC: The DMA engine copies it in chunks; the callback runs
+                       on the ARQ dispatcher thread when it is done. The
+                       request and its buffers must stay valid until then.
 
   Arguments:    request   ARQ request structure
                 owner     Owner ID
                 type      DMA type (AR_MRAM_TO_ARAM or AR_ARAM_TO_MRAM)
-                priority  Priority (0=high, 1=low)
+                priority  ARQ_PRIORITY_LOW or ARQ_PRIORITY_HIGH
                 source    Source address
                 dest      Destination address
-                length    Transfer length
+                length    Transfer length (multiple of 32 bytes)
                 callback  Completion callback
 
   Returns:      None
@@ -99,91 +553,146 @@ void ARQPostRequest(ARQRequest* request, u32 owner, u32 type, u32 priority,
         return;
     }
     
+    if ((source & 31) != 0 || (dest & 31) != 0 || (length & 31) != 0) {
+        OSReport("ARQ: Request addresses/length must be 32-byte aligned!\n");
+        return;
+    }
+    
     // Fill in request
     request->owner = owner;
     request->type = type;
-    request->priority = priority;
+    request->priority = (priority == ARQ_PRIORITY_HIGH) ? ARQ_PRIORITY_HIGH : ARQ_PRIORITY_LOW;
     request->source = source;
     request->dest = dest;
     request->length = length;
     request->callback = callback;
     request->next = NULL;
     
-    // On PC, execute immediately (no real queue needed)
-    // DMA is instant memcpy
-    ARStartDMA(type, source, dest, length);
+    LockARQ();
     
-    // Call callback
-    if (callback) {
-        callback(request);
+    if (length == 0) {
+        // Nothing to copy - complete straight away
+        if (callback) {
+            QueuePush(&s_doneQueue, request);
+            SignalARQ(&s_doneCond);
+        } else {
+            s_stats.requestsCompleted++;
+        }
+    } else {
+        QueuePush(&s_queue[request->priority], request);
+        SignalARQ(&s_workCond);
+    }
+    
+    u32 depth = s_queue[ARQ_PRIORITY_HIGH].depth + s_queue[ARQ_PRIORITY_LOW].depth;
+    if (depth > s_stats.maxQueueDepth) {
+        s_stats.maxQueueDepth = depth;
     }
+    
+    UnlockARQ();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __ARQComplete
+  
+  Description:  Complete a request whose data was transferred elsewhere
+                (DVDReadToARAMAsync). The callback runs on the dispatcher
+                thread, in order with DMA engine completions.
+  
+  Arguments:    request  Filled-in request
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __ARQComplete(ARQRequest* request) {
+    if (!s_arqInitialized) {
+        // No dispatcher to hand it to - call back on this thread
+        if (request->callback) {
+            request->callback(request);
+        }
+        return;
+    }
+    
+    LockARQ();
+    if (request->callback) {
+        QueuePush(&s_doneQueue, request);
+        SignalARQ(&s_doneCond);
+    } else {
+        s_stats.requestsCompleted++;
+    }
+    UnlockARQ();
 }
 
 /*---------------------------------------------------------------------------*
   Name:         ARQRemoveRequest
 
-  Description:  Remove a request from the queue.
-                
-                On PC: No-op since requests execute immediately
+  Description:  Remove a request from the queue. Its callback will not be
+                called. If a chunk of it is being copied, waits for that
+                chunk to finish.
 
   Arguments:    request  Request to remove
 
   Returns:      None
  *---------------------------------------------------------------------------*/
 void ARQRemoveRequest(ARQRequest* request) {
-    (void)request;
+    if (!s_arqInitialized || !request) {
+        return;
+    }
     
-    /* On PC, requests are not queued - they execute immediately.
-     * This function exists for API compatibility.
-     */
+    RemoveMatching(request, 0, FALSE);
 }
 
 /*---------------------------------------------------------------------------*
   Name:         ARQRemoveOwnerRequest
 
-  Description:  Remove all requests from a specific owner.
-                
-                On PC: No-op since requests execute immediately
+  Description:  Remove all requests from a specific owner, as
+                ARQRemoveRequest does for one request.
 
   Arguments:    owner  Owner ID
 
   Returns:      None
  *---------------------------------------------------------------------------*/
 void ARQRemoveOwnerRequest(u32 owner) {
-    (void)owner;
+    if (!s_arqInitialized) {
+        return;
+    }
     
-    /* On PC, requests are not queued - they execute immediately. */
+    RemoveMatching(NULL, owner, FALSE);
 }
 
 /*---------------------------------------------------------------------------*
   Name:         ARQFlushQueue
 
-  Description:  Flush all pending requests.
-                
-                On PC: No-op since requests execute immediately
+  Description:  Drop all pending requests without calling their callbacks.
 
   Arguments:    None
 
   Returns:      None
  *---------------------------------------------------------------------------*/
 void ARQFlushQueue(void) {
-    /* On PC, no pending requests - all execute immediately. */
+    if (!s_arqInitialized) {
+        return;
+    }
+    
+    RemoveMatching(NULL, 0, TRUE);
 }
 
 /*---------------------------------------------------------------------------*
   Name:         ARQSetChunkSize
 
   Description:  Set chunk size for breaking up large DMA transfers.
-                
+
                 On GC/Wii: Large transfers split into chunks to avoid blocking
-                On PC: Stored but not used (transfers are instant)
+                On PC: The DMA engine checks the high-priority queue after
+                       every chunk, so this bounds how long a high-priority
+                       request waits behind a large one
 
-  Arguments:    size  Chunk size in bytes
+  Arguments:    size  Chunk size in bytes (rounded up to 32)
 
   Returns:      None
  *---------------------------------------------------------------------------*/
 void ARQSetChunkSize(u32 size) {
-    s_chunkSize = size;
+    LockARQ();
+    s_chunkSize = (size + 31) & ~31;
+    UnlockARQ();
 }
 
 /*---------------------------------------------------------------------------*
@@ -199,3 +708,43 @@ u32 ARQGetChunkSize(void) {
     return s_chunkSize;
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         ARQGetStats
+
+  Description:  Snapshot of the queue depth and transfer counters.
+
+  Arguments:    stats  Receives the counters
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void ARQGetStats(ARQStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    LockARQ();
+    *stats = s_stats;
+    stats->queueDepthHi = s_queue[ARQ_PRIORITY_HIGH].depth;
+    stats->queueDepthLo = s_queue[ARQ_PRIORITY_LOW].depth;
+    stats->callbacksPending = s_doneQueue.depth + (s_dispatching ? 1 : 0);
+    UnlockARQ();
+    
+    u64 us = (u64)OSTicksToMicroseconds(stats->busyTicks);
+    stats->bytesPerSecond = us ? (u32)(stats->bytesTransferred * 1000000 / us) : 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ARQResetStats
+
+  Description:  Clear the transfer counters (queue depths are live values
+                and are not affected).
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void ARQResetStats(void) {
+    LockARQ();
+    memset(&s_stats, 0, sizeof(s_stats));
+    UnlockARQ();
+}
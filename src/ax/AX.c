@@ -0,0 +1,990 @@
+/*---------------------------------------------------------------------------*
+  AX.c - Software Voice Mixer
+  
+  On GC/Wii: The game fills parameter blocks (AXVPB) in main RAM and the
+             DSP's AX microcode reads them every 5 ms, pulls samples from
+             ARAM through the accelerator, decodes, resamples and mixes
+             them for the audio interface.
+  
+  On PC: A mixer thread plays the DSP's part. Voices read sample data in
+         place from simulated ARAM (no copies), and mixed 32 kHz stereo
+         goes into a ring buffer the audio backend pulls with
+         AXReadOutput(). AX_MODE_MANUAL skips the thread for backends
+         that would rather mix inside their own callback with AXMix().
+  
+  COMMAND QUEUE:
+  Voice state belongs to the mixer. Setters never touch it: they post a
+  command to a bounded multi-producer/single-consumer ring (a sequence
+  number per slot, producers claim slots with compare-and-swap) and the
+  mixer applies everything queued at the start of each frame. No lock is
+  shared between game and audio threads, so neither can stall the other.
+  
+  OUTPUT RING:
+  Single-producer/single-consumer, power-of-two size, monotonic positions
+  in stereo sample pairs. The thread keeps MIX_LATENCY_SAMPLES buffered;
+  that is also the worst-case delay between a command and its audio.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/ax.h>
+#include <dolphin/ax_internal.h>
+#include <dolphin/ar.h>
+#include <dolphin/ar_internal.h>
+#include <dolphin/os.h>
+#include <dolphin/atomic_internal.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Commands
+ *---------------------------------------------------------------------------*/
+
+#define CMD_QUEUE_SIZE      1024
+#define CMD_QUEUE_MASK      (CMD_QUEUE_SIZE - 1)
+
+enum {
+    CMD_RESET,          // Voice acquired
+    CMD_FREE,
+    CMD_ADDR,
+    CMD_ADPCM,
+    CMD_SRC,
+    CMD_MIX,
+    CMD_STATE
+};
+
+typedef struct AXCommand {
+    volatile u32 seq;               // Slot sequence (see PostCommand)
+    u32 type;
+    AXVoice voice;
+    union {
+        struct {
+            AXVoiceCallback callback;
+            void* context;
+        } reset;
+        AXPBADDR addr;
+        AXPBADPCM adpcm;
+        u32 ratio;                  // 16.16
+        struct {
+            s16 left;               // 1.15
+            s16 right;
+        } mix;
+        u32 state;
+    } u;
+} AXCommand;
+
+static AXCommand s_commands[CMD_QUEUE_SIZE];
+static volatile u32 s_cmdTail = 0;  // Producers: next slot to claim
+static u32 s_cmdHead = 0;           // Mixer: next slot to read
+
+/*---------------------------------------------------------------------------*
+    Voices (owned by the mixer)
+ *---------------------------------------------------------------------------*/
+
+typedef struct Voice {
+    BOOL acquired;                  // Mixer's view; ignores commands if FALSE
+    u32 state;
+    BOOL ended;                     // Reached the end this frame
+    
+    u32 format;
+    BOOL loop;
+    u32 loopAddr;
+    u32 endAddr;
+    u32 curAddr;
+    const u8* aram;                 // ARAM base, set once the range is valid
+    
+    s16 coefs[16];
+    s16 hist[2];
+    s16 loopHist[2];
+    
+    u32 ratio;                      // 16.16 source samples per output sample
+    u32 frac;                       // 16.16 phase
+    s16 carry[2];                   // Source samples at the current position
+    
+    s16 left;
+    s16 right;
+    
+    AXVoiceCallback callback;
+    void* context;
+} Voice;
+
+static Voice s_voices[AX_MAX_VOICES];
+
+// Game-visible voice state, written by the mixer after each frame
+static volatile u32 s_voiceAcquired[AX_MAX_VOICES];
+static volatile u32 s_voiceState[AX_MAX_VOICES];
+static volatile u32 s_voiceAddr[AX_MAX_VOICES];
+
+/*---------------------------------------------------------------------------*
+    Mixer State
+ *---------------------------------------------------------------------------*/
+
+#define SRC_RATIO_MAX_FIXED     ((u32)(AX_SRC_RATIO_MAX * 65536.0f))
+#define SRC_BUFFER_SAMPLES      (AX_FRAME_SAMPLES * 4 + 2)  // At AX_SRC_RATIO_MAX
+
+#define OUTPUT_RING_SAMPLES     1024    // Stereo pairs
+#define OUTPUT_RING_MASK        (OUTPUT_RING_SAMPLES - 1)
+#define MIX_LATENCY_SAMPLES     (AX_FRAME_SAMPLES * 4)  // 20 ms
+#define MIX_IDLE_SLEEP_MS       1
+
+static BOOL s_initialized = FALSE;
+static u32 s_mode = AX_MODE_THREAD;
+
+// Scratch for the voice being mixed (mixer only)
+static s16 s_srcBuffer[SRC_BUFFER_SAMPLES];
+static s16 s_voiceBuffer[AX_FRAME_SAMPLES];
+static s32 s_accumulator[AX_FRAME_SAMPLES * 2];
+
+static s16 s_ring[OUTPUT_RING_SAMPLES * 2];
+static volatile u32 s_writePos = 0;     // Mixer thread: pairs produced
+static volatile u32 s_readPos = 0;      // AXReadOutput: pairs consumed
+
+#ifdef _WIN32
+static HANDLE s_mixThread = NULL;
+#else
+static pthread_t s_mixThread;
+#endif
+static BOOL s_threadRunning = FALSE;
+static volatile u32 s_stopRequested = FALSE;
+
+// Statistics
+static volatile u32 s_activeVoices = 0;
+static volatile u32 s_framesMixed = 0;
+static volatile u64 s_voiceFrames = 0;
+static volatile u64 s_mixNs = 0;
+static volatile u32 s_maxFrameNs = 0;
+static volatile u32 s_commandsProcessed = 0;
+static volatile u32 s_commandsDropped = 0;
+static volatile u32 s_underruns = 0;
+
+/*---------------------------------------------------------------------------*
+  Name:         SleepMs
+  
+  Description:  Sleep the calling (mixer) thread.
+  
+  Arguments:    ms  Milliseconds
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void SleepMs(u32 ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    usleep(ms * 1000);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PostCommand
+  
+  Description:  Append a command to the queue. Lock-free for any number
+                of producer threads: a slot whose sequence equals the tail
+                is free, the producer that moves the tail past it owns it,
+                and publishing sequence + 1 hands it to the mixer.
+  
+  Arguments:    cmd  Command (seq is ignored)
+  
+  Returns:      FALSE if the queue is full
+ *---------------------------------------------------------------------------*/
+static BOOL PostCommand(const AXCommand* cmd) {
+    u32 pos = __AtomicLoad32(&s_cmdTail);
+    AXCommand* slot;
+    
+    for (;;) {
+        slot = &s_commands[pos & CMD_QUEUE_MASK];
+        s32 diff = (s32)(__AtomicLoad32(&slot->seq) - pos);
+        
+        if (diff == 0) {
+            if (__AtomicCompareSwap32(&s_cmdTail, pos, pos + 1)) {
+                break;
+            }
+            pos = __AtomicLoad32(&s_cmdTail);
+        } else if (diff < 0) {
+            __AtomicAdd32(&s_commandsDropped, 1);
+            return FALSE;
+        } else {
+            pos = __AtomicLoad32(&s_cmdTail);  // Another producer took it
+        }
+    }
+    
+    slot->type = cmd->type;
+    slot->voice = cmd->voice;
+    slot->u = cmd->u;
+    __AtomicStore32(&slot->seq, pos + 1);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PostVoiceCommand
+  
+  Description:  Post a command for an acquired voice.
+  
+  Arguments:    voice  Voice
+                cmd    Command (type and payload filled in)
+  
+  Returns:      FALSE if the voice is not acquired or the queue is full
+ *---------------------------------------------------------------------------*/
+static BOOL PostVoiceCommand(AXVoice voice, AXCommand* cmd) {
+    if (!s_initialized || voice < 0 || voice >= AX_MAX_VOICES ||
+        !__AtomicLoad32(&s_voiceAcquired[voice])) {
+        return FALSE;
+    }
+    
+    cmd->voice = voice;
+    return PostCommand(cmd);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         BindVoice
+  
+  Description:  Check that the voice's sample range lies inside ARAM and
+                that a loop can make progress.
+  
+  Arguments:    v  Voice
+  
+  Returns:      TRUE if the voice can play
+ *---------------------------------------------------------------------------*/
+static BOOL BindVoice(Voice* v) {
+    u32 start = v->curAddr;
+    u32 first = 0;
+    u32 last = 0;
+    
+    if (v->loop) {
+        u32 loopAddr = v->loopAddr;
+        
+        // An ADPCM loop that starts on a header must still reach a sample
+        if (v->format == AX_PB_FORMAT_ADPCM && (loopAddr & 15) < 2) {
+            loopAddr = (loopAddr & ~15u) + 2;
+        }
+        if (loopAddr > v->endAddr) {
+            return FALSE;
+        }
+        if (v->loopAddr < start) {
+            start = v->loopAddr;
+        }
+    }
+    
+    switch (v->format) {
+        case AX_PB_FORMAT_ADPCM:
+            first = (start >> 1) & ~(AX_ADPCM_FRAME_SIZE - 1);
+            last = (v->endAddr >> 1) | (AX_ADPCM_FRAME_SIZE - 1);  // Whole frames are read
+            break;
+        case AX_PB_FORMAT_PCM16:
+            first = start * 2;
+            last = v->endAddr * 2 + 1;
+            break;
+        case AX_PB_FORMAT_PCM8:
+            first = start;
+            last = v->endAddr;
+            break;
+        default:
+            return FALSE;
+    }
+    
+    if (last < first || !__ARGetPointer(first, last - first + 1)) {
+        return FALSE;
+    }
+    
+    v->aram = (const u8*)__ARGetPointer(0, 0);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ApplyCommand
+  
+  Description:  Apply one command to mixer-owned voice state.
+  
+  Arguments:    cmd  Command
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ApplyCommand(const AXCommand* cmd) {
+    Voice* v = &s_voices[cmd->voice];
+    
+    if (cmd->type == CMD_RESET) {
+        memset(v, 0, sizeof(Voice));
+        v->acquired = TRUE;
+        v->ratio = 0x10000;
+        v->left = v->right = (s16)(0x7FFF * 0.70710678f + 0.5f);  // Centered, equal power
+        v->callback = cmd->u.reset.callback;
+        v->context = cmd->u.reset.context;
+        return;
+    }
+    
+    if (!v->acquired) {
+        return;  // Stale command for a voice freed since it was posted
+    }
+    
+    switch (cmd->type) {
+        case CMD_FREE:
+            v->acquired = FALSE;
+            v->state = AX_PB_STATE_STOP;
+            __AtomicStore32(&s_voiceState[cmd->voice], AX_PB_STATE_STOP);
+            __AtomicStore32(&s_voiceAcquired[cmd->voice], FALSE);
+            break;
+        
+        case CMD_ADDR:
+            v->format = cmd->u.addr.format;
+            v->loop = (cmd->u.addr.loopFlag != 0);
+            v->loopAddr = cmd->u.addr.loopAddress;
+            v->endAddr = cmd->u.addr.endAddress;
+            v->curAddr = cmd->u.addr.currentAddress;
+            v->aram = NULL;
+            if (v->state == AX_PB_STATE_RUN && !BindVoice(v)) {
+                OSReport("AX: Voice %d has an invalid sample range, stopped\n", cmd->voice);
+                v->state = AX_PB_STATE_STOP;
+            }
+            break;
+        
+        case CMD_ADPCM:
+            memcpy(v->coefs, cmd->u.adpcm.coefs, sizeof(v->coefs));
+            v->hist[0] = cmd->u.adpcm.yn1;
+            v->hist[1] = cmd->u.adpcm.yn2;
+            v->loopHist[0] = cmd->u.adpcm.loopYn1;
+            v->loopHist[1] = cmd->u.adpcm.loopYn2;
+            break;
+        
+        case CMD_SRC:
+            v->ratio = cmd->u.ratio;
+            break;
+        
+        case CMD_MIX:
+            v->left = cmd->u.mix.left;
+            v->right = cmd->u.mix.right;
+            break;
+        
+        case CMD_STATE:
+            if (cmd->u.state == AX_PB_STATE_RUN && v->state != AX_PB_STATE_RUN) {
+                if (!v->aram && !BindVoice(v)) {
+                    OSReport("AX: Voice %d has an invalid sample range, not started\n", cmd->voice);
+                    break;
+                }
+                v->ended = FALSE;
+                v->frac = 0;
+                v->carry[0] = v->carry[1] = 0;
+            }
+            v->state = cmd->u.state;
+            break;
+        
+        default:
+            break;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ProcessCommands
+  
+  Description:  Apply every command posted so far (mixer only).
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ProcessCommands(void) {
+    u32 count = 0;
+    
+    for (;;) {
+        AXCommand* slot = &s_commands[s_cmdHead & CMD_QUEUE_MASK];
+        
+        if (__AtomicLoad32(&slot->seq) != s_cmdHead + 1) {
+            break;  // Empty, or a producer has not finished writing
+        }
+        
+        ApplyCommand(slot);
+        __AtomicStore32(&slot->seq, s_cmdHead + CMD_QUEUE_SIZE);
+        s_cmdHead++;
+        count++;
+    }
+    
+    if (count > 0) {
+        __AtomicAdd32(&s_commandsProcessed, count);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DecodeVoice
+  
+  Description:  Pull source samples from ARAM, following loops. Once a
+                non-looping voice passes its end address the rest of the
+                output is silence and the voice is marked ended.
+  
+  Arguments:    v      Voice
+                out    Receives count samples
+                count  Samples wanted
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void DecodeVoice(Voice* v, s16* out, u32 count) {
+    u32 done = 0;
+    
+    while (done < count) {
+        u32 addr = v->curAddr;
+        u32 n = count - done;
+        
+        if (v->ended) {
+            memset(&out[done], 0, n * sizeof(s16));
+            return;
+        }
+        
+        if (addr > v->endAddr) {
+            if (!v->loop) {
+                v->ended = TRUE;
+                continue;
+            }
+            v->curAddr = v->loopAddr;
+            if (v->format == AX_PB_FORMAT_ADPCM) {
+                v->hist[0] = v->loopHist[0];
+                v->hist[1] = v->loopHist[1];
+            }
+            continue;
+        }
+        
+        if (v->format == AX_PB_FORMAT_ADPCM) {
+            // Skip the header nibbles; the header is read with the frame
+            if ((addr & 15) < 2) {
+                v->curAddr = (addr & ~15u) + 2;
+                continue;
+            }
+            
+            u32 first = (addr & 15) - 2;
+            u32 avail = AX_ADPCM_FRAME_SAMPLES - first;
+            if (avail > v->endAddr - addr + 1) avail = v->endAddr - addr + 1;
+            if (n > avail) n = avail;
+            
+            __AXDecodeADPCM(v->aram + ((addr >> 1) & ~(AX_ADPCM_FRAME_SIZE - 1)),
+                            first, n, v->coefs, v->hist, &out[done]);
+        } else {
+            if (n > v->endAddr - addr + 1) n = v->endAddr - addr + 1;
+            
+            if (v->format == AX_PB_FORMAT_PCM16) {
+                __AXDecodePCM16(v->aram + addr * 2, &out[done], n);
+            } else {
+                __AXDecodePCM8(v->aram + addr, &out[done], n);
+            }
+        }
+        
+        v->curAddr = addr + n;
+        done += n;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         RenderVoice
+  
+  Description:  Decode, resample and mix one voice into the accumulator.
+                s_srcBuffer[0..1] carry the two source samples around the
+                current position from the previous frame, so resampling
+                is continuous across frames.
+  
+  Arguments:    v      Voice (running)
+                count  Output samples (<= AX_FRAME_SAMPLES)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void RenderVoice(Voice* v, u32 count) {
+    u32 end = v->frac + count * v->ratio;
+    u32 advance = end >> 16;
+    
+    s_srcBuffer[0] = v->carry[0];
+    s_srcBuffer[1] = v->carry[1];
+    DecodeVoice(v, &s_srcBuffer[2], advance);
+    
+    __AXResample(s_srcBuffer, s_voiceBuffer, count, v->frac, v->ratio);
+    
+    v->frac = end & 0xFFFF;
+    v->carry[0] = s_srcBuffer[advance];
+    v->carry[1] = s_srcBuffer[advance + 1];
+    
+    if (v->left != 0 || v->right != 0) {
+        __AXMixVoice(s_accumulator, s_voiceBuffer, count, v->left, v->right);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         MixFrame
+  
+  Description:  Apply pending commands and produce up to one 5 ms frame.
+                Voice callbacks run here, after the frame is mixed.
+  
+  Arguments:    pcm    Interleaved stereo output
+                count  Stereo pairs (<= AX_FRAME_SAMPLES)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void MixFrame(s16* pcm, u32 count) {
+    OSTime start = OSGetTime();
+    u32 active = 0;
+    
+    ProcessCommands();
+    memset(s_accumulator, 0, count * 2 * sizeof(s32));
+    
+    for (AXVoice i = 0; i < AX_MAX_VOICES; i++) {
+        if (s_voices[i].state == AX_PB_STATE_RUN) {
+            RenderVoice(&s_voices[i], count);
+            active++;
+        }
+    }
+    
+    __AXClampOutput(s_accumulator, pcm, count);
+    
+    for (AXVoice i = 0; i < AX_MAX_VOICES; i++) {
+        Voice* v = &s_voices[i];
+        
+        if (v->state != AX_PB_STATE_RUN) {
+            continue;
+        }
+        if (v->ended) {
+            v->state = AX_PB_STATE_STOP;
+            __AtomicStore32(&s_voiceState[i], AX_PB_STATE_STOP);
+            __AtomicStore32(&s_voiceAddr[i], v->curAddr);
+            if (v->callback) {
+                v->callback(i, v->context);
+            }
+            continue;
+        }
+        __AtomicStore32(&s_voiceState[i], AX_PB_STATE_RUN);
+        __AtomicStore32(&s_voiceAddr[i], v->curAddr);
+    }
+    
+    u32 ns = (u32)OSTicksToNanoseconds(OSGetTime() - start);
+    
+    __AtomicStore32(&s_activeVoices, active);
+    __AtomicAdd32(&s_framesMixed, 1);
+    __AtomicAdd64(&s_voiceFrames, active);
+    __AtomicAdd64(&s_mixNs, ns);
+    if (ns > s_maxFrameNs) {
+        s_maxFrameNs = ns;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         MixThread
+  
+  Description:  Keeps MIX_LATENCY_SAMPLES of output buffered. Commands are
+                applied even while the ring is full, so voices can still be
+                freed when nothing is reading the output.
+  
+  Arguments:    arg  Unused
+  
+  Returns:      0 (thread return value)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI MixThread(LPVOID arg)
+#else
+static void* MixThread(void* arg)
+#endif
+{
+    s16 frame[AX_FRAME_SAMPLES * 2];
+    
+    (void)arg;
+    
+    while (!__AtomicLoad32(&s_stopRequested)) {
+        u32 w = s_writePos;
+        u32 buffered = w - __AtomicLoad32(&s_readPos);
+        
+        if (buffered + AX_FRAME_SAMPLES > MIX_LATENCY_SAMPLES) {
+            ProcessCommands();
+            SleepMs(MIX_IDLE_SLEEP_MS);
+            continue;
+        }
+        
+        MixFrame(frame, AX_FRAME_SAMPLES);
+        
+        // Never straddle the end of the ring
+        u32 index = w & OUTPUT_RING_MASK;
+        u32 first = OUTPUT_RING_SAMPLES - index;
+        if (first > AX_FRAME_SAMPLES) first = AX_FRAME_SAMPLES;
+        memcpy(&s_ring[index * 2], frame, first * 2 * sizeof(s16));
+        memcpy(&s_ring[0], &frame[first * 2], (AX_FRAME_SAMPLES - first) * 2 * sizeof(s16));
+        
+        __AtomicStore32(&s_writePos, w + AX_FRAME_SAMPLES);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXInit / AXInitEx
+  
+  Description:  Start the mixer.
+  
+                On GC/Wii: Boots the AX microcode on the DSP
+                On PC: Resets all voices and, in AX_MODE_THREAD, starts the
+                       mixer thread
+  
+  Arguments:    mode  AX_MODE_THREAD or AX_MODE_MANUAL
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void AXInit(void) {
+    AXInitEx(AX_MODE_THREAD);
+}
+
+void AXInitEx(u32 mode) {
+    if (s_initialized) {
+        return;
+    }
+    
+    if (!ARCheckInit()) {
+        OSReport("AX: ARInit has not been called; voices cannot start\n");
+    }
+    
+    memset(s_voices, 0, sizeof(s_voices));
+    for (u32 i = 0; i < AX_MAX_VOICES; i++) {
+        s_voiceAcquired[i] = FALSE;
+        s_voiceState[i] = AX_PB_STATE_STOP;
+        s_voiceAddr[i] = 0;
+    }
+    for (u32 i = 0; i < CMD_QUEUE_SIZE; i++) {
+        s_commands[i].seq = i;
+    }
+    s_cmdTail = 0;
+    s_cmdHead = 0;
+    s_writePos = 0;
+    s_readPos = 0;
+    
+    s_activeVoices = 0;
+    s_framesMixed = 0;
+    s_voiceFrames = 0;
+    s_mixNs = 0;
+    s_maxFrameNs = 0;
+    s_commandsProcessed = 0;
+    s_commandsDropped = 0;
+    s_underruns = 0;
+    
+    s_mode = mode;
+    s_initialized = TRUE;
+    
+    if (mode == AX_MODE_THREAD) {
+        __AtomicStore32(&s_stopRequested, FALSE);
+#ifdef _WIN32
+        s_mixThread = CreateThread(NULL, 0, MixThread, NULL, 0, NULL);
+        s_threadRunning = (s_mixThread != NULL);
+#else
+        s_threadRunning = (pthread_create(&s_mixThread, NULL, MixThread, NULL) == 0);
+#endif
+        if (!s_threadRunning) {
+            OSReport("AX: Failed to start mixer thread\n");
+            s_initialized = FALSE;
+            return;
+        }
+    }
+    
+    OSReport("AX: Initialized (%s, %s kernels)\n",
+             mode == AX_MODE_THREAD ? "mixer thread" : "manual mixing",
+             __AXGetKernelName());
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXQuit
+  
+  Description:  Stop the mixer thread and release all voices. Commands
+                still queued are discarded.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void AXQuit(void) {
+    if (!s_initialized) {
+        return;
+    }
+    
+    if (s_threadRunning) {
+        __AtomicStore32(&s_stopRequested, TRUE);
+#ifdef _WIN32
+        WaitForSingleObject(s_mixThread, INFINITE);
+        CloseHandle(s_mixThread);
+        s_mixThread = NULL;
+#else
+        pthread_join(s_mixThread, NULL);
+#endif
+        s_threadRunning = FALSE;
+    }
+    
+    s_initialized = FALSE;
+    for (u32 i = 0; i < AX_MAX_VOICES; i++) {
+        __AtomicStore32(&s_voiceAcquired[i], FALSE);
+        __AtomicStore32(&s_voiceState[i], AX_PB_STATE_STOP);
+    }
+}
+
+BOOL AXIsInit(void) {
+    return s_initialized;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXAcquireVoice
+  
+  Description:  Allocate a voice. The slot is claimed immediately; its
+                reset reaches the mixer through the command queue, ahead
+                of anything the caller posts next.
+  
+  Arguments:    callback  Called on the mixer thread when a non-looping
+                          voice ends (may be NULL)
+                context   Passed to callback
+  
+  Returns:      Voice, or AX_INVALID_VOICE if none is free
+ *---------------------------------------------------------------------------*/
+AXVoice AXAcquireVoice(AXVoiceCallback callback, void* context) {
+    if (!s_initialized) {
+        return AX_INVALID_VOICE;
+    }
+    
+    for (AXVoice i = 0; i < AX_MAX_VOICES; i++) {
+        if (!__AtomicCompareSwap32(&s_voiceAcquired[i], FALSE, TRUE)) {
+            continue;
+        }
+        
+        AXCommand cmd;
+        cmd.type = CMD_RESET;
+        cmd.voice = i;
+        cmd.u.reset.callback = callback;
+        cmd.u.reset.context = context;
+        if (!PostCommand(&cmd)) {
+            __AtomicStore32(&s_voiceAcquired[i], FALSE);
+            return AX_INVALID_VOICE;
+        }
+        
+        __AtomicStore32(&s_voiceState[i], AX_PB_STATE_STOP);
+        __AtomicStore32(&s_voiceAddr[i], 0);
+        return i;
+    }
+    
+    return AX_INVALID_VOICE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXFreeVoice
+  
+  Description:  Stop and release a voice. The slot becomes available again
+                once the mixer has applied the free.
+  
+  Arguments:    voice  Voice
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void AXFreeVoice(AXVoice voice) {
+    AXCommand cmd;
+    
+    cmd.type = CMD_FREE;
+    if (!PostVoiceCommand(voice, &cmd) && s_initialized &&
+        voice >= 0 && voice < AX_MAX_VOICES && s_voiceAcquired[voice]) {
+        OSReport("AX: Command queue full, voice %d not freed\n", voice);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXSetVoice*
+  
+  Description:  Voice parameter setters. Applied at the next frame.
+  
+                Addresses are in format units from the start of ARAM:
+                nibbles for ADPCM, samples for PCM16, bytes for PCM8.
+  
+  Arguments:    voice  Voice
+                ...    Parameters (see ax.h)
+  
+  Returns:      FALSE if the voice is not acquired or the queue is full
+ *---------------------------------------------------------------------------*/
+BOOL AXSetVoiceAddr(AXVoice voice, const AXPBADDR* addr) {
+    AXCommand cmd;
+    
+    if (!addr) {
+        return FALSE;
+    }
+    
+    cmd.type = CMD_ADDR;
+    cmd.u.addr = *addr;
+    return PostVoiceCommand(voice, &cmd);
+}
+
+BOOL AXSetVoiceAdpcm(AXVoice voice, const AXPBADPCM* adpcm) {
+    AXCommand cmd;
+    
+    if (!adpcm) {
+        return FALSE;
+    }
+    
+    cmd.type = CMD_ADPCM;
+    cmd.u.adpcm = *adpcm;
+    return PostVoiceCommand(voice, &cmd);
+}
+
+BOOL AXSetVoiceSrcRatio(AXVoice voice, f32 ratio) {
+    AXCommand cmd;
+    u32 fixed;
+    
+    if (!(ratio > 0.0f)) {
+        return FALSE;
+    }
+    
+    fixed = (u32)(ratio * 65536.0f + 0.5f);
+    if (fixed > SRC_RATIO_MAX_FIXED) fixed = SRC_RATIO_MAX_FIXED;
+    if (fixed == 0) fixed = 1;
+    
+    cmd.type = CMD_SRC;
+    cmd.u.ratio = fixed;
+    return PostVoiceCommand(voice, &cmd);
+}
+
+BOOL AXSetVoiceMix(AXVoice voice, f32 volume, f32 pan) {
+    AXCommand cmd;
+    
+    if (volume < 0.0f) volume = 0.0f;
+    if (volume > 1.0f) volume = 1.0f;
+    if (pan < -1.0f) pan = -1.0f;
+    if (pan > 1.0f) pan = 1.0f;
+    
+    // Equal-power pan law, computed here to keep trig off the mixer
+    f32 angle = (pan + 1.0f) * 0.78539816f;  // 0 .. pi/2
+    
+    cmd.type = CMD_MIX;
+    cmd.u.mix.left = (s16)(volume * cosf(angle) * 32767.0f + 0.5f);
+    cmd.u.mix.right = (s16)(volume * sinf(angle) * 32767.0f + 0.5f);
+    return PostVoiceCommand(voice, &cmd);
+}
+
+BOOL AXSetVoiceState(AXVoice voice, u32 state) {
+    AXCommand cmd;
+    
+    if (state != AX_PB_STATE_RUN && state != AX_PB_STATE_STOP) {
+        return FALSE;
+    }
+    
+    cmd.type = CMD_STATE;
+    cmd.u.state = state;
+    return PostVoiceCommand(voice, &cmd);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXGetVoiceState / AXGetVoiceCurrentAddr
+  
+  Description:  Voice state as of the last mixed frame.
+  
+  Arguments:    voice  Voice
+  
+  Returns:      AX_PB_STATE_* / address in format units
+ *---------------------------------------------------------------------------*/
+u32 AXGetVoiceState(AXVoice voice) {
+    if (voice < 0 || voice >= AX_MAX_VOICES) {
+        return AX_PB_STATE_STOP;
+    }
+    return __AtomicLoad32(&s_voiceState[voice]);
+}
+
+u32 AXGetVoiceCurrentAddr(AXVoice voice) {
+    if (voice < 0 || voice >= AX_MAX_VOICES) {
+        return 0;
+    }
+    return __AtomicLoad32(&s_voiceAddr[voice]);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXReadOutput
+  
+  Description:  Take mixed audio from the ring (AX_MODE_THREAD). Never
+                blocks; missing samples are silence and count as an
+                underrun.
+  
+  Arguments:    pcm         Interleaved stereo output
+                numSamples  Stereo pairs wanted
+  
+  Returns:      Stereo pairs taken from the mixer
+ *---------------------------------------------------------------------------*/
+u32 AXReadOutput(s16* pcm, u32 numSamples) {
+    u32 produced = 0;
+    
+    if (!pcm || numSamples == 0) {
+        return 0;
+    }
+    
+    if (s_initialized && s_mode == AX_MODE_THREAD) {
+        u32 r = s_readPos;
+        u32 avail = __AtomicLoad32(&s_writePos) - r;
+        
+        produced = (avail < numSamples) ? avail : numSamples;
+        
+        u32 index = r & OUTPUT_RING_MASK;
+        u32 first = OUTPUT_RING_SAMPLES - index;
+        if (first > produced) first = produced;
+        memcpy(pcm, &s_ring[index * 2], first * 2 * sizeof(s16));
+        memcpy(&pcm[first * 2], &s_ring[0], (produced - first) * 2 * sizeof(s16));
+        
+        __AtomicStore32(&s_readPos, r + produced);
+        
+        if (produced < numSamples) {
+            __AtomicAdd32(&s_underruns, 1);
+        }
+    }
+    
+    if (produced < numSamples) {
+        memset(&pcm[produced * 2], 0, (numSamples - produced) * 2 * sizeof(s16));
+    }
+    
+    return produced;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXMix
+  
+  Description:  Mix on the calling thread (AX_MODE_MANUAL), in frames of
+                at most AX_FRAME_SAMPLES. Commands are applied at each
+                frame boundary.
+  
+  Arguments:    pcm         Interleaved stereo output
+                numSamples  Stereo pairs to mix
+  
+  Returns:      FALSE if AX is not initialized in AX_MODE_MANUAL
+ *---------------------------------------------------------------------------*/
+BOOL AXMix(s16* pcm, u32 numSamples) {
+    if (!s_initialized || s_mode != AX_MODE_MANUAL || !pcm) {
+        return FALSE;
+    }
+    
+    while (numSamples > 0) {
+        u32 n = (numSamples < AX_FRAME_SAMPLES) ? numSamples : AX_FRAME_SAMPLES;
+        MixFrame(pcm, n);
+        pcm += n * 2;
+        numSamples -= n;
+    }
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AXGetStats
+  
+  Description:  Snapshot mixer counters. Safe from any thread; counters
+                are read individually, so they may be a frame apart.
+  
+  Arguments:    stats  Receives counters
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void AXGetStats(AXStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    u32 buffered = __AtomicLoad32(&s_writePos) - __AtomicLoad32(&s_readPos);
+    
+    stats->activeVoices = __AtomicLoad32(&s_activeVoices);
+    stats->framesMixed = __AtomicLoad32(&s_framesMixed);
+    stats->voiceFrames = __AtomicLoad64(&s_voiceFrames);
+    stats->mixNanoseconds = __AtomicLoad64(&s_mixNs);
+    stats->maxFrameNanoseconds = s_maxFrameNs;
+    stats->commandsProcessed = __AtomicLoad32(&s_commandsProcessed);
+    stats->commandsDropped = __AtomicLoad32(&s_commandsDropped);
+    stats->underruns = __AtomicLoad32(&s_underruns);
+    stats->bufferedSamples = (buffered <= OUTPUT_RING_SAMPLES) ? buffered : 0;
+}
@@ -0,0 +1,323 @@
+/*---------------------------------------------------------------------------*
+  AXMix.c - AX Decode and Mix Kernels
+  
+  On GC/Wii: The DSP's accelerator decodes ADPCM/PCM from ARAM in
+             hardware; the AX microcode resamples and mixes.
+  
+  On PC: These loops are where the mixer spends its time, so each has an
+         SSE2 (x86) or NEON (ARM) version, chosen at compile time since
+         both are baseline on their 64-bit targets. All versions produce
+         bit-identical output to the scalar code.
+  
+  DSP-ADPCM:
+  Each sample depends on the two before it, so the predictor cannot run
+  across lanes. The vector code expands a whole frame's nibbles into
+  scaled terms (nibble << scale << 11) at once; the 14-step recurrence
+  that follows is a multiply-add and a clamp per sample.
+  
+  RESAMPLING:
+  Linear interpolation at 16.16 fixed point (the hardware uses a 4-tap
+  polyphase filter). Positions are data-dependent gathers, so this stays
+  scalar; ratio 1.0 at phase 0 is a plain copy.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/ax_internal.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AX_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define AX_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+  Name:         ExpandFrame
+  
+  Description:  Sign-extend the 16 nibbles of an ADPCM frame (two header
+                nibbles, then 14 samples) and scale them for the predictor.
+  
+  Arguments:    frame  Frame (8 bytes, header first)
+                shift  Scale exponent from the header, plus 11
+                terms  Receives 16 scaled nibbles; samples are terms[2..15]
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ExpandFrame(const u8* frame, u32 shift, s32* terms) {
+#if defined(AX_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low = _mm_set1_epi8(0x0F);
+    __m128i raw = _mm_loadl_epi64((const __m128i*)frame);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(raw, 4), low);
+    __m128i lo = _mm_and_si128(raw, low);
+    __m128i nib = _mm_slli_epi16(_mm_unpacklo_epi8(hi, lo), 4);  // High nibble first
+    
+    // Nibble into the top of a 16-bit lane, arithmetic shift back down
+    __m128i w0 = _mm_srai_epi16(_mm_unpacklo_epi8(zero, nib), 12);
+    __m128i w1 = _mm_srai_epi16(_mm_unpackhi_epi8(zero, nib), 12);
+    __m128i count = _mm_cvtsi32_si128((int)shift);
+    
+    _mm_storeu_si128((__m128i*)&terms[0],
+        _mm_sll_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(zero, w0), 16), count));
+    _mm_storeu_si128((__m128i*)&terms[4],
+        _mm_sll_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(zero, w0), 16), count));
+    _mm_storeu_si128((__m128i*)&terms[8],
+        _mm_sll_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(zero, w1), 16), count));
+    _mm_storeu_si128((__m128i*)&terms[12],
+        _mm_sll_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(zero, w1), 16), count));
+#elif defined(AX_NEON)
+    uint8x8_t raw = vld1_u8(frame);
+    uint8x8x2_t nib = vzip_u8(vshr_n_u8(raw, 4), vand_u8(raw, vdup_n_u8(0x0F)));
+    int32x4_t count = vdupq_n_s32((s32)shift);
+    
+    for (u32 half = 0; half < 2; half++) {
+        int8x8_t n = vshr_n_s8(vshl_n_s8(vreinterpret_s8_u8(nib.val[half]), 4), 4);
+        int16x8_t w = vmovl_s8(n);
+        vst1q_s32(&terms[half * 8 + 0], vshlq_s32(vmovl_s16(vget_low_s16(w)), count));
+        vst1q_s32(&terms[half * 8 + 4], vshlq_s32(vmovl_s16(vget_high_s16(w)), count));
+    }
+#else
+    for (u32 i = 0; i < 16; i++) {
+        u32 byte = frame[i >> 1];
+        s32 nibble = (s32)((i & 1) ? (byte & 0xF) : (byte >> 4));
+        terms[i] = (nibble >= 8 ? nibble - 16 : nibble) * (s32)(1u << shift);
+    }
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXDecodeADPCM
+  
+  Description:  Decode part of one DSP-ADPCM frame:
+                  s = clamp16((terms + 1024 + c1 * yn1 + c2 * yn2) >> 11)
+  
+  Arguments:    frame  Frame (header byte first)
+                first  First sample to decode (0-13)
+                count  Samples to decode (first + count <= 14)
+                coefs  Eight predictor coefficient pairs
+                hist   {yn1, yn2}, updated
+                out    Receives count samples
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __AXDecodeADPCM(const u8* frame, u32 first, u32 count, const s16* coefs,
+                     s16* hist, s16* out) {
+    s32 terms[16];
+    u32 pred = (frame[0] >> 4) & 7;
+    s32 c1 = coefs[pred * 2 + 0];
+    s32 c2 = coefs[pred * 2 + 1];
+    s32 yn1 = hist[0];
+    s32 yn2 = hist[1];
+    
+    ExpandFrame(frame, (frame[0] & 0xF) + 11, terms);
+    
+    for (u32 i = 0; i < count; i++) {
+        s32 s = (terms[first + i + 2] + 1024 + c1 * yn1 + c2 * yn2) >> 11;
+        if (s > 32767) s = 32767;
+        if (s < -32768) s = -32768;
+        out[i] = (s16)s;
+        yn2 = yn1;
+        yn1 = s;
+    }
+    
+    hist[0] = (s16)yn1;
+    hist[1] = (s16)yn2;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXDecodePCM16
+  
+  Description:  Convert big-endian ARAM samples to host order.
+  
+  Arguments:    src    Samples in ARAM
+                out    Receives count samples
+                count  Samples
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __AXDecodePCM16(const u8* src, s16* out, u32 count) {
+    u32 i = 0;
+
+#if defined(AX_SSE2)
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 2));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(out + i), v);
+    }
+#elif defined(AX_NEON)
+    for (; i + 8 <= count; i += 8) {
+        uint8x16_t v = vrev16q_u8(vld1q_u8(src + i * 2));
+        vst1q_s16(out + i, vreinterpretq_s16_u8(v));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (s16)((src[i * 2] << 8) | src[i * 2 + 1]);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXDecodePCM8
+  
+  Description:  Widen signed 8-bit samples to 16 bits.
+  
+  Arguments:    src    Samples in ARAM
+                out    Receives count samples
+                count  Samples
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __AXDecodePCM8(const u8* src, s16* out, u32 count) {
+    u32 i = 0;
+
+#if defined(AX_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(zero, v));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(zero, v));
+    }
+#elif defined(AX_NEON)
+    for (; i + 16 <= count; i += 16) {
+        int8x16_t v = vld1q_s8((const s8*)(src + i));
+        vst1q_s16(out + i, vshll_n_s8(vget_low_s8(v), 8));
+        vst1q_s16(out + i + 8, vshll_n_s8(vget_high_s8(v), 8));
+    }
+#endif
+
+    for (; i < count; i++) {
+        out[i] = (s16)((u16)src[i] << 8);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXResample
+  
+  Description:  Linear interpolation sample rate conversion.
+  
+  Arguments:    in     Source samples (see ax_internal.h for the length)
+                out    Receives count samples
+                count  Output samples
+                frac   Start position (16.16, < 1.0)
+                ratio  Step per output sample (16.16)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __AXResample(const s16* in, s16* out, u32 count, u32 frac, u32 ratio) {
+    if (ratio == 0x10000 && frac == 0) {
+        memcpy(out, in, count * sizeof(s16));
+        return;
+    }
+    
+    u32 pos = frac;
+    for (u32 i = 0; i < count; i++, pos += ratio) {
+        const s16* s = &in[pos >> 16];
+        s32 t = (s32)((pos & 0xFFFF) >> 1);  // 15 bits so the product fits
+        out[i] = (s16)(s[0] + ((((s32)s[1] - s[0]) * t) >> 15));
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXMixVoice
+  
+  Description:  Add a mono voice to the stereo accumulator.
+  
+  Arguments:    acc    Interleaved stereo accumulator
+                in     Voice samples
+                count  Samples
+                left   Left gain (1.15)
+                right  Right gain (1.15)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __AXMixVoice(s32* acc, const s16* in, u32 count, s16 left, s16 right) {
+    u32 i = 0;
+
+#if defined(AX_SSE2)
+    const __m128i gl = _mm_set1_epi16(left);
+    const __m128i gr = _mm_set1_epi16(right);
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i ll = _mm_mullo_epi16(s, gl), lh = _mm_mulhi_epi16(s, gl);
+        __m128i rl = _mm_mullo_epi16(s, gr), rh = _mm_mulhi_epi16(s, gr);
+        __m128i l0 = _mm_srai_epi32(_mm_unpacklo_epi16(ll, lh), 15);
+        __m128i l1 = _mm_srai_epi32(_mm_unpackhi_epi16(ll, lh), 15);
+        __m128i r0 = _mm_srai_epi32(_mm_unpacklo_epi16(rl, rh), 15);
+        __m128i r1 = _mm_srai_epi32(_mm_unpackhi_epi16(rl, rh), 15);
+        __m128i* a = (__m128i*)(acc + i * 2);
+        
+        _mm_storeu_si128(a + 0, _mm_add_epi32(_mm_loadu_si128(a + 0), _mm_unpacklo_epi32(l0, r0)));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi32(l0, r0)));
+        _mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2), _mm_unpacklo_epi32(l1, r1)));
+        _mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3), _mm_unpackhi_epi32(l1, r1)));
+    }
+#elif defined(AX_NEON)
+    for (; i + 4 <= count; i += 4) {
+        int16x4_t s = vld1_s16(in + i);
+        int32x4x2_t lr = vzipq_s32(vshrq_n_s32(vmull_n_s16(s, left), 15),
+                                   vshrq_n_s32(vmull_n_s16(s, right), 15));
+        vst1q_s32(acc + i * 2, vaddq_s32(vld1q_s32(acc + i * 2), lr.val[0]));
+        vst1q_s32(acc + i * 2 + 4, vaddq_s32(vld1q_s32(acc + i * 2 + 4), lr.val[1]));
+    }
+#endif
+
+    for (; i < count; i++) {
+        acc[i * 2 + 0] += ((s32)in[i] * left) >> 15;
+        acc[i * 2 + 1] += ((s32)in[i] * right) >> 15;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXClampOutput
+  
+  Description:  Saturate the accumulator to the output format.
+  
+  Arguments:    acc    Interleaved stereo accumulator
+                out    Interleaved stereo output
+                count  Stereo pairs
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __AXClampOutput(const s32* acc, s16* out, u32 count) {
+    u32 n = count * 2;
+    u32 i = 0;
+
+#if defined(AX_SSE2)
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(acc + i + 4));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+#elif defined(AX_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x4_t a = vqmovn_s32(vld1q_s32(acc + i));
+        int16x4_t b = vqmovn_s32(vld1q_s32(acc + i + 4));
+        vst1q_s16(out + i, vcombine_s16(a, b));
+    }
+#endif
+
+    for (; i < n; i++) {
+        s32 v = acc[i];
+        out[i] = (s16)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __AXGetKernelName
+  
+  Description:  Name of the compiled-in kernel set, for the startup log.
+  
+  Arguments:    None
+  
+  Returns:      "SSE2", "NEON" or "Scalar"
+ *---------------------------------------------------------------------------*/
+const char* __AXGetKernelName(void) {
+#if defined(AX_SSE2)
+    return "SSE2";
+#elif defined(AX_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
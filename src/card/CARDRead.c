@@ -8,6 +8,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef PORPOISE_USE_GECKO_MEMORY
+#include <dolphin/gecko_memory.h>
+#endif
+
 /*---------------------------------------------------------------------------*
   Name:         CARDReadAsync
 
@@ -57,7 +61,14 @@ s32 CARDReadAsync(CARDFileInfo* fileInfo, void* buf, s32 length,
         return CARD_RESULT_IOERROR;
     }
     
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    // fread into a write-protected savestate page fails instead of faulting
+    GeckoSavestatePrepareWrite(buf, length > 0 ? (u32)length : 0);
+#endif
     size_t bytesRead = fread(buf, 1, length, file);
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    GeckoSavestateEndWrite();
+#endif
     fclose(file);
     
     if (callback) {
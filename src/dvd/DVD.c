@@ -22,9 +22,10 @@
   - Standard fopen/fread/fseek operations
   - Virtual FST built from directory scanning
   - Files in normal directory structure
-  - Synchronous reads (simulated async with threading)
-  - No real queue - OS handles file I/O
-  - Instant access (no seek latency)
+  - Synchronous reads (async reads serviced by one reader thread)
+  - Async reads queued by priority, read in cancelable chunks
+  - Instant access (no seek latency) unless the optional drive latency
+    model in DVDLatency.c is enabled
   - Files stored contiguously
   - No practical size limit
   
@@ -39,16 +40,18 @@
   - Path-based file access
   - Directory operations
   - Asynchronous callback system
-  - Priority concept (though not enforced)
+  - Priority queues for async reads
+  - Cancellation of queued and in-flight reads
   - File info structures
   
   WHAT'S DIFFERENT:
   - No FST parsing - we scan directory on init
   - No DMA hardware - we use fread()
-  - Async operations use background threads (not DI interrupts)
+  - Async operations use a background reader thread (not DI interrupts)
   - No disc spin-up time - instant access
   - Root path configurable ("files/" by default)
-  - Can access files outside disc image for modding
+  - Patch/mod layers (directories, disc images, U8 archives) can be
+    mounted over the root - see DVDOverlay.c
   
   DIRECTORY STRUCTURE:
   - Game files placed in "files/" folder
@@ -59,48 +62,35 @@
 
 #include <dolphin/dvd.h>
 #include <dolphin/dvd_internal.h>
+#include <dolphin/ar_internal.h>
 #include <dolphin/os.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
+#ifdef PORPOISE_USE_GECKO_MEMORY
+#include <dolphin/gecko_memory.h>
+#endif
+
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
-#define PATH_SEPARATOR '\\'
 #define mkdir(path, mode) _mkdir(path)
 #define stat _stat
 #else
 #include <unistd.h>
-#include <dirent.h>
 #include <pthread.h>
-#define PATH_SEPARATOR '/'
 #endif
 
 /*---------------------------------------------------------------------------*
     Internal Structures
  *---------------------------------------------------------------------------*/
 
-// Internal file entry (virtual FST)
-typedef struct DVDEntry {
-    char*   path;                   // Full path
-    u32     offset;                 // Offset (always 0 for PC files)
-    u32     length;                 // File size
-    BOOL    isDir;                  // TRUE if directory
-} DVDEntry;
-
-// Internal directory state
+// Internal directory state (snapshot of the merged listing)
 typedef struct DVDDirState {
-    char    path[512];              // Full path to directory
-#ifdef _WIN32
-    HANDLE  handle;                 // Windows FindFirstFile handle
-    WIN32_FIND_DATAA findData;      // Current find data
-    BOOL    firstRead;              // TRUE if haven't read first entry yet
-#else
-    DIR*    handle;                 // POSIX directory handle
-    struct dirent* entry;           // Current entry
-#endif
+    DVDOverlayDirEntry* entries;    // Sorted entries (from DVDOverlay.c)
+    u32     count;                  // Number of entries
 } DVDDirState;
 
 // Directory state pool
@@ -116,11 +106,6 @@ static BOOL s_initialized = FALSE;
 static char s_rootPath[256] = "files/";        // Default root directory
 static char s_currentDir[256] = "/";           // Current directory (relative to root)
 
-// Virtual FST (File System Table)
-static DVDEntry* s_fst = NULL;
-static u32 s_fstSize = 0;
-static u32 s_fstCapacity = 0;
-
 // Disc ID (fake for PC)
 static DVDDiskID s_diskID = {
     .gameName = {'P', 'O', 'R', 'P'},
@@ -138,6 +123,185 @@ static DVDDiskID s_diskID = {
 static DVDCommandBlock s_commandBlocks[MAX_COMMAND_BLOCKS];
 static BOOL s_commandBlockUsed[MAX_COMMAND_BLOCKS];
 
+/*---------------------------------------------------------------------------*
+    Async Reader State
+    
+    All async reads go through the waiting queues in DVDQueue.c and are
+    serviced by a single reader thread, like the single DI channel on
+    hardware. The lock protects the queues, s_executing and the cancel
+    bookkeeping; s_workCond wakes the reader, s_doneCond wakes threads
+    waiting in DVDCancel/DVDCancelAll.
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static CRITICAL_SECTION s_asyncLock;
+static CONDITION_VARIABLE s_workCond;
+static CONDITION_VARIABLE s_doneCond;
+static BOOL s_lockInit = FALSE;
+static HANDLE s_readerThread = NULL;
+#else
+static pthread_mutex_t s_asyncLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_workCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t s_doneCond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_readerThread;
+#endif
+static BOOL s_readerStarted = FALSE;
+
+static DVDCommandBlock* s_executing = NULL;       // Block being read right now
+static BOOL s_cancelAllPending = FALSE;           // DVDCancelAll waiting on s_executing
+
+// A cancel callback waiting for a cancel already under way: for one block,
+// or (block NULL) for the pending DVDCancelAll. Fired in arrival order.
+typedef struct CancelWaiter {
+    struct CancelWaiter* next;
+    DVDCommandBlock*     block;
+    DVDFileInfo*         fileInfo;
+    DVDCallback          callback;       // Block waiters
+    DVDCBCallback        allCallback;    // DVDCancelAll waiters
+} CancelWaiter;
+
+static CancelWaiter* s_cancelWaiters = NULL;
+
+static void LockAsync(void) {
+#ifdef _WIN32
+    if (!s_lockInit) {
+        InitializeCriticalSection(&s_asyncLock);
+        InitializeConditionVariable(&s_workCond);
+        InitializeConditionVariable(&s_doneCond);
+        s_lockInit = TRUE;
+    }
+    EnterCriticalSection(&s_asyncLock);
+#else
+    pthread_mutex_lock(&s_asyncLock);
+#endif
+}
+
+static void UnlockAsync(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_asyncLock);
+#else
+    pthread_mutex_unlock(&s_asyncLock);
+#endif
+}
+
+// Wait on a condition; caller holds the async lock
+static void WaitAsync(void* cond) {
+#ifdef _WIN32
+    SleepConditionVariableCS((CONDITION_VARIABLE*)cond, &s_asyncLock, INFINITE);
+#else
+    pthread_cond_wait((pthread_cond_t*)cond, &s_asyncLock);
+#endif
+}
+
+static void SignalWork(void) {
+#ifdef _WIN32
+    WakeConditionVariable(&s_workCond);
+#else
+    pthread_cond_signal(&s_workCond);
+#endif
+}
+
+static void BroadcastDone(void) {
+#ifdef _WIN32
+    WakeAllConditionVariable(&s_doneCond);
+#else
+    pthread_cond_broadcast(&s_doneCond);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AddCancelWaiter
+  
+  Description:  Queue a callback for when a cancel under way completes.
+                Caller holds the async lock.
+  
+  Arguments:    block        Block being canceled, or NULL for DVDCancelAll
+                fileInfo     Passed to callback
+                callback     Block cancel callback
+                allCallback  DVDCancelAll callback
+  
+  Returns:      FALSE if out of memory (the caller fires it right away)
+ *---------------------------------------------------------------------------*/
+static BOOL AddCancelWaiter(DVDCommandBlock* block, DVDFileInfo* fileInfo,
+                            DVDCallback callback, DVDCBCallback allCallback) {
+    CancelWaiter* waiter = (CancelWaiter*)malloc(sizeof(CancelWaiter));
+    
+    if (!waiter) {
+        return FALSE;
+    }
+    waiter->next = NULL;
+    waiter->block = block;
+    waiter->fileInfo = fileInfo;
+    waiter->callback = callback;
+    waiter->allCallback = allCallback;
+    
+    CancelWaiter** link = &s_cancelWaiters;
+    while (*link) {
+        link = &(*link)->next;
+    }
+    *link = waiter;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         TakeCancelWaiters
+  
+  Description:  Unlink the waiters of a block (or of DVDCancelAll) in
+                order. Caller holds the async lock.
+  
+  Arguments:    block  Block whose cancel completed, or NULL
+  
+  Returns:      List to pass to FireCancelWaiters
+ *---------------------------------------------------------------------------*/
+static CancelWaiter* TakeCancelWaiters(DVDCommandBlock* block) {
+    CancelWaiter* taken = NULL;
+    CancelWaiter** tail = &taken;
+    CancelWaiter** link = &s_cancelWaiters;
+    
+    while (*link) {
+        CancelWaiter* waiter = *link;
+        if (waiter->block == block) {
+            *link = waiter->next;
+            waiter->next = NULL;
+            *tail = waiter;
+            tail = &waiter->next;
+        } else {
+            link = &waiter->next;
+        }
+    }
+    return taken;
+}
+
+// Call and free waiters taken with TakeCancelWaiters (without the lock)
+static void FireCancelWaiters(CancelWaiter* waiter) {
+    while (waiter) {
+        CancelWaiter* next = waiter->next;
+        if (waiter->block) {
+            waiter->callback(DVD_RESULT_CANCELED, waiter->fileInfo);
+        } else {
+            waiter->allCallback(DVD_RESULT_GOOD, NULL);
+        }
+        free(waiter);
+        waiter = next;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PrioToQueue
+  
+  Description:  Map a DVD_PRIO_* value to a waiting queue index. The waiting
+                queues are serviced from index 0 upward.
+  
+  Arguments:    prio  DVD_PRIO_* value
+  
+  Returns:      Queue index (0 = serviced first, 3 = serviced last)
+ *---------------------------------------------------------------------------*/
+static s32 PrioToQueue(s32 prio) {
+    if (prio >= DVD_PRIO_HIGH) return 0;
+    if (prio > DVD_PRIO_MEDIUM) return 1;
+    if (prio > DVD_PRIO_LOW) return 2;
+    return 3;
+}
+
 /*---------------------------------------------------------------------------*
   Name:         AllocCommandBlock
 
@@ -180,50 +344,103 @@ static void FreeCommandBlock(DVDCommandBlock* cb) {
 }
 
 /*---------------------------------------------------------------------------*
-  Name:         BuildPath
+  Name:         BuildDVDPath
 
-  Description:  Build absolute filesystem path from DVD path.
-                Combines root path + current dir + relative path.
+  Description:  Resolve a DVD path against the current directory into the
+                form used by the layer index: relative to the disc root,
+                '/' separated, no leading slash, "." and ".." resolved.
 
   Arguments:    dvdPath  DVD path (may be absolute or relative)
-                outPath  Buffer to receive full path
+                outPath  Buffer to receive the normalized path
                 maxLen   Buffer size
 
   Returns:      None
  *---------------------------------------------------------------------------*/
-static void BuildPath(const char* dvdPath, char* outPath, size_t maxLen) {
-    // Start with root
-    strncpy(outPath, s_rootPath, maxLen - 1);
-    outPath[maxLen - 1] = '\0';
-    
-    // Add current directory if path is relative
-    if (dvdPath[0] != '/') {
-        if (strcmp(s_currentDir, "/") != 0) {
-            strncat(outPath, s_currentDir + 1, maxLen - strlen(outPath) - 1);
-            strncat(outPath, "/", maxLen - strlen(outPath) - 1);
-        }
+static void BuildDVDPath(const char* dvdPath, char* outPath, size_t maxLen) {
+    char joined[512];
+    size_t len = 0;
+    
+    // Relative paths start from the current directory
+    if (dvdPath[0] == '/' || dvdPath[0] == '\\') {
+        snprintf(joined, sizeof(joined), "%s", dvdPath);
     } else {
-        dvdPath++;  // Skip leading slash
+        snprintf(joined, sizeof(joined), "%s/%s", s_currentDir, dvdPath);
+    }
+    
+    outPath[0] = '\0';
+    
+    char* segment = joined;
+    while (*segment) {
+        char* end = segment;
+        while (*end && *end != '/' && *end != '\\') end++;
+        size_t segLen = (size_t)(end - segment);
+        
+        if (segLen == 0 || (segLen == 1 && segment[0] == '.')) {
+            // Empty or "." - nothing to add
+        } else if (segLen == 2 && segment[0] == '.' && segment[1] == '.') {
+            // ".." - drop the last component
+            while (len > 0 && outPath[len - 1] != '/') len--;
+            if (len > 0) len--;
+            outPath[len] = '\0';
+        } else if (len + (len ? 1 : 0) + segLen < maxLen) {
+            if (len) outPath[len++] = '/';
+            memcpy(outPath + len, segment, segLen);
+            len += segLen;
+            outPath[len] = '\0';
+        }
+        
+        segment = *end ? end + 1 : end;
     }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ReadChunked
+  
+  Description:  Perform the file read for an async command block. The read
+                is split into DVD_ASYNC_CHUNK_SIZE pieces and stops early if
+                a cancel is requested between chunks.
+  
+  Arguments:    cb  Command block (owned by the reader thread while running)
+  
+  Returns:      None (updates cb->transferredSize)
+ *---------------------------------------------------------------------------*/
+static void ReadChunked(DVDCommandBlock* cb) {
+    u8* dest = (u8*)cb->addr;
+    s32 done = 0;
     
-    // Add the requested path
-    strncat(outPath, dvdPath, maxLen - strlen(outPath) - 1);
+    fseek(cb->file, (long)(cb->baseOffset + (u32)cb->offset), SEEK_SET);
     
-    // Convert slashes to platform separator
-#ifdef _WIN32
-    for (char* p = outPath; *p; p++) {
-        if (*p == '/') *p = '\\';
-    }
+    while (done < cb->length && !cb->cancelRequested) {
+        s32 chunk = cb->length - done;
+        if (chunk > DVD_ASYNC_CHUNK_SIZE) {
+            chunk = DVD_ASYNC_CHUNK_SIZE;
+        }
+        
+#ifdef PORPOISE_USE_GECKO_MEMORY
+        GeckoSavestatePrepareWrite(dest + done, (u32)chunk);
+#endif
+        size_t bytesRead = fread(dest + done, 1, (size_t)chunk, cb->file);
+#ifdef PORPOISE_USE_GECKO_MEMORY
+        GeckoSavestateEndWrite();
 #endif
+        done += (s32)bytesRead;
+        cb->transferredSize = done;
+        
+        if ((s32)bytesRead < chunk) {
+            break;  // EOF or I/O error - report what we got
+        }
+    }
 }
 
 /*---------------------------------------------------------------------------*
   Name:         AsyncReadThread
 
-  Description:  Background thread for async read operations.
-                Simulates disc DMA by reading file in background.
+  Description:  Background reader thread. Simulates the DI by popping the
+                highest priority command from the waiting queues and reading
+                it in chunks. Canceled commands complete with
+                DVD_RESULT_CANCELED, then their cancel callback fires.
 
-  Arguments:    arg  Pointer to DVDCommandBlock
+  Arguments:    arg  Unused
 
   Returns:      0 (thread return value)
  *---------------------------------------------------------------------------*/
@@ -233,22 +450,77 @@ static DWORD WINAPI AsyncReadThread(LPVOID arg)
 static void* AsyncReadThread(void* arg)
 #endif
 {
-    DVDCommandBlock* cb = (DVDCommandBlock*)arg;
-    
-    // Perform the read
-    if (cb->file) {
-        fseek(cb->file, cb->offset, SEEK_SET);
-        size_t bytesRead = fread(cb->addr, 1, cb->length, cb->file);
-        cb->result = (s32)bytesRead;
-        cb->state = DVD_STATE_END;
-    } else {
-        cb->result = DVD_RESULT_FATAL_ERROR;
-        cb->state = DVD_STATE_END;
-    }
-    
-    // Call user callback
-    if (cb->callback) {
-        ((DVDCallback)cb->callback)(cb->result, cb->fileInfo);
+    (void)arg;
+    
+    for (;;) {
+        DVDCommandBlock* cb;
+        
+        LockAsync();
+        while ((cb = __DVDPopWaitingQueue()) == NULL) {
+            WaitAsync(&s_workCond);
+        }
+        s_executing = cb;
+        cb->state = DVD_STATE_BUSY;
+        UnlockAsync();
+        
+        if (!cb->cancelRequested) {
+            ReadChunked(cb);
+            __DVDLatencyWait(cb->fileInfo, cb->offset, cb->transferredSize,
+                             cb->issueTime, TRUE, &cb->cancelRequested);
+        }
+        
+        LockAsync();
+        s_executing = NULL;
+        
+        BOOL canceled = cb->cancelRequested;
+        DVDCallback callback = cb->callback;
+        ARQRequest* aramRequest = cb->aramRequest;
+        DVDCallback cancelCallback = cb->cancelCallback;
+        DVDFileInfo* fileInfo = cb->fileInfo;
+        
+        if (canceled) {
+            cb->state = DVD_STATE_CANCELED;
+            cb->result = DVD_RESULT_CANCELED;
+        } else {
+            cb->state = DVD_STATE_END;
+            cb->result = cb->transferredSize;
+        }
+        cb->aramRequest = NULL;
+        
+        CancelWaiter* allWaiters = NULL;
+        if (s_cancelAllPending) {
+            allWaiters = TakeCancelWaiters(NULL);
+            s_cancelAllPending = FALSE;
+        }
+        UnlockAsync();
+        
+        // Completion callbacks run without the lock so they may queue more work
+        if (aramRequest) {
+            if (!canceled) {
+                aramRequest->length = (u32)cb->result;
+                __ARQComplete(aramRequest);
+            }
+        } else if (callback) {
+            callback(cb->result, fileInfo);
+        }
+        if (canceled && cancelCallback) {
+            cancelCallback(DVD_RESULT_CANCELED, fileInfo);
+        }
+        FireCancelWaiters(allWaiters);
+        
+        // Only now is the cancellation complete - release DVDCancel waiters,
+        // including DVDCancelAsync calls that arrived while the callbacks ran
+        CancelWaiter* waiters = NULL;
+        LockAsync();
+        if (canceled) {
+            waiters = TakeCancelWaiters(cb);
+            cb->cancelRequested = FALSE;
+            cb->cancelCallback = NULL;
+        }
+        BroadcastDone();
+        UnlockAsync();
+        
+        FireCancelWaiters(waiters);
     }
     
 #ifdef _WIN32
@@ -258,6 +530,38 @@ static void* AsyncReadThread(void* arg)
 #endif
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         StartReaderThread
+  
+  Description:  Create the async reader thread on first use.
+  
+  Arguments:    None
+  
+  Returns:      TRUE if the reader thread is running
+ *---------------------------------------------------------------------------*/
+static BOOL StartReaderThread(void) {
+    if (s_readerStarted) {
+        return TRUE;
+    }
+    
+#ifdef _WIN32
+    s_readerThread = CreateThread(NULL, 0, AsyncReadThread, NULL, 0, NULL);
+    if (!s_readerThread) {
+        OSReport("DVD: Failed to start async reader thread\n");
+        return FALSE;
+    }
+#else
+    if (pthread_create(&s_readerThread, NULL, AsyncReadThread, NULL) != 0) {
+        OSReport("DVD: Failed to start async reader thread\n");
+        return FALSE;
+    }
+    pthread_detach(s_readerThread);
+#endif
+    
+    s_readerStarted = TRUE;
+    return TRUE;
+}
+
 /*---------------------------------------------------------------------------*
   Name:         DVDInit
 
@@ -296,9 +600,16 @@ BOOL DVDInit(void) {
     memset(s_dirStates, 0, sizeof(s_dirStates));
     memset(s_dirStateUsed, 0, sizeof(s_dirStateUsed));
     
+    // Initialize async read queues and start the reader
+    __DVDClearWaitingQueue();
+    StartReaderThread();
+    
     // Initialize current directory
     strcpy(s_currentDir, "/");
     
+    // Index the root directory as the bottom layer
+    __DVDOverlaySetBase(s_rootPath);
+    
     s_initialized = TRUE;
     OSReport("DVD: Initialization complete\n");
     
@@ -311,7 +622,9 @@ BOOL DVDInit(void) {
   Description:  Open a file from the disc file system.
                 
                 On GC/Wii: Looks up file in FST, gets offset/length
-                On PC: Opens file using fopen() with path relative to "files/"
+                On PC: Resolves the path in the layer index (DVDOverlay.c)
+                       and opens the winning loose file, or the disc image
+                       or archive that contains it
 
   Arguments:    fileName  Path to file (relative to DVD root)
                 fileInfo  Pointer to DVDFileInfo to fill
@@ -323,21 +636,30 @@ BOOL DVDOpen(const char* fileName, DVDFileInfo* fileInfo) {
         return FALSE;
     }
     
-    // Build full path
-    char fullPath[512];
-    BuildPath(fileName, fullPath, sizeof(fullPath));
+    // Resolve to the winning layer
+    char dvdPath[512];
+    DVDOverlayFile source;
+    BuildDVDPath(fileName, dvdPath, sizeof(dvdPath));
+    
+    if (!__DVDOverlayLookup(dvdPath, &source) || source.isDir) {
+        OSReport("DVD: Failed to open file: /%s\n", dvdPath);
+        return FALSE;
+    }
     
     // Try to open file
-    FILE* file = fopen(fullPath, "rb");
+    FILE* file = fopen(source.hostPath, "rb");
     if (!file) {
-        OSReport("DVD: Failed to open file: %s\n", fullPath);
+        OSReport("DVD: Failed to open file: %s\n", source.hostPath);
         return FALSE;
     }
     
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long size = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    // Get file size (loose files may have changed since they were indexed)
+    long size = (long)source.length;
+    if (source.baseOffset == 0) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+    }
+    fseek(file, (long)source.baseOffset, SEEK_SET);
     
     // Allocate command block
     DVDCommandBlock* cb = AllocCommandBlock();
@@ -349,9 +671,10 @@ BOOL DVDOpen(const char* fileName, DVDFileInfo* fileInfo) {
     
     // Fill in file info
     cb->file = file;
+    cb->baseOffset = source.baseOffset;
     cb->state = DVD_STATE_END;
     fileInfo->cb = cb;
-    fileInfo->startAddr = 0;
+    fileInfo->startAddr = __DVDLatencyGetDiscAddress(dvdPath, (u32)size);
     fileInfo->length = (u32)size;
     fileInfo->callback = NULL;
     
@@ -380,6 +703,12 @@ BOOL DVDClose(DVDFileInfo* fileInfo) {
     
     DVDCommandBlock* cb = fileInfo->cb;
     
+    // The reader thread must be done with the block before we free it
+    if (cb->state == DVD_STATE_BUSY || cb->state == DVD_STATE_WAITING) {
+        DVDCancel(fileInfo);
+    }
+    __DVDStreamBlockClosed(cb);
+    
     // Close file handle
     if (cb->file) {
         fclose(cb->file);
@@ -399,7 +728,9 @@ BOOL DVDClose(DVDFileInfo* fileInfo) {
   Description:  Read from file synchronously with priority.
                 
                 On GC/Wii: Queues read command with priority, waits for completion
-                On PC: Reads immediately using fread() (priority ignored)
+                On PC: Reads immediately using fread() (priority ignored);
+                       with a latency model set, returns when the modeled
+                       drive would have finished
 
   Arguments:    fileInfo  Pointer to open file
                 addr      Destination buffer
@@ -431,9 +762,20 @@ s32 DVDReadPrio(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset, s32 p
         return 0;
     }
     
+    OSTime issueTime = OSGetTime();
+    
     // Seek and read
-    fseek(cb->file, offset, SEEK_SET);
+    fseek(cb->file, (long)(cb->baseOffset + (u32)offset), SEEK_SET);
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    GeckoSavestatePrepareWrite(addr, (u32)length);
+#endif
     size_t bytesRead = fread(addr, 1, length, cb->file);
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    GeckoSavestateEndWrite();
+#endif
+    
+    // Take as long as the drive would (no-op unless a model is set)
+    __DVDLatencyWait(fileInfo, offset, (s32)bytesRead, issueTime, FALSE, NULL);
     
     return (s32)bytesRead;
 }
@@ -455,33 +797,45 @@ s32 DVDRead(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset) {
 }
 
 /*---------------------------------------------------------------------------*
-  Name:         DVDReadAsyncPrio
-
-  Description:  Read from file asynchronously with priority.
-                
-                On GC/Wii: Queues read command, returns immediately, callback
-                           called from DI interrupt when complete
-                On PC: Spawns background thread to simulate async operation
-
-  Arguments:    fileInfo  Pointer to open file
-                addr      Destination buffer
-                length    Number of bytes to read
-                offset    Offset in file
-                callback  Callback when complete (or NULL)
-                prio      Priority (ignored on PC)
-
-  Returns:      TRUE if read started successfully
+  Name:         QueueRead
+  
+  Description:  Queue an async read for the reader thread.
+  
+  Arguments:    fileInfo     Pointer to open file
+                addr         Destination buffer
+                length       Number of bytes to read
+                offset       Offset in file
+                callback     Callback when complete (or NULL)
+                prio         Priority (DVD_PRIO_*)
+                aramRequest  ARQ request to complete instead of calling
+                             callback (DVDReadToARAMAsync), or NULL
+  
+  Returns:      TRUE if the read was queued
  *---------------------------------------------------------------------------*/
-BOOL DVDReadAsyncPrio(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
-                      DVDCallback callback, s32 prio) {
-    (void)prio;
-    
+static BOOL QueueRead(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
+                      DVDCallback callback, s32 prio, ARQRequest* aramRequest) {
     if (!fileInfo || !fileInfo->cb || !addr || length < 0) {
         return FALSE;
     }
     
     DVDCommandBlock* cb = fileInfo->cb;
-    if (!cb->file) {
+    if (!cb->file || !StartReaderThread()) {
+        return FALSE;
+    }
+    
+    // Clamp to file size
+    if (offset < 0) offset = 0;
+    if (offset > (s32)fileInfo->length) offset = (s32)fileInfo->length;
+    if (offset + length > (s32)fileInfo->length) {
+        length = (s32)fileInfo->length - offset;
+    }
+    
+    LockAsync();
+    
+    // One outstanding command per file, as on hardware
+    if (cb->state == DVD_STATE_BUSY || cb->state == DVD_STATE_WAITING ||
+        cb->cancelRequested) {
+        UnlockAsync();
         return FALSE;
     }
     
@@ -489,26 +843,46 @@ BOOL DVDReadAsyncPrio(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
     cb->addr = addr;
     cb->length = length;
     cb->offset = offset;
-    cb->callback = (void*)callback;
-    cb->state = DVD_STATE_BUSY;
-    
-    // Start async read thread
-#ifdef _WIN32
-    cb->thread = CreateThread(NULL, 0, AsyncReadThread, cb, 0, NULL);
-    if (!cb->thread) {
-        cb->state = DVD_STATE_END;
-        return FALSE;
-    }
-#else
-    if (pthread_create(&cb->thread, NULL, AsyncReadThread, cb) != 0) {
-        cb->state = DVD_STATE_END;
-        return FALSE;
-    }
-#endif
+    cb->callback = callback;
+    cb->prio = PrioToQueue(prio);
+    cb->transferredSize = 0;
+    cb->cancelRequested = FALSE;
+    cb->cancelCallback = NULL;
+    cb->issueTime = OSGetTime();
+    cb->aramRequest = aramRequest;
+    cb->state = DVD_STATE_WAITING;
+    
+    __DVDPushWaitingQueue(cb->prio, cb);
+    SignalWork();
+    UnlockAsync();
     
     return TRUE;
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         DVDReadAsyncPrio
+  
+  Description:  Read from file asynchronously with priority.
+  
+                On GC/Wii: Queues read command, returns immediately, callback
+                           called from DI interrupt when complete
+                On PC: Queues the command for the async reader thread, which
+                       services higher priorities first
+  
+  Arguments:    fileInfo  Pointer to open file
+                addr      Destination buffer
+                length    Number of bytes to read
+                offset    Offset in file
+                callback  Callback when complete (or NULL)
+                prio      Priority (DVD_PRIO_*)
+  
+  Returns:      TRUE if read started successfully
+ *---------------------------------------------------------------------------*/
+BOOL DVDReadAsyncPrio(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
+                      DVDCallback callback, s32 prio) {
+    return QueueRead(fileInfo, addr, length, offset, callback, prio, NULL);
+}
+
 /*---------------------------------------------------------------------------*
   Name:         DVDReadAsync
 
@@ -527,6 +901,67 @@ BOOL DVDReadAsync(DVDFileInfo* fileInfo, void* addr, s32 length, s32 offset,
     return DVDReadAsyncPrio(fileInfo, addr, length, offset, callback, DVD_PRIO_MEDIUM);
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         DVDReadToARAMAsync
+  
+  Description:  Read a file range straight into ARAM.
+  
+                On GC/Wii: Games read into a main RAM buffer, then ARQ the
+                           buffer to ARAM
+                On PC: The async reader thread reads the file directly into
+                       simulated ARAM - one copy, no staging buffer. The
+                       request completes like an ARQ request: its callback
+                       runs on the ARQ dispatcher thread (or on the reader
+                       thread if ARQInit has not been called). A canceled
+                       read (DVDCancel) does not call back.
+                
+                The request is filled in as for ARQPostRequest with type
+                ARQ_TYPE_MRAM_TO_ARAM, source = file offset, dest =
+                aramAddr; length is set to the bytes read on completion.
+  
+  Arguments:    fileInfo  Pointer to open file
+                request   ARQ request (valid until the callback)
+                owner     Owner ID stored in the request
+                aramAddr  ARAM destination (32-byte aligned)
+                length    Number of bytes to read
+                offset    Offset in file
+                callback  ARQ-style completion callback (or NULL)
+                prio      Priority (DVD_PRIO_*)
+  
+  Returns:      TRUE if read started successfully
+ *---------------------------------------------------------------------------*/
+BOOL DVDReadToARAMAsync(DVDFileInfo* fileInfo, ARQRequest* request, u32 owner,
+                        u32 aramAddr, s32 length, s32 offset,
+                        void (*callback)(ARQRequest*), s32 prio) {
+    if (!fileInfo || !request || length < 0 || (aramAddr & 31) != 0) {
+        return FALSE;
+    }
+    
+    // Clamp to file size first so the ARAM check covers what is read
+    if (offset < 0) offset = 0;
+    if (offset > (s32)fileInfo->length) offset = (s32)fileInfo->length;
+    if (offset + length > (s32)fileInfo->length) {
+        length = (s32)fileInfo->length - offset;
+    }
+    
+    void* dest = __ARGetPointer(aramAddr, (u32)length);
+    if (!dest) {
+        OSReport("DVD: ARAM range 0x%08X+%d is invalid (ARInit called?)\n", aramAddr, length);
+        return FALSE;
+    }
+    
+    request->next = NULL;
+    request->owner = owner;
+    request->type = ARQ_TYPE_MRAM_TO_ARAM;
+    request->priority = (prio >= DVD_PRIO_HIGH) ? ARQ_PRIORITY_HIGH : ARQ_PRIORITY_LOW;
+    request->source = (u32)offset;
+    request->dest = aramAddr;
+    request->length = (u32)length;
+    request->callback = callback;
+    
+    return QueueRead(fileInfo, dest, length, offset, NULL, prio, request);
+}
+
 /*---------------------------------------------------------------------------*
   Name:         DVDSeek
 
@@ -553,7 +988,7 @@ s32 DVDSeek(DVDFileInfo* fileInfo, s32 offset) {
     if (offset < 0) offset = 0;
     if (offset > (s32)fileInfo->length) offset = fileInfo->length;
     
-    fseek(cb->file, offset, SEEK_SET);
+    fseek(cb->file, (long)(cb->baseOffset + (u32)offset), SEEK_SET);
     return offset;
 }
 
@@ -580,7 +1015,8 @@ s32 DVDGetFileInfoStatus(const DVDFileInfo* fileInfo) {
   Description:  Open a directory for reading.
                 
                 On GC/Wii: Looks up directory in FST
-                On PC: Opens directory using platform APIs
+                On PC: Takes a sorted snapshot of the directory merged
+                       across all mounted layers
 
   Arguments:    dirName  Path to directory
                 dir      Pointer to DVDDir structure to fill
@@ -606,32 +1042,15 @@ BOOL DVDOpenDir(const char* dirName, DVDDir* dir) {
         return FALSE;
     }
     
-    // Build full path
-    char fullPath[512];
-    BuildPath(dirName, fullPath, sizeof(fullPath));
+    char dvdPath[512];
+    BuildDVDPath(dirName, dvdPath, sizeof(dvdPath));
     
     DVDDirState* state = &s_dirStates[stateIndex];
-    strncpy(state->path, fullPath, sizeof(state->path) - 1);
-    
-#ifdef _WIN32
-    // Windows: Use FindFirstFile
-    char searchPath[520];
-    snprintf(searchPath, sizeof(searchPath), "%s\\*", fullPath);
-    
-    state->handle = FindFirstFileA(searchPath, &state->findData);
-    if (state->handle == INVALID_HANDLE_VALUE) {
-        OSReport("DVD: Failed to open directory: %s\n", fullPath);
+    state->entries = __DVDOverlayListDir(dvdPath, &state->count);
+    if (!state->entries) {
+        OSReport("DVD: Failed to open directory: /%s\n", dvdPath);
         return FALSE;
     }
-    state->firstRead = TRUE;
-#else
-    // POSIX: Use opendir
-    state->handle = opendir(fullPath);
-    if (!state->handle) {
-        OSReport("DVD: Failed to open directory: %s\n", fullPath);
-        return FALSE;
-    }
-#endif
     
     // Mark state as used and store index in DVDDir
     s_dirStateUsed[stateIndex] = TRUE;
@@ -648,7 +1067,7 @@ BOOL DVDOpenDir(const char* dirName, DVDDir* dir) {
   Description:  Read next entry from directory.
                 
                 On GC/Wii: Reads from FST
-                On PC: Uses FindNextFile (Windows) or readdir (POSIX)
+                On PC: Reads from the snapshot taken by DVDOpenDir
 
   Arguments:    dir      Pointer to open directory
                 dirent   Pointer to DVDDirEntry to fill
@@ -666,64 +1085,16 @@ BOOL DVDReadDir(DVDDir* dir, DVDDirEntry* dirent) {
     }
     
     DVDDirState* state = &s_dirStates[stateIndex];
-    
-#ifdef _WIN32
-    // Windows implementation
-    BOOL found = FALSE;
-    
-    if (state->firstRead) {
-        // First entry already loaded by FindFirstFile
-        state->firstRead = FALSE;
-        found = TRUE;
-    } else {
-        // Read next entry
-        found = FindNextFileA(state->handle, &state->findData);
-    }
-    
-    if (!found) {
+    if (dir->location >= state->count) {
         return FALSE;  // End of directory
     }
     
-    // Skip "." and ".." entries
-    while (strcmp(state->findData.cFileName, ".") == 0 ||
-           strcmp(state->findData.cFileName, "..") == 0) {
-        if (!FindNextFileA(state->handle, &state->findData)) {
-            return FALSE;
-        }
-    }
-    
     // Fill in entry info
-    dirent->isDir = (state->findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
-    dirent->name = state->findData.cFileName;  // Points to state (valid until next read)
+    DVDOverlayDirEntry* entry = &state->entries[dir->location];
+    dirent->isDir = entry->isDir;
+    dirent->name = entry->name;  // Valid until DVDCloseDir
     dirent->entryNum = dir->location++;
     
-#else
-    // POSIX implementation
-    state->entry = readdir(state->handle);
-    if (!state->entry) {
-        return FALSE;  // End of directory
-    }
-    
-    // Skip "." and ".." entries
-    while (strcmp(state->entry->d_name, ".") == 0 ||
-           strcmp(state->entry->d_name, "..") == 0) {
-        state->entry = readdir(state->handle);
-        if (!state->entry) {
-            return FALSE;
-        }
-    }
-    
-    // Check if entry is directory
-    char entryPath[1024];
-    snprintf(entryPath, sizeof(entryPath), "%s/%s", state->path, state->entry->d_name);
-    struct stat st;
-    dirent->isDir = (stat(entryPath, &st) == 0 && S_ISDIR(st.st_mode));
-    
-    // Fill in entry info
-    dirent->name = state->entry->d_name;  // Points to state (valid until next read)
-    dirent->entryNum = dir->location++;
-#endif
-    
     return TRUE;
 }
 
@@ -747,18 +1118,9 @@ BOOL DVDCloseDir(DVDDir* dir) {
     }
     
     DVDDirState* state = &s_dirStates[stateIndex];
-    
-#ifdef _WIN32
-    if (state->handle != INVALID_HANDLE_VALUE) {
-        FindClose(state->handle);
-        state->handle = INVALID_HANDLE_VALUE;
-    }
-#else
-    if (state->handle) {
-        closedir(state->handle);
-        state->handle = NULL;
-    }
-#endif
+    free(state->entries);
+    state->entries = NULL;
+    state->count = 0;
     
     s_dirStateUsed[stateIndex] = FALSE;
     memset(dir, 0, sizeof(DVDDir));
@@ -780,30 +1142,6 @@ void DVDRewindDir(DVDDir* dir) {
         return;
     }
     
-    int stateIndex = dir->entryNum;
-    if (stateIndex < 0 || stateIndex >= MAX_OPEN_DIRS || !s_dirStateUsed[stateIndex]) {
-        return;
-    }
-    
-    DVDDirState* state = &s_dirStates[stateIndex];
-    
-#ifdef _WIN32
-    // Close and reopen to rewind
-    if (state->handle != INVALID_HANDLE_VALUE) {
-        FindClose(state->handle);
-    }
-    
-    char searchPath[520];
-    snprintf(searchPath, sizeof(searchPath), "%s\\*", state->path);
-    state->handle = FindFirstFileA(searchPath, &state->findData);
-    state->firstRead = TRUE;
-#else
-    // POSIX: rewinddir
-    if (state->handle) {
-        rewinddir(state->handle);
-    }
-#endif
-    
     dir->location = 0;
 }
 
@@ -841,25 +1179,18 @@ BOOL DVDChangeDir(const char* dirName) {
         return FALSE;
     }
     
-    // Build full path to verify it exists
-    char fullPath[512];
-    BuildPath(dirName, fullPath, sizeof(fullPath));
+    // Verify the directory exists in some layer
+    char dvdPath[512];
+    DVDOverlayFile source;
+    BuildDVDPath(dirName, dvdPath, sizeof(dvdPath));
     
-    struct stat st;
-    if (stat(fullPath, &st) != 0 || !(st.st_mode & S_IFDIR)) {
+    if (!__DVDOverlayLookup(dvdPath, &source) || !source.isDir) {
         return FALSE;
     }
     
     // Update current directory
-    if (dirName[0] == '/') {
-        strncpy(s_currentDir, dirName, sizeof(s_currentDir) - 1);
-    } else {
-        // Append to current dir
-        if (strcmp(s_currentDir, "/") != 0) {
-            strncat(s_currentDir, "/", sizeof(s_currentDir) - strlen(s_currentDir) - 1);
-        }
-        strncat(s_currentDir, dirName, sizeof(s_currentDir) - strlen(s_currentDir) - 1);
-    }
+    snprintf(s_currentDir, sizeof(s_currentDir), "/%.*s",
+             (int)sizeof(s_currentDir) - 2, dvdPath);
     
     return TRUE;
 }
@@ -918,6 +1249,11 @@ BOOL DVDSetRootDirectory(const char* path) {
     }
     
     OSReport("DVD: Root directory changed to: %s\n", s_rootPath);
+    
+    // Re-index the bottom layer; mounted layers stay on top
+    if (s_initialized) {
+        __DVDOverlaySetBase(s_rootPath);
+    }
     return TRUE;
 }
 
@@ -937,38 +1273,29 @@ const char* DVDGetRootDirectory(void) {
 /*---------------------------------------------------------------------------*
   Name:         DVDCancel
 
-  Description:  Cancel a pending asynchronous operation.
+  Description:  Cancel a pending asynchronous operation and wait until the
+                cancellation has completed.
                 
                 On GC/Wii: Cancels DMA transfer, clears DI queue
-                On PC: Waits for thread to complete (can't truly cancel)
+                On PC: See DVDCancelAsync; blocks until the reader thread
+                       has stopped the read and run its callbacks
 
   Arguments:    fileInfo  Pointer to file with pending operation
 
   Returns:      TRUE if canceled successfully
  *---------------------------------------------------------------------------*/
 BOOL DVDCancel(DVDFileInfo* fileInfo) {
-    if (!fileInfo || !fileInfo->cb) {
+    if (!DVDCancelAsync(fileInfo, NULL)) {
         return FALSE;
     }
     
     DVDCommandBlock* cb = fileInfo->cb;
     
-    // If operation is busy, wait for it to complete
-    if (cb->state == DVD_STATE_BUSY) {
-#ifdef _WIN32
-        if (cb->thread) {
-            WaitForSingleObject(cb->thread, INFINITE);
-            CloseHandle(cb->thread);
-            cb->thread = NULL;
-        }
-#else
-        if (cb->thread) {
-            pthread_join(cb->thread, NULL);
-        }
-#endif
-        cb->state = DVD_STATE_CANCELED;
-        cb->result = DVD_RESULT_CANCELED;
+    LockAsync();
+    while (cb->cancelRequested) {
+        WaitAsync(&s_doneCond);
     }
+    UnlockAsync();
     
     return TRUE;
 }
@@ -977,6 +1304,15 @@ BOOL DVDCancel(DVDFileInfo* fileInfo) {
   Name:         DVDCancelAsync
 
   Description:  Cancel asynchronously with callback.
+  
+                A command still waiting in the priority queues is removed
+                immediately. A command the reader thread is running stops at
+                the next chunk boundary. Either way the read callback gets
+                DVD_RESULT_CANCELED, then the cancel callback fires once the
+                cancellation is complete. A cancel of a command already
+                being canceled gets its callback when that cancel
+                completes. If nothing is pending, the cancel callback
+                fires right away.
 
   Arguments:    fileInfo  Pointer to file with pending operation
                 callback  Callback when cancel completes
@@ -984,13 +1320,52 @@ BOOL DVDCancel(DVDFileInfo* fileInfo) {
   Returns:      TRUE if cancel initiated
  *---------------------------------------------------------------------------*/
 BOOL DVDCancelAsync(DVDFileInfo* fileInfo, DVDCallback callback) {
-    BOOL result = DVDCancel(fileInfo);
+    if (!fileInfo || !fileInfo->cb) {
+        return FALSE;
+    }
+    
+    DVDCommandBlock* cb = fileInfo->cb;
+    
+    LockAsync();
     
+    if (cb->cancelRequested) {
+        // Already being canceled - fire when that cancel completes
+        if (callback && AddCancelWaiter(cb, fileInfo, callback, NULL)) {
+            callback = NULL;
+        }
+        UnlockAsync();
+        if (callback) {
+            callback(DVD_RESULT_CANCELED, fileInfo);
+        }
+        return TRUE;
+    }
+    
+    if (cb == s_executing) {
+        // In flight: the reader stops between chunks and finishes the cancel
+        cb->cancelRequested = TRUE;
+        cb->cancelCallback = callback;
+        UnlockAsync();
+        return TRUE;
+    }
+    
+    DVDCallback readCallback = NULL;
+    if (__DVDDequeueWaitingQueue(cb)) {
+        // Never started: drop it from the queue right now
+        cb->state = DVD_STATE_CANCELED;
+        cb->result = DVD_RESULT_CANCELED;
+        readCallback = cb->callback;
+    }
+    
+    UnlockAsync();
+    
+    if (readCallback) {
+        readCallback(DVD_RESULT_CANCELED, fileInfo);
+    }
     if (callback) {
-        callback(result ? DVD_RESULT_CANCELED : DVD_RESULT_FATAL_ERROR, fileInfo);
+        callback(DVD_RESULT_CANCELED, fileInfo);
     }
     
-    return result;
+    return TRUE;
 }
 
 /*---------------------------------------------------------------------------*
@@ -999,7 +1374,7 @@ BOOL DVDCancelAsync(DVDFileInfo* fileInfo, DVDCallback callback) {
   Description:  Get number of bytes transferred so far for async operation.
                 
                 On GC/Wii: Reads DI transfer counter
-                On PC: Returns full size (operations complete quickly)
+                On PC: Returns bytes read by the reader thread so far
 
   Arguments:    fileInfo  Pointer to file with operation
 
@@ -1012,13 +1387,8 @@ s32 DVDGetTransferredSize(DVDFileInfo* fileInfo) {
     
     DVDCommandBlock* cb = fileInfo->cb;
     
-    // If operation complete, return result
-    if (cb->state == DVD_STATE_END) {
-        return cb->result;
-    }
-    
-    // If busy, return 0 (can't track partial progress easily)
-    return 0;
+    // Updated after every chunk, also valid after a cancel
+    return cb->transferredSize;
 }
 
 /*---------------------------------------------------------------------------*
@@ -1408,16 +1778,49 @@ BOOL DVDSetAutoInvalidation(BOOL autoInval) {
 /*---------------------------------------------------------------------------*
   Name:         DVDCancelAllAsync
 
-  Description:  Cancel all pending DVD operations.
+  Description:  Cancel all pending DVD operations. Queued commands are
+                removed immediately and complete with DVD_RESULT_CANCELED.
+                The command in flight, if any, stops at its next chunk
+                boundary; the callback fires after that, along with those
+                of earlier calls still waiting for it.
 
   Arguments:    callback  Callback when complete
 
   Returns:      TRUE always
  *---------------------------------------------------------------------------*/
 BOOL DVDCancelAllAsync(DVDCBCallback callback) {
-    /* On PC, operations complete quickly so nothing to cancel.
-     * Call callback immediately.
-     */
+    DVDCommandBlock* canceled[MAX_COMMAND_BLOCKS];
+    u32 numCanceled = 0;
+    DVDCommandBlock* cb;
+    
+    LockAsync();
+    
+    while ((cb = __DVDPopWaitingQueue()) != NULL) {
+        cb->state = DVD_STATE_CANCELED;
+        cb->result = DVD_RESULT_CANCELED;
+        if (numCanceled < MAX_COMMAND_BLOCKS) {
+            canceled[numCanceled++] = cb;
+        }
+    }
+    
+    BOOL inFlight = (s_executing != NULL);
+    if (inFlight) {
+        // Callbacks of earlier DVDCancelAllAsync calls still pending fire too
+        s_executing->cancelRequested = TRUE;
+        s_cancelAllPending = TRUE;
+        if (callback && AddCancelWaiter(NULL, NULL, NULL, callback)) {
+            callback = NULL;
+        }
+    }
+    
+    UnlockAsync();
+    
+    for (u32 i = 0; i < numCanceled; i++) {
+        if (canceled[i]->callback) {
+            canceled[i]->callback(DVD_RESULT_CANCELED, canceled[i]->fileInfo);
+        }
+    }
+    
     if (callback) {
         callback(DVD_RESULT_GOOD, NULL);
     }
@@ -1427,13 +1830,22 @@ BOOL DVDCancelAllAsync(DVDCBCallback callback) {
 /*---------------------------------------------------------------------------*
   Name:         DVDCancelAll
 
-  Description:  Cancel all pending DVD operations (synchronous).
+  Description:  Cancel all pending DVD operations (synchronous). Returns
+                once the in-flight command, if any, has stopped.
 
   Arguments:    None
 
   Returns:      DVD_RESULT_GOOD
  *---------------------------------------------------------------------------*/
 s32 DVDCancelAll(void) {
+    DVDCancelAllAsync(NULL);
+    
+    LockAsync();
+    while (s_cancelAllPending) {
+        WaitAsync(&s_doneCond);
+    }
+    UnlockAsync();
+    
     return DVD_RESULT_GOOD;
 }
 
@@ -1457,71 +1869,6 @@ BOOL DVDCheckDiskAsync(DVDCommandBlock* block, DVDCBCallback callback) {
     return TRUE;
 }
 
-/*---------------------------------------------------------------------------*
-  Name:         DVDPrepareStreamAbsAsync
-
-  Description:  Prepare DVD for audio streaming from absolute offset.
-                
-                On GC/Wii: Configures hardware audio streaming DMA
-                On PC: No-op (no hardware streaming)
-
-  Arguments:    block     Command block
-                length    Stream length
-                offset    Disc offset
-                callback  Callback when complete
-
-  Returns:      TRUE always
- *---------------------------------------------------------------------------*/
-BOOL DVDPrepareStreamAbsAsync(DVDCommandBlock* block, u32 length, u32 offset,
-                               DVDCBCallback callback) {
-    (void)block;
-    (void)length;
-    (void)offset;
-    
-    /* Hardware audio streaming not supported on PC.
-     * Games should use regular DVDRead for audio data.
-     */
-    if (callback) {
-        callback(DVD_RESULT_GOOD, block);
-    }
-    
-    return TRUE;
-}
-
-/*---------------------------------------------------------------------------*
-  Name:         DVDCancelStreamAsync
-
-  Description:  Cancel audio streaming.
-
-  Arguments:    block     Command block
-                callback  Callback when complete
-
-  Returns:      TRUE always
- *---------------------------------------------------------------------------*/
-BOOL DVDCancelStreamAsync(DVDCommandBlock* block, DVDCBCallback callback) {
-    (void)block;
-    
-    if (callback) {
-        callback(DVD_RESULT_GOOD, block);
-    }
-    
-    return TRUE;
-}
-
-/*---------------------------------------------------------------------------*
-  Name:         DVDCancelStream
-
-  Description:  Cancel audio streaming (synchronous).
-
-  Arguments:    block  Command block
-
-  Returns:      DVD_RESULT_GOOD
- *---------------------------------------------------------------------------*/
-s32 DVDCancelStream(DVDCommandBlock* block) {
-    (void)block;
-    return DVD_RESULT_GOOD;
-}
-
 /*---------------------------------------------------------------------------*
   Name:         DVDReadAbsAsyncPrio
 
@@ -1588,30 +1935,3 @@ void DVDReset(void) {
     /* No DVD hardware to reset on PC. */
     OSReport("DVD: Reset requested (no-op on PC)\n");
 }
-
-/*---------------------------------------------------------------------------*
-  Name:         DVDPrepareStreamAsync
-
-  Description:  Prepare streaming from absolute offset.
-
-  Arguments:    block     Command block
-                length    Stream length
-                offset    Disc offset
-                callback  Completion callback
-
-  Returns:      TRUE if started
- *---------------------------------------------------------------------------*/
-BOOL DVDPrepareStreamAsync(DVDCommandBlock* block, u32 length, u32 offset,
-                           DVDCBCallback callback) {
-    (void)block;
-    (void)length;
-    (void)offset;
-    
-    /* Streaming not implemented on PC. */
-    if (callback) {
-        callback(DVD_RESULT_READY, block);
-    }
-    
-    return TRUE;
-}
-
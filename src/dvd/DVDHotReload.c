@@ -0,0 +1,530 @@
+/*---------------------------------------------------------------------------*
+  DVDHotReload.c - Live Asset Reload
+  
+  On GC/Wii: The disc is read-only; there is nothing to reload.
+  
+  On PC: Artists edit files under the DVD root while the game runs. A
+         watcher thread follows every directory layer with inotify and
+         feeds each change to the layered file system as a single-path
+         update, so only the affected index entries change and nothing is
+         rescanned. Disc image and archive layers are rescanned when their
+         file is rewritten.
+  
+  WATCHES:
+  inotify is not recursive, so every directory of every directory layer
+  gets its own watch; directories created later are added as they
+  appear. Layers mounted, unmounted or refreshed while watching are
+  noticed by their install stamp and re-watched.
+  
+  NOTIFICATION:
+  The optional game callback runs on the watcher thread after the index
+  is updated, so a DVDOpen from inside it already sees the new file.
+  Changes to files hidden by a higher layer are not reported.
+  
+  Hot reload needs inotify (Linux). Elsewhere DVDEnableHotReload fails
+  and DVDRefreshLayer remains the way to pick up changes.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/dvd.h>
+#include <dolphin/dvd_internal.h>
+#include <dolphin/os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*---------------------------------------------------------------------------*
+    Watcher State
+ *---------------------------------------------------------------------------*/
+
+#define HOTRELOAD_POLL_MS       100     // Layer changes are noticed this fast
+#define HOTRELOAD_MAX_DEPTH     16
+#define HOTRELOAD_DIR_MASK      (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | \
+                                 IN_MOVED_FROM | IN_MOVED_TO)
+
+typedef struct Watch {
+    int     wd;
+    s32     layer;
+    u32     stamp;              // Layer install stamp the watch belongs to
+    BOOL    isSource;           // Watches an image/archive's directory
+    char*   dvdDir;             // Directory layers: "" or "dir/"
+    char*   name;               // Source watches: image/archive file name
+} Watch;
+
+typedef struct PendingChange {
+    char*   path;
+    s32     event;
+} PendingChange;
+
+static int s_inotifyFd = -1;
+static pthread_t s_watchThread;
+static volatile BOOL s_watchRunning = FALSE;
+static DVDHotReloadCallback s_callback = NULL;
+
+static Watch* s_watches = NULL;
+static u32 s_watchCount = 0;
+static u32 s_watchCapacity = 0;
+
+static u32 s_layerStamp[DVD_MAX_LAYERS];   // 0 = not watched
+
+static PendingChange* s_pending = NULL;    // Collected under the overlay lock
+static u32 s_pendingCount = 0;
+static u32 s_pendingCapacity = 0;
+
+/*---------------------------------------------------------------------------*
+  Name:         AddWatch
+  
+  Description:  Watch a host directory on behalf of a layer.
+  
+  Arguments:    hostDir  Host directory
+                layer    Layer slot
+                stamp    Layer install stamp
+                dvdDir   DVD directory ("" or "dir/"), or NULL for sources
+                name     Image/archive file name, or NULL for directories
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+static BOOL AddWatch(const char* hostDir, s32 layer, u32 stamp,
+                     const char* dvdDir, const char* name) {
+    int wd = inotify_add_watch(s_inotifyFd, hostDir, HOTRELOAD_DIR_MASK | IN_ONLYDIR);
+    if (wd < 0) {
+        OSReport("DVD: Cannot watch %s (errno %d)\n", hostDir, errno);
+        return FALSE;
+    }
+    
+    if (s_watchCount == s_watchCapacity) {
+        u32 capacity = s_watchCapacity ? s_watchCapacity * 2 : 64;
+        Watch* grown = (Watch*)realloc(s_watches, capacity * sizeof(Watch));
+        if (!grown) {
+            return FALSE;
+        }
+        s_watches = grown;
+        s_watchCapacity = capacity;
+    }
+    
+    Watch* w = &s_watches[s_watchCount];
+    w->wd = wd;
+    w->layer = layer;
+    w->stamp = stamp;
+    w->isSource = (name != NULL);
+    w->dvdDir = strdup(dvdDir ? dvdDir : "");
+    w->name = name ? strdup(name) : NULL;
+    if (!w->dvdDir || (name && !w->name)) {
+        free(w->dvdDir);
+        free(w->name);
+        return FALSE;
+    }
+    s_watchCount++;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         RemoveWatchAt
+  
+  Description:  Drop a watch record. The kernel watch is removed once no
+                other record shares it (one directory can be watched for
+                several layers, and inotify hands out one wd per inode).
+  
+  Arguments:    index     Record index
+                rmKernel  FALSE if the kernel already dropped the watch
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void RemoveWatchAt(u32 index, BOOL rmKernel) {
+    int wd = s_watches[index].wd;
+    
+    free(s_watches[index].dvdDir);
+    free(s_watches[index].name);
+    s_watches[index] = s_watches[--s_watchCount];
+    
+    if (rmKernel) {
+        for (u32 i = 0; i < s_watchCount; i++) {
+            if (s_watches[i].wd == wd) {
+                return;
+            }
+        }
+        inotify_rm_watch(s_inotifyFd, wd);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         WatchTree
+  
+  Description:  Watch a directory and every directory below it.
+  
+  Arguments:    hostDir  Host directory (ends with '/')
+                dvdDir   Matching DVD directory ("" or "dir/")
+                layer    Layer slot
+                stamp    Layer install stamp
+                depth    Recursion depth
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void WatchTree(const char* hostDir, const char* dvdDir, s32 layer, u32 stamp, u32 depth) {
+    DIR* dir;
+    struct dirent* ent;
+    
+    if (depth > HOTRELOAD_MAX_DEPTH || !AddWatch(hostDir, layer, stamp, dvdDir, NULL)) {
+        return;
+    }
+    
+    dir = opendir(hostDir);
+    if (!dir) {
+        return;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        char hostPath[512];
+        char dvdPath[512];
+        struct stat st;
+        
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+            continue;
+        }
+        snprintf(hostPath, sizeof(hostPath), "%s%s/", hostDir, ent->d_name);
+        if (stat(hostPath, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            continue;
+        }
+        snprintf(dvdPath, sizeof(dvdPath), "%s%s/", dvdDir, ent->d_name);
+        WatchTree(hostPath, dvdPath, layer, stamp, depth + 1);
+    }
+    closedir(dir);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         SyncLayers
+  
+  Description:  Bring the watch set in line with the mounted layers:
+                drop watches of layers that went away or were replaced,
+                and watch layers that are new.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void SyncLayers(void) {
+    for (s32 layer = 0; layer < DVD_MAX_LAYERS; layer++) {
+        char path[256];
+        s32 type;
+        u32 stamp = 0;
+        
+        if (!__DVDOverlayGetLayer(layer, path, sizeof(path), &type, &stamp)) {
+            stamp = 0;
+        }
+        if (stamp == s_layerStamp[layer]) {
+            continue;
+        }
+        
+        // Watch the new contents before dropping the old records, so
+        // directories in both keep their kernel watch throughout
+        s_layerStamp[layer] = stamp;
+        if (stamp == 0) {
+            // Layer unmounted
+        } else if (type == DVD_LAYER_DIRECTORY) {
+            WatchTree(path, "", layer, stamp, 0);
+        } else {
+            // Watch the directory: editors replace files by renaming
+            char dir[256];
+            const char* slash = strrchr(path, '/');
+            if (slash) {
+                snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path + 1), path);
+            } else {
+                strcpy(dir, "./");
+            }
+            AddWatch(dir, layer, stamp, NULL, slash ? slash + 1 : path);
+        }
+        
+        for (u32 i = 0; i < s_watchCount; ) {
+            if (s_watches[i].layer == layer && s_watches[i].stamp != stamp) {
+                RemoveWatchAt(i, TRUE);
+            } else {
+                i++;
+            }
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         CollectChange
+  
+  Description:  Overlay change reporter; queues the change for delivery
+                once the overlay lock is released.
+ *---------------------------------------------------------------------------*/
+static void CollectChange(const char* dvdPath, s32 event, void* arg) {
+    (void)arg;
+    
+    if (s_pendingCount == s_pendingCapacity) {
+        u32 capacity = s_pendingCapacity ? s_pendingCapacity * 2 : 32;
+        PendingChange* grown = (PendingChange*)realloc(s_pending, capacity * sizeof(PendingChange));
+        if (!grown) {
+            return;
+        }
+        s_pending = grown;
+        s_pendingCapacity = capacity;
+    }
+    s_pending[s_pendingCount].path = strdup(dvdPath);
+    s_pending[s_pendingCount].event = event;
+    if (s_pending[s_pendingCount].path) {
+        s_pendingCount++;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DeliverChanges
+  
+  Description:  Hand collected changes to the game callback.
+ *---------------------------------------------------------------------------*/
+static void DeliverChanges(void) {
+    DVDHotReloadCallback callback = s_callback;
+    
+    for (u32 i = 0; i < s_pendingCount; i++) {
+        if (callback) {
+            callback(s_pending[i].event, s_pending[i].path);
+        }
+        free(s_pending[i].path);
+    }
+    s_pendingCount = 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         HandleEvent
+  
+  Description:  Apply one inotify event.
+  
+  Arguments:    ev  Event
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void HandleEvent(const struct inotify_event* ev) {
+    if (ev->mask & IN_Q_OVERFLOW) {
+        // Events were lost; fall back to rescanning the directory layers
+        OSReport("DVD: Hot reload event queue overflowed, rescanning\n");
+        for (s32 layer = 0; layer < DVD_MAX_LAYERS; layer++) {
+            if (s_layerStamp[layer]) {
+                DVDRefreshLayer(layer);
+            }
+        }
+        return;
+    }
+    
+    if (ev->mask & IN_IGNORED) {
+        // Kernel dropped the watch (directory deleted)
+        for (u32 i = 0; i < s_watchCount; ) {
+            if (s_watches[i].wd == ev->wd) {
+                RemoveWatchAt(i, FALSE);
+            } else {
+                i++;
+            }
+        }
+        return;
+    }
+    
+    if (ev->len == 0) {
+        return;
+    }
+    
+    // A plain file creation is followed by IN_CLOSE_WRITE when it is done
+    if ((ev->mask & IN_CREATE) && !(ev->mask & IN_ISDIR)) {
+        return;
+    }
+    
+    // Copy matching records first: handling can add or remove watches
+    u32 matches = 0;
+    for (u32 i = 0; i < s_watchCount; i++) {
+        if (s_watches[i].wd == ev->wd) matches++;
+    }
+    if (matches == 0) {
+        return;
+    }
+    Watch* targets = (Watch*)malloc(matches * sizeof(Watch));
+    if (!targets) {
+        return;
+    }
+    matches = 0;
+    for (u32 i = 0; i < s_watchCount; i++) {
+        if (s_watches[i].wd == ev->wd) {
+            targets[matches] = s_watches[i];
+            targets[matches].dvdDir = strdup(s_watches[i].dvdDir);
+            targets[matches].name = s_watches[i].name ? strdup(s_watches[i].name) : NULL;
+            matches++;
+        }
+    }
+    
+    for (u32 t = 0; t < matches; t++) {
+        const Watch* w = &targets[t];
+        
+        if (w->isSource) {
+            if (w->name && strcmp(ev->name, w->name) == 0 &&
+                (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+                char path[256];
+                s32 type;
+                u32 stamp;
+                if (__DVDOverlayGetLayer(w->layer, path, sizeof(path), &type, &stamp) &&
+                    stamp == w->stamp && DVDRefreshLayer(w->layer) && s_callback) {
+                    s_callback(DVD_HOTRELOAD_LAYER, path);
+                }
+            }
+            continue;
+        }
+        if (!w->dvdDir) {
+            continue;
+        }
+        
+        char dvdPath[512];
+        snprintf(dvdPath, sizeof(dvdPath), "%s%s", w->dvdDir, ev->name);
+        
+        if (ev->mask & IN_ISDIR) {
+            if (ev->mask & IN_MOVED_FROM) {
+                // The subtree's watches now describe another place
+                size_t len = strlen(dvdPath);
+                for (u32 i = 0; i < s_watchCount; ) {
+                    const Watch* x = &s_watches[i];
+                    if (x->layer == w->layer && !x->isSource &&
+                        strncmp(x->dvdDir, dvdPath, len) == 0 && x->dvdDir[len] == '/') {
+                        RemoveWatchAt(i, TRUE);
+                    } else {
+                        i++;
+                    }
+                }
+            } else if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                char path[256];
+                char hostDir[512];
+                char dvdDir[512];
+                s32 type;
+                u32 stamp;
+                if (__DVDOverlayGetLayer(w->layer, path, sizeof(path), &type, &stamp) &&
+                    stamp == w->stamp) {
+                    snprintf(hostDir, sizeof(hostDir), "%s%.*s/", path,
+                             (int)(sizeof(hostDir) - sizeof(path) - 1), dvdPath);
+                    snprintf(dvdDir, sizeof(dvdDir), "%.*s/", (int)sizeof(dvdDir) - 2, dvdPath);
+                    WatchTree(hostDir, dvdDir, w->layer, stamp, 0);
+                }
+            }
+        }
+        
+        __DVDOverlayUpdatePath(w->layer, w->stamp, dvdPath, CollectChange, NULL);
+        DeliverChanges();
+    }
+    
+    for (u32 t = 0; t < matches; t++) {
+        free(targets[t].dvdDir);
+        free(targets[t].name);
+    }
+    free(targets);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         WatchThread
+  
+  Description:  Wait for inotify events and apply them.
+ *---------------------------------------------------------------------------*/
+static void* WatchThread(void* arg) {
+    // Large enough for many events; names are at most NAME_MAX
+    char buffer[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+    (void)arg;
+    
+    while (s_watchRunning) {
+        struct pollfd pfd;
+        
+        SyncLayers();
+        
+        pfd.fd = s_inotifyFd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, HOTRELOAD_POLL_MS) <= 0) {
+            continue;
+        }
+        
+        ssize_t n = read(s_inotifyFd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            continue;
+        }
+        
+        for (char* p = buffer; p < buffer + n; ) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            HandleEvent(ev);
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    
+    return NULL;
+}
+
+#endif // __linux__
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDEnableHotReload
+  
+  Description:  Start the watcher thread. Calling it again while enabled
+                just replaces the callback.
+  
+  Arguments:    callback  Called for each visible change (can be NULL)
+  
+  Returns:      TRUE if watching
+ *---------------------------------------------------------------------------*/
+BOOL DVDEnableHotReload(DVDHotReloadCallback callback) {
+#ifdef __linux__
+    s_callback = callback;
+    if (s_watchRunning) {
+        return TRUE;
+    }
+    
+    s_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (s_inotifyFd < 0) {
+        OSReport("DVD: inotify unavailable (errno %d), hot reload disabled\n", errno);
+        return FALSE;
+    }
+    
+    memset(s_layerStamp, 0, sizeof(s_layerStamp));
+    s_watchRunning = TRUE;
+    if (pthread_create(&s_watchThread, NULL, WatchThread, NULL) != 0) {
+        s_watchRunning = FALSE;
+        close(s_inotifyFd);
+        s_inotifyFd = -1;
+        return FALSE;
+    }
+    
+    OSReport("DVD: Hot reload enabled\n");
+    return TRUE;
+#else
+    (void)callback;
+    OSReport("DVD: Hot reload needs inotify, not available on this platform\n");
+    return FALSE;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDDisableHotReload
+  
+  Description:  Stop the watcher thread and drop all watches. Must not be
+                called from the hot reload callback.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void DVDDisableHotReload(void) {
+#ifdef __linux__
+    if (!s_watchRunning) {
+        return;
+    }
+    
+    s_watchRunning = FALSE;
+    pthread_join(s_watchThread, NULL);
+    
+    while (s_watchCount > 0) {
+        RemoveWatchAt(s_watchCount - 1, FALSE);
+    }
+    close(s_inotifyFd);
+    s_inotifyFd = -1;
+    s_callback = NULL;
+    
+    OSReport("DVD: Hot reload disabled\n");
+#endif
+}
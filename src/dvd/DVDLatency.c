@@ -0,0 +1,540 @@
+/*---------------------------------------------------------------------------*
+  DVDLatency.c - Optional Disc Drive Timing Model
+  
+  On GC/Wii: Every read pays for the drive: a seek that grows with the
+             distance the head travels, rotational latency, and a transfer
+             rate that depends on where on the (CAV) disc the data lives.
+             There is one head, so reads queue behind each other.
+  
+  On PC: Reads are effectively instant, so load hitches only show up on
+         hardware. When a latency model is set, DVDReadPrio and the async
+         reader hold each read until the modeled completion time (measured
+         on the OS time base), and reads slower than the stall threshold
+         are recorded for a per-frame report.
+  
+  DISC LAYOUT:
+  There is no disc image, so files get modeled disc addresses by walking
+  the merged file system (all layers) the way a mastering tool lays out an
+  FST: directory entries in name order, depth first, each file aligned to
+  a 32KB ECC block. Renaming or moving files therefore changes the modeled
+  layout the same way it would change a real disc.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/dvd.h>
+#include <dolphin/dvd_internal.h>
+#include <dolphin/os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Model State
+ *---------------------------------------------------------------------------*/
+
+#define LAYOUT_DATA_START       0x00100000  // After boot block, apploader, FST
+#define LAYOUT_ALIGN            0x8000      // 32KB ECC block
+#define MAX_FRAME_STALLS        64
+#define WAIT_SLICE_MS           2           // Cancel check interval while waiting
+
+typedef struct LayoutEntry {
+    char*   path;           // DVD path
+    u32     hash;
+    u32     discAddr;
+} LayoutEntry;
+
+static BOOL s_enabled = FALSE;
+static DVDLatencyModel s_model;
+
+// Disc layout, sorted by discAddr (assigned in walk order)
+static LayoutEntry* s_layout = NULL;
+static u32 s_layoutCount = 0;
+static u32 s_layoutCapacity = 0;
+static u32* s_layoutHash = NULL;           // Open addressing, index + 1
+static u32 s_layoutHashSize = 0;
+static u32 s_layoutEnd = LAYOUT_DATA_START;
+static u32 s_layoutGeneration = 0;        // Overlay generation laid out
+
+// Single head
+static u32 s_headPos = 0;
+static OSTime s_headFreeAt = 0;
+
+// Stalls for the current frame
+static DVDLatencyStall s_stalls[MAX_FRAME_STALLS];
+static u32 s_stallCount = 0;
+static u32 s_stallsDropped = 0;
+static u32 s_frameNumber = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION s_modelLock;
+static BOOL s_modelLockInit = FALSE;
+#else
+static pthread_mutex_t s_modelLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void LockModel(void) {
+#ifdef _WIN32
+    if (!s_modelLockInit) {
+        InitializeCriticalSection(&s_modelLock);
+        s_modelLockInit = TRUE;
+    }
+    EnterCriticalSection(&s_modelLock);
+#else
+    pthread_mutex_lock(&s_modelLock);
+#endif
+}
+
+static void UnlockModel(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_modelLock);
+#else
+    pthread_mutex_unlock(&s_modelLock);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ClearLayout
+  
+  Description:  Free the modeled disc layout.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ClearLayout(void) {
+    for (u32 i = 0; i < s_layoutCount; i++) {
+        free(s_layout[i].path);
+    }
+    free(s_layout);
+    free(s_layoutHash);
+    s_layout = NULL;
+    s_layoutHash = NULL;
+    s_layoutCount = 0;
+    s_layoutCapacity = 0;
+    s_layoutHashSize = 0;
+    s_layoutEnd = LAYOUT_DATA_START;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         RehashLayout
+  
+  Description:  Rebuild the path hash table at twice the entry count.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void RehashLayout(void) {
+    u32 size = 64;
+    while (size < s_layoutCount * 2) size <<= 1;
+    
+    u32* table = (u32*)calloc(size, sizeof(u32));
+    if (!table) {
+        return;
+    }
+    
+    for (u32 i = 0; i < s_layoutCount; i++) {
+        u32 slot = s_layout[i].hash & (size - 1);
+        while (table[slot]) slot = (slot + 1) & (size - 1);
+        table[slot] = i + 1;
+    }
+    
+    free(s_layoutHash);
+    s_layoutHash = table;
+    s_layoutHashSize = size;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         FindLayoutEntry
+  
+  Description:  Look up a DVD path in the layout.
+  
+  Arguments:    path  DVD path
+  
+  Returns:      Entry, or NULL if the file is not laid out
+ *---------------------------------------------------------------------------*/
+static LayoutEntry* FindLayoutEntry(const char* path) {
+    if (!s_layoutHash) {
+        return NULL;
+    }
+    
+    u32 hash = __DVDHashPath(path);
+    u32 slot = hash & (s_layoutHashSize - 1);
+    
+    while (s_layoutHash[slot]) {
+        LayoutEntry* e = &s_layout[s_layoutHash[slot] - 1];
+        if (e->hash == hash && strcmp(e->path, path) == 0) {
+            return e;
+        }
+        slot = (slot + 1) & (s_layoutHashSize - 1);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AppendLayoutEntry
+  
+  Description:  Place a file after the last laid out file.
+  
+  Arguments:    path    DVD path
+                length  File size in bytes
+  
+  Returns:      New entry, or NULL on allocation failure
+ *---------------------------------------------------------------------------*/
+static LayoutEntry* AppendLayoutEntry(const char* path, u32 length) {
+    if (s_layoutCount == s_layoutCapacity) {
+        u32 capacity = s_layoutCapacity ? s_layoutCapacity * 2 : 256;
+        LayoutEntry* grown = (LayoutEntry*)realloc(s_layout, capacity * sizeof(LayoutEntry));
+        if (!grown) {
+            return NULL;
+        }
+        s_layout = grown;
+        s_layoutCapacity = capacity;
+    }
+    
+    char* copy = (char*)malloc(strlen(path) + 1);
+    if (!copy) {
+        return NULL;
+    }
+    strcpy(copy, path);
+    
+    LayoutEntry* e = &s_layout[s_layoutCount++];
+    e->path = copy;
+    e->hash = __DVDHashPath(copy);
+    e->discAddr = s_layoutEnd;
+    
+    s_layoutEnd += (length + LAYOUT_ALIGN - 1) & ~(LAYOUT_ALIGN - 1);
+    if (s_layoutEnd < e->discAddr || s_layoutEnd > s_model.discSize) {
+        s_layoutEnd = s_model.discSize;  // Disc full - pile the rest at the end
+    }
+    
+    if (s_layoutCount * 2 > s_layoutHashSize) {
+        RehashLayout();
+    } else {
+        u32 slot = e->hash & (s_layoutHashSize - 1);
+        while (s_layoutHash[slot]) slot = (slot + 1) & (s_layoutHashSize - 1);
+        s_layoutHash[slot] = s_layoutCount;
+    }
+    return e;
+}
+
+static void LayoutFile(const char* dvdPath, u32 length, void* arg) {
+    (void)arg;
+    AppendLayoutEntry(dvdPath, length);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         BuildLayout
+  
+  Description:  (Re)build the modeled layout from the merged file system.
+                Caller holds the model lock.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void BuildLayout(void) {
+    ClearLayout();
+    s_layoutGeneration = __DVDOverlayGetGeneration();
+    
+    __DVDOverlayWalkFiles(LayoutFile, NULL);
+    if (!s_layoutHash) {
+        RehashLayout();
+    }
+    
+    OSReport("DVD: Latency model laid out %u files (%u MB)\n",
+             s_layoutCount, (s_layoutEnd - LAYOUT_DATA_START) / (1024 * 1024));
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDGetDefaultLatencyModel
+  
+  Description:  Fill in parameters approximating the GameCube drive: 8cm
+                CAV disc, ~2.1-3.1 MB/s inner to outer, ~128ms average
+                random access.
+  
+  Arguments:    model  Receives defaults
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void DVDGetDefaultLatencyModel(DVDLatencyModel* model) {
+    if (!model) {
+        return;
+    }
+    
+    model->discSize = 1459978240u;
+    model->trackSeekUs = 1000;
+    model->fullSeekUs = 200000;
+    model->rpm = 2900;
+    model->numZones = 8;
+    model->innerRateKBps = 2088;
+    model->outerRateKBps = 3125;
+    model->stallThresholdMs = 16;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDSetLatencyModel
+  
+  Description:  Enable, reconfigure or disable the drive timing model. The
+                layout is built from the current DVD root; files should be
+                opened after enabling so they get disc addresses.
+  
+  Arguments:    model  Parameters, or NULL to disable
+  
+  Returns:      TRUE if the model is enabled
+ *---------------------------------------------------------------------------*/
+BOOL DVDSetLatencyModel(const DVDLatencyModel* model) {
+    LockModel();
+    
+    if (!model) {
+        s_enabled = FALSE;
+        ClearLayout();
+        UnlockModel();
+        OSReport("DVD: Latency model disabled\n");
+        return FALSE;
+    }
+    
+    s_model = *model;
+    if (s_model.discSize < LAYOUT_DATA_START * 2) s_model.discSize = LAYOUT_DATA_START * 2;
+    if (s_model.rpm == 0) s_model.rpm = 1;
+    if (s_model.numZones == 0) s_model.numZones = 1;
+    if (s_model.innerRateKBps == 0) s_model.innerRateKBps = 1;
+    if (s_model.outerRateKBps == 0) s_model.outerRateKBps = s_model.innerRateKBps;
+    
+    s_headPos = 0;
+    s_headFreeAt = 0;
+    s_stallCount = 0;
+    s_stallsDropped = 0;
+    BuildLayout();
+    s_enabled = TRUE;
+    
+    UnlockModel();
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDLatencyGetDiscAddress
+  
+  Description:  Modeled disc address for a file being opened. The layout
+                is rebuilt if layers changed; files the layout still does
+                not know are appended to the end.
+  
+  Arguments:    path    Normalized DVD path
+                length  File size
+  
+  Returns:      Disc address, or 0 if the model is disabled
+ *---------------------------------------------------------------------------*/
+u32 __DVDLatencyGetDiscAddress(const char* path, u32 length) {
+    u32 addr = 0;
+    
+    if (!s_enabled || !path) {
+        return 0;
+    }
+    
+    LockModel();
+    if (s_enabled) {
+        if (s_layoutGeneration != __DVDOverlayGetGeneration()) {
+            BuildLayout();
+        }
+        LayoutEntry* e = FindLayoutEntry(path);
+        if (!e) {
+            e = AppendLayoutEntry(path, length);
+        }
+        addr = e ? e->discAddr : 0;
+    }
+    UnlockModel();
+    
+    return addr;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         FindPathByAddress
+  
+  Description:  Map a disc address back to the file laid out there.
+                Caller holds the model lock.
+  
+  Arguments:    addr  Disc address of the file start
+  
+  Returns:      Host path, or NULL
+ *---------------------------------------------------------------------------*/
+static const char* FindPathByAddress(u32 addr) {
+    u32 lo = 0;
+    u32 hi = s_layoutCount;
+    
+    while (lo < hi) {
+        u32 mid = (lo + hi) / 2;
+        if (s_layout[mid].discAddr < addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < s_layoutCount && s_layout[lo].discAddr == addr) ? s_layout[lo].path : NULL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDLatencyWait
+  
+  Description:  Charge a completed host read to the modeled drive and hold
+                the caller until the drive would have finished it.
+                
+                seek      = track + (full - track) * sqrt(distance / disc)
+                rotation  = half a revolution (average) unless sequential
+                transfer  = length / rate of the zone the read starts in
+                
+                The head serves one read at a time, so a read issued while
+                the head is busy also waits for the reads ahead of it.
+  
+  Arguments:    fileInfo   File read from
+                offset     Offset of the read in the file
+                length     Bytes read
+                issueTime  OSGetTime() when the read was issued
+                async      TRUE for reads from the async reader
+                abort      Polled while waiting (may be NULL)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __DVDLatencyWait(DVDFileInfo* fileInfo, s32 offset, s32 length,
+                      OSTime issueTime, BOOL async, volatile BOOL* abort) {
+    DVDLatencyStall stall;
+    
+    if (!s_enabled || !fileInfo || length <= 0) {
+        return;
+    }
+    
+    LockModel();
+    
+    u32 addr = fileInfo->startAddr + (u32)offset;
+    u32 distance = (addr > s_headPos) ? addr - s_headPos : s_headPos - addr;
+    OSTime start = (s_headFreeAt > issueTime) ? s_headFreeAt : issueTime;
+    
+    u32 seekUs = 0;
+    u32 rotationUs = 0;
+    if (distance != 0) {
+        double frac = (double)distance / (double)s_model.discSize;
+        if (frac > 1.0) frac = 1.0;
+        seekUs = s_model.trackSeekUs +
+                 (u32)((double)(s_model.fullSeekUs - s_model.trackSeekUs) * sqrt(frac));
+        rotationUs = 30000000u / s_model.rpm;
+    }
+    
+    u32 zone = (u32)(((u64)addr * s_model.numZones) / s_model.discSize);
+    if (zone >= s_model.numZones) zone = s_model.numZones - 1;
+    u32 rateKBps = s_model.innerRateKBps;
+    if (s_model.numZones > 1) {
+        rateKBps += (u32)(((s64)s_model.outerRateKBps - (s64)s_model.innerRateKBps) *
+                          (s64)zone / (s64)(s_model.numZones - 1));
+    }
+    u32 transferUs = (u32)(((u64)length * 1000000u) / ((u64)rateKBps * 1024u));
+    
+    OSTime done = start + OSMicrosecondsToTicks((OSTime)seekUs + rotationUs + transferUs);
+    s_headFreeAt = done;
+    s_headPos = addr + (u32)length;
+    
+    u32 totalMs = (u32)OSTicksToMilliseconds(done - issueTime);
+    BOOL stalled = (totalMs > s_model.stallThresholdMs);
+    if (stalled) {
+        // Copied: the layout is rebuilt when the overlay changes
+        const char* path = FindPathByAddress(fileInfo->startAddr);
+        stall.path[0] = '\0';
+        if (path) {
+            strncat(stall.path, path, sizeof(stall.path) - 1);
+        }
+        stall.discAddr = addr;
+        stall.offset = offset;
+        stall.length = length;
+        stall.async = async;
+        stall.queueUs = (u32)OSTicksToMicroseconds(start - issueTime);
+        stall.seekUs = seekUs;
+        stall.rotationUs = rotationUs;
+        stall.transferUs = transferUs;
+        stall.totalMs = totalMs;
+        if (s_stallCount < MAX_FRAME_STALLS) {
+            s_stalls[s_stallCount++] = stall;
+        } else {
+            s_stallsDropped++;
+        }
+    }
+    
+    UnlockModel();
+    
+    // Hold the caller until the modeled completion time
+    for (;;) {
+        OSTime now = OSGetTime();
+        if (now >= done || (abort && *abort)) {
+            break;
+        }
+        OSTime remaining = done - now;
+        if (abort && remaining > OSMillisecondsToTicks(WAIT_SLICE_MS)) {
+            remaining = OSMillisecondsToTicks(WAIT_SLICE_MS);
+        }
+        OSSleepTicks(remaining);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDGetLatencyStalls
+  
+  Description:  Copy the stalls recorded so far in the current frame.
+  
+  Arguments:    stalls     Destination array (may be NULL to just count)
+                maxStalls  Capacity of stalls
+  
+  Returns:      Number of stalls recorded this frame
+ *---------------------------------------------------------------------------*/
+u32 DVDGetLatencyStalls(DVDLatencyStall* stalls, u32 maxStalls) {
+    LockModel();
+    u32 count = s_stallCount;
+    if (stalls) {
+        u32 n = (count < maxStalls) ? count : maxStalls;
+        memcpy(stalls, s_stalls, n * sizeof(DVDLatencyStall));
+    }
+    UnlockModel();
+    return count;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDLatencyEndFrame
+  
+  Description:  Report the stalls of the frame that just ended and start a
+                new one. Call once per frame (e.g. after VIWaitForRetrace).
+  
+  Arguments:    None
+  
+  Returns:      Number of stalls in the frame that ended
+ *---------------------------------------------------------------------------*/
+u32 DVDLatencyEndFrame(void) {
+    if (!s_enabled) {
+        return 0;
+    }
+    
+    LockModel();
+    
+    u32 count = s_stallCount;
+    for (u32 i = 0; i < count; i++) {
+        const DVDLatencyStall* s = &s_stalls[i];
+        OSReport("DVD: Frame %u stall %u ms %s %s +0x%X len 0x%X "
+                 "(disc 0x%08X queue %u us seek %u us rot %u us xfer %u us)\n",
+                 s_frameNumber, s->totalMs, s->async ? "async" : "sync",
+                 s->path[0] ? s->path : "?", s->offset, s->length, s->discAddr,
+                 s->queueUs, s->seekUs, s->rotationUs, s->transferUs);
+    }
+    if (s_stallsDropped) {
+        OSReport("DVD: Frame %u: %u more stalls not recorded\n",
+                 s_frameNumber, s_stallsDropped);
+    }
+    
+    count += s_stallsDropped;
+    s_stallCount = 0;
+    s_stallsDropped = 0;
+    s_frameNumber++;
+    
+    UnlockModel();
+    return count;
+}
@@ -0,0 +1,1320 @@
+/*---------------------------------------------------------------------------*
+  DVDOverlay.c - Layered Disc File System
+  
+  On GC/Wii: One disc, one FST. DVDOpen looks a path up in the FST.
+  
+  On PC: The "disc" is a stack of layers. Layer 0 is the DVD root directory
+         ("files/" by default); patches and mods are mounted on top of it
+         as loose directories, GameCube disc images (.gcm/.iso) or U8
+         archives (.arc). A file in a higher layer hides the same path in
+         the layers below.
+  
+  INDEXES:
+  - Every layer keeps its own entry list and path hash table.
+  - The merged index maps each path to the entry of its winning (highest)
+    layer, so DVDOpen resolves a path with one hash probe no matter how
+    many layers are mounted.
+  - When a layer is mounted, unmounted or refreshed, only the paths that
+    layer contributes (before and after the change) are re-resolved; the
+    rest of the index is untouched.
+  - Hot reload (DVDHotReload.c) updates single paths of a directory layer
+    in place. Deleted files stay in the layer's table marked removed, so
+    their slots can be revived if the file comes back.
+  
+  PATHS:
+  Index keys are DVD paths relative to the disc root, '/' separated, no
+  leading slash ("" is the root directory). Case is significant, as it is
+  for fopen on most hosts.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/dvd.h>
+#include <dolphin/dvd_internal.h>
+#include <dolphin/os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define stat _stat
+#else
+#include <dirent.h>
+#include <pthread.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Layer State
+ *---------------------------------------------------------------------------*/
+
+#define LAYER_MAX_DEPTH         16
+#define GCM_MAGIC_OFFSET        0x1C
+#define GCM_MAGIC               0xC2339F3D
+#define GCM_FST_OFFSET          0x424
+#define U8_MAGIC                0x55AA382D
+#define FST_ENTRY_SIZE          12
+
+typedef struct LayerEntry {
+    char*   path;               // DVD path (key)
+    u32     hash;
+    BOOL    isDir;
+    u32     offset;             // Data offset in the image/archive
+    u32     length;             // File size
+    BOOL    removed;            // Deleted on the host since the scan
+} LayerEntry;
+
+typedef struct Layer {
+    BOOL        used;
+    s32         type;           // DVD_LAYER_*
+    u32         rank;           // Higher rank wins
+    u32         stamp;          // s_generation when installed
+    char        path[256];      // Directory (with trailing separator) or file
+    LayerEntry* entries;
+    u32         count;
+    u32         capacity;
+    u32*        hash;           // Open addressing, entry index + 1
+    u32         hashSize;
+} Layer;
+
+typedef struct IndexSlot {
+    u32         hash;
+    s32         layer;          // Winning layer, -1 if deleted
+    u32         entry;          // Entry in that layer
+} IndexSlot;
+
+#define SLOT_EMPTY      -2
+#define SLOT_DELETED    -1
+
+static Layer s_layers[DVD_MAX_LAYERS];
+static u32 s_nextRank = 1;                 // Layer 0 always has rank 0
+
+static IndexSlot* s_index = NULL;
+static u32 s_indexSize = 0;
+static u32 s_indexUsed = 0;                // Live + deleted slots
+static u32 s_generation = 0;               // Bumped on every layer change
+
+#ifdef _WIN32
+static CRITICAL_SECTION s_overlayLock;
+static BOOL s_overlayLockInit = FALSE;
+#else
+static pthread_mutex_t s_overlayLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void LockOverlay(void) {
+#ifdef _WIN32
+    if (!s_overlayLockInit) {
+        InitializeCriticalSection(&s_overlayLock);
+        s_overlayLockInit = TRUE;
+    }
+    EnterCriticalSection(&s_overlayLock);
+#else
+    pthread_mutex_lock(&s_overlayLock);
+#endif
+}
+
+static void UnlockOverlay(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_overlayLock);
+#else
+    pthread_mutex_unlock(&s_overlayLock);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDHashPath
+  
+  Description:  FNV-1a hash of a DVD path.
+  
+  Arguments:    path  DVD path
+  
+  Returns:      Hash value
+ *---------------------------------------------------------------------------*/
+u32 __DVDHashPath(const char* path) {
+    u32 hash = 2166136261u;
+    
+    for (const char* p = path; *p; p++) {
+        hash ^= (u8)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static u32 ReadBE32(const u8* p) {
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         LayerFindAny
+  
+  Description:  Look a path up in one layer, including removed entries.
+  
+  Arguments:    layer  Layer
+                path   DVD path
+                hash   __DVDHashPath(path)
+  
+  Returns:      Entry index, or -1 if the layer has never had the path
+ *---------------------------------------------------------------------------*/
+static s32 LayerFindAny(const Layer* layer, const char* path, u32 hash) {
+    if (!layer->hash) {
+        return -1;
+    }
+    
+    u32 mask = layer->hashSize - 1;
+    for (u32 slot = hash & mask; layer->hash[slot]; slot = (slot + 1) & mask) {
+        const LayerEntry* e = &layer->entries[layer->hash[slot] - 1];
+        if (e->hash == hash && strcmp(e->path, path) == 0) {
+            return (s32)(layer->hash[slot] - 1);
+        }
+    }
+    return -1;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         LayerFind
+  
+  Description:  Look a path up in one layer.
+  
+  Arguments:    layer  Layer
+                path   DVD path
+                hash   __DVDHashPath(path)
+  
+  Returns:      Entry index, or -1 if the layer does not have the path
+ *---------------------------------------------------------------------------*/
+static s32 LayerFind(const Layer* layer, const char* path, u32 hash) {
+    s32 entry = LayerFindAny(layer, path, hash);
+    
+    if (entry >= 0 && layer->entries[entry].removed) {
+        return -1;
+    }
+    return entry;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         LayerAdd
+  
+  Description:  Add an entry to a layer. Duplicate paths keep the first
+                entry; a removed entry for the path is brought back.
+  
+  Arguments:    layer   Layer
+                path    DVD path
+                isDir   TRUE for directories
+                offset  Data offset (images/archives)
+                length  File size
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+static BOOL LayerAdd(Layer* layer, const char* path, BOOL isDir, u32 offset, u32 length) {
+    u32 hash = __DVDHashPath(path);
+    s32 existing = LayerFindAny(layer, path, hash);
+    
+    if (existing >= 0) {
+        LayerEntry* e = &layer->entries[existing];
+        if (e->removed) {
+            e->isDir = isDir;
+            e->offset = offset;
+            e->length = length;
+            e->removed = FALSE;
+        }
+        return TRUE;
+    }
+    
+    if (layer->count == layer->capacity) {
+        u32 capacity = layer->capacity ? layer->capacity * 2 : 256;
+        LayerEntry* grown = (LayerEntry*)realloc(layer->entries, capacity * sizeof(LayerEntry));
+        if (!grown) {
+            return FALSE;
+        }
+        layer->entries = grown;
+        layer->capacity = capacity;
+    }
+    
+    // Keep the hash table at most half full
+    if ((layer->count + 1) * 2 > layer->hashSize) {
+        u32 size = layer->hashSize ? layer->hashSize * 2 : 512;
+        u32* table = (u32*)calloc(size, sizeof(u32));
+        if (!table) {
+            return FALSE;
+        }
+        for (u32 i = 0; i < layer->count; i++) {
+            u32 slot = layer->entries[i].hash & (size - 1);
+            while (table[slot]) slot = (slot + 1) & (size - 1);
+            table[slot] = i + 1;
+        }
+        free(layer->hash);
+        layer->hash = table;
+        layer->hashSize = size;
+    }
+    
+    char* copy = (char*)malloc(strlen(path) + 1);
+    if (!copy) {
+        return FALSE;
+    }
+    strcpy(copy, path);
+    
+    LayerEntry* e = &layer->entries[layer->count];
+    e->path = copy;
+    e->hash = hash;
+    e->isDir = isDir;
+    e->offset = offset;
+    e->length = length;
+    e->removed = FALSE;
+    
+    u32 slot = hash & (layer->hashSize - 1);
+    while (layer->hash[slot]) slot = (slot + 1) & (layer->hashSize - 1);
+    layer->hash[slot] = ++layer->count;
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         LayerFreeContents
+  
+  Description:  Free a layer's entries and hash table.
+  
+  Arguments:    layer  Layer
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void LayerFreeContents(Layer* layer) {
+    for (u32 i = 0; i < layer->count; i++) {
+        free(layer->entries[i].path);
+    }
+    free(layer->entries);
+    free(layer->hash);
+    layer->entries = NULL;
+    layer->hash = NULL;
+    layer->count = 0;
+    layer->capacity = 0;
+    layer->hashSize = 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ScanDirectory
+  
+  Description:  Add the contents of a host directory to a layer.
+  
+  Arguments:    layer    Layer being built
+                hostDir  Host directory (ends with a separator)
+                dvdDir   Matching DVD path ("" or "dir/")
+                depth    Recursion depth
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ScanDirectory(Layer* layer, const char* hostDir, const char* dvdDir, u32 depth) {
+    char hostPath[512];
+    char dvdPath[512];
+    
+    if (depth > LAYER_MAX_DEPTH) {
+        return;
+    }
+
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    snprintf(hostPath, sizeof(hostPath), "%s*", hostDir);
+    HANDLE handle = FindFirstFileA(hostPath, &data);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    do {
+        const char* name = data.cFileName;
+        BOOL isDir = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        u32 length = data.nFileSizeLow;
+#else
+    DIR* dir = opendir(hostDir);
+    struct dirent* ent;
+    if (!dir) {
+        return;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        const char* name = ent->d_name;
+        struct stat st;
+        snprintf(hostPath, sizeof(hostPath), "%s%s", hostDir, name);
+        if (stat(hostPath, &st) != 0) {
+            continue;
+        }
+        BOOL isDir = S_ISDIR(st.st_mode);
+        u32 length = (u32)st.st_size;
+#endif
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+        
+        snprintf(dvdPath, sizeof(dvdPath), "%s%s", dvdDir, name);
+        LayerAdd(layer, dvdPath, isDir, 0, isDir ? 0 : length);
+        
+        if (isDir) {
+            char subHost[512];
+            char subDvd[512];
+            snprintf(subHost, sizeof(subHost), "%s%s%c", hostDir, name, PATH_SEPARATOR);
+            snprintf(subDvd, sizeof(subDvd), "%.*s/", (int)sizeof(subDvd) - 2, dvdPath);
+            ScanDirectory(layer, subHost, subDvd, depth + 1);
+        }
+#ifdef _WIN32
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+#else
+    }
+    closedir(dir);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ParseFST
+  
+  Description:  Add the entries of an FST-style node table to a layer. Disc
+                image FSTs and U8 archives share the format: 12-byte nodes
+                (type:8 nameOffset:24, offset or parent, length or next
+                index), the root node's length is the node count, and the
+                string table follows the nodes.
+  
+  Arguments:    layer  Layer being built
+                fst    Node table (big endian)
+                size   Bytes available at fst
+  
+  Returns:      TRUE if the table was well formed
+ *---------------------------------------------------------------------------*/
+static BOOL ParseFST(Layer* layer, const u8* fst, u32 size) {
+    u32 dirEnd[LAYER_MAX_DEPTH + 1];
+    char prefix[LAYER_MAX_DEPTH + 1][512];
+    u32 depth = 0;
+    
+    if (size < FST_ENTRY_SIZE) {
+        return FALSE;
+    }
+    
+    u32 count = ReadBE32(fst + 8);
+    if (count == 0 || count > size / FST_ENTRY_SIZE) {
+        return FALSE;
+    }
+    
+    const char* strings = (const char*)fst + count * FST_ENTRY_SIZE;
+    u32 stringsSize = size - count * FST_ENTRY_SIZE;
+    
+    dirEnd[0] = count;
+    prefix[0][0] = '\0';
+    
+    for (u32 i = 1; i < count; i++) {
+        const u8* node = fst + i * FST_ENTRY_SIZE;
+        BOOL isDir = (node[0] & 1) != 0;
+        u32 nameOffset = ReadBE32(node) & 0x00FFFFFF;
+        u32 field1 = ReadBE32(node + 4);
+        u32 field2 = ReadBE32(node + 8);
+        char path[512];
+        
+        // Leave directories we have walked past
+        while (depth > 0 && i >= dirEnd[depth]) {
+            depth--;
+        }
+        
+        if (nameOffset >= stringsSize) {
+            return FALSE;
+        }
+        snprintf(path, sizeof(path), "%s%.*s", prefix[depth],
+                 (int)strnlen(strings + nameOffset, stringsSize - nameOffset),
+                 strings + nameOffset);
+        
+        if (isDir) {
+            (void)field1;  // Parent index - implied by nesting
+            LayerAdd(layer, path, TRUE, 0, 0);
+            if (depth < LAYER_MAX_DEPTH && field2 > i && field2 <= count) {
+                depth++;
+                dirEnd[depth] = field2;
+                snprintf(prefix[depth], sizeof(prefix[depth]), "%.*s/",
+                         (int)sizeof(prefix[depth]) - 2, path);
+            }
+        } else {
+            LayerAdd(layer, path, FALSE, field1, field2);
+        }
+    }
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ScanImage
+  
+  Description:  Add the files of a GameCube disc image or U8 archive to a
+                layer.
+  
+  Arguments:    layer  Layer being built
+  
+  Returns:      TRUE if the file was recognized and parsed
+ *---------------------------------------------------------------------------*/
+static BOOL ScanImage(Layer* layer) {
+    u8 header[0x440];
+    u32 fstOffset;
+    u32 fstSize;
+    BOOL ok = FALSE;
+    
+    FILE* file = fopen(layer->path, "rb");
+    if (!file) {
+        return FALSE;
+    }
+    
+    memset(header, 0, sizeof(header));
+    size_t got = fread(header, 1, sizeof(header), file);
+    
+    if (layer->type == DVD_LAYER_ARCHIVE) {
+        if (got < 16 || ReadBE32(header) != U8_MAGIC) {
+            OSReport("DVD: %s is not a U8 archive\n", layer->path);
+            fclose(file);
+            return FALSE;
+        }
+        fstOffset = ReadBE32(header + 4);   // Root node
+        fstSize = ReadBE32(header + 8);     // Nodes + string table
+    } else {
+        if (got < sizeof(header) || ReadBE32(header + GCM_MAGIC_OFFSET) != GCM_MAGIC) {
+            OSReport("DVD: %s is not a GameCube disc image\n", layer->path);
+            fclose(file);
+            return FALSE;
+        }
+        fstOffset = ReadBE32(header + GCM_FST_OFFSET);
+        fstSize = ReadBE32(header + GCM_FST_OFFSET + 4);
+    }
+    
+    u8* fst = (fstSize > 0 && fstSize < 64 * 1024 * 1024) ? (u8*)malloc(fstSize) : NULL;
+    if (fst && fseek(file, (long)fstOffset, SEEK_SET) == 0 &&
+        fread(fst, 1, fstSize, file) == fstSize) {
+        ok = ParseFST(layer, fst, fstSize);
+    }
+    if (!ok) {
+        OSReport("DVD: Could not read file table of %s\n", layer->path);
+    }
+    
+    free(fst);
+    fclose(file);
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ScanLayer
+  
+  Description:  (Re)build a layer's entries from its source.
+  
+  Arguments:    layer  Layer with type and path set, contents empty
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+static BOOL ScanLayer(Layer* layer) {
+    LayerAdd(layer, "", TRUE, 0, 0);  // Root directory
+    
+    if (layer->type == DVD_LAYER_DIRECTORY) {
+        ScanDirectory(layer, layer->path, "", 0);
+        return TRUE;
+    }
+    return ScanImage(layer);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         IndexFindSlot
+  
+  Description:  Find the merged index slot for a path.
+  
+  Arguments:    path  DVD path
+                hash  __DVDHashPath(path)
+  
+  Returns:      Slot, or NULL if the path has never been indexed
+ *---------------------------------------------------------------------------*/
+static IndexSlot* IndexFindSlot(const char* path, u32 hash) {
+    if (!s_index) {
+        return NULL;
+    }
+    
+    u32 mask = s_indexSize - 1;
+    for (u32 i = hash & mask; s_index[i].layer != SLOT_EMPTY; i = (i + 1) & mask) {
+        IndexSlot* slot = &s_index[i];
+        if (slot->layer >= 0 && slot->hash == hash &&
+            strcmp(s_layers[slot->layer].entries[slot->entry].path, path) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         IndexResize
+  
+  Description:  Rehash live slots into a table sized for the current entry
+                count, dropping deleted slots.
+  
+  Arguments:    minLive  Live entries the table must hold
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+static BOOL IndexResize(u32 minLive) {
+    u32 size = 1024;
+    while (size < minLive * 2) size <<= 1;
+    
+    IndexSlot* table = (IndexSlot*)malloc(size * sizeof(IndexSlot));
+    if (!table) {
+        return FALSE;
+    }
+    for (u32 i = 0; i < size; i++) {
+        table[i].layer = SLOT_EMPTY;
+    }
+    
+    u32 used = 0;
+    for (u32 i = 0; i < s_indexSize; i++) {
+        if (s_index[i].layer >= 0) {
+            u32 j = s_index[i].hash & (size - 1);
+            while (table[j].layer != SLOT_EMPTY) j = (j + 1) & (size - 1);
+            table[j] = s_index[i];
+            used++;
+        }
+    }
+    
+    free(s_index);
+    s_index = table;
+    s_indexSize = size;
+    s_indexUsed = used;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         IndexResolve
+  
+  Description:  Re-resolve one path: find its highest-ranked layer and
+                point the merged index at it, or delete it if no layer has
+                the path any more.
+  
+  Arguments:    path  DVD path
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void IndexResolve(const char* path) {
+    u32 hash = __DVDHashPath(path);
+    s32 bestLayer = -1;
+    s32 bestEntry = -1;
+    
+    for (s32 i = 0; i < DVD_MAX_LAYERS; i++) {
+        if (!s_layers[i].used) continue;
+        if (bestLayer >= 0 && s_layers[i].rank < s_layers[bestLayer].rank) continue;
+        
+        s32 entry = LayerFind(&s_layers[i], path, hash);
+        if (entry >= 0) {
+            bestLayer = i;
+            bestEntry = entry;
+        }
+    }
+    
+    IndexSlot* slot = IndexFindSlot(path, hash);
+    if (slot) {
+        if (bestLayer >= 0) {
+            slot->layer = bestLayer;
+            slot->entry = (u32)bestEntry;
+        } else {
+            slot->layer = SLOT_DELETED;
+        }
+        return;
+    }
+    if (bestLayer < 0) {
+        return;
+    }
+    
+    if ((s_indexUsed + 1) * 2 > s_indexSize && !IndexResize(s_indexUsed + 1)) {
+        return;
+    }
+    
+    u32 mask = s_indexSize - 1;
+    u32 i = hash & mask;
+    while (s_index[i].layer >= 0) i = (i + 1) & mask;
+    if (s_index[i].layer == SLOT_EMPTY) {
+        s_indexUsed++;
+    }
+    s_index[i].hash = hash;
+    s_index[i].layer = bestLayer;
+    s_index[i].entry = (u32)bestEntry;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ReplaceLayer
+  
+  Description:  Install new contents for a layer slot and re-resolve every
+                path the old or new contents mention. Other paths keep
+                their index slots untouched. Caller holds the lock.
+  
+  Arguments:    index     Layer slot
+                newLayer  New contents (used = FALSE to remove the layer)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ReplaceLayer(s32 index, Layer* newLayer) {
+    Layer old = s_layers[index];
+    
+    s_layers[index] = *newLayer;
+    
+    // Old entries first: their index slots may point into the old layer
+    if (old.used) {
+        for (u32 i = 0; i < old.count; i++) {
+            u32 hash = old.entries[i].hash;
+            IndexSlot* slot = NULL;
+            
+            // Find slot by pointer identity (strings are still the old ones)
+            if (s_index) {
+                u32 mask = s_indexSize - 1;
+                for (u32 j = hash & mask; s_index[j].layer != SLOT_EMPTY; j = (j + 1) & mask) {
+                    if (s_index[j].layer == index && s_index[j].hash == hash &&
+                        s_index[j].entry == i) {
+                        slot = &s_index[j];
+                        break;
+                    }
+                }
+            }
+            if (slot) {
+                slot->layer = SLOT_DELETED;  // Re-resolved below
+            }
+        }
+        for (u32 i = 0; i < old.count; i++) {
+            IndexResolve(old.entries[i].path);
+        }
+    }
+    
+    if (newLayer->used) {
+        for (u32 i = 0; i < newLayer->count; i++) {
+            IndexResolve(newLayer->entries[i].path);
+        }
+    }
+    
+    if (old.used) {
+        LayerFreeContents(&old);
+    }
+    
+    // Compact once deleted slots pile up
+    if (s_index) {
+        u32 live = 0;
+        for (u32 i = 0; i < s_indexSize; i++) {
+            if (s_index[i].layer >= 0) live++;
+        }
+        if (s_indexUsed > live * 2 + 1024) {
+            IndexResize(live);
+        }
+    }
+    
+    s_generation++;
+    s_layers[index].stamp = s_generation;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         BuildLayer
+  
+  Description:  Create and scan a layer description.
+  
+  Arguments:    out   Receives the layer
+                path  Directory or file
+                type  DVD_LAYER_* (AUTO detects)
+                rank  Stack position
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+static BOOL BuildLayer(Layer* out, const char* path, s32 type, u32 rank) {
+    struct stat st;
+    
+    memset(out, 0, sizeof(*out));
+    
+    if (stat(path, &st) != 0) {
+        OSReport("DVD: Layer source does not exist: %s\n", path);
+        return FALSE;
+    }
+    
+    if (type == DVD_LAYER_AUTO) {
+        if (st.st_mode & S_IFDIR) {
+            type = DVD_LAYER_DIRECTORY;
+        } else {
+            u8 magic[4] = {0};
+            FILE* f = fopen(path, "rb");
+            if (f) {
+                if (fread(magic, 1, 4, f) != 4) magic[0] = 0;
+                fclose(f);
+            }
+            type = (ReadBE32(magic) == U8_MAGIC) ? DVD_LAYER_ARCHIVE : DVD_LAYER_DISC_IMAGE;
+        }
+    }
+    
+    out->type = type;
+    out->rank = rank;
+    strncpy(out->path, path, sizeof(out->path) - 1);
+    
+    // Directory layers are addressed as prefix + relative path
+    if (type == DVD_LAYER_DIRECTORY) {
+        size_t len = strlen(out->path);
+        if (len > 0 && len < sizeof(out->path) - 1 &&
+            out->path[len - 1] != '/' && out->path[len - 1] != '\\') {
+            out->path[len] = PATH_SEPARATOR;
+            out->path[len + 1] = '\0';
+        }
+    }
+    
+    if (!ScanLayer(out)) {
+        LayerFreeContents(out);
+        return FALSE;
+    }
+    
+    out->used = TRUE;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlaySetBase
+  
+  Description:  Mount or re-mount the DVD root directory as layer 0.
+  
+  Arguments:    rootPath  Root directory
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __DVDOverlaySetBase(const char* rootPath) {
+    Layer layer;
+    
+    if (!BuildLayer(&layer, rootPath, DVD_LAYER_DIRECTORY, 0)) {
+        memset(&layer, 0, sizeof(layer));
+    }
+    
+    LockOverlay();
+    ReplaceLayer(0, &layer);
+    UnlockOverlay();
+    
+    OSReport("DVD: Indexed %u entries in %s\n", layer.count, rootPath);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDMountLayer
+  
+  Description:  Mount a directory, disc image or archive on top of the
+                layer stack.
+  
+  Arguments:    path  Directory, .gcm/.iso image or U8 archive
+                type  DVD_LAYER_* (DVD_LAYER_AUTO to detect)
+  
+  Returns:      Layer ID (> 0), or -1 on failure
+ *---------------------------------------------------------------------------*/
+s32 DVDMountLayer(const char* path, s32 type) {
+    Layer layer;
+    s32 slot = -1;
+    
+    if (!path) {
+        return -1;
+    }
+    
+    LockOverlay();
+    for (s32 i = 1; i < DVD_MAX_LAYERS; i++) {
+        if (!s_layers[i].used) {
+            slot = i;
+            break;
+        }
+    }
+    u32 rank = s_nextRank++;
+    UnlockOverlay();
+    
+    if (slot < 0) {
+        OSReport("DVD: Too many layers mounted\n");
+        return -1;
+    }
+    
+    // Scan without the lock; only the index update needs it
+    if (!BuildLayer(&layer, path, type, rank)) {
+        return -1;
+    }
+    
+    LockOverlay();
+    if (s_layers[slot].used) {
+        // Raced with another mount - take any free slot
+        slot = -1;
+        for (s32 i = 1; i < DVD_MAX_LAYERS; i++) {
+            if (!s_layers[i].used) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot >= 0) {
+        ReplaceLayer(slot, &layer);
+    }
+    UnlockOverlay();
+    
+    if (slot < 0) {
+        LayerFreeContents(&layer);
+        return -1;
+    }
+    
+    OSReport("DVD: Mounted layer %d: %s (%u entries)\n", slot, path, layer.count);
+    return slot;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDUnmountLayer
+  
+  Description:  Remove a layer. Paths it provided fall back to the layers
+                below. Files already open keep reading from the old source.
+  
+  Arguments:    layerId  ID from DVDMountLayer (layer 0 cannot be removed)
+  
+  Returns:      TRUE if unmounted
+ *---------------------------------------------------------------------------*/
+BOOL DVDUnmountLayer(s32 layerId) {
+    Layer empty;
+    
+    if (layerId <= 0 || layerId >= DVD_MAX_LAYERS) {
+        return FALSE;
+    }
+    
+    memset(&empty, 0, sizeof(empty));
+    
+    LockOverlay();
+    if (!s_layers[layerId].used) {
+        UnlockOverlay();
+        return FALSE;
+    }
+    ReplaceLayer(layerId, &empty);
+    UnlockOverlay();
+    
+    OSReport("DVD: Unmounted layer %d\n", layerId);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDRefreshLayer
+  
+  Description:  Re-scan a layer after its contents changed on the host and
+                update the index for the paths it adds or drops.
+  
+  Arguments:    layerId  Layer ID (0 = DVD root directory)
+  
+  Returns:      TRUE if refreshed
+ *---------------------------------------------------------------------------*/
+BOOL DVDRefreshLayer(s32 layerId) {
+    Layer layer;
+    char path[256];
+    s32 type;
+    u32 rank;
+    
+    if (layerId < 0 || layerId >= DVD_MAX_LAYERS) {
+        return FALSE;
+    }
+    
+    LockOverlay();
+    if (!s_layers[layerId].used) {
+        UnlockOverlay();
+        return FALSE;
+    }
+    strcpy(path, s_layers[layerId].path);
+    type = s_layers[layerId].type;
+    rank = s_layers[layerId].rank;
+    UnlockOverlay();
+    
+    if (!BuildLayer(&layer, path, type, rank)) {
+        return FALSE;
+    }
+    
+    LockOverlay();
+    if (s_layers[layerId].used && s_layers[layerId].rank == rank) {
+        ReplaceLayer(layerId, &layer);
+    } else {
+        LayerFreeContents(&layer);  // Unmounted meanwhile
+    }
+    UnlockOverlay();
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDGetNumLayers
+  
+  Description:  Count mounted layers, including the DVD root directory.
+  
+  Arguments:    None
+  
+  Returns:      Number of layers
+ *---------------------------------------------------------------------------*/
+s32 DVDGetNumLayers(void) {
+    s32 count = 0;
+    
+    LockOverlay();
+    for (s32 i = 0; i < DVD_MAX_LAYERS; i++) {
+        if (s_layers[i].used) count++;
+    }
+    UnlockOverlay();
+    
+    return count;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         FillResult
+  
+  Description:  Describe a winning entry for DVD.c. Caller holds the lock.
+  
+  Arguments:    layer  Layer slot
+                entry  Entry index
+                out    Receives host path, offset, length
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void FillResult(s32 layer, u32 entry, DVDOverlayFile* out) {
+    const Layer* l = &s_layers[layer];
+    const LayerEntry* e = &l->entries[entry];
+    
+    out->isDir = e->isDir;
+    out->length = e->length;
+    out->layer = layer;
+    
+    if (l->type == DVD_LAYER_DIRECTORY) {
+        snprintf(out->hostPath, sizeof(out->hostPath), "%s%s", l->path, e->path);
+#ifdef _WIN32
+        for (char* p = out->hostPath; *p; p++) {
+            if (*p == '/') *p = '\\';
+        }
+#endif
+        out->baseOffset = 0;
+    } else {
+        strncpy(out->hostPath, l->path, sizeof(out->hostPath) - 1);
+        out->hostPath[sizeof(out->hostPath) - 1] = '\0';
+        out->baseOffset = e->offset;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlayLookup
+  
+  Description:  Resolve a DVD path with one probe of the merged index.
+  
+                A miss also checks the directory layers on the host, top
+                first, so files created after the last scan are found; a
+                hit there is added to its layer and the index.
+  
+  Arguments:    dvdPath  Normalized DVD path
+                out      Receives where to read the file from
+  
+  Returns:      TRUE if found
+ *---------------------------------------------------------------------------*/
+BOOL __DVDOverlayLookup(const char* dvdPath, DVDOverlayFile* out) {
+    BOOL found = FALSE;
+    
+    LockOverlay();
+    
+    IndexSlot* slot = IndexFindSlot(dvdPath, __DVDHashPath(dvdPath));
+    if (slot) {
+        FillResult(slot->layer, slot->entry, out);
+        found = TRUE;
+    } else {
+        s32 best = -1;
+        struct stat st;
+        
+        for (s32 i = 0; i < DVD_MAX_LAYERS; i++) {
+            const Layer* l = &s_layers[i];
+            if (!l->used || l->type != DVD_LAYER_DIRECTORY) continue;
+            if (best >= 0 && l->rank < s_layers[best].rank) continue;
+            
+            char hostPath[512];
+            snprintf(hostPath, sizeof(hostPath), "%s%s", l->path, dvdPath);
+            if (stat(hostPath, &st) == 0) {
+                best = i;
+            }
+        }
+        
+        if (best >= 0) {
+            char hostPath[512];
+            snprintf(hostPath, sizeof(hostPath), "%s%s", s_layers[best].path, dvdPath);
+            if (stat(hostPath, &st) == 0) {
+                BOOL isDir = (st.st_mode & S_IFDIR) != 0;
+                LayerAdd(&s_layers[best], dvdPath, isDir, 0, isDir ? 0 : (u32)st.st_size);
+                IndexResolve(dvdPath);
+                
+                slot = IndexFindSlot(dvdPath, __DVDHashPath(dvdPath));
+                if (slot) {
+                    FillResult(slot->layer, slot->entry, out);
+                    found = TRUE;
+                }
+            }
+        }
+    }
+    
+    UnlockOverlay();
+    return found;
+}
+
+static int CompareDirEntries(const void* a, const void* b) {
+    return strcmp(((const DVDOverlayDirEntry*)a)->name, ((const DVDOverlayDirEntry*)b)->name);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlayListDir
+  
+  Description:  List the merged contents of a directory, sorted by name.
+                Walks the whole index, so meant for DVDOpenDir, not for
+                per-frame use.
+  
+  Arguments:    dvdPath  Normalized DVD path of the directory
+                count    Receives number of entries
+  
+  Returns:      Array of entries (one allocation, release with free()),
+                or NULL if the directory does not exist
+ *---------------------------------------------------------------------------*/
+DVDOverlayDirEntry* __DVDOverlayListDir(const char* dvdPath, u32* count) {
+    DVDOverlayDirEntry* list = NULL;
+    size_t dirLen = strlen(dvdPath);
+    u32 n = 0;
+    size_t names = 0;
+    
+    *count = 0;
+    
+    LockOverlay();
+    
+    IndexSlot* dirSlot = IndexFindSlot(dvdPath, __DVDHashPath(dvdPath));
+    if (!dirSlot || !s_layers[dirSlot->layer].entries[dirSlot->entry].isDir) {
+        UnlockOverlay();
+        return NULL;
+    }
+    
+    // Pass 0 sizes the allocation, pass 1 fills it
+    for (u32 pass = 0; pass < 2; pass++) {
+        char* strings = list ? (char*)(list + n) : NULL;
+        u32 fill = 0;
+        
+        for (u32 i = 0; i < s_indexSize; i++) {
+            if (s_index[i].layer < 0) continue;
+            
+            const LayerEntry* e = &s_layers[s_index[i].layer].entries[s_index[i].entry];
+            const char* name = e->path;
+            
+            if (dirLen > 0) {
+                if (strncmp(name, dvdPath, dirLen) != 0 || name[dirLen] != '/') continue;
+                name += dirLen + 1;
+            }
+            if (name[0] == '\0' || strchr(name, '/')) continue;  // Self or deeper
+            
+            if (pass == 0) {
+                n++;
+                names += strlen(name) + 1;
+            } else {
+                strcpy(strings, name);
+                list[fill].name = strings;
+                list[fill].isDir = e->isDir;
+                strings += strlen(name) + 1;
+                fill++;
+            }
+        }
+        
+        if (pass == 0) {
+            list = (DVDOverlayDirEntry*)malloc(n * sizeof(DVDOverlayDirEntry) + names + 1);
+            if (!list) {
+                UnlockOverlay();
+                return NULL;
+            }
+        }
+    }
+    
+    UnlockOverlay();
+    
+    qsort(list, n, sizeof(DVDOverlayDirEntry), CompareDirEntries);
+    *count = n;
+    return list;
+}
+
+static int CompareFSTOrder(const void* a, const void* b) {
+    const char* pa = (*(const LayerEntry* const*)a)->path;
+    const char* pb = (*(const LayerEntry* const*)b)->path;
+    
+    // '/' sorts before every name character, giving depth-first FST order
+    for (;; pa++, pb++) {
+        u8 ca = (*pa == '/') ? 1 : (u8)*pa;
+        u8 cb = (*pb == '/') ? 1 : (u8)*pb;
+        if (ca != cb || ca == 0) return (int)ca - (int)cb;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlayWalkFiles
+  
+  Description:  Visit every file of the merged disc in FST order (names
+                sorted, depth first).
+  
+  Arguments:    visit  Called with DVD path and length of each file
+                arg    Passed to visit
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __DVDOverlayWalkFiles(void (*visit)(const char* dvdPath, u32 length, void* arg), void* arg) {
+    LockOverlay();
+    
+    const LayerEntry** files = (const LayerEntry**)malloc((s_indexSize + 1) * sizeof(LayerEntry*));
+    u32 n = 0;
+    
+    if (files) {
+        for (u32 i = 0; i < s_indexSize; i++) {
+            if (s_index[i].layer < 0) continue;
+            const LayerEntry* e = &s_layers[s_index[i].layer].entries[s_index[i].entry];
+            if (!e->isDir) {
+                files[n++] = e;
+            }
+        }
+        qsort(files, n, sizeof(LayerEntry*), CompareFSTOrder);
+        for (u32 i = 0; i < n; i++) {
+            visit(files[i]->path, files[i]->length, arg);
+        }
+        free(files);
+    }
+    
+    UnlockOverlay();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlayGetGeneration
+  
+  Description:  Counter bumped whenever a layer is mounted, unmounted or
+                rescanned, so users of the merged tree (e.g. the latency
+                model layout) can tell it is stale. Single-path updates
+                (late-created files, hot reload) do not bump it.
+  
+  Arguments:    None
+  
+  Returns:      Generation number
+ *---------------------------------------------------------------------------*/
+u32 __DVDOverlayGetGeneration(void) {
+    return s_generation;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlayGetLayer
+  
+  Description:  Describe a mounted layer.
+  
+  Arguments:    layerId  Layer slot
+                path     Receives the source path (directories end with a
+                         separator)
+                size     Size of path
+                type     Receives DVD_LAYER_*
+                stamp    Receives the install stamp; it changes whenever
+                         the layer is replaced or rescanned
+  
+  Returns:      TRUE if the slot holds a layer
+ *---------------------------------------------------------------------------*/
+BOOL __DVDOverlayGetLayer(s32 layerId, char* path, u32 size, s32* type, u32* stamp) {
+    BOOL used;
+    
+    if (layerId < 0 || layerId >= DVD_MAX_LAYERS) {
+        return FALSE;
+    }
+    
+    LockOverlay();
+    used = s_layers[layerId].used;
+    if (used) {
+        snprintf(path, size, "%s", s_layers[layerId].path);
+        *type = s_layers[layerId].type;
+        *stamp = s_layers[layerId].stamp;
+    }
+    UnlockOverlay();
+    
+    return used;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         UnderPath
+  
+  Description:  Test whether an entry path is dvdPath or inside it.
+ *---------------------------------------------------------------------------*/
+static BOOL UnderPath(const char* entryPath, const char* dvdPath, size_t len) {
+    if (len == 0) {
+        return TRUE;
+    }
+    return strncmp(entryPath, dvdPath, len) == 0 &&
+           (entryPath[len] == '\0' || entryPath[len] == '/');
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDOverlayUpdatePath
+  
+  Description:  Bring one path of a directory layer up to date with the
+                host after it was created, rewritten or deleted. If the
+                path is (or was) a directory, everything under it is
+                updated too. Only the affected entries are touched.
+                
+                changed is called, with the overlay locked, for every file
+                whose visible version changed: files hidden by a higher
+                layer are updated silently.
+  
+  Arguments:    layerId  Directory layer
+                stamp    Install stamp the caller knows the layer by; the
+                         update is dropped if the layer was replaced
+                dvdPath  Normalized DVD path
+                changed  Change reporter, or NULL
+                arg      Passed to changed
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __DVDOverlayUpdatePath(s32 layerId, u32 stamp, const char* dvdPath,
+                            DVDOverlayChangeFunc changed, void* arg) {
+    char hostPath[512];
+    struct stat st;
+    size_t len = strlen(dvdPath);
+    
+    if (layerId < 0 || layerId >= DVD_MAX_LAYERS) {
+        return;
+    }
+    
+    LockOverlay();
+    
+    Layer* layer = &s_layers[layerId];
+    if (!layer->used || layer->stamp != stamp || layer->type != DVD_LAYER_DIRECTORY) {
+        UnlockOverlay();
+        return;
+    }
+    
+    snprintf(hostPath, sizeof(hostPath), "%s%s", layer->path, dvdPath);
+    BOOL exists = (stat(hostPath, &st) == 0);
+    BOOL isDir = exists && (st.st_mode & S_IFDIR) != 0;
+    
+    s32 entry = LayerFindAny(layer, dvdPath, __DVDHashPath(dvdPath));
+    BOOL wasDir = (entry >= 0 && layer->entries[entry].isDir);
+    BOOL subtree = isDir || wasDir;
+    
+    // Drop the old view of the path, then re-add what is on the host now
+    if (entry >= 0) {
+        layer->entries[entry].removed = TRUE;
+    }
+    if (wasDir) {
+        for (u32 i = 0; i < layer->count; i++) {
+            if (UnderPath(layer->entries[i].path, dvdPath, len)) {
+                layer->entries[i].removed = TRUE;
+            }
+        }
+    }
+    if (exists) {
+        LayerAdd(layer, dvdPath, isDir, 0, isDir ? 0 : (u32)st.st_size);
+        if (isDir) {
+            char hostDir[512];
+            char dvdDir[512];
+            snprintf(hostDir, sizeof(hostDir), "%.*s%c", (int)sizeof(hostDir) - 2,
+                     hostPath, PATH_SEPARATOR);
+            snprintf(dvdDir, sizeof(dvdDir), "%.*s/", (int)sizeof(dvdDir) - 2, dvdPath);
+            ScanDirectory(layer, hostDir, len ? dvdDir : "", 0);
+        }
+    }
+    
+    // Re-resolve; the index still names the old winners until then
+    for (u32 i = 0; i < layer->count; i++) {
+        const char* path;
+        
+        if (subtree) {
+            if (!UnderPath(layer->entries[i].path, dvdPath, len)) continue;
+        } else if ((s32)i != entry && strcmp(layer->entries[i].path, dvdPath) != 0) {
+            continue;
+        }
+        
+        path = layer->entries[i].path;
+        u32 hash = layer->entries[i].hash;
+        IndexSlot* slot = IndexFindSlot(path, hash);
+        s32 before = slot ? slot->layer : -1;
+        
+        IndexResolve(path);
+        
+        slot = IndexFindSlot(path, hash);
+        s32 after = slot ? slot->layer : -1;
+        
+        if (changed && !layer->entries[i].isDir && (before == layerId || after == layerId)) {
+            s32 event = (before < 0) ? DVD_HOTRELOAD_ADDED :
+                        (after < 0)  ? DVD_HOTRELOAD_REMOVED : DVD_HOTRELOAD_MODIFIED;
+            changed(path, event, arg);
+        }
+    }
+    
+    UnlockOverlay();
+}
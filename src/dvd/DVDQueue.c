@@ -4,7 +4,7 @@
   Manages priority-based command queues for DVD operations.
   
   On GC/Wii: Hardware has limited command slots, needs queuing
-  On PC: File I/O is instant, but we maintain queues for API compatibility
+  On PC: The async reader thread in DVD.c services these queues in order
  *---------------------------------------------------------------------------*/
 
 #include <dolphin/dvd.h>
@@ -96,6 +96,10 @@ static DVDCommandBlock* PopWaitingQueuePrio(s32 prio) {
     q->next = tmp->next;
     tmp->next->prev = q;
     
+    // Unlink so __DVDIsBlockInWaitingQueue() reports it as no longer queued
+    tmp->next = NULL;
+    tmp->prev = NULL;
+    
     OSRestoreInterrupts(enabled);
     return tmp;
 }
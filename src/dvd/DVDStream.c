@@ -0,0 +1,627 @@
+/*---------------------------------------------------------------------------*
+  DVDStream.c - DVD Audio Streaming
+  
+  On GC/Wii: The drive streams ADP (DVD streaming ADPCM) straight from the
+             disc, decodes it in hardware and feeds the audio interface.
+             The game only issues DVDPrepareStreamAbsAsync/DVDCancelStream.
+  
+  On PC: A streaming thread reads the prepared region of the file into a
+         single-producer/single-consumer ring buffer. The audio backend pulls
+         PCM with DVDStreamDecode(), which decodes ADP frames on demand and
+         never blocks on disc I/O - if the ring runs dry it outputs silence
+         and counts an underrun.
+  
+  RING BUFFER:
+  - Power-of-two size, monotonic read/write positions (wrap via mask)
+  - Writes are whole 32-byte ADP frames, so frames never straddle the end
+  - Producer (stream thread) owns s_writePos, consumer owns s_readPos
+  - Prepare/cancel stop the producer and briefly take s_decodeLock to reset
+    the consumer side; a decode that finds it held outputs silence
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/dvd.h>
+#include <dolphin/dvd_internal.h>
+#include <dolphin/os.h>
+#include <dolphin/atomic_internal.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Stream State
+ *---------------------------------------------------------------------------*/
+
+#define STREAM_BUFFER_SIZE      (256 * 1024)  // ~1.5s of 48 kHz stereo ADP
+#define STREAM_BUFFER_MASK      (STREAM_BUFFER_SIZE - 1)
+#define STREAM_READ_SIZE        (32 * 1024)   // Bytes per disc read
+#define STREAM_PREFILL_SIZE     (64 * 1024)   // Buffered before prepare completes
+#define STREAM_IDLE_SLEEP_MS    5             // Producer sleep when ring is full
+
+static u8 s_ring[STREAM_BUFFER_SIZE];
+static volatile u32 s_writePos = 0;           // Producer: bytes written
+static volatile u32 s_readPos = 0;            // Consumer: bytes decoded
+static volatile u32 s_decodeLock = 0;         // Held by decode or by reset
+
+static volatile u32 s_active = FALSE;         // Stream prepared
+static volatile u32 s_ended = FALSE;          // Producer finished the region
+static volatile u32 s_stopRequested = FALSE;  // Tells the producer to exit
+
+static DVDCommandBlock* s_streamBlock = NULL;
+static DVDCBCallback s_prepareCallback = NULL;
+static DVDFileInfo* s_prepareFileInfo = NULL; // For DVDPrepareStreamAsync
+static DVDCallback s_prepareFileCallback = NULL;
+static u32 s_streamOffset = 0;                // Next file offset to read
+static u32 s_streamRemaining = 0;             // Bytes left in the region
+
+#ifdef _WIN32
+static HANDLE s_streamThread = NULL;
+#else
+static pthread_t s_streamThread;
+#endif
+static BOOL s_threadRunning = FALSE;
+
+// Decoder state (consumer side, guarded by s_decodeLock)
+static s32 s_hist[2][2];                      // [channel][h1, h2]
+static s16 s_leftover[DVD_STREAM_FRAME_SAMPLES * 2];
+static u32 s_leftoverPos = 0;
+static u32 s_leftoverCount = 0;
+
+// Statistics
+static volatile u32 s_underruns = 0;
+static volatile u32 s_blocksDecoded = 0;
+static volatile u64 s_bytesRead = 0;
+static volatile u64 s_decodeNs = 0;
+static volatile u32 s_maxBlockNs = 0;
+
+/*---------------------------------------------------------------------------*
+  Name:         ReadAt
+  
+  Description:  Positional read that does not disturb the FILE* position,
+                so the stream thread can share a file with DVDRead calls.
+  
+  Arguments:    file    Open file
+                dest    Destination buffer
+                length  Bytes to read
+                offset  File offset
+  
+  Returns:      Bytes read, or -1 on error
+ *---------------------------------------------------------------------------*/
+static s32 ReadAt(FILE* file, void* dest, u32 length, u32 offset) {
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    OVERLAPPED ov;
+    DWORD got = 0;
+    
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = offset;
+    if (!ReadFile(handle, dest, length, &got, &ov)) {
+        return (GetLastError() == ERROR_HANDLE_EOF) ? 0 : -1;
+    }
+    return (s32)got;
+#else
+    ssize_t got = pread(fileno(file), dest, length, (off_t)offset);
+    return (got < 0) ? -1 : (s32)got;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         SleepMs
+  
+  Description:  Sleep the calling (stream) thread.
+  
+  Arguments:    ms  Milliseconds
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void SleepMs(u32 ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    usleep(ms * 1000);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         FirePrepareCallback
+  
+  Description:  Report the outcome of a prepare request, once.
+  
+  Arguments:    result  DVD_RESULT_* code
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void FirePrepareCallback(s32 result) {
+    DVDCBCallback callback = s_prepareCallback;
+    DVDCallback fileCallback = s_prepareFileCallback;
+    DVDFileInfo* fileInfo = s_prepareFileInfo;
+    
+    s_prepareCallback = NULL;
+    s_prepareFileCallback = NULL;
+    s_prepareFileInfo = NULL;
+    
+    if (callback) {
+        callback(result, s_streamBlock);
+    }
+    if (fileCallback) {
+        fileCallback(result, fileInfo);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StreamThread
+  
+  Description:  Producer. Keeps the ring buffer topped up from the streamed
+                region until it is exhausted or a stop is requested. Fires
+                the prepare callback once the prefill is buffered.
+  
+  Arguments:    arg  Unused
+  
+  Returns:      0 (thread return value)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI StreamThread(LPVOID arg)
+#else
+static void* StreamThread(void* arg)
+#endif
+{
+    FILE* file = s_streamBlock->file;
+    BOOL primed = FALSE;
+    s32 result = DVD_RESULT_GOOD;
+    
+    (void)arg;
+    
+    while (!__AtomicLoad32(&s_stopRequested) && s_streamRemaining > 0) {
+        u32 w = s_writePos;
+        u32 space = STREAM_BUFFER_SIZE - (w - __AtomicLoad32(&s_readPos));
+        u32 length = STREAM_READ_SIZE;
+        
+        if (length > s_streamRemaining) length = s_streamRemaining;
+        
+        // Wait for a full chunk of space unless this is the tail
+        if (space < length) {
+            if (!primed) {
+                primed = TRUE;
+                FirePrepareCallback(DVD_RESULT_GOOD);
+            }
+            SleepMs(STREAM_IDLE_SLEEP_MS);
+            continue;
+        }
+        
+        // Never straddle the end of the ring
+        if (length > STREAM_BUFFER_SIZE - (w & STREAM_BUFFER_MASK)) {
+            length = STREAM_BUFFER_SIZE - (w & STREAM_BUFFER_MASK);
+        }
+        
+        s32 got = ReadAt(file, &s_ring[w & STREAM_BUFFER_MASK], length,
+                         s_streamBlock->baseOffset + s_streamOffset);
+        if (got < DVD_STREAM_FRAME_SIZE) {
+            if (got < 0) {
+                OSReport("DVD: Stream read failed at offset 0x%08X\n", s_streamOffset);
+                result = DVD_RESULT_FATAL_ERROR;
+            }
+            break;  // Error, or file shorter than the prepared region
+        }
+        got &= ~(DVD_STREAM_FRAME_SIZE - 1);
+        
+        __AtomicStore32(&s_writePos, w + (u32)got);
+        __AtomicAdd64(&s_bytesRead, (u64)got);
+        s_streamOffset += (u32)got;
+        s_streamRemaining -= (u32)got;
+        
+        if (!primed && (s_writePos >= STREAM_PREFILL_SIZE || s_streamRemaining == 0)) {
+            primed = TRUE;
+            FirePrepareCallback(DVD_RESULT_GOOD);
+        }
+    }
+    
+    __AtomicStore32(&s_ended, TRUE);
+    
+    if (!primed) {
+        if (__AtomicLoad32(&s_stopRequested)) {
+            result = DVD_RESULT_CANCELED;
+        }
+        FirePrepareCallback(result);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         AcquireDecodeLock / ReleaseDecodeLock
+  
+  Description:  Exclude the audio thread while the game thread resets the
+                stream. Decoding holds the lock for one call only, so the
+                game thread never waits long.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void AcquireDecodeLock(void) {
+    while (!__AtomicCompareSwap32(&s_decodeLock, 0, 1)) {
+        SleepMs(0);
+    }
+}
+
+static void ReleaseDecodeLock(void) {
+    __AtomicStore32(&s_decodeLock, 0);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StopStream
+  
+  Description:  Stop the producer thread and empty the ring buffer.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StopStream(void) {
+    if (s_threadRunning) {
+        __AtomicStore32(&s_stopRequested, TRUE);
+#ifdef _WIN32
+        WaitForSingleObject(s_streamThread, INFINITE);
+        CloseHandle(s_streamThread);
+        s_streamThread = NULL;
+#else
+        pthread_join(s_streamThread, NULL);
+#endif
+        s_threadRunning = FALSE;
+    }
+    
+    AcquireDecodeLock();
+    __AtomicStore32(&s_active, FALSE);
+    __AtomicStore32(&s_writePos, 0);
+    __AtomicStore32(&s_readPos, 0);
+    memset(s_hist, 0, sizeof(s_hist));
+    s_leftoverPos = 0;
+    s_leftoverCount = 0;
+    ReleaseDecodeLock();
+    
+    s_streamBlock = NULL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StartStream
+  
+  Description:  Validate the region, replace any current stream and start
+                the producer thread. Exactly one of the callbacks is used.
+  
+  Arguments:    block         Command block of an open file
+                length        Bytes of ADP data (0 = to end of file)
+                offset        Start offset within the file
+                callback      Block-style prepare callback
+                fileInfo      File passed to fileCallback
+                fileCallback  File-style prepare callback
+  
+  Returns:      TRUE if streaming started
+ *---------------------------------------------------------------------------*/
+static BOOL StartStream(DVDCommandBlock* block, u32 length, u32 offset,
+                        DVDCBCallback callback, DVDFileInfo* fileInfo,
+                        DVDCallback fileCallback) {
+    if (!block || !block->file || !block->fileInfo) {
+        return FALSE;
+    }
+    
+    u32 fileLength = block->fileInfo->length;
+    
+    offset &= ~(DVD_STREAM_FRAME_SIZE - 1);
+    if (offset >= fileLength) {
+        OSReport("DVD: Stream offset 0x%08X is past end of file\n", offset);
+        return FALSE;
+    }
+    if (length == 0 || length > fileLength - offset) {
+        length = fileLength - offset;
+    }
+    length &= ~(DVD_STREAM_FRAME_SIZE - 1);
+    if (length == 0) {
+        return FALSE;
+    }
+    
+    // One stream at a time - a new prepare replaces the current stream
+    StopStream();
+    
+    s_streamBlock = block;
+    s_prepareCallback = callback;
+    s_prepareFileInfo = fileInfo;
+    s_prepareFileCallback = fileCallback;
+    s_streamOffset = offset;
+    s_streamRemaining = length;
+    __AtomicStore32(&s_stopRequested, FALSE);
+    __AtomicStore32(&s_ended, FALSE);
+    __AtomicStore32(&s_active, TRUE);
+    
+#ifdef _WIN32
+    s_streamThread = CreateThread(NULL, 0, StreamThread, NULL, 0, NULL);
+    s_threadRunning = (s_streamThread != NULL);
+#else
+    s_threadRunning = (pthread_create(&s_streamThread, NULL, StreamThread, NULL) == 0);
+#endif
+    
+    if (!s_threadRunning) {
+        OSReport("DVD: Failed to start stream thread\n");
+        __AtomicStore32(&s_active, FALSE);
+        s_streamBlock = NULL;
+        s_prepareCallback = NULL;
+        s_prepareFileInfo = NULL;
+        s_prepareFileCallback = NULL;
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDPrepareStreamAbsAsync
+  
+  Description:  Start streaming ADP audio.
+  
+                On GC/Wii: offset is an absolute disc address
+                On PC: offset is relative to the start of block's file (there
+                       is no disc image to address); rounded down to a
+                       32-byte frame. length 0 streams to end of file.
+  
+  Arguments:    block     Command block of an open file
+                length    Bytes of ADP data to stream
+                offset    Start offset within the file
+                callback  Called from the stream thread once primed
+  
+  Returns:      TRUE if streaming started
+ *---------------------------------------------------------------------------*/
+BOOL DVDPrepareStreamAbsAsync(DVDCommandBlock* block, u32 length, u32 offset,
+                               DVDCBCallback callback) {
+    return StartStream(block, length, offset, callback, NULL, NULL);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDPrepareStreamAsync
+  
+  Description:  Start streaming ADP audio from an open file.
+  
+  Arguments:    fileInfo  Open file
+                length    Bytes of ADP data to stream (0 = to end of file)
+                offset    Start offset within the file
+                callback  Called from the stream thread once primed
+  
+  Returns:      TRUE if streaming started
+ *---------------------------------------------------------------------------*/
+BOOL DVDPrepareStreamAsync(DVDFileInfo* fileInfo, u32 length, u32 offset,
+                           DVDCallback callback) {
+    if (!fileInfo) {
+        return FALSE;
+    }
+    
+    return StartStream(fileInfo->cb, length, offset, NULL, fileInfo, callback);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDCancelStreamAsync
+  
+  Description:  Stop audio streaming.
+  
+                On PC: Completes before returning (the stream thread only
+                       has to finish its current read); the callback is
+                       called from the calling thread.
+  
+  Arguments:    block     Command block
+                callback  Completion callback
+  
+  Returns:      TRUE
+ *---------------------------------------------------------------------------*/
+BOOL DVDCancelStreamAsync(DVDCommandBlock* block, DVDCBCallback callback) {
+    StopStream();
+    
+    if (callback) {
+        callback(DVD_RESULT_GOOD, block);
+    }
+    
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDCancelStream
+  
+  Description:  Stop audio streaming (synchronous).
+  
+  Arguments:    block  Command block
+  
+  Returns:      DVD_RESULT_GOOD
+ *---------------------------------------------------------------------------*/
+s32 DVDCancelStream(DVDCommandBlock* block) {
+    (void)block;
+    
+    StopStream();
+    return DVD_RESULT_GOOD;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __DVDStreamBlockClosed
+  
+  Description:  Called by DVDClose before a command block is released. Stops
+                the stream if it reads from that block's file.
+  
+  Arguments:    block  Command block being closed
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __DVDStreamBlockClosed(DVDCommandBlock* block) {
+    if (block && block == s_streamBlock) {
+        StopStream();
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DecodeFrame
+  
+  Description:  Decode one 32-byte ADP frame into 28 interleaved stereo
+                samples. Header bytes 0/1 hold the left/right predictor
+                (high nibble) and shift (low nibble); data bytes carry the
+                left sample in the low nibble and the right in the high one.
+  
+  Arguments:    frame  ADP frame
+                out    56 s16 samples (L, R, ...)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void DecodeFrame(const u8* frame, s16* out) {
+    for (u32 ch = 0; ch < 2; ch++) {
+        u32 pred = frame[ch] >> 4;
+        u32 shift = frame[ch] & 0xF;
+        s32 h1 = s_hist[ch][0];
+        s32 h2 = s_hist[ch][1];
+        
+        for (u32 i = 0; i < DVD_STREAM_FRAME_SAMPLES; i++) {
+            u32 nibble = ch ? (frame[4 + i] >> 4) : (frame[4 + i] & 0xF);
+            s32 hist = 0;
+            
+            switch (pred) {
+                case 1: hist = h1 * 0x3C; break;
+                case 2: hist = h1 * 0x73 - h2 * 0x34; break;
+                case 3: hist = h1 * 0x62 - h2 * 0x37; break;
+                default: break;
+            }
+            
+            hist = (hist + 0x20) >> 6;
+            if (hist > 0x1FFFFF) hist = 0x1FFFFF;
+            if (hist < -0x200000) hist = -0x200000;
+            
+            s32 cur = ((((s16)(nibble << 12)) >> shift) << 6) + hist;
+            h2 = h1;
+            h1 = cur;
+            
+            cur >>= 6;
+            if (cur > 32767) cur = 32767;
+            if (cur < -32768) cur = -32768;
+            out[i * 2 + ch] = (s16)cur;
+        }
+        
+        s_hist[ch][0] = h1;
+        s_hist[ch][1] = h2;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDStreamDecode
+  
+  Description:  Decode buffered ADP data into PCM for the audio backend.
+                Never blocks on disc I/O. Frames requested beyond what is
+                buffered are silence; if the stream has not ended this is
+                counted as an underrun.
+  
+  Arguments:    pcm        Interleaved stereo output
+                numFrames  Stereo sample pairs wanted
+  
+  Returns:      Sample pairs decoded from the stream
+ *---------------------------------------------------------------------------*/
+u32 DVDStreamDecode(s16* pcm, u32 numFrames) {
+    u32 produced = 0;
+    u32 blocks = 0;
+    
+    if (!pcm || numFrames == 0) {
+        return 0;
+    }
+    
+    // Stream being reset right now - output silence rather than wait
+    if (!__AtomicCompareSwap32(&s_decodeLock, 0, 1)) {
+        memset(pcm, 0, numFrames * 2 * sizeof(s16));
+        return 0;
+    }
+    
+    OSTime start = OSGetTime();
+    u32 w = __AtomicLoad32(&s_writePos);
+    u32 r = s_readPos;
+    
+    while (produced < numFrames) {
+        // Samples left over from a frame split across calls
+        if (s_leftoverPos < s_leftoverCount) {
+            u32 n = s_leftoverCount - s_leftoverPos;
+            if (n > numFrames - produced) n = numFrames - produced;
+            memcpy(&pcm[produced * 2], &s_leftover[s_leftoverPos * 2], n * 2 * sizeof(s16));
+            s_leftoverPos += n;
+            produced += n;
+            continue;
+        }
+        
+        if (w - r < DVD_STREAM_FRAME_SIZE) {
+            break;
+        }
+        
+        const u8* frame = &s_ring[r & STREAM_BUFFER_MASK];
+        if (numFrames - produced >= DVD_STREAM_FRAME_SAMPLES) {
+            DecodeFrame(frame, &pcm[produced * 2]);
+            produced += DVD_STREAM_FRAME_SAMPLES;
+        } else {
+            DecodeFrame(frame, s_leftover);
+            s_leftoverPos = 0;
+            s_leftoverCount = DVD_STREAM_FRAME_SAMPLES;
+        }
+        
+        r += DVD_STREAM_FRAME_SIZE;
+        blocks++;
+    }
+    
+    __AtomicStore32(&s_readPos, r);
+    
+    if (blocks > 0) {
+        u64 ns = (u64)OSTicksToNanoseconds(OSGetTime() - start);
+        u32 perBlock = (u32)(ns / blocks);
+        
+        __AtomicAdd64(&s_decodeNs, ns);
+        __AtomicAdd32(&s_blocksDecoded, blocks);
+        if (perBlock > s_maxBlockNs) {
+            s_maxBlockNs = perBlock;
+        }
+    }
+    
+    if (produced < numFrames) {
+        memset(&pcm[produced * 2], 0, (numFrames - produced) * 2 * sizeof(s16));
+        if (__AtomicLoad32(&s_active) && !__AtomicLoad32(&s_ended)) {
+            __AtomicAdd32(&s_underruns, 1);
+        }
+    }
+    
+    ReleaseDecodeLock();
+    return produced;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DVDGetStreamStats
+  
+  Description:  Snapshot streaming counters. Safe from any thread; counters
+                are read individually, so they may be a few frames apart.
+  
+  Arguments:    stats  Receives counters
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void DVDGetStreamStats(DVDStreamStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    u32 w = __AtomicLoad32(&s_writePos);
+    u32 r = __AtomicLoad32(&s_readPos);
+    
+    stats->active = (BOOL)__AtomicLoad32(&s_active);
+    stats->ended = (BOOL)__AtomicLoad32(&s_ended);
+    stats->bufferSize = STREAM_BUFFER_SIZE;
+    stats->bufferedBytes = (w - r <= STREAM_BUFFER_SIZE) ? (w - r) : 0;
+    stats->underruns = __AtomicLoad32(&s_underruns);
+    stats->blocksDecoded = __AtomicLoad32(&s_blocksDecoded);
+    stats->bytesRead = __AtomicLoad64(&s_bytesRead);
+    stats->decodeNanoseconds = __AtomicLoad64(&s_decodeNs);
+    stats->avgBlockNanoseconds = stats->blocksDecoded
+        ? (u32)(stats->decodeNanoseconds / stats->blocksDecoded) : 0;
+    stats->maxBlockNanoseconds = s_maxBlockNs;
+}
@@ -6,21 +6,187 @@
   - Locked cache scratchpad
   - Big-endian byte order
   - Virtual address mirrors (cached/uncached)
+  - Optional fastmem: the guest address space mirrored in host memory
+  
+  Regions are anonymous mappings committed on first touch (see Region
+  Backing), so an untouched 64 MB MEM2 costs no RAM.
  *---------------------------------------------------------------------------*/
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* memfd_create, MADV_HUGEPAGE */
+#endif
+
 #include <dolphin/gecko_memory.h>
 #include <dolphin/os.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define GECKO_FASTMEM 1
+#include <signal.h>
+#endif
+
 #ifdef PORPOISE_USE_GECKO_MEMORY
 GeckoMemory* g_geckoMemory = NULL;
 #endif
 
+static void ReleaseFastmem(GeckoMemory* mem);
+
+/*---------------------------------------------------------------------------*
+    Region Backing
+    
+    Each region is its own anonymous mapping. The OS hands out zeroed
+    pages on first touch, so nothing is cleared at startup and only pages
+    the game uses count against RAM. With GECKO_MEMORY_HUGE_PAGES the
+    mapping is 2 MB aligned and marked for transparent huge pages (Linux;
+    elsewhere the flag is ignored).
+ *---------------------------------------------------------------------------*/
+
+#define HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+static u8* RegionAlloc(u32 size, u32 flags) {
+#ifdef _WIN32
+    (void)flags;
+    return (u8*)VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    BOOL huge = FALSE;
+#ifdef MADV_HUGEPAGE
+    huge = (flags & GECKO_MEMORY_HUGE_PAGES) && size >= HUGE_PAGE_SIZE;
+#endif
+    size_t span = huge ? (size_t)size + HUGE_PAGE_SIZE : size;
+    u8* p = (u8*)mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    
+    if (p == (u8*)MAP_FAILED) {
+        return NULL;
+    }
+    if (huge) {
+        /* Trim to a 2 MB aligned start so whole huge pages fit */
+        u8* aligned = (u8*)ROUND_UP((uintptr_t)p, HUGE_PAGE_SIZE);
+        if (aligned > p) {
+            munmap(p, aligned - p);
+        }
+        munmap(aligned + size, (p + span) - (aligned + size));
+        p = aligned;
+#ifdef MADV_HUGEPAGE
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+    }
+    return p;
+#endif
+}
+
+static void RegionFree(u8* p, u32 size) {
+    if (!p) {
+        return;
+    }
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+}
+
+/* Copy into a zero-filled destination, skipping all-zero source pages
+   (reading an untouched page does not commit it; writing would) */
+static void CopyTouched(u8* dst, const u8* src, u32 size) {
+    static const u8 zero[4096];
+    
+    for (u32 off = 0; off < size; off += sizeof(zero)) {
+        u32 n = (size - off < sizeof(zero)) ? size - off : (u32)sizeof(zero);
+        if (memcmp(src + off, zero, n) != 0) {
+            memcpy(dst + off, src + off, n);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ResidentBytes
+  
+  Description:  Count the pages of a region that are in physical memory.
+  
+  Arguments:    p     Region start (page aligned)
+                size  Region size
+  
+  Returns:      Resident bytes, 0 if unknown
+ *---------------------------------------------------------------------------*/
+static u32 ResidentBytes(const u8* p, u32 size) {
+    u32 resident = 0;
+    
+    if (!p) {
+        return 0;
+    }
+    
+#ifdef _WIN32
+    PSAPI_WORKING_SET_EX_INFORMATION info[256];
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    u32 page = si.dwPageSize;
+    
+    for (u32 off = 0; off < size; ) {
+        u32 n = 0;
+        for (; n < ARRAY_LENGTH(info) && off + n * page < size; n++) {
+            info[n].VirtualAddress = (PVOID)(p + off + n * page);
+        }
+        if (!QueryWorkingSetEx(GetCurrentProcess(), info, n * sizeof(info[0]))) {
+            return 0;
+        }
+        for (u32 i = 0; i < n; i++) {
+            if (info[i].VirtualAttributes.Valid) {
+                resident += page;
+            }
+        }
+        off += n * page;
+    }
+#else
+    unsigned char vec[1024];
+    u32 page = (u32)sysconf(_SC_PAGESIZE);
+    
+    for (u32 off = 0; off < size; ) {
+        u32 pages = ROUND_UP(size - off, page) / page;
+        if (pages > sizeof(vec)) {
+            pages = sizeof(vec);
+        }
+#ifdef __APPLE__
+        if (mincore((void*)(p + off), (size_t)pages * page, (char*)vec) != 0) {
+#else
+        if (mincore((void*)(p + off), (size_t)pages * page, vec) != 0) {
+#endif
+            return 0;
+        }
+        for (u32 i = 0; i < pages; i++) {
+            if (vec[i] & 1) {
+                resident += page;
+            }
+        }
+        off += pages * page;
+    }
+#endif
+    return (resident < size) ? resident : size;
+}
+
 void GeckoMemoryInit(GeckoMemory* mem, BOOL is_wii) {
+    GeckoMemoryInitEx(mem, is_wii, 0);
+}
+
+void GeckoMemoryInitEx(GeckoMemory* mem, BOOL is_wii, u32 flags) {
     if (!mem) return;
     
-    memset(mem->mem1, 0, GECKO_MEM1_SIZE);
+    mem->flags = flags;
+    mem->mem1 = RegionAlloc(GECKO_MEM1_SIZE, flags);
+    mem->locked_cache = RegionAlloc(GECKO_LOCKED_CACHE_SIZE, flags);
+    if (!mem->mem1 || !mem->locked_cache) {
+        OSPanic(__FILE__, __LINE__, "Failed to allocate Gecko MEM1");
+    }
+    mem->fastmem = NULL;
     mem->is_wii = is_wii;
     mem->mem2_enabled = FALSE;
     mem->aram_enabled = FALSE;
@@ -28,9 +194,8 @@ void GeckoMemoryInit(GeckoMemory* mem, BOOL is_wii) {
     
     /* Allocate MEM2 for Wii */
     if (is_wii) {
-        mem->mem2 = (u8*)malloc(GECKO_MEM2_SIZE);
+        mem->mem2 = RegionAlloc(GECKO_MEM2_SIZE, flags);
         if (mem->mem2) {
-            memset(mem->mem2, 0, GECKO_MEM2_SIZE);
             mem->mem2_enabled = TRUE;
         }
     } else {
@@ -38,20 +203,27 @@ void GeckoMemoryInit(GeckoMemory* mem, BOOL is_wii) {
     }
     
     mem->aram = NULL;
-    memset(mem->locked_cache, 0, GECKO_LOCKED_CACHE_SIZE);
 }
 
 void GeckoMemoryFree(GeckoMemory* mem) {
     if (!mem) return;
     
+    /* Fastmem owns MEM1, MEM2 and the locked cache */
+    ReleaseFastmem(mem);
+    
+    RegionFree(mem->mem1, GECKO_MEM1_SIZE);
+    RegionFree(mem->locked_cache, GECKO_LOCKED_CACHE_SIZE);
+    mem->mem1 = NULL;
+    mem->locked_cache = NULL;
+    
     if (mem->mem2) {
-        free(mem->mem2);
+        RegionFree(mem->mem2, GECKO_MEM2_SIZE);
         mem->mem2 = NULL;
         mem->mem2_enabled = FALSE;
     }
     
     if (mem->aram) {
-        free(mem->aram);
+        RegionFree(mem->aram, GECKO_ARAM_SIZE);
         mem->aram = NULL;
         mem->aram_enabled = FALSE;
     }
@@ -60,13 +232,35 @@ void GeckoMemoryFree(GeckoMemory* mem) {
 void GeckoMemoryAllocARAM(GeckoMemory* mem) {
     if (!mem || mem->aram_enabled) return;
     
-    mem->aram = (u8*)malloc(GECKO_ARAM_SIZE);
+    mem->aram = RegionAlloc(GECKO_ARAM_SIZE, mem->flags);
     if (mem->aram) {
-        memset(mem->aram, 0, GECKO_ARAM_SIZE);
         mem->aram_enabled = TRUE;
     }
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         GeckoMemoryGetUsage
+  
+  Description:  Report how much of each region is in physical memory.
+                Pages the game never touched are not counted.
+  
+  Arguments:    mem    GeckoMemory
+                usage  Receives resident bytes per region
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoMemoryGetUsage(const GeckoMemory* mem, GeckoMemoryUsage* usage) {
+    if (!usage) return;
+    
+    memset(usage, 0, sizeof(*usage));
+    if (!mem) return;
+    
+    usage->mem1Resident = ResidentBytes(mem->mem1, GECKO_MEM1_SIZE);
+    usage->mem2Resident = mem->mem2_enabled ? ResidentBytes(mem->mem2, GECKO_MEM2_SIZE) : 0;
+    usage->aramResident = mem->aram_enabled ? ResidentBytes(mem->aram, GECKO_ARAM_SIZE) : 0;
+    usage->lockedCacheResident = ResidentBytes(mem->locked_cache, GECKO_LOCKED_CACHE_SIZE);
+}
+
 u32 GeckoTranslateAddress(u32 vaddr) {
     /* Cached mirror of MEM1 (0x80000000 - 0x817FFFFF) */
     if (vaddr >= 0x80000000 && vaddr < 0x81800000) {
@@ -98,6 +292,10 @@ BOOL GeckoIsLockedCacheAddress(u32 addr) {
 }
 
 u8 GeckoRead8(const GeckoMemory* mem, u32 vaddr) {
+    if (mem->fastmem) {
+        return mem->fastmem[vaddr];
+    }
+    
     u32 paddr = GeckoTranslateAddress(vaddr);
     
     /* Locked cache */
@@ -123,6 +321,11 @@ u8 GeckoRead8(const GeckoMemory* mem, u32 vaddr) {
 }
 
 void GeckoWrite8(GeckoMemory* mem, u32 vaddr, u8 value) {
+    if (mem->fastmem) {
+        mem->fastmem[GECKO_FASTMEM_STORE_VIEW + vaddr] = value;
+        return;
+    }
+    
     u32 paddr = GeckoTranslateAddress(vaddr);
     
     /* Locked cache */
@@ -147,54 +350,603 @@ void GeckoWrite8(GeckoMemory* mem, u32 vaddr, u8 value) {
     }
 }
 
+/*---------------------------------------------------------------------------*
+    Multi-byte Access
+    
+    Each access translates its address once. If all of its bytes land in
+    the same region (always true for naturally aligned accesses) it is a
+    single unaligned host load or store plus a byte swap. Accesses that
+    straddle a region boundary or touch unmapped space take the byte-wise
+    path, so they see exactly what GeckoRead8/GeckoWrite8 would.
+    
+    With fastmem the host address is fastmem + vaddr (stores: in the store
+    view) with no checks at all; see the Fastmem section.
+ *---------------------------------------------------------------------------*/
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define GeckoSwap16(x) (x)
+#define GeckoSwap32(x) (x)
+#define GeckoSwap64(x) (x)
+#elif defined(_MSC_VER)
+#define GeckoSwap16(x) _byteswap_ushort(x)
+#define GeckoSwap32(x) _byteswap_ulong(x)
+#define GeckoSwap64(x) _byteswap_uint64(x)
+#else
+#define GeckoSwap16(x) __builtin_bswap16(x)
+#define GeckoSwap32(x) __builtin_bswap32(x)
+#define GeckoSwap64(x) __builtin_bswap64(x)
+#endif
+
+#define FastLoad(mem, vaddr)    ((mem)->fastmem + (vaddr))
+#define FastStore(mem, vaddr)   ((mem)->fastmem + GECKO_FASTMEM_STORE_VIEW + (vaddr))
+
+/* Host address of vaddr and the bytes left in its region (0 if unmapped) */
+static inline u8* LookupRun(const GeckoMemory* mem, u32 vaddr, u32* avail) {
+    /* Locked cache */
+    if (GeckoIsLockedCacheAddress(vaddr)) {
+        u32 offset = vaddr - GECKO_LOCKED_CACHE_BASE;
+        *avail = GECKO_LOCKED_CACHE_SIZE - offset;
+        return (u8*)&mem->locked_cache[offset];
+    }
+    
+    u32 paddr = GeckoTranslateAddress(vaddr);
+    
+    /* MEM1 (mirrors end exactly where MEM1 does) */
+    if (paddr < GECKO_MEM1_SIZE) {
+        *avail = GECKO_MEM1_SIZE - paddr;
+        return (u8*)&mem->mem1[paddr];
+    }
+    
+    /* MEM2 (Wii); staying below 64 MB keeps the upper address bits, and
+       with them the translation, the same for every byte */
+    if (mem->mem2_enabled && (paddr & 0x10000000)) {
+        u32 offset = paddr & 0x03FFFFFF;
+        if (offset < GECKO_MEM2_SIZE) {
+            *avail = GECKO_MEM2_SIZE - offset;
+            return &mem->mem2[offset];
+        }
+    }
+    
+    *avail = 0;
+    return NULL;
+}
+
+/* Host address of [vaddr, vaddr + size) if it lies in one region, else NULL */
+static inline u8* LookupRange(const GeckoMemory* mem, u32 vaddr, u32 size) {
+    u32 avail;
+    u8* p = LookupRun(mem, vaddr, &avail);
+    return (avail >= size) ? p : NULL;
+}
+
+static u64 ReadSlow(const GeckoMemory* mem, u32 vaddr, u32 size) {
+    u64 value = 0;
+    for (u32 i = 0; i < size; i++) {
+        value = (value << 8) | GeckoRead8(mem, vaddr + i);
+    }
+    return value;
+}
+
+static void WriteSlow(GeckoMemory* mem, u32 vaddr, u64 value, u32 size) {
+    for (u32 i = 0; i < size; i++) {
+        GeckoWrite8(mem, vaddr + i, (u8)(value >> ((size - 1 - i) * 8)));
+    }
+}
+
 u16 GeckoRead16(const GeckoMemory* mem, u32 vaddr) {
-    u8 b0 = GeckoRead8(mem, vaddr);
-    u8 b1 = GeckoRead8(mem, vaddr + 1);
-    return ((u16)b0 << 8) | b1;
+    const u8* p = mem->fastmem ? FastLoad(mem, vaddr) : LookupRange(mem, vaddr, 2);
+    if (p) {
+        u16 v;
+        memcpy(&v, p, sizeof(v));
+        return GeckoSwap16(v);
+    }
+    return (u16)ReadSlow(mem, vaddr, 2);
 }
 
 void GeckoWrite16(GeckoMemory* mem, u32 vaddr, u16 value) {
-    GeckoWrite8(mem, vaddr, (value >> 8) & 0xFF);
-    GeckoWrite8(mem, vaddr + 1, value & 0xFF);
+    u8* p = mem->fastmem ? FastStore(mem, vaddr) : LookupRange(mem, vaddr, 2);
+    if (p) {
+        u16 v = GeckoSwap16(value);
+        memcpy(p, &v, sizeof(v));
+        return;
+    }
+    WriteSlow(mem, vaddr, value, 2);
 }
 
 u32 GeckoRead32(const GeckoMemory* mem, u32 vaddr) {
-    u8 b0 = GeckoRead8(mem, vaddr);
-    u8 b1 = GeckoRead8(mem, vaddr + 1);
-    u8 b2 = GeckoRead8(mem, vaddr + 2);
-    u8 b3 = GeckoRead8(mem, vaddr + 3);
-    return ((u32)b0 << 24) | ((u32)b1 << 16) | ((u32)b2 << 8) | b3;
+    const u8* p = mem->fastmem ? FastLoad(mem, vaddr) : LookupRange(mem, vaddr, 4);
+    if (p) {
+        u32 v;
+        memcpy(&v, p, sizeof(v));
+        return GeckoSwap32(v);
+    }
+    return (u32)ReadSlow(mem, vaddr, 4);
 }
 
 void GeckoWrite32(GeckoMemory* mem, u32 vaddr, u32 value) {
-    GeckoWrite8(mem, vaddr, (value >> 24) & 0xFF);
-    GeckoWrite8(mem, vaddr + 1, (value >> 16) & 0xFF);
-    GeckoWrite8(mem, vaddr + 2, (value >> 8) & 0xFF);
-    GeckoWrite8(mem, vaddr + 3, value & 0xFF);
+    u8* p = mem->fastmem ? FastStore(mem, vaddr) : LookupRange(mem, vaddr, 4);
+    if (p) {
+        u32 v = GeckoSwap32(value);
+        memcpy(p, &v, sizeof(v));
+        return;
+    }
+    WriteSlow(mem, vaddr, value, 4);
+}
+
+u64 GeckoRead64(const GeckoMemory* mem, u32 vaddr) {
+    const u8* p = mem->fastmem ? FastLoad(mem, vaddr) : LookupRange(mem, vaddr, 8);
+    if (p) {
+        u64 v;
+        memcpy(&v, p, sizeof(v));
+        return GeckoSwap64(v);
+    }
+    return ReadSlow(mem, vaddr, 8);
+}
+
+void GeckoWrite64(GeckoMemory* mem, u32 vaddr, u64 value) {
+    u8* p = mem->fastmem ? FastStore(mem, vaddr) : LookupRange(mem, vaddr, 8);
+    if (p) {
+        u64 v = GeckoSwap64(value);
+        memcpy(p, &v, sizeof(v));
+        return;
+    }
+    WriteSlow(mem, vaddr, value, 8);
+}
+
+/*---------------------------------------------------------------------------*
+    Block Access
+    
+    Copies a span between guest and host memory, byte-swapping every
+    element of the given width (1 copies without swapping). Each run that
+    stays inside one region is converted in bulk by OSSwapBytes*. An
+    element that straddles a region end or touches unmapped space is
+    accessed byte-wise, as GeckoRead8/GeckoWrite8 would. With fastmem a
+    run only ends where the address wraps past 0xFFFFFFFF.
+ *---------------------------------------------------------------------------*/
+
+/* Like LookupRun, for the fastmem load or store view */
+static inline u8* FastRun(const GeckoMemory* mem, u32 vaddr, u32* avail, BOOL store) {
+    *avail = (vaddr != 0) ? 0u - vaddr : 0xFFFFFFFF;
+    return store ? FastStore(mem, vaddr) : FastLoad(mem, vaddr);
+}
+
+static BOOL IsValidBlock(u32 size, u32 width) {
+    return (width == 1 || width == 2 || width == 4 || width == 8) && (size % width) == 0;
+}
+
+static void SwapRun(u8* dst, const u8* src, u32 size, u32 width) {
+    switch (width) {
+        case 2:  OSSwapBytes16(dst, src, size / 2); break;
+        case 4:  OSSwapBytes32(dst, src, size / 4); break;
+        case 8:  OSSwapBytes64(dst, src, size / 8); break;
+        default: memcpy(dst, src, size); break;
+    }
+}
+
+/* Host-order element <-> u64 */
+static void StoreHost(u8* p, u64 value, u32 width) {
+    u8 v8 = (u8)value;
+    u16 v16 = (u16)value;
+    u32 v32 = (u32)value;
+    
+    switch (width) {
+        case 1:  memcpy(p, &v8, 1); break;
+        case 2:  memcpy(p, &v16, 2); break;
+        case 4:  memcpy(p, &v32, 4); break;
+        default: memcpy(p, &value, 8); break;
+    }
+}
+
+static u64 LoadHost(const u8* p, u32 width) {
+    u8 v8;
+    u16 v16;
+    u32 v32;
+    u64 v64;
+    
+    switch (width) {
+        case 1:  memcpy(&v8, p, 1); return v8;
+        case 2:  memcpy(&v16, p, 2); return v16;
+        case 4:  memcpy(&v32, p, 4); return v32;
+        default: memcpy(&v64, p, 8); return v64;
+    }
+}
+
+BOOL GeckoReadBlock(const GeckoMemory* mem, void* dst, u32 vaddr, u32 size, u32 width) {
+    u8* out = (u8*)dst;
+    
+    if (!mem || !dst || !IsValidBlock(size, width)) {
+        return FALSE;
+    }
+    
+    while (size > 0) {
+        u32 avail;
+        const u8* p = mem->fastmem ? FastRun(mem, vaddr, &avail, FALSE)
+                                   : LookupRun(mem, vaddr, &avail);
+        u32 n = ((avail < size) ? avail : size) & ~(width - 1);  /* Whole elements */
+        
+        if (n > 0) {
+            SwapRun(out, p, n, width);
+        } else {
+            n = width;
+            StoreHost(out, ReadSlow(mem, vaddr, width), width);
+        }
+        
+        out += n;
+        vaddr += n;
+        size -= n;
+    }
+    return TRUE;
+}
+
+BOOL GeckoWriteBlock(GeckoMemory* mem, u32 vaddr, const void* src, u32 size, u32 width) {
+    const u8* in = (const u8*)src;
+    
+    if (!mem || !src || !IsValidBlock(size, width)) {
+        return FALSE;
+    }
+    
+    while (size > 0) {
+        u32 avail;
+        u8* p = mem->fastmem ? FastRun(mem, vaddr, &avail, TRUE)
+                             : LookupRun(mem, vaddr, &avail);
+        u32 n = ((avail < size) ? avail : size) & ~(width - 1);  /* Whole elements */
+        
+        if (n > 0) {
+            SwapRun(p, in, n, width);
+        } else {
+            n = width;
+            WriteSlow(mem, vaddr, LoadHost(in, width), width);
+        }
+        
+        in += n;
+        vaddr += n;
+        size -= n;
+    }
+    return TRUE;
 }
 
 void* GeckoGetPointer(GeckoMemory* mem, u32 vaddr) {
-    u32 paddr = GeckoTranslateAddress(vaddr);
+    u32 avail;
+    u8* p = LookupRun(mem, vaddr, &avail);
     
-    /* Locked cache */
+    /* With fastmem, hand out the address's own mirror, so a transfer that
+       runs past the end of the region reads open bus instead of the heap */
+    if (p && mem->fastmem) {
+        return FastLoad(mem, vaddr);
+    }
+    return p;
+}
+
+/*---------------------------------------------------------------------------*
+    Fastmem
+    
+    One memfd holds MEM1, the locked cache and MEM2. A single reservation
+    covers the 32-bit guest space twice, as a load view and a store view,
+    plus one page:
+    
+      [0, 4 GiB)          Loads:  fastmem + vaddr
+      [4 GiB, 8 GiB)      Stores: fastmem + GECKO_FASTMEM_STORE_VIEW + vaddr
+      [8 GiB, +1 page)    MEM1 page 0 again, for a store that wraps past
+                          0xFFFFFFFF (a wrapping load already lands on
+                          page 0 of the store view)
+    
+    The mirrors at 0x00000000/0x80000000/0xC0000000 (MEM1),
+    0x10000000/0x90000000/0xD0000000 (MEM2) and 0xE0000000 (locked cache)
+    are mapped in both views up front. Every other page starts with no
+    access. The first touch faults into FastmemFault, which resolves the
+    page with the slow-path translation and maps it in place:
+    - Backed by memory: that part of the memfd
+    - Unmapped, load view: a private copy of a page of 0xFF
+    - Unmapped, store view: one shared scratch page that is never read
+    Keeping the views apart is what makes an unmapped load read 0xFF and
+    an unmapped store vanish, as in GeckoRead8/GeckoWrite8, without
+    decoding the faulting instruction. Resolved pages are always writable,
+    so an access never faults twice on the same page.
+ *---------------------------------------------------------------------------*/
+
+#ifdef GECKO_FASTMEM
+
+#define FAST_SPAN           (2 * GECKO_FASTMEM_STORE_VIEW)
+#define FAST_SLOT           0x4000      // Largest page size supported (16 KB)
+
+/* memfd layout */
+#define FAST_MEM1_OFFSET    0
+#define FAST_LC_OFFSET      (FAST_MEM1_OFFSET + GECKO_MEM1_SIZE)
+#define FAST_OPENBUS_OFFSET (FAST_LC_OFFSET + GECKO_LOCKED_CACHE_SIZE)
+#define FAST_SCRATCH_OFFSET (FAST_OPENBUS_OFFSET + FAST_SLOT)
+#define FAST_MEM2_OFFSET    (FAST_SCRATCH_OFFSET + FAST_SLOT)
+
+static u8* volatile s_fastBase = NULL;  // Reservation; NULL when off
+static int s_fastFd = -1;
+static u32 s_pageSize;
+static BOOL s_fastMem2;                 // MEM2 is in the memfd
+static BOOL s_handlerInstalled = FALSE;
+static struct sigaction s_prevSegv;
+
+/* memfd offset backing guest address vaddr, or -1 if unmapped */
+static s64 BackingOffset(u32 vaddr) {
     if (GeckoIsLockedCacheAddress(vaddr)) {
-        u32 offset = vaddr - GECKO_LOCKED_CACHE_BASE;
-        return &mem->locked_cache[offset];
+        return FAST_LC_OFFSET + (vaddr - GECKO_LOCKED_CACHE_BASE);
     }
     
-    /* MEM1 */
+    u32 paddr = GeckoTranslateAddress(vaddr);
     if (paddr < GECKO_MEM1_SIZE) {
-        return &mem->mem1[paddr];
+        return FAST_MEM1_OFFSET + paddr;
     }
-    
-    /* MEM2 (Wii) */
-    if (mem->mem2_enabled && (paddr & 0x10000000)) {
+    if (s_fastMem2 && (paddr & 0x10000000)) {
         u32 offset = paddr & 0x03FFFFFF;
         if (offset < GECKO_MEM2_SIZE) {
-            return &mem->mem2[offset];
+            return FAST_MEM2_OFFSET + offset;
         }
     }
+    return -1;
+}
+
+static BOOL MapBacking(u64 offset, u32 size, s64 fileOffset, int flags) {
+    void* p = mmap(s_fastBase + offset, size, PROT_READ | PROT_WRITE,
+                   flags | MAP_FIXED, s_fastFd, (off_t)fileOffset);
+    return p != MAP_FAILED;
+}
+
+/* Map the page containing reservation offset 'offset' (signal handler) */
+static BOOL ResolvePage(u64 offset) {
+    offset &= ~(u64)(s_pageSize - 1);
     
-    return NULL;
+    s64 backing = BackingOffset((u32)offset);
+    if (backing >= 0) {
+        return MapBacking(offset, s_pageSize, backing, MAP_SHARED);
+    }
+    if (offset >= GECKO_FASTMEM_STORE_VIEW) {
+        return MapBacking(offset, s_pageSize, FAST_SCRATCH_OFFSET, MAP_SHARED);
+    }
+    return MapBacking(offset, s_pageSize, FAST_OPENBUS_OFFSET, MAP_PRIVATE);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         FastmemFault
+  
+  Description:  SIGSEGV handler. Faults inside the reservation map the
+                page and return, so the access is retried. Anything else
+                goes to the handler that was installed before.
+  
+  Arguments:    sig      Signal number
+                info     Fault address
+                context  Interrupted context
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void FastmemFault(int sig, siginfo_t* info, void* context) {
+    u8* base = s_fastBase;
+    u8* addr = (u8*)info->si_addr;
+    
+    if (base && addr >= base && addr < base + FAST_SPAN &&
+        ResolvePage((u64)(addr - base))) {
+        return;
+    }
+    
+    if (s_prevSegv.sa_flags & SA_SIGINFO) {
+        s_prevSegv.sa_sigaction(sig, info, context);
+    } else if (s_prevSegv.sa_handler != SIG_DFL && s_prevSegv.sa_handler != SIG_IGN) {
+        s_prevSegv.sa_handler(sig);
+    } else {
+        /* Default action: the access faults again and the process dies */
+        struct sigaction dfl;
+        memset(&dfl, 0, sizeof(dfl));
+        dfl.sa_handler = SIG_DFL;
+        sigaction(sig, &dfl, NULL);
+    }
+}
+
+static void UnmapFastmem(void) {
+    u8* base = s_fastBase;
+    
+    s_fastBase = NULL;
+    if (base) {
+        munmap(base, FAST_SPAN + s_pageSize);
+    }
+    if (s_fastFd >= 0) {
+        close(s_fastFd);
+        s_fastFd = -1;
+    }
 }
 
+/* Fill the open bus slot with 0xFF */
+static BOOL FillOpenBus(void) {
+    u8 ones[1024];
+    
+    memset(ones, 0xFF, sizeof(ones));
+    for (u32 off = 0; off < FAST_SLOT; off += sizeof(ones)) {
+        if (pwrite(s_fastFd, ones, sizeof(ones), FAST_OPENBUS_OFFSET + off) != (ssize_t)sizeof(ones)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         MapFastmem
+  
+  Description:  Create the memfd and reservation and map the fixed
+                mirrors in both views.
+  
+  Arguments:    mem2  Include MEM2
+  
+  Returns:      TRUE on success (s_fastBase set)
+ *---------------------------------------------------------------------------*/
+static BOOL MapFastmem(BOOL mem2) {
+    static const struct { u32 vaddr; u32 size; u32 offset; } mirrors[] = {
+        { 0x00000000, GECKO_MEM1_SIZE, FAST_MEM1_OFFSET },
+        { 0x80000000, GECKO_MEM1_SIZE, FAST_MEM1_OFFSET },
+        { 0xC0000000, GECKO_MEM1_SIZE, FAST_MEM1_OFFSET },
+        { GECKO_LOCKED_CACHE_BASE, GECKO_LOCKED_CACHE_SIZE, FAST_LC_OFFSET },
+        { 0x10000000, GECKO_MEM2_SIZE, FAST_MEM2_OFFSET },
+        { 0x90000000, GECKO_MEM2_SIZE, FAST_MEM2_OFFSET },
+        { 0xD0000000, GECKO_MEM2_SIZE, FAST_MEM2_OFFSET },
+    };
+    u32 fileSize = FAST_MEM2_OFFSET + (mem2 ? GECKO_MEM2_SIZE : 0);
+    
+    s_fastMem2 = mem2;
+    s_fastFd = memfd_create("porpoise-fastmem", MFD_CLOEXEC);
+    if (s_fastFd < 0 || ftruncate(s_fastFd, fileSize) != 0 || !FillOpenBus()) {
+        UnmapFastmem();
+        return FALSE;
+    }
+    
+    void* base = mmap(NULL, FAST_SPAN + s_pageSize, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        UnmapFastmem();
+        return FALSE;
+    }
+    s_fastBase = (u8*)base;
+    
+    for (u32 i = 0; i < ARRAY_LENGTH(mirrors); i++) {
+        if (mirrors[i].offset == FAST_MEM2_OFFSET && !mem2) {
+            continue;
+        }
+        for (u64 view = 0; view < FAST_SPAN; view += GECKO_FASTMEM_STORE_VIEW) {
+            if (!MapBacking(view + mirrors[i].vaddr, mirrors[i].size, mirrors[i].offset, MAP_SHARED)) {
+                UnmapFastmem();
+                return FALSE;
+            }
+        }
+    }
+    if (!MapBacking(FAST_SPAN, s_pageSize, FAST_MEM1_OFFSET, MAP_SHARED)) {
+        UnmapFastmem();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL InstallFaultHandler(void) {
+    struct sigaction sa;
+    
+    if (s_handlerInstalled) {
+        return TRUE;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = FastmemFault;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSEGV, &sa, &s_prevSegv) != 0) {
+        return FALSE;
+    }
+    s_handlerInstalled = TRUE;
+    return TRUE;
+}
+
+#endif // GECKO_FASTMEM
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoMemoryEnableFastmem
+  
+  Description:  Move MEM1, MEM2 and the locked cache into the fastmem
+                backing store and switch every accessor to base + vaddr.
+                The current contents are kept.
+  
+  Arguments:    mem  Initialized GeckoMemory
+  
+  Returns:      TRUE if fastmem is on, FALSE if unsupported here, in use
+                by another GeckoMemory, or the mapping failed
+ *---------------------------------------------------------------------------*/
+BOOL GeckoMemoryEnableFastmem(GeckoMemory* mem) {
+    if (!mem || !mem->mem1) {
+        return FALSE;
+    }
+    if (mem->fastmem) {
+        return TRUE;
+    }
+    
+#ifdef GECKO_FASTMEM
+    if (s_fastBase) {
+        OSReport("Gecko: Fastmem is already in use by another GeckoMemory\n");
+        return FALSE;
+    }
+    
+    s_pageSize = (u32)sysconf(_SC_PAGESIZE);
+    if (s_pageSize > FAST_SLOT) {
+        OSReport("Gecko: Fastmem needs pages of 16 KB or less (host: %u)\n", s_pageSize);
+        return FALSE;
+    }
+    if (!MapFastmem(mem->mem2_enabled) || !InstallFaultHandler()) {
+        UnmapFastmem();
+        OSReport("Gecko: Could not map the fastmem region\n");
+        return FALSE;
+    }
+    
+    /* The memfd starts zeroed, so untouched pages need no copy */
+    u8* base = s_fastBase;
+    CopyTouched(base + GECKO_CACHED_BASE, mem->mem1, GECKO_MEM1_SIZE);
+    CopyTouched(base + GECKO_LOCKED_CACHE_BASE, mem->locked_cache, GECKO_LOCKED_CACHE_SIZE);
+    RegionFree(mem->mem1, GECKO_MEM1_SIZE);
+    RegionFree(mem->locked_cache, GECKO_LOCKED_CACHE_SIZE);
+    mem->mem1 = base + GECKO_CACHED_BASE;
+    mem->locked_cache = base + GECKO_LOCKED_CACHE_BASE;
+    
+    if (mem->mem2_enabled) {
+        CopyTouched(base + 0x90000000, mem->mem2, GECKO_MEM2_SIZE);
+        RegionFree(mem->mem2, GECKO_MEM2_SIZE);
+        mem->mem2 = base + 0x90000000;
+    }
+    
+    mem->fastmem = base;
+    OSReport("Gecko: Fastmem enabled at %p\n", (void*)base);
+    return TRUE;
+#else
+    OSReport("Gecko: Fastmem is not supported on this platform\n");
+    return FALSE;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoMemoryDisableFastmem
+  
+  Description:  Copy the contents back to heap buffers and unmap the
+                fastmem region.
+  
+  Arguments:    mem  GeckoMemory with fastmem enabled
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoMemoryDisableFastmem(GeckoMemory* mem) {
+    if (!mem || !mem->fastmem) {
+        return;
+    }
+    
+    u8* mem1 = RegionAlloc(GECKO_MEM1_SIZE, mem->flags);
+    u8* lc = RegionAlloc(GECKO_LOCKED_CACHE_SIZE, mem->flags);
+    u8* mem2 = mem->mem2_enabled ? RegionAlloc(GECKO_MEM2_SIZE, mem->flags) : NULL;
+    
+    if (!mem1 || !lc || (mem->mem2_enabled && !mem2)) {
+        RegionFree(mem1, GECKO_MEM1_SIZE);
+        RegionFree(lc, GECKO_LOCKED_CACHE_SIZE);
+        RegionFree(mem2, GECKO_MEM2_SIZE);
+        OSReport("Gecko: Out of memory, fastmem stays enabled\n");
+        return;
+    }
+    
+    CopyTouched(mem1, mem->mem1, GECKO_MEM1_SIZE);
+    CopyTouched(lc, mem->locked_cache, GECKO_LOCKED_CACHE_SIZE);
+    if (mem2) {
+        CopyTouched(mem2, mem->mem2, GECKO_MEM2_SIZE);
+    }
+    
+    ReleaseFastmem(mem);
+    mem->mem1 = mem1;
+    mem->locked_cache = lc;
+    mem->mem2 = mem2;
+}
+
+/* Unmap fastmem without saving the contents */
+static void ReleaseFastmem(GeckoMemory* mem) {
+    if (!mem->fastmem) {
+        return;
+    }
+    
+#ifdef GECKO_FASTMEM
+    UnmapFastmem();
+#endif
+    mem->fastmem = NULL;
+    mem->mem1 = NULL;
+    mem->locked_cache = NULL;
+    mem->mem2 = NULL;
+}
@@ -0,0 +1,1136 @@
+/*---------------------------------------------------------------------------*
+  GeckoSavestate.c - Incremental Savestates of Emulated Memory
+  
+  A savestate is MEM1, MEM2, ARAM, the locked cache and the 64 bytes of
+  SRAM. Copying all of it is over 100 MB per snapshot, so snapshots are
+  incremental: the first one copies every page that is not all zero,
+  later ones only the pages written since the previous snapshot.
+  
+  On Linux the regions are write-protected after each snapshot and the
+  first write to a page faults into SavestateFault, which marks the page
+  dirty and opens it. GeckoSavestateTake protects the dirty pages again
+  and hands them to a worker thread that copies them while the game
+  runs on. A page written before the worker reaches it is copied by the
+  writing thread first (copy-on-write), so every snapshot holds the
+  memory exactly as it was when it was taken.
+  
+  Elsewhere, GeckoSavestateTake compares every page with the previous
+  snapshot on the calling thread instead.
+  
+  Snapshots are stored as a base image (the oldest snapshot, one pointer
+  per page) plus, for each newer snapshot, the pages it copied. Pages
+  that are all zero are stored as NULL.
+ *---------------------------------------------------------------------------*/
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <dolphin/gecko_memory.h>
+#include <dolphin/os.h>
+#include <dolphin/os_internal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#define SAVESTATE_TRACK 1
+#include <dolphin/atomic_internal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#endif
+
+#define SRAM_BYTES          64
+#define CHUNK_PAGES         64          // Page buffers allocated at a time
+#define FILE_MAGIC          0x47535356  // 'GSSV'
+#define FILE_VERSION        1
+
+enum { REGION_MEM1, REGION_MEM2, REGION_ARAM, REGION_LC, NUM_REGIONS };
+
+/* Page states (tracking) */
+#define PAGE_CLEAN          0   // Matches the latest snapshot; write-protected
+#define PAGE_DIRTY          1   // Written since; writable
+#define PAGE_PENDING        2   // Not yet copied into the latest snapshot; write-protected
+#define PAGE_COPYING        3   // Being copied into the latest snapshot
+
+typedef struct SavedPage {
+    u32 page;
+    u8* data;                   // NULL if the page was all zero
+} SavedPage;
+
+typedef struct Snapshot {
+    SavedPage* pages;           // Pages copied by this snapshot (none for the oldest)
+    u32 numPages;
+    u8  sram[SRAM_BYTES];
+} Snapshot;
+
+struct GeckoSavestate {
+    GeckoMemory* mem;
+    u8*  base[NUM_REGIONS];     // Host address of each region, NULL if absent
+    u32  size[NUM_REGIONS];     // Bytes, rounded up to whole pages
+    u32  first[NUM_REGIONS];    // Index of the region's first page
+    u32  pageSize;
+    u32  numPages;
+    
+    u8** oldest;                // Contents of the oldest snapshot, per page
+    u8** latest;                // Contents of the latest snapshot, per page
+    Snapshot* ring;             // depth + 1 slots
+    u32  depth;
+    u32  head;                  // Slot of the oldest snapshot
+    u32  count;
+    BOOL full;                  // Next snapshot considers every page
+    u32* list;                  // Scratch: one entry per page
+    u8*  mark;                  // Scratch: one flag per page
+    
+    u8** chunks;                // Page buffer allocations
+    u32  numChunks;
+    u32  chunkUsed;             // Buffers handed out from the last chunk
+    u8*  freePages;             // Buffers of dropped snapshots, linked through the first word
+    
+    u32  lastPages;
+    u32  lastTakeUs;
+    u64  storedBytes;
+    volatile u32 cowPages;
+    
+#ifdef SAVESTATE_TRACK
+    volatile u32* state;        // PAGE_* per page
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t workCond;
+    pthread_cond_t idleCond;
+    BOOL quit;
+    BOOL busy;                  // Worker has a batch
+    u32  batch;                 // Bumped for each batch handed out
+    u32* work;                  // Pages the latest snapshot still copies
+    u32  workCount;
+    volatile u32 workNext;      // Next entry of work to claim
+#endif
+};
+
+/*---------------------------------------------------------------------------*
+    Page Helpers
+ *---------------------------------------------------------------------------*/
+
+static u8* PageAddress(const GeckoSavestate* ss, u32 page) {
+    for (u32 r = NUM_REGIONS; r-- > 0; ) {
+        if (ss->base[r] && page >= ss->first[r]) {
+            return ss->base[r] + (size_t)(page - ss->first[r]) * ss->pageSize;
+        }
+    }
+    return NULL;
+}
+
+static BOOL IsZeroPage(const u8* p, u32 size) {
+    const u64* q = (const u64*)p;
+    u64 acc = 0;
+    
+    for (u32 i = 0; i < size / 8; i += 8) {
+        acc |= q[i] | q[i + 1] | q[i + 2] | q[i + 3] | q[i + 4] | q[i + 5] | q[i + 6] | q[i + 7];
+        if (acc) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static Snapshot* Slot(GeckoSavestate* ss, u32 index) {
+    return &ss->ring[(ss->head + index) % (ss->depth + 1)];
+}
+
+/*---------------------------------------------------------------------------*
+    Page Buffers
+    
+    Copies live in chunks of CHUNK_PAGES pages. Buffers of dropped
+    snapshots go on a free list and are reused, so a steady rewind buffer
+    stops allocating (and faulting in fresh memory) after the first
+    'depth' frames. Chunks are released by GeckoSavestateDestroy.
+ *---------------------------------------------------------------------------*/
+
+static u8* AllocData(GeckoSavestate* ss) {
+    u8* data = ss->freePages;
+    
+    if (data) {
+        ss->freePages = *(u8**)data;
+    } else {
+        if (ss->numChunks == 0 || ss->chunkUsed == CHUNK_PAGES) {
+            u8** chunks = (u8**)realloc(ss->chunks, (ss->numChunks + 1) * sizeof(u8*));
+            if (!chunks) {
+                return NULL;
+            }
+            ss->chunks = chunks;
+            ss->chunks[ss->numChunks] = (u8*)malloc((size_t)CHUNK_PAGES * ss->pageSize);
+            if (!ss->chunks[ss->numChunks]) {
+                return NULL;
+            }
+            ss->numChunks++;
+            ss->chunkUsed = 0;
+        }
+        data = ss->chunks[ss->numChunks - 1] + (size_t)ss->chunkUsed++ * ss->pageSize;
+    }
+    ss->storedBytes += ss->pageSize;
+    return data;
+}
+
+static void FreeData(GeckoSavestate* ss, u8* data) {
+    if (data) {
+        *(u8**)data = ss->freePages;
+        ss->freePages = data;
+        ss->storedBytes -= ss->pageSize;
+    }
+}
+
+static void FreeSnapshot(GeckoSavestate* ss, Snapshot* snap) {
+    for (u32 i = 0; i < snap->numPages; i++) {
+        FreeData(ss, snap->pages[i].data);
+    }
+    free(snap->pages);
+    snap->pages = NULL;
+    snap->numPages = 0;
+}
+
+/* Contents of snapshot 'index' (0 = oldest) into table */
+static void BuildTable(GeckoSavestate* ss, u32 index, u8** table) {
+    memcpy(table, ss->oldest, ss->numPages * sizeof(u8*));
+    for (u32 s = 1; s <= index; s++) {
+        const Snapshot* snap = Slot(ss, s);
+        for (u32 i = 0; i < snap->numPages; i++) {
+            table[snap->pages[i].page] = snap->pages[i].data;
+        }
+    }
+}
+
+static BOOL SaveSram(u8* out) {
+    OSSram* sram = __OSLockSram();
+    
+    if (!sram) {
+        return FALSE;
+    }
+    memcpy(out, sram, SRAM_BYTES);
+    __OSUnlockSram(FALSE);
+    return TRUE;
+}
+
+static void LoadSram(const u8* in) {
+    OSSram* sram = __OSLockSram();
+    
+    if (sram) {
+        BOOL changed = memcmp(sram, in, SRAM_BYTES) != 0;
+        memcpy(sram, in, SRAM_BYTES);
+        __OSUnlockSram(changed);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+    Write Tracking (Linux)
+    
+    State changes of a page, all but the worker's under s_lock:
+    - CLEAN -> DIRTY: first write after a snapshot (SavestateFault)
+    - DIRTY -> PENDING: GeckoSavestateTake, before protecting the page
+    - PENDING -> COPYING -> CLEAN: the worker copied it
+    - PENDING -> COPYING -> DIRTY: a write got there first and copied it
+    A page is writable only while DIRTY.
+ *---------------------------------------------------------------------------*/
+
+#ifdef SAVESTATE_TRACK
+
+static GeckoSavestate* volatile s_active = NULL;
+static volatile u32 s_lock = 0;
+static u32 s_writers = 0;               /* PrepareWrite..EndWrite in flight; under s_lock */
+static BOOL s_handlerInstalled = FALSE;
+static struct sigaction s_prevSegv;
+
+/* Spin lock: also taken in the signal handler, so no mutex */
+static void Lock(void) {
+    while (!__AtomicCompareSwap32(&s_lock, 0, 1)) {
+        sched_yield();
+    }
+}
+
+static void Unlock(void) {
+    __AtomicStore32(&s_lock, 0);
+}
+
+/* Lock once no system call is writing into the regions: protecting its
+   pages again would make it fail with EFAULT */
+static void LockIdle(void) {
+    for (;;) {
+        Lock();
+        if (s_writers == 0) {
+            return;
+        }
+        Unlock();
+        sched_yield();
+    }
+}
+
+/* Page index of a host address, or -1 outside the regions */
+static s32 PageIndex(const GeckoSavestate* ss, const u8* addr) {
+    for (u32 r = 0; r < NUM_REGIONS; r++) {
+        if (ss->base[r] && addr >= ss->base[r] && addr < ss->base[r] + ss->size[r]) {
+            return (s32)(ss->first[r] + (u32)(addr - ss->base[r]) / ss->pageSize);
+        }
+    }
+    return -1;
+}
+
+static void ProtectRegions(GeckoSavestate* ss, int prot) {
+    for (u32 r = 0; r < NUM_REGIONS; r++) {
+        if (ss->base[r]) {
+            mprotect(ss->base[r], ss->size[r], prot);
+        }
+    }
+}
+
+/* Copy a pending page into the latest snapshot, unless someone else is */
+static BOOL CopyPending(GeckoSavestate* ss, u32 page) {
+    if (!__AtomicCompareSwap32(&ss->state[page], PAGE_PENDING, PAGE_COPYING)) {
+        return FALSE;
+    }
+    memcpy(ss->latest[page], PageAddress(ss, page), ss->pageSize);
+    return TRUE;
+}
+
+/* Let writes into a page through: copy it first if still pending. Caller
+   holds s_lock. */
+static void OpenPage(GeckoSavestate* ss, u32 page) {
+    for (;;) {
+        u32 state = __AtomicLoad32(&ss->state[page]);
+        
+        if (state == PAGE_PENDING && CopyPending(ss, page)) {
+            __AtomicAdd32(&ss->cowPages, 1);
+            break;
+        }
+        if (state == PAGE_CLEAN || state == PAGE_DIRTY) {
+            break;
+        }
+        sched_yield();      // The worker is copying it
+    }
+    __AtomicStore32(&ss->state[page], PAGE_DIRTY);
+    mprotect(PageAddress(ss, page), ss->pageSize, PROT_READ | PROT_WRITE);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         SavestateFault
+  
+  Description:  SIGSEGV handler. A write to a protected page of the
+                tracked regions opens the page and returns, so the store
+                is retried. Anything else goes to the handler that was
+                installed before.
+  
+  Arguments:    sig      Signal number
+                info     Fault address
+                context  Interrupted context
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void SavestateFault(int sig, siginfo_t* info, void* context) {
+    GeckoSavestate* ss = s_active;
+    s32 page = ss ? PageIndex(ss, (const u8*)info->si_addr) : -1;
+    
+    if (page >= 0 && info->si_code == SEGV_ACCERR) {
+        Lock();
+        OpenPage(ss, (u32)page);
+        Unlock();
+        return;
+    }
+    
+    if (s_prevSegv.sa_flags & SA_SIGINFO) {
+        s_prevSegv.sa_sigaction(sig, info, context);
+    } else if (s_prevSegv.sa_handler != SIG_DFL && s_prevSegv.sa_handler != SIG_IGN) {
+        s_prevSegv.sa_handler(sig);
+    } else {
+        /* Default action: the access faults again and the process dies */
+        struct sigaction dfl;
+        memset(&dfl, 0, sizeof(dfl));
+        dfl.sa_handler = SIG_DFL;
+        sigaction(sig, &dfl, NULL);
+    }
+}
+
+static BOOL InstallFaultHandler(void) {
+    struct sigaction sa;
+    
+    if (s_handlerInstalled) {
+        return TRUE;
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = SavestateFault;
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGSEGV, &sa, &s_prevSegv) != 0) {
+        return FALSE;
+    }
+    s_handlerInstalled = TRUE;
+    return TRUE;
+}
+
+/* Claim and copy pages of the current batch until none are left */
+static void CopyBatch(GeckoSavestate* ss) {
+    u32 i;
+    
+    while ((i = __AtomicAdd32(&ss->workNext, 1)) < ss->workCount) {
+        u32 page = ss->work[i];
+        if (CopyPending(ss, page)) {
+            __AtomicStore32(&ss->state[page], PAGE_CLEAN);
+        }
+    }
+}
+
+static void* WorkerThread(void* arg) {
+    GeckoSavestate* ss = (GeckoSavestate*)arg;
+    u32 seen = 0;
+    
+    pthread_mutex_lock(&ss->lock);
+    for (;;) {
+        while (!ss->quit && ss->batch == seen) {
+            pthread_cond_wait(&ss->workCond, &ss->lock);
+        }
+        if (ss->quit) {
+            break;
+        }
+        seen = ss->batch;
+        pthread_mutex_unlock(&ss->lock);
+        
+        CopyBatch(ss);
+        
+        pthread_mutex_lock(&ss->lock);
+        ss->busy = FALSE;
+        pthread_cond_broadcast(&ss->idleCond);
+    }
+    pthread_mutex_unlock(&ss->lock);
+    return NULL;
+}
+
+/* Finish the background copy, helping with whatever is left */
+static void Drain(GeckoSavestate* ss) {
+    CopyBatch(ss);
+    pthread_mutex_lock(&ss->lock);
+    while (ss->busy) {
+        pthread_cond_wait(&ss->idleCond, &ss->lock);
+    }
+    pthread_mutex_unlock(&ss->lock);
+    ss->workCount = 0;
+}
+
+static void StartBatch(GeckoSavestate* ss, u32 count) {
+    pthread_mutex_lock(&ss->lock);
+    memcpy(ss->work, ss->list, count * sizeof(u32));
+    ss->workCount = count;
+    ss->workNext = 0;
+    ss->busy = TRUE;
+    ss->batch++;
+    pthread_cond_signal(&ss->workCond);
+    pthread_mutex_unlock(&ss->lock);
+}
+
+#endif // SAVESTATE_TRACK
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateCreate
+  
+  Description:  Start keeping savestates of a GeckoMemory. Call after
+                GeckoMemoryAllocARAM if ARAM is to be included. Nothing
+                is copied until the first GeckoSavestateTake.
+  
+  Arguments:    mem    Initialized GeckoMemory, fastmem off
+                depth  Snapshots to keep (older ones are dropped)
+  
+  Returns:      Savestate, or NULL if fastmem is on, another savestate is
+                active, or out of memory
+ *---------------------------------------------------------------------------*/
+GeckoSavestate* GeckoSavestateCreate(GeckoMemory* mem, u32 depth) {
+    if (!mem || !mem->mem1 || depth == 0) {
+        return NULL;
+    }
+    if (mem->fastmem) {
+        OSReport("Gecko: Savestates need fastmem off\n");
+        return NULL;
+    }
+    
+    GeckoSavestate* ss = (GeckoSavestate*)calloc(1, sizeof(GeckoSavestate));
+    if (!ss) {
+        return NULL;
+    }
+
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    ss->pageSize = si.dwPageSize;
+#else
+    ss->pageSize = (u32)sysconf(_SC_PAGESIZE);
+#endif
+
+    ss->mem = mem;
+    ss->base[REGION_MEM1] = mem->mem1;
+    ss->base[REGION_MEM2] = mem->mem2_enabled ? mem->mem2 : NULL;
+    ss->base[REGION_ARAM] = mem->aram_enabled ? mem->aram : NULL;
+    ss->base[REGION_LC] = mem->locked_cache;
+    ss->size[REGION_MEM1] = GECKO_MEM1_SIZE;
+    ss->size[REGION_MEM2] = GECKO_MEM2_SIZE;
+    ss->size[REGION_ARAM] = GECKO_ARAM_SIZE;
+    ss->size[REGION_LC] = GECKO_LOCKED_CACHE_SIZE;
+    for (u32 r = 0; r < NUM_REGIONS; r++) {
+        ss->size[r] = (ss->size[r] + ss->pageSize - 1) & ~(ss->pageSize - 1);
+        ss->first[r] = ss->numPages;
+        if (ss->base[r]) {
+            ss->numPages += ss->size[r] / ss->pageSize;
+        }
+    }
+    
+    ss->depth = depth;
+    ss->full = TRUE;
+    ss->ring = (Snapshot*)calloc(depth + 1, sizeof(Snapshot));
+    ss->oldest = (u8**)calloc(ss->numPages, sizeof(u8*));
+    ss->latest = (u8**)calloc(ss->numPages, sizeof(u8*));
+    ss->list = (u32*)malloc(ss->numPages * sizeof(u32));
+    ss->mark = (u8*)malloc(ss->numPages);
+    BOOL ok = ss->ring && ss->oldest && ss->latest && ss->list && ss->mark;
+    
+#ifdef SAVESTATE_TRACK
+    ss->state = (volatile u32*)calloc(ss->numPages, sizeof(u32));
+    ss->work = (u32*)malloc(ss->numPages * sizeof(u32));
+    ok = ok && ss->state && ss->work;
+    
+    if (ok && s_active) {
+        OSReport("Gecko: Another savestate is already active\n");
+        ok = FALSE;
+    }
+    for (u32 r = 0; ok && r < NUM_REGIONS; r++) {
+        // OSProtectRange mprotects its pages too; each would undo the other
+        if (ss->base[r] && __OSIsRangeWatched(ss->base[r], ss->size[r])) {
+            OSReport("Gecko: Savestates cannot track memory watched by OSProtectRange\n");
+            ok = FALSE;
+        }
+    }
+    if (ok && !InstallFaultHandler()) {
+        OSReport("Gecko: Could not install the savestate fault handler\n");
+        ok = FALSE;
+    }
+    if (ok) {
+        pthread_mutex_init(&ss->lock, NULL);
+        pthread_cond_init(&ss->workCond, NULL);
+        pthread_cond_init(&ss->idleCond, NULL);
+        if (pthread_create(&ss->worker, NULL, WorkerThread, ss) != 0) {
+            pthread_cond_destroy(&ss->idleCond);
+            pthread_cond_destroy(&ss->workCond);
+            pthread_mutex_destroy(&ss->lock);
+            ok = FALSE;
+        }
+    }
+    if (!ok) {
+        free((void*)ss->state);
+        free(ss->work);
+    }
+#endif
+
+    if (!ok) {
+        free(ss->ring);
+        free(ss->oldest);
+        free(ss->latest);
+        free(ss->list);
+        free(ss->mark);
+        free(ss);
+        return NULL;
+    }
+
+#ifdef SAVESTATE_TRACK
+    s_active = ss;
+#endif
+    return ss;
+}
+
+/* Drop every snapshot */
+static void DropAll(GeckoSavestate* ss) {
+    for (u32 s = 1; s < ss->count; s++) {
+        FreeSnapshot(ss, Slot(ss, s));
+    }
+    for (u32 p = 0; p < ss->numPages; p++) {
+        FreeData(ss, ss->oldest[p]);
+    }
+    memset(ss->oldest, 0, ss->numPages * sizeof(u8*));
+    memset(ss->latest, 0, ss->numPages * sizeof(u8*));
+    ss->head = 0;
+    ss->count = 0;
+    ss->full = TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateDestroy
+  
+  Description:  Stop tracking, make the regions writable again and free
+                every snapshot. Call before GeckoMemoryFree.
+  
+  Arguments:    ss  Savestate
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoSavestateDestroy(GeckoSavestate* ss) {
+    if (!ss) {
+        return;
+    }
+
+#ifdef SAVESTATE_TRACK
+    Drain(ss);
+    pthread_mutex_lock(&ss->lock);
+    ss->quit = TRUE;
+    pthread_cond_signal(&ss->workCond);
+    pthread_mutex_unlock(&ss->lock);
+    pthread_join(ss->worker, NULL);
+    pthread_cond_destroy(&ss->idleCond);
+    pthread_cond_destroy(&ss->workCond);
+    pthread_mutex_destroy(&ss->lock);
+    
+    Lock();
+    s_active = NULL;
+    ProtectRegions(ss, PROT_READ | PROT_WRITE);
+    Unlock();
+    free((void*)ss->state);
+    free(ss->work);
+#endif
+
+    DropAll(ss);
+    for (u32 i = 0; i < ss->numChunks; i++) {
+        free(ss->chunks[i]);
+    }
+    free(ss->chunks);
+    free(ss->ring);
+    free(ss->oldest);
+    free(ss->latest);
+    free(ss->list);
+    free(ss->mark);
+    free(ss);
+}
+
+/* Allocate a copy buffer for each page in ss->list; FALSE if out of memory */
+static BOOL AllocPages(GeckoSavestate* ss, SavedPage* pages, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        pages[i].page = ss->list[i];
+        pages[i].data = AllocData(ss);
+        if (!pages[i].data) {
+            while (i-- > 0) {
+                FreeData(ss, pages[i].data);
+            }
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Make snap the latest snapshot; drop the oldest if over depth */
+static void PushSnapshot(GeckoSavestate* ss, Snapshot* snap) {
+    for (u32 i = 0; i < snap->numPages; i++) {
+        ss->latest[snap->pages[i].page] = snap->pages[i].data;
+    }
+    
+    if (ss->count == 0) {
+        /* The first snapshot is the base image */
+        for (u32 i = 0; i < snap->numPages; i++) {
+            ss->oldest[snap->pages[i].page] = snap->pages[i].data;
+        }
+        free(snap->pages);
+        snap->pages = NULL;
+        snap->numPages = 0;
+    }
+    ss->count++;
+    
+    if (ss->count > ss->depth) {
+        /* Fold the second oldest into the base image */
+        Snapshot* next = Slot(ss, 1);
+        for (u32 i = 0; i < next->numPages; i++) {
+            u32 page = next->pages[i].page;
+            FreeData(ss, ss->oldest[page]);
+            ss->oldest[page] = next->pages[i].data;
+        }
+        free(next->pages);
+        next->pages = NULL;
+        next->numPages = 0;
+        ss->head = (ss->head + 1) % (ss->depth + 1);
+        ss->count--;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateTake
+  
+  Description:  Take a snapshot. With write tracking this only protects
+                the pages written since the previous snapshot and queues
+                them for the worker; the copy finishes in the background.
+                The first snapshot (and the first after a load) looks at
+                every page.
+  
+  Arguments:    ss  Savestate
+  
+  Returns:      TRUE on success, FALSE if out of memory (no snapshot)
+ *---------------------------------------------------------------------------*/
+BOOL GeckoSavestateTake(GeckoSavestate* ss) {
+    if (!ss) {
+        return FALSE;
+    }
+    
+    OSTime start = OSGetTime();
+    Snapshot* snap = Slot(ss, ss->count);
+    u32 count = 0;
+    
+    if (!SaveSram(snap->sram)) {
+        /* Locked elsewhere: keep the previous contents */
+        if (ss->count > 0) {
+            memcpy(snap->sram, Slot(ss, ss->count - 1)->sram, SRAM_BYTES);
+        } else {
+            memset(snap->sram, 0, SRAM_BYTES);
+        }
+    }
+
+#ifdef SAVESTATE_TRACK
+    Drain(ss);
+    LockIdle();
+    
+    /* A full snapshot protects first, so no write slips past the scan */
+    if (ss->full) {
+        ProtectRegions(ss, PROT_READ);
+    }
+    for (u32 p = 0; p < ss->numPages; p++) {
+        if (ss->full) {
+            if (!IsZeroPage(PageAddress(ss, p), ss->pageSize)) {
+                ss->list[count++] = p;
+            }
+        } else if (ss->state[p] == PAGE_DIRTY) {
+            ss->list[count++] = p;
+        }
+    }
+    
+    snap->pages = (SavedPage*)malloc((count ? count : 1) * sizeof(SavedPage));
+    if (!snap->pages || !AllocPages(ss, snap->pages, count)) {
+        free(snap->pages);
+        snap->pages = NULL;
+        Unlock();
+        return FALSE;
+    }
+    snap->numPages = count;
+    
+    /* Pending before protected: a write in between lands in the copy.
+       One call per region is cheaper than one per page, and merges the
+       mappings SavestateFault split up. */
+    for (u32 i = 0; i < count; i++) {
+        __AtomicStore32(&ss->state[ss->list[i]], PAGE_PENDING);
+    }
+    if (ss->full) {
+        for (u32 p = 0; p < ss->numPages; p++) {
+            if (ss->state[p] == PAGE_DIRTY) {
+                __AtomicStore32(&ss->state[p], PAGE_CLEAN);
+            }
+        }
+    } else {
+        ProtectRegions(ss, PROT_READ);
+    }
+    PushSnapshot(ss, snap);
+    ss->full = FALSE;
+    Unlock();
+    
+    if (count > 0) {
+        StartBatch(ss, count);
+    }
+#else
+    /* No tracking: compare every page with the previous snapshot */
+    for (u32 p = 0; p < ss->numPages; p++) {
+        const u8* addr = PageAddress(ss, p);
+        BOOL changed = ss->latest[p] ? memcmp(addr, ss->latest[p], ss->pageSize) != 0
+                                     : !IsZeroPage(addr, ss->pageSize);
+        if (changed) {
+            ss->list[count++] = p;
+        }
+    }
+    
+    snap->pages = (SavedPage*)malloc((count ? count : 1) * sizeof(SavedPage));
+    if (!snap->pages || !AllocPages(ss, snap->pages, count)) {
+        free(snap->pages);
+        snap->pages = NULL;
+        return FALSE;
+    }
+    snap->numPages = count;
+    for (u32 i = 0; i < count; i++) {
+        memcpy(snap->pages[i].data, PageAddress(ss, snap->pages[i].page), ss->pageSize);
+    }
+    PushSnapshot(ss, snap);
+    ss->full = FALSE;
+#endif
+
+    ss->lastPages = count;
+    ss->lastTakeUs = (u32)OSTicksToMicroseconds(OSGetTime() - start);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateRestore
+  
+  Description:  Put memory and SRAM back to an earlier snapshot. Only
+                pages written since then are copied back. Snapshots newer
+                than the one restored are dropped, so it becomes the
+                latest.
+  
+  Arguments:    ss   Savestate
+                age  0 = latest snapshot, 1 = the one before, ...
+  
+  Returns:      TRUE on success, FALSE if there is no such snapshot
+ *---------------------------------------------------------------------------*/
+BOOL GeckoSavestateRestore(GeckoSavestate* ss, u32 age) {
+    if (!ss || age >= ss->count) {
+        return FALSE;
+    }
+    
+    u32 index = ss->count - 1 - age;
+    
+#ifdef SAVESTATE_TRACK
+    Drain(ss);
+    LockIdle();
+    
+    /* Written since: copied by a newer snapshot, or dirty now */
+    memset(ss->mark, 0, ss->numPages);
+    for (u32 s = index + 1; s < ss->count; s++) {
+        const Snapshot* snap = Slot(ss, s);
+        for (u32 i = 0; i < snap->numPages; i++) {
+            ss->mark[snap->pages[i].page] = 1;
+        }
+    }
+    for (u32 p = 0; p < ss->numPages; p++) {
+        if (ss->state[p] == PAGE_DIRTY) {
+            ss->mark[p] = 1;
+        }
+    }
+    
+    BuildTable(ss, index, ss->latest);
+    ProtectRegions(ss, PROT_READ | PROT_WRITE);
+    for (u32 p = 0; p < ss->numPages; p++) {
+        if (ss->mark[p]) {
+            u8* addr = PageAddress(ss, p);
+            if (ss->latest[p]) {
+                memcpy(addr, ss->latest[p], ss->pageSize);
+            } else {
+                memset(addr, 0, ss->pageSize);
+            }
+        }
+        ss->state[p] = PAGE_CLEAN;
+    }
+    ProtectRegions(ss, PROT_READ);
+    Unlock();
+#else
+    BuildTable(ss, index, ss->latest);
+    for (u32 p = 0; p < ss->numPages; p++) {
+        u8* addr = PageAddress(ss, p);
+        if (ss->latest[p]) {
+            if (memcmp(addr, ss->latest[p], ss->pageSize) != 0) {
+                memcpy(addr, ss->latest[p], ss->pageSize);
+            }
+        } else if (!IsZeroPage(addr, ss->pageSize)) {
+            memset(addr, 0, ss->pageSize);
+        }
+    }
+#endif
+
+    for (u32 s = index + 1; s < ss->count; s++) {
+        FreeSnapshot(ss, Slot(ss, s));
+    }
+    ss->count = index + 1;
+    LoadSram(Slot(ss, index)->sram);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateWait
+  
+  Description:  Wait until the latest snapshot is completely copied.
+                Take, Restore and Save do this themselves.
+  
+  Arguments:    ss  Savestate
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoSavestateWait(GeckoSavestate* ss) {
+#ifdef SAVESTATE_TRACK
+    if (ss) {
+        Drain(ss);
+    }
+#else
+    (void)ss;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestatePrepareWrite
+  
+  Description:  Open the tracked pages of a host range for writing. The
+                kernel does not fault on protected pages but fails the
+                call (EFAULT), so call this before a read(2) or fread
+                into emulated memory, and GeckoSavestateEndWrite after
+                it. Until then, Take, Restore and Load wait rather than
+                protect the pages again; don't call them in between on
+                the same thread.
+  
+  Arguments:    addr  Host address
+                size  Bytes about to be written
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoSavestatePrepareWrite(void* addr, u32 size) {
+#ifdef SAVESTATE_TRACK
+    Lock();
+    s_writers++;
+    
+    GeckoSavestate* ss = s_active;
+    if (!ss || size == 0) {
+        Unlock();
+        return;
+    }
+    
+    const u8* end = (const u8*)addr + size;
+    for (const u8* p = (const u8*)addr; p < end; p += ss->pageSize) {
+        s32 page = PageIndex(ss, p);
+        if (page >= 0 && ss->state[page] != PAGE_DIRTY) {
+            OpenPage(ss, (u32)page);
+        }
+    }
+    s32 last = PageIndex(ss, end - 1);
+    if (last >= 0 && ss->state[last] != PAGE_DIRTY) {
+        OpenPage(ss, (u32)last);
+    }
+    Unlock();
+#else
+    (void)addr;
+    (void)size;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateEndWrite
+  
+  Description:  The system call after GeckoSavestatePrepareWrite is done.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoSavestateEndWrite(void) {
+#ifdef SAVESTATE_TRACK
+    Lock();
+    s_writers--;
+    Unlock();
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __GeckoSavestateIsTracked
+  
+  Description:  Check whether write tracking covers part of a host range.
+  
+  Arguments:    addr  Host address
+                size  Bytes
+  
+  Returns:      TRUE if a tracked region overlaps the range
+ *---------------------------------------------------------------------------*/
+BOOL __GeckoSavestateIsTracked(const void* addr, u32 size) {
+#ifdef SAVESTATE_TRACK
+    GeckoSavestate* ss = s_active;
+    const u8* lo = (const u8*)addr;
+    const u8* hi = lo + size;
+    
+    if (!ss) {
+        return FALSE;
+    }
+    for (u32 r = 0; r < NUM_REGIONS; r++) {
+        if (ss->base[r] && lo < ss->base[r] + ss->size[r] && hi > ss->base[r]) {
+            return TRUE;
+        }
+    }
+#else
+    (void)addr;
+    (void)size;
+#endif
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+    Savestate Files
+    
+    Header, then one byte per page (1 = stored, 0 = all zero), then the
+    stored pages in order. Host byte order: files are for repro on the
+    same kind of machine, not for exchange.
+ *---------------------------------------------------------------------------*/
+
+typedef struct FileHeader {
+    u32 magic;
+    u32 version;
+    u32 pageSize;
+    u32 numPages;
+    u32 size[NUM_REGIONS];      // 0 for an absent region
+    u8  sram[SRAM_BYTES];
+} FileHeader;
+
+static void FillHeader(const GeckoSavestate* ss, FileHeader* header) {
+    memset(header, 0, sizeof(*header));
+    header->magic = FILE_MAGIC;
+    header->version = FILE_VERSION;
+    header->pageSize = ss->pageSize;
+    header->numPages = ss->numPages;
+    for (u32 r = 0; r < NUM_REGIONS; r++) {
+        header->size[r] = ss->base[r] ? ss->size[r] : 0;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateSave
+  
+  Description:  Write a snapshot to a file, e.g. the state just before a
+                crash for a repro.
+  
+  Arguments:    ss    Savestate
+                age   0 = latest snapshot, 1 = the one before, ...
+                path  File to write
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+BOOL GeckoSavestateSave(GeckoSavestate* ss, u32 age, const char* path) {
+    if (!ss || !path || age >= ss->count) {
+        return FALSE;
+    }
+    
+    u8** table = (u8**)malloc(ss->numPages * sizeof(u8*));
+    if (!table) {
+        return FALSE;
+    }
+    
+    GeckoSavestateWait(ss);
+    u32 index = ss->count - 1 - age;
+    BuildTable(ss, index, table);
+    
+    FileHeader header;
+    FillHeader(ss, &header);
+    memcpy(header.sram, Slot(ss, index)->sram, SRAM_BYTES);
+    for (u32 p = 0; p < ss->numPages; p++) {
+        ss->mark[p] = table[p] != NULL;
+    }
+    
+    FILE* fp = fopen(path, "wb");
+    BOOL ok = fp != NULL;
+    if (ok) {
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+             fwrite(ss->mark, 1, ss->numPages, fp) == ss->numPages;
+        for (u32 p = 0; ok && p < ss->numPages; p++) {
+            if (table[p]) {
+                ok = fwrite(table[p], 1, ss->pageSize, fp) == ss->pageSize;
+            }
+        }
+        ok = (fclose(fp) == 0) && ok;
+    }
+    free(table);
+    
+    if (!ok) {
+        OSReport("Gecko: Could not write savestate %s\n", path);
+    }
+    return ok;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateLoad
+  
+  Description:  Load a file written by GeckoSavestateSave into memory and
+                SRAM. All snapshots are dropped and a new full one is
+                taken of the loaded state.
+  
+  Arguments:    ss    Savestate
+                path  File to read
+  
+  Returns:      TRUE on success, FALSE if the file is missing, damaged or
+                from a different memory layout (memory unchanged)
+ *---------------------------------------------------------------------------*/
+BOOL GeckoSavestateLoad(GeckoSavestate* ss, const char* path) {
+    FileHeader header;
+    FileHeader expect;
+    
+    if (!ss || !path) {
+        return FALSE;
+    }
+    
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return FALSE;
+    }
+    
+    FillHeader(ss, &expect);
+    BOOL ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              memcmp(&header, &expect, offsetof(FileHeader, sram)) == 0 &&
+              fread(ss->mark, 1, ss->numPages, fp) == ss->numPages;
+    if (!ok) {
+        fclose(fp);
+        OSReport("Gecko: %s is not a savestate of this memory layout\n", path);
+        return FALSE;
+    }
+
+#ifdef SAVESTATE_TRACK
+    Drain(ss);
+    Lock();
+    ProtectRegions(ss, PROT_READ | PROT_WRITE);
+    for (u32 p = 0; p < ss->numPages; p++) {
+        ss->state[p] = PAGE_DIRTY;
+    }
+    Unlock();
+#endif
+
+    for (u32 p = 0; p < ss->numPages; p++) {
+        u8* addr = PageAddress(ss, p);
+        if (!ss->mark[p]) {
+            if (!IsZeroPage(addr, ss->pageSize)) {
+                memset(addr, 0, ss->pageSize);
+            }
+        } else if (ok) {
+            ok = fread(addr, 1, ss->pageSize, fp) == ss->pageSize;
+        }
+    }
+    fclose(fp);
+    
+    if (!ok) {
+        OSReport("Gecko: %s is truncated, memory is partly loaded\n", path);
+    }
+    LoadSram(header.sram);
+    DropAll(ss);
+    return GeckoSavestateTake(ss) && ok;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         GeckoSavestateGetStats
+  
+  Description:  Report snapshot count, sizes and the cost of the latest
+                GeckoSavestateTake.
+  
+  Arguments:    ss     Savestate
+                stats  Receives the statistics
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void GeckoSavestateGetStats(const GeckoSavestate* ss, GeckoSavestateStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    memset(stats, 0, sizeof(*stats));
+    if (!ss) {
+        return;
+    }
+    
+    stats->snapshots = ss->count;
+    stats->pageSize = ss->pageSize;
+    stats->lastPages = ss->lastPages;
+    stats->cowPages = ss->cowPages;
+    stats->lastTakeUs = ss->lastTakeUs;
+    stats->storedBytes = ss->storedBytes;
+#ifdef SAVESTATE_TRACK
+    stats->tracking = TRUE;
+#endif
+}
@@ -1,4 +1,5 @@
 #include <dolphin/os.h>
+#include <dolphin/os_internal.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
@@ -22,9 +23,6 @@ static void* s_mem2ArenaLo = NULL;
 static void* s_mem1Base = NULL;
 static void* s_mem2Base = NULL;
 
-#define SIMULATED_MEM1_SIZE (24 * 1024 * 1024)  // 24 MB like GameCube/Wii
-#define SIMULATED_MEM2_SIZE (64 * 1024 * 1024)  // 64 MB like Wii
-
 /*---------------------------------------------------------------------------*
   Name:         OSInit
 
@@ -49,8 +47,12 @@ void OSInit(void) {
     
     // Initialize simulated memory arenas
     // Many games expect these to be valid memory ranges they can subdivide
+    // Regions created with OSCreateSharedMemory are used in place of the heap
     if (s_mem1Base == NULL) {
-        s_mem1Base = malloc(SIMULATED_MEM1_SIZE);
+        s_mem1Base = OSGetSharedRegion(OS_SHARED_MEM1, NULL);
+        if (s_mem1Base == NULL) {
+            s_mem1Base = malloc(SIMULATED_MEM1_SIZE);
+        }
         if (s_mem1Base == NULL) {
             OSPanic(__FILE__, __LINE__, "Failed to allocate simulated MEM1");
         }
@@ -67,7 +69,10 @@ void OSInit(void) {
     }
     
     if (s_mem2Base == NULL) {
-        s_mem2Base = malloc(SIMULATED_MEM2_SIZE);
+        s_mem2Base = OSGetSharedRegion(OS_SHARED_MEM2, NULL);
+        if (s_mem2Base == NULL) {
+            s_mem2Base = malloc(SIMULATED_MEM2_SIZE);
+        }
         if (s_mem2Base == NULL) {
             OSPanic(__FILE__, __LINE__, "Failed to allocate simulated MEM2");
         }
@@ -0,0 +1,368 @@
+/*---------------------------------------------------------------------------*
+  OSByteSwap.c - Bulk Byte Swap
+  
+  On GC/Wii: Data on disc and in memory is big-endian, the CPU's native
+             order; nothing is converted.
+  
+  On PC: Big-endian tables loaded from disc, or copied out of emulated
+         memory (GeckoReadBlock), have to be swapped to host order. One
+         byte shuffle handles 16, 32 or 64-bit elements; only the shuffle
+         pattern differs.
+  
+  KERNELS:
+  - Scalar: bswap per element (all CPUs)
+  - SSSE3: pshufb, 64 bytes per loop iteration
+  - AVX2: vpshufb, 128 bytes per loop iteration
+  - NEON: rev16/rev32/rev64 (ARM, always available there)
+  The best kernel the CPU supports is picked on first use. Elements left
+  over after the vector loop go through the scalar code.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/os.h>
+#include <dolphin/os_internal.h>
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SWAP_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SWAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SWAP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SWAP_TARGET(isa)
+#endif
+
+#if defined(_MSC_VER)
+#define Swap16(x) _byteswap_ushort(x)
+#define Swap32(x) _byteswap_ulong(x)
+#define Swap64(x) _byteswap_uint64(x)
+#else
+#define Swap16(x) __builtin_bswap16(x)
+#define Swap32(x) __builtin_bswap32(x)
+#define Swap64(x) __builtin_bswap64(x)
+#endif
+
+/*---------------------------------------------------------------------------*
+    Engine State
+ *---------------------------------------------------------------------------*/
+
+typedef void (*SwapFunc)(u8* dst, const u8* src, u32 count);
+
+typedef struct SwapKernel {
+    const char* name;
+    SwapFunc    swap16;
+    SwapFunc    swap32;
+    SwapFunc    swap64;
+} SwapKernel;
+
+static volatile BOOL s_swapInitialized = FALSE;
+static u32 s_supported = 1u << OS_SWAP_KERNEL_SCALAR;   // Bit per kernel
+static u32 s_kernel = OS_SWAP_KERNEL_SCALAR;
+
+/*---------------------------------------------------------------------------*
+    Scalar Kernel
+ *---------------------------------------------------------------------------*/
+
+static void Swap16Scalar(u8* dst, const u8* src, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        u16 v;
+        memcpy(&v, src + i * 2, 2);
+        v = Swap16(v);
+        memcpy(dst + i * 2, &v, 2);
+    }
+}
+
+static void Swap32Scalar(u8* dst, const u8* src, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        u32 v;
+        memcpy(&v, src + i * 4, 4);
+        v = Swap32(v);
+        memcpy(dst + i * 4, &v, 4);
+    }
+}
+
+static void Swap64Scalar(u8* dst, const u8* src, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        u64 v;
+        memcpy(&v, src + i * 8, 8);
+        v = Swap64(v);
+        memcpy(dst + i * 8, &v, 8);
+    }
+}
+
+#ifdef SWAP_X86
+
+/*---------------------------------------------------------------------------*
+    x86 Kernels
+    
+    Each iteration loads all of its vectors before storing any, so an
+    in-place swap (dst == src) is safe. Returns the bytes not handled.
+ *---------------------------------------------------------------------------*/
+
+// Byte order within each 16-byte lane for 2/4/8-byte elements
+static const u8 s_shuffle16[16] = { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+static const u8 s_shuffle32[16] = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+static const u8 s_shuffle64[16] = { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 };
+
+SWAP_TARGET("ssse3")
+static u32 ShuffleSSSE3(u8* dst, const u8* src, u32 size, const u8* pattern) {
+    __m128i mask = _mm_loadu_si128((const __m128i*)pattern);
+    
+    for (; size >= 64; size -= 64, src += 64, dst += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + 48));
+        _mm_storeu_si128((__m128i*)(dst + 0), _mm_shuffle_epi8(a, mask));
+        _mm_storeu_si128((__m128i*)(dst + 16), _mm_shuffle_epi8(b, mask));
+        _mm_storeu_si128((__m128i*)(dst + 32), _mm_shuffle_epi8(c, mask));
+        _mm_storeu_si128((__m128i*)(dst + 48), _mm_shuffle_epi8(d, mask));
+    }
+    for (; size >= 16; size -= 16, src += 16, dst += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(a, mask));
+    }
+    return size;
+}
+
+SWAP_TARGET("avx2")
+static u32 ShuffleAVX2(u8* dst, const u8* src, u32 size, const u8* pattern) {
+    __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)pattern));
+    
+    for (; size >= 128; size -= 128, src += 128, dst += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src + 0));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(src + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(src + 96));
+        _mm256_storeu_si256((__m256i*)(dst + 0), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256((__m256i*)(dst + 32), _mm256_shuffle_epi8(b, mask));
+        _mm256_storeu_si256((__m256i*)(dst + 64), _mm256_shuffle_epi8(c, mask));
+        _mm256_storeu_si256((__m256i*)(dst + 96), _mm256_shuffle_epi8(d, mask));
+    }
+    for (; size >= 32; size -= 32, src += 32, dst += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)src);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_shuffle_epi8(a, mask));
+    }
+    _mm256_zeroupper();
+    return size;
+}
+
+#define SWAP_X86_WRAPPER(isa, width, pattern)                               \
+static void Swap##width##isa(u8* dst, const u8* src, u32 count) {           \
+    u32 size = count * (width / 8);                                         \
+    u32 left = Shuffle##isa(dst, src, size, pattern);                       \
+    Swap##width##Scalar(dst + size - left, src + size - left, left / (width / 8)); \
+}
+
+SWAP_X86_WRAPPER(SSSE3, 16, s_shuffle16)
+SWAP_X86_WRAPPER(SSSE3, 32, s_shuffle32)
+SWAP_X86_WRAPPER(SSSE3, 64, s_shuffle64)
+SWAP_X86_WRAPPER(AVX2, 16, s_shuffle16)
+SWAP_X86_WRAPPER(AVX2, 32, s_shuffle32)
+SWAP_X86_WRAPPER(AVX2, 64, s_shuffle64)
+
+/*---------------------------------------------------------------------------*
+  Name:         DetectKernels
+  
+  Description:  Find the vector kernels this CPU runs and the OS saves the
+                registers for.
+  
+  Arguments:    None
+  
+  Returns:      Bit mask of supported OS_SWAP_KERNEL_* values
+ *---------------------------------------------------------------------------*/
+static u32 DetectKernels(void) {
+    u32 regs[4];
+    u32 mask = 1u << OS_SWAP_KERNEL_SCALAR;
+    
+    __OSCPUID(0, 0, regs);
+    u32 maxLeaf = regs[0];
+    
+    __OSCPUID(1, 0, regs);
+    if (regs[2] & (1u << 9)) {
+        mask |= 1u << OS_SWAP_KERNEL_SSSE3;
+    }
+    
+    BOOL osxsave = (regs[2] & (1u << 27)) != 0;
+    BOOL avx = (regs[2] & (1u << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7) {
+        return mask;
+    }
+    
+    __OSCPUID(7, 0, regs);
+    if ((__OSReadXCR0() & 0x6) == 0x6 && (regs[1] & (1u << 5))) {
+        mask |= 1u << OS_SWAP_KERNEL_AVX2;
+    }
+    return mask;
+}
+
+#endif // SWAP_X86
+
+#ifdef SWAP_NEON
+
+/*---------------------------------------------------------------------------*
+    NEON Kernel
+ *---------------------------------------------------------------------------*/
+
+static void Swap16NEON(u8* dst, const u8* src, u32 count) {
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_u8(dst + i * 2, vrev16q_u8(vld1q_u8(src + i * 2)));
+    }
+    Swap16Scalar(dst + i * 2, src + i * 2, count - i);
+}
+
+static void Swap32NEON(u8* dst, const u8* src, u32 count) {
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(dst + i * 4, vrev32q_u8(vld1q_u8(src + i * 4)));
+    }
+    Swap32Scalar(dst + i * 4, src + i * 4, count - i);
+}
+
+static void Swap64NEON(u8* dst, const u8* src, u32 count) {
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        vst1q_u8(dst + i * 8, vrev64q_u8(vld1q_u8(src + i * 8)));
+    }
+    Swap64Scalar(dst + i * 8, src + i * 8, count - i);
+}
+
+#endif // SWAP_NEON
+
+static const SwapKernel s_kernels[] = {
+    { "scalar", Swap16Scalar, Swap32Scalar, Swap64Scalar },
+#ifdef SWAP_X86
+    { "SSSE3",  Swap16SSSE3,  Swap32SSSE3,  Swap64SSSE3 },
+    { "AVX2",   Swap16AVX2,   Swap32AVX2,   Swap64AVX2 },
+#else
+    { "SSSE3",  NULL,         NULL,         NULL },
+    { "AVX2",   NULL,         NULL,         NULL },
+#endif
+#ifdef SWAP_NEON
+    { "NEON",   Swap16NEON,   Swap32NEON,   Swap64NEON },
+#else
+    { "NEON",   NULL,         NULL,         NULL },
+#endif
+};
+
+#define NUM_KERNELS (sizeof(s_kernels) / sizeof(s_kernels[0]))
+
+/*---------------------------------------------------------------------------*
+  Name:         InitSwapEngine
+  
+  Description:  Pick the kernel on first use. Racing callers compute the
+                same result, so no lock is needed.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void InitSwapEngine(void) {
+    if (s_swapInitialized) {
+        return;
+    }
+
+#if defined(SWAP_X86)
+    s_supported = DetectKernels();
+#elif defined(SWAP_NEON)
+    s_supported |= 1u << OS_SWAP_KERNEL_NEON;
+#endif
+
+    s_kernel = OS_SWAP_KERNEL_SCALAR;
+    for (u32 k = 0; k < NUM_KERNELS; k++) {
+        if (s_supported & (1u << k)) {
+            s_kernel = k;
+        }
+    }
+    s_swapInitialized = TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSSwapBytes16 / OSSwapBytes32 / OSSwapBytes64
+  
+  Description:  Reverse the byte order of each element.
+  
+  Arguments:    dst    Destination (may equal src)
+                src    Source elements
+                count  Number of elements
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void OSSwapBytes16(void* dst, const void* src, u32 count) {
+    InitSwapEngine();
+    s_kernels[s_kernel].swap16((u8*)dst, (const u8*)src, count);
+}
+
+void OSSwapBytes32(void* dst, const void* src, u32 count) {
+    InitSwapEngine();
+    s_kernels[s_kernel].swap32((u8*)dst, (const u8*)src, count);
+}
+
+void OSSwapBytes64(void* dst, const void* src, u32 count) {
+    InitSwapEngine();
+    s_kernels[s_kernel].swap64((u8*)dst, (const u8*)src, count);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetSwapKernel
+  
+  Description:  Get the kernel used by OSSwapBytes*.
+  
+  Arguments:    None
+  
+  Returns:      OS_SWAP_KERNEL_* value
+ *---------------------------------------------------------------------------*/
+u32 OSGetSwapKernel(void) {
+    InitSwapEngine();
+    return s_kernel;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSIsSwapKernelSupported
+  
+  Description:  Check whether this CPU can run a kernel.
+  
+  Arguments:    kernel  OS_SWAP_KERNEL_* value
+  
+  Returns:      TRUE if supported
+ *---------------------------------------------------------------------------*/
+BOOL OSIsSwapKernelSupported(u32 kernel) {
+    InitSwapEngine();
+    return kernel < NUM_KERNELS && (s_supported & (1u << kernel)) != 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSSetSwapKernel
+  
+  Description:  Force a kernel (for benchmarking or to rule one out).
+  
+  Arguments:    kernel  OS_SWAP_KERNEL_* value
+  
+  Returns:      TRUE if set, FALSE if the CPU does not support it
+ *---------------------------------------------------------------------------*/
+BOOL OSSetSwapKernel(u32 kernel) {
+    if (!OSIsSwapKernelSupported(kernel)) {
+        return FALSE;
+    }
+    s_kernel = kernel;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetSwapKernelName
+  
+  Description:  Get a printable kernel name.
+  
+  Arguments:    kernel  OS_SWAP_KERNEL_* value
+  
+  Returns:      Name, or "unavailable" for unknown kernels
+ *---------------------------------------------------------------------------*/
+const char* OSGetSwapKernelName(u32 kernel) {
+    return kernel < NUM_KERNELS ? s_kernels[kernel].name : "unavailable";
+}
@@ -11,23 +11,49 @@
   - CPUs handle cache coherency automatically
   - No manual cache control needed
   - OS/compiler handle instruction cache
-  - We simulate the API but most operations are no-ops
+  - The DC* range calls still say what the game is about to do, so they
+    map onto host hints: prefetch for touch, streaming stores or dc zva
+    for zero, line writeback for store/flush of shared memory
   
   TWO MODES:
   1. Simple mode (default): Most operations are no-ops
   2. Full emulation mode (PORPOISE_USE_GECKO_MEMORY): Implements locked cache
   
   Key functions that matter on PC:
-  - DCZeroRange: Fast memset (we use actual memset)
-  - DCFlushRange: Important if we later add real DMA
+  - DCTouchRange: Prefetch into the host L1
+  - DCZeroRange: Zeroing sized to the range (memset, streaming, dc zva)
+  - DCFlushRange/DCStoreRange: Release fence; line writeback when another
+    process maps the memory (OSSharedMemory)
   - ICInvalidateRange: Important for JIT or code modification
  *---------------------------------------------------------------------------*/
 
 #include <dolphin/os.h>
+#include <dolphin/os_internal.h>
+#include <dolphin/atomic_internal.h>
+#include <stdint.h>
 #include <string.h>
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CACHE_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define CACHE_ARM64 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CACHE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CACHE_TARGET(isa)
+#endif
+
 #ifdef PORPOISE_USE_GECKO_MEMORY
 #include <dolphin/gecko_memory.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
 #endif
 
 #define CACHE_LINE_SIZE 32
@@ -35,11 +61,315 @@
 /* Locked cache state (for full emulation mode) */
 static BOOL s_locked_cache_enabled = FALSE;
 
+/*---------------------------------------------------------------------------*
+    Host Cache Primitives
+    
+    - Touch: prefetch into L1 (prefetcht0 / prfm pldl1keep), at most
+      TOUCH_MAX_BYTES per call; a larger touch would evict its own start
+      from the GC's 32 KB L1 too
+    - Zero: dc zva on ARM. On x86, ranges at or above the copy engine's
+      streaming threshold use non-temporal stores, since a clear that
+      large would flush the cache anyway; smaller ones use memset, which
+      leaves the lines cached like dcbz does
+    - Store/Flush: host caches are coherent, so another thread only needs
+      a release fence. For ranges inside a shared region while another
+      process is attached, lines are also written back (clwb, clflushopt
+      or clflush; dc cvac/civac on ARM) so consumers outside the coherent
+      domain, such as a device importing the pages, see the data
+    Detected per CPU on first use; OSSetCachePrimitives can turn them off.
+ *---------------------------------------------------------------------------*/
+
+#define HOST_LINE_DEFAULT   64
+#define TOUCH_MAX_BYTES     (32 * 1024)
+#define ZVA_MIN_BYTES       256
+
+static volatile BOOL s_primInitialized = FALSE;
+static u32 s_primSupported = 0;
+static u32 s_primEnabled = 0;
+static u32 s_hostLine = HOST_LINE_DEFAULT;
+#ifdef CACHE_ARM64
+static u32 s_zvaBlock = 0;          // dc zva block size
+#endif
+
+#ifdef CACHE_X86
+
+CACHE_TARGET("sse2")
+static void StreamZero(u8* p, uintptr_t size) {
+    __m128i zero = _mm_setzero_si128();
+    
+    // p and size are multiples of 32
+    for (; size >= 64; size -= 64, p += 64) {
+        _mm_stream_si128((__m128i*)(p + 0), zero);
+        _mm_stream_si128((__m128i*)(p + 16), zero);
+        _mm_stream_si128((__m128i*)(p + 32), zero);
+        _mm_stream_si128((__m128i*)(p + 48), zero);
+    }
+    if (size) {
+        _mm_stream_si128((__m128i*)(p + 0), zero);
+        _mm_stream_si128((__m128i*)(p + 16), zero);
+    }
+    _mm_sfence();
+}
+
+CACHE_TARGET("clwb")
+static void WritebackCLWB(uintptr_t a, uintptr_t end, uintptr_t line) {
+    for (; a < end; a += line) {
+        _mm_clwb((void*)a);
+    }
+}
+
+CACHE_TARGET("clflushopt")
+static void WritebackCLFLUSHOPT(uintptr_t a, uintptr_t end, uintptr_t line) {
+    for (; a < end; a += line) {
+        _mm_clflushopt((void*)a);
+    }
+}
+
+CACHE_TARGET("sse2")
+static void WritebackCLFLUSH(uintptr_t a, uintptr_t end, uintptr_t line) {
+    for (; a < end; a += line) {
+        _mm_clflush((const void*)a);
+    }
+}
+
+#endif // CACHE_X86
+
+/*---------------------------------------------------------------------------*
+  Name:         InitCachePrimitives
+  
+  Description:  Detect the host primitives and line size on first use.
+                Racing callers compute the same result, so no lock is
+                needed.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void InitCachePrimitives(void) {
+    u32 mask = 0;
+    
+    if (s_primInitialized) {
+        return;
+    }
+
+#ifdef CACHE_X86
+    u32 regs[4];
+    
+    __OSCPUID(0, 0, regs);
+    u32 maxLeaf = regs[0];
+    
+    __OSCPUID(1, 0, regs);
+    if (regs[3] & (1u << 25)) mask |= OS_CACHE_PRIM_PREFETCH;
+    if (regs[3] & (1u << 26)) mask |= OS_CACHE_PRIM_STREAM_ZERO;
+    if (regs[3] & (1u << 19)) {
+        mask |= OS_CACHE_PRIM_CLFLUSH;
+        s_hostLine = ((regs[1] >> 8) & 0xFF) * 8;
+    }
+    if (maxLeaf >= 7) {
+        __OSCPUID(7, 0, regs);
+        if (regs[1] & (1u << 23)) mask |= OS_CACHE_PRIM_CLFLUSHOPT;
+        if (regs[1] & (1u << 24)) mask |= OS_CACHE_PRIM_CLWB;
+    }
+#elif defined(CACHE_ARM64)
+    u64 ctr, dczid;
+    
+    __asm__ volatile("mrs %0, ctr_el0" : "=r"(ctr));
+    __asm__ volatile("mrs %0, dczid_el0" : "=r"(dczid));
+    s_hostLine = 4u << ((ctr >> 16) & 0xF);
+    mask = OS_CACHE_PRIM_PREFETCH | OS_CACHE_PRIM_DC_CVAC;
+    if (!(dczid & 0x10)) {
+        s_zvaBlock = 4u << (dczid & 0xF);
+        mask |= OS_CACHE_PRIM_DC_ZVA;
+    }
+#else
+    mask = OS_CACHE_PRIM_PREFETCH;
+#endif
+
+    if (s_hostLine < 16 || (s_hostLine & (s_hostLine - 1))) {
+        s_hostLine = HOST_LINE_DEFAULT;
+    }
+    s_primSupported = mask;
+    s_primEnabled = mask;
+    s_primInitialized = TRUE;
+}
+
+static inline void Prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#elif defined(CACHE_X86)
+    _mm_prefetch((const char*)p, _MM_HINT_T0);
+#else
+    (void)p;
+#endif
+}
+
+static void TouchLines(const void* addr, u32 nBytes) {
+    InitCachePrimitives();
+    if (!addr || nBytes == 0 || !(s_primEnabled & OS_CACHE_PRIM_PREFETCH)) {
+        return;
+    }
+    
+    uintptr_t line = s_hostLine;
+    uintptr_t a = (uintptr_t)addr & ~(line - 1);
+    uintptr_t end = (uintptr_t)addr + (nBytes < TOUCH_MAX_BYTES ? nBytes : TOUCH_MAX_BYTES);
+    
+    for (; a < end; a += line) {
+        Prefetch((const void*)a);
+    }
+}
+
+/* p and size are multiples of CACHE_LINE_SIZE */
+static void ZeroLines(u8* p, uintptr_t size) {
+    InitCachePrimitives();
+
+#ifdef CACHE_ARM64
+    uintptr_t block = s_zvaBlock;
+    if ((s_primEnabled & OS_CACHE_PRIM_DC_ZVA) && size >= ZVA_MIN_BYTES && size >= 2 * block) {
+        u8* end = p + size;
+        u8* first = (u8*)(((uintptr_t)p + block - 1) & ~(block - 1));
+        u8* last = (u8*)((uintptr_t)end & ~(block - 1));
+        
+        memset(p, 0, (size_t)(first - p));
+        for (u8* b = first; b < last; b += block) {
+            __asm__ volatile("dc zva, %0" : : "r"(b) : "memory");
+        }
+        memset(last, 0, (size_t)(end - last));
+        return;
+    }
+#endif
+
+#ifdef CACHE_X86
+    if ((s_primEnabled & OS_CACHE_PRIM_STREAM_ZERO) && size >= OSGetCopyStreamThreshold()) {
+        StreamZero(p, size);
+        return;
+    }
+#endif
+
+    memset(p, 0, (size_t)size);
+}
+
+static BOOL InSharedRegion(const void* addr, u32 nBytes) {
+    static const u32 regions[] = { OS_SHARED_MEM1, OS_SHARED_MEM2, OS_SHARED_ARAM };
+    const u8* p = (const u8*)addr;
+    
+    if (!OSIsSharedPeerAttached()) {
+        return FALSE;
+    }
+    for (u32 i = 0; i < ARRAY_LENGTH(regions); i++) {
+        u32 size;
+        const u8* base = (const u8*)OSGetSharedRegion(regions[i], &size);
+        if (base && p < base + size && p + nBytes > base) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StoreLines
+  
+  Description:  DCStoreRange/DCFlushRange and their NoSync and block forms.
+                Writes the lines back only for shared memory with another
+                process attached (see above).
+  
+  Arguments:    addr    Start of the range
+                nBytes  Size of the range
+                evict   Flush (drop the lines) rather than store
+                sync    Order the stores before later ones (PPC sync)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StoreLines(const void* addr, u32 nBytes, BOOL evict, BOOL sync) {
+    BOOL written = FALSE;
+    
+    if (addr && nBytes > 0 && InSharedRegion(addr, nBytes)) {
+        InitCachePrimitives();
+        
+        u32 prim = s_primEnabled;
+        uintptr_t line = s_hostLine;
+        uintptr_t a = (uintptr_t)addr & ~(line - 1);
+        uintptr_t end = (uintptr_t)addr + nBytes;
+        
+        written = TRUE;
+#ifdef CACHE_X86
+        if (!evict && (prim & OS_CACHE_PRIM_CLWB)) {
+            WritebackCLWB(a, end, line);
+        } else if (prim & OS_CACHE_PRIM_CLFLUSHOPT) {
+            WritebackCLFLUSHOPT(a, end, line);
+        } else if (prim & OS_CACHE_PRIM_CLFLUSH) {
+            WritebackCLFLUSH(a, end, line);
+        } else {
+            written = FALSE;
+        }
+#elif defined(CACHE_ARM64)
+        if (!(prim & OS_CACHE_PRIM_DC_CVAC)) {
+            written = FALSE;
+        } else if (evict) {
+            for (; a < end; a += line) {
+                __asm__ volatile("dc civac, %0" : : "r"(a) : "memory");
+            }
+        } else {
+            for (; a < end; a += line) {
+                __asm__ volatile("dc cvac, %0" : : "r"(a) : "memory");
+            }
+        }
+#else
+        (void)prim;
+        (void)a;
+        (void)end;
+        (void)evict;
+        written = FALSE;
+#endif
+    }
+    
+    if (!sync) {
+        return;
+    }
+    if (written) {
+#ifdef CACHE_X86
+        _mm_sfence();       // Orders clwb/clflushopt
+#elif defined(CACHE_ARM64)
+        __asm__ volatile("dsb ish" : : : "memory");
+#endif
+    } else {
+        __AtomicReleaseFence();
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetCachePrimitives / OSSetCachePrimitives
+  
+  Description:  Get the host primitives the DC* calls use, or restrict them
+                (for benchmarks and A/B tests). Bits the CPU lacks are
+                ignored, so OSSetCachePrimitives(0xFFFFFFFF) restores and
+                returns everything supported.
+  
+  Arguments:    mask  OS_CACHE_PRIM_* bits to use
+  
+  Returns:      Bits in effect
+ *---------------------------------------------------------------------------*/
+u32 OSGetCachePrimitives(void) {
+    InitCachePrimitives();
+    return s_primEnabled;
+}
+
+u32 OSSetCachePrimitives(u32 mask) {
+    InitCachePrimitives();
+    s_primEnabled = mask & s_primSupported;
+    return s_primEnabled;
+}
+
+u32 OSGetHostCacheLineSize(void) {
+    InitCachePrimitives();
+    return s_hostLine;
+}
+
 /*---------------------------------------------------------------------------*
   L1 Data Cache Operations
   
   On original hardware, these use PowerPC dcbf/dcbi/dcbz/dcbst instructions.
-  On PC, most are no-ops since x86/ARM handle cache coherency automatically.
+  On PC, coherency is automatic; the calls map onto the host primitives
+  above.
  *---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*
@@ -70,14 +400,13 @@ void DCInvalidateRange(void* addr, u32 nBytes) {
                 Critical before DMA operations! Games call this before GPU
                 reads data or before DVD writes.
                 
-                On PC: No-op for now. If we implement real DMA later, we might
-                need memory barriers here.
+                On PC: Release fence, so another thread that sees a later
+                store also sees the range. Lines in a shared region are
+                written back and dropped (clflushopt / dc civac) while
+                another process is attached.
  *---------------------------------------------------------------------------*/
 void DCFlushRange(void* addr, u32 nBytes) {
-    // No-op on PC - but kept for API compatibility
-    // If we add real DMA: insert memory barrier/fence here
-    (void)addr;
-    (void)nBytes;
+    StoreLines(addr, nBytes, TRUE, TRUE);
 }
 
 /*---------------------------------------------------------------------------*
@@ -86,11 +415,11 @@ void DCFlushRange(void* addr, u32 nBytes) {
   Description:  Stores data cache to main memory without invalidating.
                 Like DCFlushRange but cache lines stay in cache.
                 
-                On PC: No-op.
+                On PC: As DCFlushRange, but shared lines are written back
+                and kept (clwb / dc cvac).
  *---------------------------------------------------------------------------*/
 void DCStoreRange(void* addr, u32 nBytes) {
-    (void)addr;
-    (void)nBytes;
+    StoreLines(addr, nBytes, FALSE, TRUE);
 }
 
 /*---------------------------------------------------------------------------*
@@ -99,16 +428,14 @@ void DCStoreRange(void* addr, u32 nBytes) {
   Description:  Same as above but without sync barrier (for performance when
                 batching multiple operations).
                 
-                On PC: No-op.
+                On PC: Shared lines are written back; no fence.
  *---------------------------------------------------------------------------*/
 void DCFlushRangeNoSync(void* addr, u32 nBytes) {
-    (void)addr;
-    (void)nBytes;
+    StoreLines(addr, nBytes, TRUE, FALSE);
 }
 
 void DCStoreRangeNoSync(void* addr, u32 nBytes) {
-    (void)addr;
-    (void)nBytes;
+    StoreLines(addr, nBytes, FALSE, FALSE);
 }
 
 /*---------------------------------------------------------------------------*
@@ -120,19 +447,24 @@ void DCStoreRangeNoSync(void* addr, u32 nBytes) {
                 
                 This is faster than memset on PowerPC!
                 
-                On PC: Use standard memset (compiler may optimize to SSE/AVX).
+                On PC: dc zva on ARM. On x86, ranges at or above the copy
+                engine's streaming threshold use non-temporal stores;
+                smaller ones use memset.
+                
+                For aligned ranges this is exactly what dcbz zeroes. Host
+                buffers need not be 32-byte aligned, so an unaligned range
+                is not widened to every line it touches.
 
   Arguments:    addr   - Address (aligned down to 32 bytes)
                 nBytes - Size (aligned up to 32 bytes)
  *---------------------------------------------------------------------------*/
 void DCZeroRange(void* addr, u32 nBytes) {
     if (addr && nBytes > 0) {
-        // Align down to 32-byte boundary
-        u32 alignedAddr = ((u32)addr) & ~31;
-        // Align up size
-        u32 alignedSize = (nBytes + 31) & ~31;
+        uintptr_t start = (uintptr_t)addr & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+        uintptr_t size = ((uintptr_t)nBytes + CACHE_LINE_SIZE - 1) &
+                         ~(uintptr_t)(CACHE_LINE_SIZE - 1);
         
-        memset((void*)alignedAddr, 0, alignedSize);
+        ZeroLines((u8*)start, size);
     }
 }
 
@@ -143,12 +475,10 @@ void DCZeroRange(void* addr, u32 nBytes) {
                 'dcbt' (data cache block touch) to load data into L1 cache
                 without blocking.
                 
-                On PC: No-op. Modern CPUs have hardware prefetchers.
+                On PC: Prefetch each host line (first 32 KB of the range).
  *---------------------------------------------------------------------------*/
 void DCTouchRange(void* addr, u32 nBytes) {
-    // No-op - modern CPUs prefetch automatically
-    (void)addr;
-    (void)nBytes;
+    TouchLines(addr, nBytes);
 }
 
 /*---------------------------------------------------------------------------*
@@ -176,25 +506,26 @@ void DCUnfreeze(void) {
 }
 
 void DCTouchLoad(void* addr) {
-    // Prefetch single cache line - no-op
-    (void)addr;
+    // Prefetch single cache line
+    TouchLines(addr, 1);
 }
 
 void DCBlockZero(void* addr) {
-    // Zero single 32-byte block
+    // Zero 32 bytes from addr; the same block dcbz zeroes when addr is
+    // aligned, and nothing before an unaligned host buffer
     if (addr) {
         memset(addr, 0, CACHE_LINE_SIZE);
     }
 }
 
 void DCBlockStore(void* addr) {
-    // Store single cache line - no-op
-    (void)addr;
+    // Store single cache line (dcbst has no sync)
+    StoreLines(addr, CACHE_LINE_SIZE, FALSE, FALSE);
 }
 
 void DCBlockFlush(void* addr) {
-    // Flush single cache line - no-op
-    (void)addr;
+    // Flush single cache line
+    StoreLines(addr, CACHE_LINE_SIZE, TRUE, FALSE);
 }
 
 void DCBlockInvalidate(void* addr) {
@@ -315,12 +646,294 @@ void L2SetWriteThrough(BOOL writeThrough) {
   - Full emulation mode: Uses 16KB buffer from GeckoMemory
  *---------------------------------------------------------------------------*/
 
+#ifdef PORPOISE_USE_GECKO_MEMORY
+
+/*---------------------------------------------------------------------------*
+    Locked Cache DMA Queue
+    
+    On GC/Wii the locked cache DMA engine has a 15-entry queue. The CPU
+    keeps running while blocks move, and LCQueueWait(n) stalls until at
+    most n transactions are outstanding, which is what lets a game load
+    the next tile while it processes the current one.
+    
+    On PC a DMA thread (started by LCEnable) works through a ring of the
+    same depth in FIFO order. Posting to a full queue blocks until a slot
+    frees, as the hardware stalls the CPU. Source and destination are
+    resolved when a transaction is posted. As on hardware, a buffer must
+    not be touched until its transaction has left the queue.
+    
+    A transaction is a few microseconds of copying at most, so the DMA
+    thread and waiters spin for a moment before sleeping on a condition
+    variable; a full wakeup would cost more than the copy. On a single
+    CPU spinning only delays the other side, so nobody spins.
+ *---------------------------------------------------------------------------*/
+
+#define LC_QUEUE_DEPTH  15
+#define LC_SPIN_TICKS   (OS_TIMER_CLOCK / 20000)    // 50 us (multi-core hosts)
+
+typedef struct LCTransaction {
+    u8*       dst;
+    const u8* src;
+    u32       size;
+} LCTransaction;
+
+static LCTransaction s_lcQueue[LC_QUEUE_DEPTH];
+static u32 s_lcHead = 0;                // Next transaction to copy
+static volatile u32 s_lcCount = 0;      // Outstanding, including the one in flight
+static BOOL s_lcBusy = FALSE;           // Head is being copied
+static BOOL s_lcEngineSleeping = FALSE;
+static u32 s_lcWaiters = 0;             // Threads asleep on s_lcIdleCond
+static BOOL s_lcThreadRunning = FALSE;
+static BOOL s_lcStopRequested = FALSE;
+static OSTime s_lcSpinTicks = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION s_lcLock;
+static CONDITION_VARIABLE s_lcWorkCond;    // Wakes the DMA thread
+static CONDITION_VARIABLE s_lcIdleCond;    // A transaction finished
+static BOOL s_lcLockInit = FALSE;
+static HANDLE s_lcThread = NULL;
+#else
+static pthread_mutex_t s_lcLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_lcWorkCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t s_lcIdleCond = PTHREAD_COND_INITIALIZER;
+static pthread_t s_lcThread;
+#endif
+
+static void LockLC(void) {
+#ifdef _WIN32
+    if (!s_lcLockInit) {
+        InitializeCriticalSection(&s_lcLock);
+        InitializeConditionVariable(&s_lcWorkCond);
+        InitializeConditionVariable(&s_lcIdleCond);
+        s_lcLockInit = TRUE;
+    }
+    EnterCriticalSection(&s_lcLock);
+#else
+    pthread_mutex_lock(&s_lcLock);
+#endif
+}
+
+static void UnlockLC(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_lcLock);
+#else
+    pthread_mutex_unlock(&s_lcLock);
+#endif
+}
+
+// Wait on a condition; caller holds the LC lock
+static void WaitLC(void* cond) {
+#ifdef _WIN32
+    SleepConditionVariableCS((CONDITION_VARIABLE*)cond, &s_lcLock, INFINITE);
+#else
+    pthread_cond_wait((pthread_cond_t*)cond, &s_lcLock);
+#endif
+}
+
+static void SignalLC(void* cond) {
+#ifdef _WIN32
+    WakeAllConditionVariable((CONDITION_VARIABLE*)cond);
+#else
+    pthread_cond_broadcast((pthread_cond_t*)cond);
+#endif
+}
+
+static inline void SpinPause(void) {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         SpinUntil
+  
+  Description:  Poll the outstanding count without the lock for up to
+                s_lcSpinTicks. Caller holds the LC lock; it is dropped
+                while spinning and held again on return.
+  
+  Arguments:    below  TRUE: wait for count <= limit; FALSE: count > limit
+                limit  Threshold
+  
+  Returns:      TRUE if the condition held before the spin ran out
+ *---------------------------------------------------------------------------*/
+static BOOL SpinUntil(BOOL below, u32 limit) {
+    OSTime start = OSGetTime();
+    BOOL met = FALSE;
+    
+    if (s_lcSpinTicks == 0) {
+        return FALSE;
+    }
+    
+    UnlockLC();
+    do {
+        u32 count = __AtomicLoad32(&s_lcCount);
+        if (below ? (count <= limit) : (count > limit)) {
+            met = TRUE;
+            break;
+        }
+        SpinPause();
+    } while (OSGetTime() - start < s_lcSpinTicks);
+    LockLC();
+    return met;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         LCDMAThread
+  
+  Description:  Copies queued transactions in order.
+  
+  Arguments:    arg  Unused
+  
+  Returns:      0 (thread return value)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI LCDMAThread(LPVOID arg)
+#else
+static void* LCDMAThread(void* arg)
+#endif
+{
+    (void)arg;
+    
+    LockLC();
+    
+    while (!s_lcStopRequested) {
+        if (s_lcCount == 0) {
+            if (!SpinUntil(FALSE, 0) && s_lcCount == 0 && !s_lcStopRequested) {
+                s_lcEngineSleeping = TRUE;
+                WaitLC(&s_lcWorkCond);
+                s_lcEngineSleeping = FALSE;
+            }
+            continue;
+        }
+        
+        LCTransaction t = s_lcQueue[s_lcHead];
+        s_lcBusy = TRUE;
+        UnlockLC();
+        
+        OSCopyMemory(t.dst, t.src, t.size);
+        
+        LockLC();
+        s_lcBusy = FALSE;
+        s_lcHead = (s_lcHead + 1) % LC_QUEUE_DEPTH;
+        __AtomicStore32(&s_lcCount, s_lcCount - 1);
+        if (s_lcWaiters > 0) {
+            SignalLC(&s_lcIdleCond);
+        }
+    }
+    
+    UnlockLC();
+    return 0;
+}
+
+// Caller holds the LC lock
+static void WaitForQueue(u32 len) {
+    while (s_lcCount > len) {
+        if (SpinUntil(TRUE, len)) {
+            continue;
+        }
+        s_lcWaiters++;
+        if (s_lcCount > len) {
+            WaitLC(&s_lcIdleCond);
+        }
+        s_lcWaiters--;
+    }
+}
+
+static u32 CountCPUs(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u32)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (u32)n : 1;
+#endif
+}
+
+static void StartLCThread(void) {
+    LockLC();
+    if (!s_lcThreadRunning) {
+        s_lcStopRequested = FALSE;
+        s_lcSpinTicks = (CountCPUs() > 1) ? LC_SPIN_TICKS : 0;
+#ifdef _WIN32
+        s_lcThread = CreateThread(NULL, 0, LCDMAThread, NULL, 0, NULL);
+        s_lcThreadRunning = (s_lcThread != NULL);
+#else
+        s_lcThreadRunning = (pthread_create(&s_lcThread, NULL, LCDMAThread, NULL) == 0);
+#endif
+        if (!s_lcThreadRunning) {
+            OSReport("LC: Could not start the DMA thread, transfers are synchronous\n");
+        }
+    }
+    UnlockLC();
+}
+
+static void StopLCThread(void) {
+    LockLC();
+    if (!s_lcThreadRunning) {
+        UnlockLC();
+        return;
+    }
+    WaitForQueue(0);
+    s_lcStopRequested = TRUE;
+    SignalLC(&s_lcWorkCond);
+    UnlockLC();
+
+#ifdef _WIN32
+    WaitForSingleObject(s_lcThread, INFINITE);
+    CloseHandle(s_lcThread);
+    s_lcThread = NULL;
+#else
+    pthread_join(s_lcThread, NULL);
+#endif
+    s_lcThreadRunning = FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PostTransaction
+  
+  Description:  Queue one DMA transaction, blocking while the queue is
+                full. Without the DMA thread the copy happens here.
+  
+  Arguments:    dst   Host destination
+                src   Host source
+                size  Bytes (at most LC_MAX_DMA_BYTES)
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void PostTransaction(u8* dst, const u8* src, u32 size) {
+    LockLC();
+    if (!s_lcThreadRunning) {
+        UnlockLC();
+        OSCopyMemory(dst, src, size);
+        return;
+    }
+    
+    WaitForQueue(LC_QUEUE_DEPTH - 1);
+    
+    LCTransaction* t = &s_lcQueue[(s_lcHead + s_lcCount) % LC_QUEUE_DEPTH];
+    t->dst = dst;
+    t->src = src;
+    t->size = size;
+    __AtomicStore32(&s_lcCount, s_lcCount + 1);
+    if (s_lcEngineSleeping) {
+        SignalLC(&s_lcWorkCond);
+    }
+    UnlockLC();
+}
+
+#endif // PORPOISE_USE_GECKO_MEMORY
+
 void LCEnable(void) {
     s_locked_cache_enabled = TRUE;
     
 #ifdef PORPOISE_USE_GECKO_MEMORY
     if (g_geckoMemory) {
         g_geckoMemory->locked_cache_enabled = TRUE;
+        StartLCThread();
         OSReport("Locked cache enabled (16 KB scratchpad at 0xE0000000)\n");
     }
 #endif
@@ -330,6 +943,8 @@ void LCDisable(void) {
     s_locked_cache_enabled = FALSE;
     
 #ifdef PORPOISE_USE_GECKO_MEMORY
+    /* Outstanding transactions finish first */
+    StopLCThread();
     if (g_geckoMemory) {
         g_geckoMemory->locked_cache_enabled = FALSE;
     }
@@ -349,7 +964,7 @@ void LCLoadBlocks(void* destTag, void* srcAddr, u32 numBlocks) {
                 /* Get source pointer */
                 void* src = GeckoGetPointer(g_geckoMemory, (u32)srcAddr);
                 if (src) {
-                    memcpy(&g_geckoMemory->locked_cache[offset], src, size);
+                    PostTransaction(&g_geckoMemory->locked_cache[offset], (const u8*)src, size);
                 }
             }
         }
@@ -374,7 +989,7 @@ void LCStoreBlocks(void* destAddr, void* srcTag, u32 numBlocks) {
                 /* Get destination pointer */
                 void* dest = GeckoGetPointer(g_geckoMemory, (u32)destAddr);
                 if (dest) {
-                    memcpy(dest, &g_geckoMemory->locked_cache[offset], size);
+                    PostTransaction((u8*)dest, &g_geckoMemory->locked_cache[offset], size);
                 }
             }
         }
@@ -437,18 +1052,48 @@ u32 LCStoreData(void* destAddr, void* srcAddr, u32 nBytes) {
     return 0;
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         LCQueueLength
+  
+  Description:  Number of DMA transactions not yet finished (0 - 15).
+ *---------------------------------------------------------------------------*/
 u32 LCQueueLength(void) {
-    /* No DMA queue on PC - all transfers are instant */
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    return __AtomicLoad32(&s_lcCount);
+#else
     return 0;
+#endif
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         LCQueueWait
+  
+  Description:  Block until at most len DMA transactions are outstanding.
+                LCQueueWait(0) waits for all of them.
+ *---------------------------------------------------------------------------*/
 void LCQueueWait(u32 len) {
-    /* Instant on PC */
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    LockLC();
+    WaitForQueue(len);
+    UnlockLC();
+#else
     (void)len;
+#endif
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         LCFlushQueue
+  
+  Description:  Drop the transactions that have not started (as the
+                hardware's flush bit does) and wait for the one in flight.
+ *---------------------------------------------------------------------------*/
 void LCFlushQueue(void) {
-    /* Instant on PC */
+#ifdef PORPOISE_USE_GECKO_MEMORY
+    LockLC();
+    __AtomicStore32(&s_lcCount, s_lcBusy ? 1 : 0);
+    WaitForQueue(0);
+    UnlockLC();
+#endif
 }
 
 void LCAlloc(void* addr, u32 nBytes) {
@@ -0,0 +1,526 @@
+/*---------------------------------------------------------------------------*
+  OSMemCopy.c - Bulk Copy Engine
+  
+  On GC/Wii: ARAM and locked cache transfers are done by DMA engines; the
+             CPU caches are not involved.
+  
+  On PC: Simulated DMA is a CPU copy. Small transfers are fastest through
+         the cache, but a multi-megabyte ARAM upload copied with ordinary
+         stores evicts everything the game thread was working on. Copies
+         at or above the streaming threshold therefore use non-temporal
+         stores, which write around the cache like the real DMA would.
+  
+  KERNELS:
+  - Scalar: memcpy (all CPUs; the only kernel off x86)
+  - SSE2, AVX2, AVX-512: 16/32/64-byte vector loops, each with a cached
+    and a streaming (non-temporal) variant
+  The best kernel the CPU and OS support is picked on first use. Copies
+  below COPY_SMALL_SIZE always go to memcpy; vector setup does not pay
+  off there.
+  
+  THRESHOLD:
+  Defaults to half the last-level cache when the host reports it (so a
+  streamed copy is one that would have flushed most of the cache anyway),
+  otherwise 1 MB.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/os.h>
+#include <dolphin/os_internal.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COPY_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define COPY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define COPY_TARGET(isa)
+#endif
+
+/*---------------------------------------------------------------------------*
+    Engine State
+ *---------------------------------------------------------------------------*/
+
+#define COPY_SMALL_SIZE         256
+#define COPY_DEFAULT_THRESHOLD  (1024 * 1024)
+#define COPY_MIN_THRESHOLD      (256 * 1024)
+#define COPY_MAX_THRESHOLD      (16 * 1024 * 1024)
+
+typedef void (*CopyFunc)(void* dst, const void* src, u32 size);
+
+typedef struct CopyKernel {
+    const char* name;
+    CopyFunc    cached;
+    CopyFunc    streaming;
+} CopyKernel;
+
+static volatile BOOL s_copyInitialized = FALSE;
+static u32 s_supported = 1u << OS_COPY_KERNEL_SCALAR;   // Bit per kernel
+static u32 s_kernel = OS_COPY_KERNEL_SCALAR;
+static u32 s_streamThreshold = COPY_DEFAULT_THRESHOLD;
+
+static void CopyScalar(void* dst, const void* src, u32 size) {
+    memcpy(dst, src, size);
+}
+
+#ifdef COPY_X86
+
+/*---------------------------------------------------------------------------*
+    x86 Kernels
+    
+    Loads are unaligned. Each kernel copies a short head with memcpy so
+    its stores are aligned (required for streaming stores, and it keeps
+    cached stores from splitting cache lines). Every streaming copy ends
+    with sfence so the data is globally visible before completion is
+    reported.
+ *---------------------------------------------------------------------------*/
+
+COPY_TARGET("sse2")
+static void CopySSE2Cached(void* dst, const void* src, u32 size) {
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    u32 head = (u32)((16 - ((uintptr_t)d & 15)) & 15);
+    
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    for (; size >= 64; size -= 64, s += 64, d += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_storeu_si128((__m128i*)(d + 0), a);
+        _mm_storeu_si128((__m128i*)(d + 16), b);
+        _mm_storeu_si128((__m128i*)(d + 32), c);
+        _mm_storeu_si128((__m128i*)(d + 48), e);
+    }
+    memcpy(d, s, size);
+}
+
+COPY_TARGET("sse2")
+static void CopySSE2Streaming(void* dst, const void* src, u32 size) {
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    u32 head = (u32)((16 - ((uintptr_t)d & 15)) & 15);
+    
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    for (; size >= 64; size -= 64, s += 64, d += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_stream_si128((__m128i*)(d + 0), a);
+        _mm_stream_si128((__m128i*)(d + 16), b);
+        _mm_stream_si128((__m128i*)(d + 32), c);
+        _mm_stream_si128((__m128i*)(d + 48), e);
+    }
+    _mm_sfence();
+    memcpy(d, s, size);
+}
+
+COPY_TARGET("avx2")
+static void CopyAVX2Cached(void* dst, const void* src, u32 size) {
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    u32 head = (u32)((32 - ((uintptr_t)d & 31)) & 31);
+    
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    for (; size >= 128; size -= 128, s += 128, d += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s + 0));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i*)(s + 96));
+        _mm256_storeu_si256((__m256i*)(d + 0), a);
+        _mm256_storeu_si256((__m256i*)(d + 32), b);
+        _mm256_storeu_si256((__m256i*)(d + 64), c);
+        _mm256_storeu_si256((__m256i*)(d + 96), e);
+    }
+    _mm256_zeroupper();
+    memcpy(d, s, size);
+}
+
+COPY_TARGET("avx2")
+static void CopyAVX2Streaming(void* dst, const void* src, u32 size) {
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    u32 head = (u32)((32 - ((uintptr_t)d & 31)) & 31);
+    
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    for (; size >= 128; size -= 128, s += 128, d += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s + 0));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i*)(s + 96));
+        _mm256_stream_si256((__m256i*)(d + 0), a);
+        _mm256_stream_si256((__m256i*)(d + 32), b);
+        _mm256_stream_si256((__m256i*)(d + 64), c);
+        _mm256_stream_si256((__m256i*)(d + 96), e);
+    }
+    _mm_sfence();
+    _mm256_zeroupper();
+    memcpy(d, s, size);
+}
+
+COPY_TARGET("avx512f")
+static void CopyAVX512Cached(void* dst, const void* src, u32 size) {
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    u32 head = (u32)((64 - ((uintptr_t)d & 63)) & 63);
+    
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    for (; size >= 256; size -= 256, s += 256, d += 256) {
+        __m512i a = _mm512_loadu_si512((const void*)(s + 0));
+        __m512i b = _mm512_loadu_si512((const void*)(s + 64));
+        __m512i c = _mm512_loadu_si512((const void*)(s + 128));
+        __m512i e = _mm512_loadu_si512((const void*)(s + 192));
+        _mm512_storeu_si512((void*)(d + 0), a);
+        _mm512_storeu_si512((void*)(d + 64), b);
+        _mm512_storeu_si512((void*)(d + 128), c);
+        _mm512_storeu_si512((void*)(d + 192), e);
+    }
+    _mm256_zeroupper();
+    memcpy(d, s, size);
+}
+
+COPY_TARGET("avx512f")
+static void CopyAVX512Streaming(void* dst, const void* src, u32 size) {
+    u8* d = (u8*)dst;
+    const u8* s = (const u8*)src;
+    u32 head = (u32)((64 - ((uintptr_t)d & 63)) & 63);
+    
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    size -= head;
+    
+    for (; size >= 256; size -= 256, s += 256, d += 256) {
+        __m512i a = _mm512_loadu_si512((const void*)(s + 0));
+        __m512i b = _mm512_loadu_si512((const void*)(s + 64));
+        __m512i c = _mm512_loadu_si512((const void*)(s + 128));
+        __m512i e = _mm512_loadu_si512((const void*)(s + 192));
+        _mm512_stream_si512((void*)(d + 0), a);
+        _mm512_stream_si512((void*)(d + 64), b);
+        _mm512_stream_si512((void*)(d + 128), c);
+        _mm512_stream_si512((void*)(d + 192), e);
+    }
+    _mm_sfence();
+    _mm256_zeroupper();
+    memcpy(d, s, size);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __OSCPUID
+  
+  Description:  Run CPUID. Shared by every file that picks kernels by
+                CPU feature.
+  
+  Arguments:    leaf     EAX input
+                subleaf  ECX input
+                regs     Receives EAX, EBX, ECX, EDX
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __OSCPUID(u32 leaf, u32 subleaf, u32 regs[4]) {
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    regs[0] = (u32)r[0]; regs[1] = (u32)r[1]; regs[2] = (u32)r[2]; regs[3] = (u32)r[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __OSReadXCR0
+  
+  Description:  Read XCR0, the register state the OS saves on context
+                switches. Only valid when CPUID.1:ECX.OSXSAVE is set.
+  
+  Arguments:    None
+  
+  Returns:      XCR0
+ *---------------------------------------------------------------------------*/
+u64 __OSReadXCR0(void) {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    u32 lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((u64)hi << 32) | lo;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DetectKernels
+  
+  Description:  Find the vector kernels this CPU runs and the OS saves the
+                registers for (XSAVE state enabled in XCR0).
+  
+  Arguments:    None
+  
+  Returns:      Bit mask of supported OS_COPY_KERNEL_* values
+ *---------------------------------------------------------------------------*/
+static u32 DetectKernels(void) {
+    u32 regs[4];
+    u32 mask = 1u << OS_COPY_KERNEL_SCALAR;
+    
+    __OSCPUID(0, 0, regs);
+    u32 maxLeaf = regs[0];
+    
+    __OSCPUID(1, 0, regs);
+    if (regs[3] & (1u << 26)) {
+        mask |= 1u << OS_COPY_KERNEL_SSE2;
+    }
+    
+    BOOL osxsave = (regs[2] & (1u << 27)) != 0;
+    BOOL avx = (regs[2] & (1u << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7) {
+        return mask;
+    }
+    
+    u64 xcr0 = __OSReadXCR0();
+    __OSCPUID(7, 0, regs);
+    
+    // YMM state (bits 1-2) for AVX2; plus opmask/ZMM state (bits 5-7)
+    if ((xcr0 & 0x6) == 0x6 && (regs[1] & (1u << 5))) {
+        mask |= 1u << OS_COPY_KERNEL_AVX2;
+    }
+    if ((xcr0 & 0xE6) == 0xE6 && (regs[1] & (1u << 16))) {
+        mask |= 1u << OS_COPY_KERNEL_AVX512;
+    }
+    return mask;
+}
+
+#endif // COPY_X86
+
+static const CopyKernel s_kernels[] = {
+    { "scalar",  CopyScalar,       CopyScalar },
+#ifdef COPY_X86
+    { "SSE2",    CopySSE2Cached,   CopySSE2Streaming },
+    { "AVX2",    CopyAVX2Cached,   CopyAVX2Streaming },
+    { "AVX-512", CopyAVX512Cached, CopyAVX512Streaming },
+#endif
+};
+
+#define NUM_KERNELS (sizeof(s_kernels) / sizeof(s_kernels[0]))
+
+/*---------------------------------------------------------------------------*
+  Name:         DefaultThreshold
+  
+  Description:  Streaming threshold from the host's last-level cache size.
+  
+  Arguments:    None
+  
+  Returns:      Threshold in bytes
+ *---------------------------------------------------------------------------*/
+static u32 DefaultThreshold(void) {
+    long cache = 0;
+
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+    cache = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (cache <= 0) {
+        cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+#endif
+
+    if (cache <= 0) {
+        return COPY_DEFAULT_THRESHOLD;
+    }
+    
+    u32 threshold = (u32)(cache / 2);
+    if (threshold < COPY_MIN_THRESHOLD) threshold = COPY_MIN_THRESHOLD;
+    if (threshold > COPY_MAX_THRESHOLD) threshold = COPY_MAX_THRESHOLD;
+    return threshold;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         InitCopyEngine
+  
+  Description:  Pick the kernel and threshold on first use. Racing callers
+                compute the same result, so no lock is needed.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void InitCopyEngine(void) {
+    if (s_copyInitialized) {
+        return;
+    }
+
+#ifdef COPY_X86
+    s_supported = DetectKernels();
+#endif
+
+    s_kernel = OS_COPY_KERNEL_SCALAR;
+    for (u32 k = 0; k < NUM_KERNELS; k++) {
+        if (s_supported & (1u << k)) {
+            s_kernel = k;
+        }
+    }
+    s_streamThreshold = DefaultThreshold();
+    s_copyInitialized = TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSCopyMemoryPart
+  
+  Description:  Copy one piece of a larger transfer. The store type is
+                chosen by the size of the whole transfer, so a chunked
+                upload streams every chunk, not just the big ones.
+  
+  Arguments:    dst           Destination
+                src           Source (must not overlap dst)
+                size          Bytes to copy now
+                transferSize  Size of the whole transfer
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void OSCopyMemoryPart(void* dst, const void* src, u32 size, u32 transferSize) {
+    if (size < COPY_SMALL_SIZE) {
+        memcpy(dst, src, size);
+        return;
+    }
+    
+    InitCopyEngine();
+    
+    const CopyKernel* kernel = &s_kernels[s_kernel];
+    if (transferSize >= s_streamThreshold) {
+        kernel->streaming(dst, src, size);
+    } else {
+        kernel->cached(dst, src, size);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSCopyMemory
+  
+  Description:  Copy memory with the selected kernel, streaming transfers
+                at or above the threshold.
+  
+  Arguments:    dst   Destination
+                src   Source (must not overlap dst)
+                size  Bytes to copy
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void OSCopyMemory(void* dst, const void* src, u32 size) {
+    OSCopyMemoryPart(dst, src, size, size);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetCopyKernel
+  
+  Description:  Get the kernel used by OSCopyMemory.
+  
+  Arguments:    None
+  
+  Returns:      OS_COPY_KERNEL_* value
+ *---------------------------------------------------------------------------*/
+u32 OSGetCopyKernel(void) {
+    InitCopyEngine();
+    return s_kernel;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSIsCopyKernelSupported
+  
+  Description:  Check whether this CPU can run a kernel.
+  
+  Arguments:    kernel  OS_COPY_KERNEL_* value
+  
+  Returns:      TRUE if supported
+ *---------------------------------------------------------------------------*/
+BOOL OSIsCopyKernelSupported(u32 kernel) {
+    InitCopyEngine();
+    return kernel < NUM_KERNELS && (s_supported & (1u << kernel)) != 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSSetCopyKernel
+  
+  Description:  Force a kernel (for benchmarking or to rule one out).
+  
+  Arguments:    kernel  OS_COPY_KERNEL_* value
+  
+  Returns:      TRUE if set, FALSE if the CPU does not support it
+ *---------------------------------------------------------------------------*/
+BOOL OSSetCopyKernel(u32 kernel) {
+    if (!OSIsCopyKernelSupported(kernel)) {
+        return FALSE;
+    }
+    s_kernel = kernel;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetCopyKernelName
+  
+  Description:  Get a printable kernel name.
+  
+  Arguments:    kernel  OS_COPY_KERNEL_* value
+  
+  Returns:      Name, or "unavailable" for kernels not built on this host
+ *---------------------------------------------------------------------------*/
+const char* OSGetCopyKernelName(u32 kernel) {
+    return kernel < NUM_KERNELS ? s_kernels[kernel].name : "unavailable";
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetCopyStreamThreshold
+  
+  Description:  Get the size from which transfers use streaming stores.
+  
+  Arguments:    None
+  
+  Returns:      Threshold in bytes
+ *---------------------------------------------------------------------------*/
+u32 OSGetCopyStreamThreshold(void) {
+    InitCopyEngine();
+    return s_streamThreshold;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSSetCopyStreamThreshold
+  
+  Description:  Set the size from which transfers use streaming stores.
+                0 streams everything; 0xFFFFFFFF never streams.
+  
+  Arguments:    bytes  Threshold in bytes
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void OSSetCopyStreamThreshold(u32 bytes) {
+    InitCopyEngine();
+    s_streamThreshold = bytes;
+}
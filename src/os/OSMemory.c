@@ -60,102 +60,74 @@
   ✅ On PC, we have way more memory, but we simulate the limits
   ✅ OSAlloc uses these values to create arenas
   
-  **Memory Protection - COMPLEX:**
-  
-  Why We Can't Port It Directly:
-  
-  1. **No Hardware Registers** ❌
-     - No MEM_MARR registers on PC
-     - Can't configure protection at hardware level
-     - x86/ARM MMU works differently (page-based)
-  
-  2. **Page Granularity** ❌
-     - PowerPC: 1KB granularity (flexible)
-     - x86/x64: 4KB page granularity (coarse)
-     - Can't protect arbitrary 1KB blocks
-  
-  3. **OS-Level Protection** ❌
-     - Windows: VirtualProtect() (PAGE_READONLY, PAGE_READWRITE, etc.)
-     - Linux: mprotect() (PROT_READ, PROT_WRITE, PROT_EXEC)
-     - Requires page alignment (4KB boundaries)
-     - May not work with heap allocations
-  
-  4. **Exception Handling** ❌
-     - GC/Wii: MEM interrupt → MEMInterruptHandler()
-     - PC: Access violation → OS exception handler
-     - Hard to intercept and map to OSError system
-  
-  **What We CAN Do:**
-  
-  Option 1: **No-Op (Current Implementation)** ✅
-  - OSProtectRange does nothing
-  - Games that use it for debugging won't break
-  - No actual protection (but PC has OS-level protection anyway)
-  
-  Option 2: **Platform Protection (Advanced)** ⚠️
-  - Use VirtualProtect (Windows) / mprotect (Linux)
-  - Round addresses to page boundaries
-  - Set up exception handler to catch violations
-  - Map to OS_ERROR_PROTECTION
-  - Complex, platform-specific, may not work with all allocators
-  
-  Option 3: **Debug Mode Only** 🔍
-  - In debug builds, track protected ranges
-  - Insert checks in memory access wrappers
-  - Report violations (without hardware support)
-  - Zero overhead in release builds
-  
-  **Current Implementation:**
-  We use Option 1 (No-Op) because:
-  - Most games don't rely on memory protection
-  - Used mostly for debugging during development
-  - OS-level protection (DEP, ASLR) provides security on PC
-  - Simpler and more compatible
-  
-  MIGRATION NOTES:
-  ================
-  
-  **If your game uses OSProtectRange:**
-  
-  1. **For Debugging** (most common):
-     - Remove OSProtectRange calls
-     - Use debugger memory watchpoints instead
-     - PC debuggers have better tools (Visual Studio, GDB)
-  
-  2. **For Security** (rare):
-     - Rely on OS-level protection (DEP, W^X)
-     - Modern OSes prevent code modification by default
-     - Don't need explicit protection
-  
-  3. **For ROM Protection** (very rare):
-     - If protecting read-only data, use const keyword
-     - Compiler/OS will place in read-only section
-     - Hardware enforces it automatically
-  
-  4. **For Heap Protection** (advanced):
-     - Use platform APIs (VirtualProtect/mprotect)
-     - Implement custom wrapper if needed
-     - See FUTURE_MEMORY_PROTECTION.md (if created)
+  **Memory Protection - WATCHPOINTS (Linux x86-64):**
+  
+  The four channels are enforced with page protection and a SIGSEGV
+  handler, so stray accesses are caught at full speed everywhere else:
+  
+  - control is what the channel PERMITS, as on hardware: READ makes the
+    range read-only, NONE makes it inaccessible, RDWR turns the channel
+    off. The range is rounded to 1 KB like MEM_MARR.
+  - Every page the range touches is mprotect'ed (PROT_READ for
+    read-only, PROT_NONE otherwise; x86 pages cannot be write-only, so
+    WRITE-only channels fault on reads too and let them through).
+  - On a fault the handler checks the address against the 1 KB ranges.
+    A violation is counted, recorded (address, host PC, channels) and
+    dispatched to the OS_ERROR_PROTECTION handler as
+    handler(OS_ERROR_PROTECTION, context, cause, addr), like
+    MEMInterruptHandler, except that addr is the full host pointer
+    (void*, read with va_arg(ap, void*)), not a u32 physical address.
+    Without a handler it is only counted.
+  - Either way the access then completes: the page is opened, the trap
+    flag single-steps the one instruction, and the SIGTRAP that follows
+    protects the page again. Accesses to the rest of a watched page
+    (outside the range) cost the same fault + step and nothing else.
+  - Faults that are not ours go to the handler installed before
+    (e.g. GeckoMemory fastmem), and the other way round.
+  
+  Limitations: another thread touching the page during the one-
+  instruction window is not caught; system calls writing into a
+  protected page (read() into a buffer) fail with EFAULT instead of
+  faulting. A range on pages an active savestate tracks is refused
+  (GeckoSavestate.c protects them for its own use). Elsewhere
+  OSProtectRange only records the channels.
  *---------------------------------------------------------------------------*/
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* REG_ERR, REG_EFL, REG_RIP */
+#endif
+
 #include <dolphin/os.h>
+#include <dolphin/os_internal.h>
+#include <stdint.h>
 #include <string.h>
 
-/* Simulated memory sizes (matches real hardware) */
-#define SIMULATED_MEM1_SIZE  (24 * 1024 * 1024)  /* 24 MB */
-#define SIMULATED_MEM2_SIZE  (64 * 1024 * 1024)  /* 64 MB */
+#if defined(__linux__) && defined(__x86_64__)
+#define PROTECT_WATCH 1
+#include <dolphin/atomic_internal.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+/* Protection channels (MEM_MARR0-3) */
+#define NUM_CHANNELS        4
+#define PROTECT_GRANULE     1024        // MEM_MARR granularity
 
-/* Protection state tracking (for API compatibility and debug logging) */
-#ifdef _DEBUG
 typedef struct {
-    void* addr;
-    u32   size;
-    u32   control;
-    BOOL  active;
+    uintptr_t start;            // Rounded to PROTECT_GRANULE
+    uintptr_t end;
+    u32       control;          // Accesses permitted (OS_PROTECT_CONTROL_*)
+    BOOL      active;           // control != OS_PROTECT_CONTROL_RDWR
 } ProtectionChannel;
 
-static ProtectionChannel s_protectionChannels[4] = {0};
-#endif
+static ProtectionChannel s_protectionChannels[NUM_CHANNELS] = {0};
+
+/* Watchpoint statistics */
+static volatile u32 s_violations[NUM_CHANNELS];
+static volatile u32 s_pageFaults;
+static OSProtectFault s_lastFault[NUM_CHANNELS];
 
 /*---------------------------------------------------------------------------*
   Name:         OSGetPhysicalMem1Size
@@ -244,9 +216,234 @@ u32 OSGetConsoleSimulatedMem2Size(void) {
   MEMORY PROTECTION
   
   OSProtectRange() is a hardware-based memory protection system on GC/Wii.
-  On PC, we can't replicate it exactly, so we provide a compatible stub.
+  On Linux x86-64 the channels become page-protection watchpoints (see the
+  top of this file); elsewhere they are only recorded.
  *===========================================================================*/
 
+#ifdef PROTECT_WATCH
+
+#define MAX_STEP_PAGES      4           // Pages one instruction can open
+#define EFLAGS_TF           0x100       // Trap flag: single-step
+#define PF_WRITE            0x2         // Page fault error code: write access
+
+static uintptr_t s_pageSize;
+static BOOL s_handlersInstalled = FALSE;
+static struct sigaction s_prevSegv;
+static struct sigaction s_prevTrap;
+
+/* Pages opened for the instruction this thread is stepping */
+static __thread uintptr_t t_stepPages[MAX_STEP_PAGES];
+static __thread u32 t_stepCount;
+static __thread BOOL t_stepOverflow;     // Opened more pages than recorded
+
+static uintptr_t PageDown(uintptr_t addr) {
+    return addr & ~(s_pageSize - 1);
+}
+
+static uintptr_t PageUp(uintptr_t addr) {
+    return (addr + s_pageSize - 1) & ~(s_pageSize - 1);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PageProtection
+  
+  Description:  Host protection for one page: the strictest of the
+                channels whose range touches it. Called from the signal
+                handlers too.
+  
+  Arguments:    page  Page address
+  
+  Returns:      PROT_* flags (PROT_READ | PROT_WRITE if not watched)
+ *---------------------------------------------------------------------------*/
+static int PageProtection(uintptr_t page) {
+    int prot = PROT_READ | PROT_WRITE;
+    
+    for (u32 i = 0; i < NUM_CHANNELS; i++) {
+        const ProtectionChannel* ch = &s_protectionChannels[i];
+        if (ch->active && page < PageUp(ch->end) && page + s_pageSize > PageDown(ch->start)) {
+            // Read-only maps onto PROT_READ; x86 has no write-only pages
+            prot &= (ch->control == OS_PROTECT_CONTROL_READ) ? PROT_READ : PROT_NONE;
+        }
+    }
+    return prot;
+}
+
+/* Re-apply PageProtection over [lo, hi), one mprotect per run of pages */
+static void ApplyPages(uintptr_t lo, uintptr_t hi) {
+    uintptr_t runStart = lo;
+    int runProt = -1;
+    
+    for (uintptr_t page = lo; page < hi; page += s_pageSize) {
+        int prot = PageProtection(page);
+        if (prot != runProt) {
+            if (runProt >= 0) {
+                mprotect((void*)runStart, page - runStart, runProt);
+            }
+            runStart = page;
+            runProt = prot;
+        }
+    }
+    if (runProt >= 0) {
+        mprotect((void*)runStart, hi - runStart, runProt);
+    }
+}
+
+static void Chain(const struct sigaction* prev, int sig, siginfo_t* info, void* context) {
+    if (prev->sa_flags & SA_SIGINFO) {
+        prev->sa_sigaction(sig, info, context);
+    } else if (prev->sa_handler != SIG_DFL && prev->sa_handler != SIG_IGN) {
+        prev->sa_handler(sig);
+    } else {
+        /* Default action once this handler returns (the fault repeats;
+           a trap is raised again, blocked until then) */
+        struct sigaction dfl;
+        memset(&dfl, 0, sizeof(dfl));
+        dfl.sa_handler = SIG_DFL;
+        sigaction(sig, &dfl, NULL);
+        if (sig == SIGTRAP) {
+            raise(sig);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ProtectFault
+  
+  Description:  SIGSEGV handler. Faults on watched pages check the
+                channels, dispatch OS_ERROR_PROTECTION for a violation,
+                then open the page and single-step the access. Other
+                faults go to the handler installed before.
+  
+  Arguments:    sig      Signal number
+                info     Fault address
+                context  Interrupted context
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ProtectFault(int sig, siginfo_t* info, void* context) {
+    ucontext_t* uc = (ucontext_t*)context;
+    uintptr_t addr = (uintptr_t)info->si_addr;
+    uintptr_t page = PageDown(addr);
+    
+    if (info->si_code != SEGV_ACCERR || PageProtection(page) == (PROT_READ | PROT_WRITE)) {
+        Chain(&s_prevSegv, sig, info, context);
+        return;
+    }
+    
+    /* Another thread finishing its own step on the same page protected it
+       again under this instruction: reopen and retry, already counted */
+    for (u32 i = 0; i < t_stepCount; i++) {
+        if (t_stepPages[i] == page) {
+            mprotect((void*)page, s_pageSize, PROT_READ | PROT_WRITE);
+            return;
+        }
+    }
+    
+    BOOL write = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+    u32 need = write ? OS_PROTECT_CONTROL_WRITE : OS_PROTECT_CONTROL_READ;
+    u32 cause = 0;
+    
+    __AtomicAdd32(&s_pageFaults, 1);
+    for (u32 i = 0; i < NUM_CHANNELS; i++) {
+        const ProtectionChannel* ch = &s_protectionChannels[i];
+        if (ch->active && addr >= ch->start && addr < ch->end && !(ch->control & need)) {
+            cause |= OS_PROTECT0_BIT << i;
+            __AtomicAdd32(&s_violations[i], 1);
+            s_lastFault[i].addr = (void*)addr;
+            s_lastFault[i].pc = (void*)uc->uc_mcontext.gregs[REG_RIP];
+            s_lastFault[i].cause = OS_PROTECT0_BIT << i;
+            s_lastFault[i].write = write;
+        }
+    }
+    
+    if (cause) {
+        OSErrorHandler handler = __OSGetErrorHandler(OS_ERROR_PROTECTION);
+        if (handler) {
+            OSContext ctx;
+            memset(&ctx, 0, sizeof(ctx));
+            // Low 32 bits only; OSGetLastProtectFault has the full PC
+            ctx.srr0 = (u32)uc->uc_mcontext.gregs[REG_RIP];
+            ctx.gpr[1] = (u32)uc->uc_mcontext.gregs[REG_RSP];
+            ctx.state = OS_CONTEXT_STATE_EXC;
+            // Host pointer, as given to OSProtectRange: a u32 would truncate it
+            handler(OS_ERROR_PROTECTION, &ctx, cause, (void*)addr);
+        }
+    }
+    
+    /* Let the access through: open the page for one instruction. Past
+       MAX_STEP_PAGES the page goes unrecorded and StepTrap re-protects
+       every watched page instead. */
+    if (t_stepCount < MAX_STEP_PAGES) {
+        t_stepPages[t_stepCount++] = page;
+    } else {
+        t_stepOverflow = TRUE;
+    }
+    mprotect((void*)page, s_pageSize, PROT_READ | PROT_WRITE);
+    uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StepTrap
+  
+  Description:  SIGTRAP handler. After a stepped access, protect the
+                pages again and stop stepping. Other traps (debugger
+                breakpoints) go to the handler installed before.
+  
+  Arguments:    sig      Signal number
+                info     Trap details
+                context  Interrupted context
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StepTrap(int sig, siginfo_t* info, void* context) {
+    ucontext_t* uc = (ucontext_t*)context;
+    
+    if (t_stepCount == 0) {
+        Chain(&s_prevTrap, sig, info, context);
+        return;
+    }
+    
+    for (u32 i = 0; i < t_stepCount; i++) {
+        mprotect((void*)t_stepPages[i], s_pageSize, PageProtection(t_stepPages[i]));
+    }
+    if (t_stepOverflow) {
+        for (u32 i = 0; i < NUM_CHANNELS; i++) {
+            const ProtectionChannel* ch = &s_protectionChannels[i];
+            if (ch->active) {
+                ApplyPages(PageDown(ch->start), PageUp(ch->end));
+            }
+        }
+        t_stepOverflow = FALSE;
+    }
+    t_stepCount = 0;
+    uc->uc_mcontext.gregs[REG_EFL] &= ~(greg_t)EFLAGS_TF;
+}
+
+static BOOL InstallHandlers(void) {
+    struct sigaction sa;
+    
+    if (s_handlersInstalled) {
+        return TRUE;
+    }
+    
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_flags = SA_SIGINFO;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_sigaction = ProtectFault;
+    if (sigaction(SIGSEGV, &sa, &s_prevSegv) != 0) {
+        return FALSE;
+    }
+    sa.sa_sigaction = StepTrap;
+    if (sigaction(SIGTRAP, &sa, &s_prevTrap) != 0) {
+        sigaction(SIGSEGV, &s_prevSegv, NULL);
+        return FALSE;
+    }
+    s_handlersInstalled = TRUE;
+    return TRUE;
+}
+
+#endif // PROTECT_WATCH
+
 /*---------------------------------------------------------------------------*
   Name:         OSProtectRange
 
@@ -257,108 +454,184 @@ u32 OSGetConsoleSimulatedMem2Size(void) {
                 - 4 channels available (OS_PROTECT_CHAN0-3)
                 - Each protects one memory range
                 - 1KB granularity (addr & size rounded to 1KB)
-                - Protection types:
-                  * OS_PROTECT_CONTROL_NONE  - No protection
+                - control is the access the range still permits:
+                  * OS_PROTECT_CONTROL_NONE  - No access
                   * OS_PROTECT_CONTROL_READ  - Read-only
                   * OS_PROTECT_CONTROL_WRITE - Write-only
-                  * OS_PROTECT_CONTROL_RDWR  - Full protect
+                  * OS_PROTECT_CONTROL_RDWR  - Full access (channel off)
                 - Violation triggers MEM interrupt → OS_ERROR_PROTECTION
                 
-                On PC: STUB - No actual protection applied.
+                On PC (Linux x86-64): Page-protection watchpoint; see the
+                top of this file. Call from one thread at a time.
                 
-                Why not implemented:
-                - No MEM hardware controller on PC
-                - OS-level protection (VirtualProtect/mprotect) has different
-                  granularity (4KB pages vs 1KB)
-                - Most games use this for debugging, not critical functionality
-                - PC OSes provide their own memory protection (DEP, etc.)
+                Elsewhere: The channel is only recorded.
 
   Arguments:    chan    - Protection channel (0-3)
                 addr    - Start address (rounded down to 1KB boundary)
                 nBytes  - Size (addr+nBytes rounded up to 1KB boundary)
-                control - Protection flags (OS_PROTECT_CONTROL_*)
+                control - Permitted accesses (OS_PROTECT_CONTROL_*)
 
   Returns:      None
-  
-  Migration:
-  - For debugging: Use debugger memory watchpoints
-  - For security: Rely on OS protection (DEP, W^X)
-  - For ROM data: Use 'const' keyword
  *---------------------------------------------------------------------------*/
 void OSProtectRange(u32 chan, void* addr, u32 nBytes, u32 control) {
     /* Validate parameters (same as original) */
-    if (chan >= 4) {
+    if (chan >= NUM_CHANNELS) {
         return;
     }
     
-    /* Original hardware:
-     * 1. Flush data cache for the range (DCFlushRange)
-     * 2. Disable interrupts (OSDisableInterrupts)
-     * 3. Mask MEM interrupt for this channel
-     * 4. Configure MEM_MARR registers:
-     *    - MEM_MARR0_START/END for channel 0
-     *    - MEM_MARR1_START/END for channel 1
-     *    - MEM_MARR2_START/END for channel 2
-     *    - MEM_MARR3_START/END for channel 3
-     * 5. Set MEM_MARR_CONTROL with protection bits
-     * 6. Unmask MEM interrupt for this channel
-     * 7. Restore interrupts
-     * 
-     * PC: Can't configure hardware. Just track for debugging.
-     */
+    ProtectionChannel* ch = &s_protectionChannels[chan];
+    uintptr_t start = (uintptr_t)addr & ~(uintptr_t)(PROTECT_GRANULE - 1);
+    uintptr_t end = ((uintptr_t)addr + nBytes + PROTECT_GRANULE - 1) &
+                    ~(uintptr_t)(PROTECT_GRANULE - 1);
     
-#ifdef _DEBUG
-    /* Debug mode: Track protection ranges for logging/validation */
-    u32 start = (u32)addr & ~0x3FF;  /* Round down to 1KB */
-    u32 end = ((u32)addr + nBytes + 0x3FF) & ~0x3FF;  /* Round up to 1KB */
+    control &= OS_PROTECT_CONTROL_RDWR;
+
+#ifdef PROTECT_WATCH
+    if (s_pageSize == 0) {
+        s_pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    }
     
-    s_protectionChannels[chan].addr = (void*)start;
-    s_protectionChannels[chan].size = end - start;
-    s_protectionChannels[chan].control = control & OS_PROTECT_CONTROL_RDWR;
-    s_protectionChannels[chan].active = (control != OS_PROTECT_CONTROL_NONE);
+    // Savestate tracking mprotects its pages too; each would undo the other
+    if (control != OS_PROTECT_CONTROL_RDWR && end > start &&
+        __GeckoSavestateIsTracked((void*)PageDown(start), (u32)(PageUp(end) - PageDown(start)))) {
+        OSReport("OSProtectRange: Channel %u overlaps memory tracked by a savestate; not changed\n", chan);
+        return;
+    }
+    if (control != OS_PROTECT_CONTROL_RDWR && !InstallHandlers()) {
+        OSReport("OSProtectRange: Could not install the fault handlers\n");
+        return;
+    }
     
-    const char* controlStr = "NONE";
-    if (control == OS_PROTECT_CONTROL_READ) {
-        controlStr = "READ-ONLY";
-    } else if (control == OS_PROTECT_CONTROL_WRITE) {
-        controlStr = "WRITE-ONLY";
-    } else if (control == OS_PROTECT_CONTROL_RDWR) {
-        controlStr = "READ/WRITE (FULL)";
+    // Pages of the old range lose this channel's protection
+    uintptr_t oldLo = ch->active ? PageDown(ch->start) : 0;
+    uintptr_t oldHi = ch->active ? PageUp(ch->end) : 0;
+    ch->active = FALSE;
+    if (oldHi > oldLo) {
+        ApplyPages(oldLo, oldHi);
+    }
+#endif
+
+    ch->start = start;
+    ch->end = end;
+    ch->control = control;
+    ch->active = (control != OS_PROTECT_CONTROL_RDWR) && end > start;
+
+#ifdef PROTECT_WATCH
+    if (ch->active) {
+        ApplyPages(PageDown(start), PageUp(end));
     }
+#endif
+
+#ifdef _DEBUG
+    static const char* s_controlNames[] = { "NO ACCESS", "READ-ONLY", "WRITE-ONLY", "OFF" };
     
-    if (s_protectionChannels[chan].active) {
-        OSReport("[OSMemory] Channel %u: Protect 0x%08X - 0x%08X (%u bytes) [%s]\n",
-                 chan, start, end, end - start, controlStr);
-        OSReport("            NOTE: Protection is NOT enforced on PC!\n");
-        OSReport("            Use debugger watchpoints for memory debugging.\n");
+    if (ch->active) {
+        OSReport("[OSMemory] Channel %u: Protect %p - %p (%u bytes) [%s]\n",
+                 chan, (void*)start, (void*)end, (u32)(end - start), s_controlNames[control]);
+#ifndef PROTECT_WATCH
+        OSReport("            NOTE: Protection is NOT enforced on this platform!\n");
+#endif
     } else {
         OSReport("[OSMemory] Channel %u: Protection disabled\n", chan);
     }
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __OSIsRangeWatched (Internal)
+  
+  Description:  Check whether an enforced channel protects a page of a
+                host range.
+  
+  Arguments:    addr  Host address
+                size  Bytes
+  
+  Returns:      TRUE if a watched page overlaps the range
+ *---------------------------------------------------------------------------*/
+BOOL __OSIsRangeWatched(const void* addr, u32 size) {
+#ifdef PROTECT_WATCH
+    uintptr_t lo = (uintptr_t)addr;
+    uintptr_t hi = lo + size;
+    
+    for (u32 i = 0; i < NUM_CHANNELS; i++) {
+        const ProtectionChannel* ch = &s_protectionChannels[i];
+        if (ch->active && lo < PageUp(ch->end) && hi > PageDown(ch->start)) {
+            return TRUE;
+        }
+    }
 #else
-    /* Release mode: No-op (zero overhead) */
-    (void)chan;
     (void)addr;
-    (void)nBytes;
-    (void)control;
+    (void)size;
 #endif
-    
-    /* TODO (Advanced): Platform-specific memory protection
-     * 
-     * Windows example:
-     * DWORD oldProtect;
-     * VirtualProtect(addr, nBytes, PAGE_READONLY, &oldProtect);
-     * 
-     * Linux example:
-     * mprotect(addr, nBytes, PROT_READ);
-     * 
-     * Issues:
-     * - Requires page alignment (4KB on x86/x64)
-     * - May not work with heap allocations
-     * - Needs exception handler to map violations to OS_ERROR_PROTECTION
-     * - Platform-specific code
-     * 
-     * For now, we leave it as a no-op for maximum compatibility.
-     */
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetProtectFaultCount (PC extension)
+  
+  Description:  Number of accesses that violated a channel since the last
+                OSResetProtectStats. Accesses to the rest of a watched
+                page are not counted here.
+  
+  Arguments:    chan  Protection channel (0-3)
+  
+  Returns:      Violation count
+ *---------------------------------------------------------------------------*/
+u32 OSGetProtectFaultCount(u32 chan) {
+    if (chan >= NUM_CHANNELS) {
+        return 0;
+    }
+#ifdef PROTECT_WATCH
+    return __AtomicLoad32(&s_violations[chan]);
+#else
+    return s_violations[chan];
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetLastProtectFault (PC extension)
+  
+  Description:  The most recent violation of a channel.
+  
+  Arguments:    chan   Protection channel (0-3)
+                fault  Receives the address, host PC and access type
+  
+  Returns:      FALSE if the channel has no violation recorded
+ *---------------------------------------------------------------------------*/
+BOOL OSGetLastProtectFault(u32 chan, OSProtectFault* fault) {
+    if (chan >= NUM_CHANNELS || !fault || OSGetProtectFaultCount(chan) == 0) {
+        return FALSE;
+    }
+    *fault = s_lastFault[chan];
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetProtectPageFaultCount (PC extension)
+  
+  Description:  Every fault taken on a watched page, including accesses
+                outside the ranges that share a page with them. Compared
+                with the violation counts, this is the overhead a range
+                that is not page aligned costs.
+  
+  Arguments:    None
+  
+  Returns:      Fault count
+ *---------------------------------------------------------------------------*/
+u32 OSGetProtectPageFaultCount(void) {
+#ifdef PROTECT_WATCH
+    return __AtomicLoad32(&s_pageFaults);
+#else
+    return s_pageFaults;
+#endif
+}
+
+void OSResetProtectStats(void) {
+    for (u32 i = 0; i < NUM_CHANNELS; i++) {
+        s_violations[i] = 0;
+        memset(&s_lastFault[i], 0, sizeof(s_lastFault[i]));
+    }
+    s_pageFaults = 0;
 }
 
 /*---------------------------------------------------------------------------*
@@ -376,10 +649,11 @@ void OSProtectRange(u32 chan, void* addr, u32 nBytes, u32 control) {
   Arguments:    None
  *---------------------------------------------------------------------------*/
 void __OSMemoryInit(void) {
+    /* Channels start off (static storage); they are not cleared here, so
+       pages protected by an earlier OSProtectRange stay consistent */
+    OSResetProtectStats();
+
 #ifdef _DEBUG
-    /* Clear protection channels */
-    memset(s_protectionChannels, 0, sizeof(s_protectionChannels));
-    
     OSReport("[OSMemory] Initialized\n");
     OSReport("           MEM1: %u MB (%u bytes)\n",
              SIMULATED_MEM1_SIZE / (1024*1024), SIMULATED_MEM1_SIZE);
@@ -392,63 +666,6 @@ void __OSMemoryInit(void) {
      * - Masks all MEM interrupts initially
      * - Registers shutdown function to disable protection on reset
      * 
-     * PC: No interrupts to register, no shutdown needed.
+     * PC: The fault handlers are installed by the first OSProtectRange.
      */
 }
-
-/*---------------------------------------------------------------------------*
-  FUTURE ENHANCEMENT: Platform Memory Protection
-  
-  If you need real memory protection on PC, you could implement:
-  
-  Windows (VirtualProtect):
-  -------------------------
-  DWORD FlipperToPlatformProtection(u32 control) {
-      if (control == OS_PROTECT_CONTROL_NONE) return PAGE_READWRITE;
-      if (control == OS_PROTECT_CONTROL_READ) return PAGE_READONLY;
-      if (control == OS_PROTECT_CONTROL_WRITE) return PAGE_WRITECOPY;
-      if (control == OS_PROTECT_CONTROL_RDWR) return PAGE_NOACCESS;
-      return PAGE_READWRITE;
-  }
-  
-  void OSProtectRange(u32 chan, void* addr, u32 nBytes, u32 control) {
-      // Round to page boundaries (4KB)
-      void* pageAddr = (void*)((uintptr_t)addr & ~0xFFF);
-      size_t pageSize = (nBytes + 0xFFF) & ~0xFFF;
-      
-      DWORD protect = FlipperToPlatformProtection(control);
-      DWORD oldProtect;
-      
-      if (!VirtualProtect(pageAddr, pageSize, protect, &oldProtect)) {
-          OSReport("VirtualProtect failed: %u\n", GetLastError());
-      }
-  }
-  
-  Linux (mprotect):
-  -----------------
-  int FlipperToPlatformProtection(u32 control) {
-      if (control == OS_PROTECT_CONTROL_NONE) return PROT_READ | PROT_WRITE;
-      if (control == OS_PROTECT_CONTROL_READ) return PROT_READ;
-      if (control == OS_PROTECT_CONTROL_WRITE) return PROT_WRITE;
-      if (control == OS_PROTECT_CONTROL_RDWR) return PROT_NONE;
-      return PROT_READ | PROT_WRITE;
-  }
-  
-  void OSProtectRange(u32 chan, void* addr, u32 nBytes, u32 control) {
-      // Round to page boundaries
-      void* pageAddr = (void*)((uintptr_t)addr & ~0xFFF);
-      size_t pageSize = (nBytes + 0xFFF) & ~0xFFF;
-      
-      int prot = FlipperToPlatformProtection(control);
-      
-      if (mprotect(pageAddr, pageSize, prot) != 0) {
-          OSReport("mprotect failed: %s\n", strerror(errno));
-      }
-  }
-  
-  Exception Handling:
-  -------------------
-  You'd also need to set up platform exception handlers to catch
-  access violations and map them to OS_ERROR_PROTECTION.
-  See OSError.c for details on exception handling integration.
- *---------------------------------------------------------------------------*/
@@ -0,0 +1,532 @@
+/*---------------------------------------------------------------------------*
+  OSSharedMemory.c - Shared Memory Regions and Message Rings
+  
+  On GC/Wii: The DSP reads sample data straight from ARAM while the CPU
+             keeps running; a hitch on the CPU cannot stall audio.
+  
+  On PC: To get the same isolation, the audio mixer can run in its own
+         process. ARAM (and optionally MEM1/MEM2) then lives in a named
+         shared memory object instead of the heap, so the mixer maps the
+         same pages and reads samples in place.
+  
+  LAYOUT (one object):
+    Header       magic, version, region offsets and sizes, peer flags
+    Ring 0       creator -> attached process (commands)
+    Ring 1       attached process -> creator (notifications)
+    Regions      MEM1, MEM2, ARAM (requested ones only, page aligned)
+  
+  RINGS:
+  - Single producer, single consumer, fixed 32-byte messages
+  - Monotonic head/tail counters (wrap via mask) on separate cache lines,
+    published with release stores and read with acquire loads, so they
+    work across processes without locks or system calls
+  - Each process sends on its own ring and polls the other
+  
+  Linux/macOS use POSIX shm_open (the name is visible to other processes,
+  which an unnamed memfd is not); Windows uses a named file mapping.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/os.h>
+#include <dolphin/ar.h>
+#include <dolphin/os_internal.h>
+#include <dolphin/atomic_internal.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Layout
+ *---------------------------------------------------------------------------*/
+
+#define SHARED_MAGIC        0x50525053  // 'PRPS'
+#define SHARED_VERSION      1
+#define SHARED_REGION_ALIGN 0x10000     // Page (and Windows granularity) aligned
+#define SHARED_RING_MASK    (OS_SHARED_RING_ENTRIES - 1)
+#define SHARED_NUM_REGIONS  3           // MEM1, MEM2, ARAM
+
+typedef struct SharedRing {
+    volatile u32    head;               // Producer: messages written
+    u8              pad0[60];
+    volatile u32    tail;               // Consumer: messages read
+    u8              pad1[60];
+    OSSharedMessage slots[OS_SHARED_RING_ENTRIES];
+} SharedRing;
+
+typedef struct SharedHeader {
+    u32             magic;
+    u32             version;
+    u32             totalSize;
+    u32             regions;            // OS_SHARED_* mask
+    u32             regionOffset[SHARED_NUM_REGIONS];
+    u32             regionSize[SHARED_NUM_REGIONS];
+    volatile u32    creatorAlive;
+    volatile u32    peers;              // Attached processes
+    u8              pad[64];
+    SharedRing      rings[2];
+} SharedHeader;
+
+static const u32 s_regionSizes[SHARED_NUM_REGIONS] = {
+    SIMULATED_MEM1_SIZE, SIMULATED_MEM2_SIZE, AR_INTERNAL_SIZE
+};
+
+/*---------------------------------------------------------------------------*
+    Named Objects
+ *---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*
+  Name:         MakeName
+  
+  Description:  Build the platform object name ("/name" for POSIX,
+                "Local\name" for Windows).
+  
+  Arguments:    mem   Object to name
+                name  Name given by the caller
+  
+  Returns:      FALSE if the name is empty or too long
+ *---------------------------------------------------------------------------*/
+static BOOL MakeName(__OSNamedMemory* mem, const char* name) {
+    if (!name || !name[0]) {
+        return FALSE;
+    }
+
+#ifdef _WIN32
+    int len = snprintf(mem->name, sizeof(mem->name), "Local\\%s", name);
+#else
+    int len = snprintf(mem->name, sizeof(mem->name), "%s%s",
+                       name[0] == '/' ? "" : "/", name);
+#endif
+    return len > 0 && len < (int)sizeof(mem->name);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __OSCreateNamedMemory
+  
+  Description:  Create a named object and map it, zero-filled.
+                
+                POSIX names outlive their processes, so one left by a
+                crashed run is unlinked first; a process that still has
+                it mapped keeps the old pages. A Windows object only
+                exists while a process has it open: if one does, the
+                object is reused and cleared, and fails if it is smaller
+                than size.
+  
+  Arguments:    mem   Receives the mapping
+                name  Object name
+                size  Bytes to map
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+BOOL __OSCreateNamedMemory(__OSNamedMemory* mem, const char* name, u32 size) {
+    memset(mem, 0, sizeof(*mem));
+    if (!MakeName(mem, name) || size == 0) {
+        return FALSE;
+    }
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        0, size, mem->name);
+    if (!mapping) {
+        return FALSE;
+    }
+    BOOL reused = GetLastError() == ERROR_ALREADY_EXISTS;
+    
+    // Fails if a reused object is smaller than size
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!base) {
+        CloseHandle(mapping);
+        return FALSE;
+    }
+    if (reused) {
+        memset(base, 0, size);
+    }
+    mem->mapping = mapping;
+#else
+    shm_unlink(mem->name);  // Left behind by a crashed run
+    int fd = shm_open(mem->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0 && ftruncate(fd, size) != 0) {
+        close(fd);
+        shm_unlink(mem->name);
+        fd = -1;
+    }
+    if (fd < 0) {
+        return FALSE;
+    }
+    
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(mem->name);
+        return FALSE;
+    }
+#endif
+    
+    mem->base = base;
+    mem->size = size;
+    mem->creator = TRUE;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __OSOpenNamedMemory
+  
+  Description:  Map the whole of an object created by another process.
+  
+  Arguments:    mem   Receives the mapping; mem->size is the object size
+                name  Object name
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+BOOL __OSOpenNamedMemory(__OSNamedMemory* mem, const char* name) {
+    memset(mem, 0, sizeof(*mem));
+    if (!MakeName(mem, name)) {
+        return FALSE;
+    }
+
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mem->name);
+    if (!mapping) {
+        return FALSE;
+    }
+    
+    // A view of size 0 maps the whole object
+    MEMORY_BASIC_INFORMATION info;
+    void* base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!base || VirtualQuery(base, &info, sizeof(info)) == 0 ||
+        (u64)info.RegionSize > 0xFFFFFFFFu) {
+        if (base) {
+            UnmapViewOfFile(base);
+        }
+        CloseHandle(mapping);
+        return FALSE;
+    }
+    mem->mapping = mapping;
+    mem->size = (u32)info.RegionSize;
+#else
+    int fd = shm_open(mem->name, O_RDWR, 0);
+    if (fd < 0) {
+        return FALSE;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (u64)st.st_size > 0xFFFFFFFFu) {
+        close(fd);
+        return FALSE;
+    }
+    
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return FALSE;
+    }
+    mem->size = (u32)st.st_size;
+#endif
+    
+    mem->base = base;
+    mem->creator = FALSE;
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __OSCloseNamedMemory
+  
+  Description:  Unmap an object. The creator also removes the name;
+                processes that still have it mapped keep their view.
+  
+  Arguments:    mem  Mapping to close
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __OSCloseNamedMemory(__OSNamedMemory* mem) {
+    if (!mem->base) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(mem->base);
+    CloseHandle((HANDLE)mem->mapping);
+    mem->mapping = NULL;
+#else
+    munmap(mem->base, mem->size);
+    if (mem->creator) {
+        shm_unlink(mem->name);
+    }
+#endif
+    mem->base = NULL;
+    mem->size = 0;
+}
+
+/*---------------------------------------------------------------------------*
+    Internal State
+ *---------------------------------------------------------------------------*/
+
+static __OSNamedMemory s_object;
+static SharedHeader* s_shared = NULL;
+static BOOL s_isCreator = FALSE;
+
+static u32 RegionIndex(u32 region) {
+    switch (region) {
+        case OS_SHARED_MEM1: return 0;
+        case OS_SHARED_MEM2: return 1;
+        case OS_SHARED_ARAM: return 2;
+        default:             return SHARED_NUM_REGIONS;
+    }
+}
+
+static void CloseShared(void) {
+    __OSCloseNamedMemory(&s_object);
+    s_shared = NULL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ValidateHeader
+  
+  Description:  Check an attached object's header before anything uses
+                it: every region must have its expected size and lie
+                inside the mapping, after the header.
+  
+  Arguments:    header  Mapped header
+                size    Bytes mapped
+  
+  Returns:      TRUE if the layout is usable
+ *---------------------------------------------------------------------------*/
+static BOOL ValidateHeader(const SharedHeader* header, u32 size) {
+    if (size < sizeof(SharedHeader) ||
+        __AtomicLoad32((volatile u32*)&header->magic) != SHARED_MAGIC ||
+        header->version != SHARED_VERSION || header->totalSize > size) {
+        return FALSE;
+    }
+    
+    for (u32 i = 0; i < SHARED_NUM_REGIONS; i++) {
+        u64 offset = header->regionOffset[i];
+        u64 length = header->regionSize[i];
+        
+        if (!(header->regions & (1u << i))) {
+            if (length != 0) {
+                return FALSE;
+            }
+            continue;
+        }
+        if (length != s_regionSizes[i] || offset < sizeof(SharedHeader) ||
+            offset + length > header->totalSize) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSCreateSharedMemory
+  
+  Description:  Create the shared object with the requested regions. Call
+                before OSInit (MEM1/MEM2) and ARInit (ARAM); they pick up
+                the shared regions instead of allocating from the heap.
+  
+  Arguments:    name     Object name (e.g. "porpoise"); an object left
+                         under this name is replaced (see
+                         __OSCreateNamedMemory)
+                regions  OS_SHARED_MEM1 | OS_SHARED_MEM2 | OS_SHARED_ARAM
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+BOOL OSCreateSharedMemory(const char* name, u32 regions) {
+    if (s_shared) {
+        OSReport("OS: Shared memory already open\n");
+        return FALSE;
+    }
+    if (!name || !name[0] || !(regions & (OS_SHARED_MEM1 | OS_SHARED_MEM2 | OS_SHARED_ARAM))) {
+        OSReport("OS: OSCreateSharedMemory: Invalid name or regions\n");
+        return FALSE;
+    }
+    
+    u32 offsets[SHARED_NUM_REGIONS] = { 0 };
+    u32 total = (sizeof(SharedHeader) + SHARED_REGION_ALIGN - 1) & ~(SHARED_REGION_ALIGN - 1);
+    for (u32 i = 0; i < SHARED_NUM_REGIONS; i++) {
+        if (regions & (1u << i)) {
+            offsets[i] = total;
+            total += s_regionSizes[i];
+        }
+    }
+    
+    if (!__OSCreateNamedMemory(&s_object, name, total)) {
+        OSReport("OS: Failed to create shared memory '%s'\n", s_object.name);
+        return FALSE;
+    }
+    SharedHeader* header = (SharedHeader*)s_object.base;
+    
+    // New objects are zero-filled; the header is published last
+    header->version = SHARED_VERSION;
+    header->totalSize = total;
+    header->regions = regions;
+    for (u32 i = 0; i < SHARED_NUM_REGIONS; i++) {
+        header->regionOffset[i] = offsets[i];
+        header->regionSize[i] = (regions & (1u << i)) ? s_regionSizes[i] : 0;
+    }
+    header->creatorAlive = TRUE;
+    __AtomicStore32(&header->magic, SHARED_MAGIC);
+    
+    s_shared = header;
+    s_isCreator = TRUE;
+    
+    OSReport("OS: Shared memory '%s' created (%u MB)\n", s_object.name, total / (1024 * 1024));
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSAttachSharedMemory
+  
+  Description:  Map a shared object created by another process.
+  
+  Arguments:    name  Name passed to OSCreateSharedMemory
+  
+  Returns:      TRUE on success
+ *---------------------------------------------------------------------------*/
+BOOL OSAttachSharedMemory(const char* name) {
+    if (s_shared) {
+        OSReport("OS: Shared memory already open\n");
+        return FALSE;
+    }
+    if (!__OSOpenNamedMemory(&s_object, name)) {
+        return FALSE;
+    }
+    
+    // A stale or foreign object must not yield regions outside the mapping
+    SharedHeader* header = (SharedHeader*)s_object.base;
+    if (!ValidateHeader(header, s_object.size)) {
+        OSReport("OS: '%s' is not a compatible shared memory object\n", s_object.name);
+        __OSCloseNamedMemory(&s_object);
+        return FALSE;
+    }
+    
+    s_shared = header;
+    s_isCreator = FALSE;
+    __AtomicAdd32(&header->peers, 1);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSDetachSharedMemory
+  
+  Description:  Unmap the shared object. The creator also removes the
+                name; processes that still have it mapped keep their view.
+                Do not call while OSInit/ARInit memory is still in use.
+  
+  Arguments:    None
+  
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void OSDetachSharedMemory(void) {
+    if (!s_shared) {
+        return;
+    }
+    
+    if (s_isCreator) {
+        __AtomicStore32(&s_shared->creatorAlive, FALSE);
+    } else {
+        __AtomicAdd32(&s_shared->peers, (u32)-1);
+    }
+    CloseShared();
+    s_isCreator = FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSGetSharedRegion
+  
+  Description:  Get where a region is mapped in this process.
+  
+  Arguments:    region  OS_SHARED_MEM1, OS_SHARED_MEM2 or OS_SHARED_ARAM
+                size    Receives the region size (can be NULL)
+  
+  Returns:      Region base, or NULL if the region is not shared
+ *---------------------------------------------------------------------------*/
+void* OSGetSharedRegion(u32 region, u32* size) {
+    u32 index = RegionIndex(region);
+    
+    if (!s_shared || index == SHARED_NUM_REGIONS || !s_shared->regionSize[index]) {
+        if (size) *size = 0;
+        return NULL;
+    }
+    
+    if (size) *size = s_shared->regionSize[index];
+    return (u8*)s_shared + s_shared->regionOffset[index];
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSIsSharedPeerAttached
+  
+  Description:  Check for the other side. For the creator: has another
+                process attached? For an attached process: is the
+                creator still there (it clears the flag on detach)?
+  
+  Arguments:    None
+  
+  Returns:      TRUE if the other side is present
+ *---------------------------------------------------------------------------*/
+BOOL OSIsSharedPeerAttached(void) {
+    if (!s_shared) {
+        return FALSE;
+    }
+    return s_isCreator ? __AtomicLoad32(&s_shared->peers) != 0
+                       : __AtomicLoad32(&s_shared->creatorAlive) != 0;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSSendSharedMessage
+  
+  Description:  Post a message to the other process. Lock-free and never
+                blocks; only one thread per process may send.
+  
+  Arguments:    msg  Message to copy into the ring
+  
+  Returns:      FALSE if not open or the ring is full
+ *---------------------------------------------------------------------------*/
+BOOL OSSendSharedMessage(const OSSharedMessage* msg) {
+    if (!s_shared || !msg) {
+        return FALSE;
+    }
+    
+    SharedRing* ring = &s_shared->rings[s_isCreator ? 0 : 1];
+    u32 head = ring->head;  // Only we write it
+    
+    if (head - __AtomicLoad32(&ring->tail) >= OS_SHARED_RING_ENTRIES) {
+        return FALSE;
+    }
+    
+    ring->slots[head & SHARED_RING_MASK] = *msg;
+    __AtomicStore32(&ring->head, head + 1);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OSReceiveSharedMessage
+  
+  Description:  Take the next message from the other process. Lock-free
+                and never blocks; only one thread per process may receive.
+  
+  Arguments:    msg  Receives the message
+  
+  Returns:      FALSE if not open or no message is waiting
+ *---------------------------------------------------------------------------*/
+BOOL OSReceiveSharedMessage(OSSharedMessage* msg) {
+    if (!s_shared || !msg) {
+        return FALSE;
+    }
+    
+    SharedRing* ring = &s_shared->rings[s_isCreator ? 1 : 0];
+    u32 tail = ring->tail;  // Only we write it
+    
+    if (tail == __AtomicLoad32(&ring->head)) {
+        return FALSE;
+    }
+    
+    *msg = ring->slots[tail & SHARED_RING_MASK];
+    __AtomicStore32(&ring->tail, tail + 1);
+    return TRUE;
+}
@@ -51,9 +51,9 @@
   - Convert to 40.5 MHz equivalent
   
   Linux/Mac:
-  - `gettimeofday()` - Microsecond precision
+  - `clock_gettime(CLOCK_MONOTONIC)` - Nanosecond precision
   - Convert to 40.5 MHz ticks
-  - Or `clock_gettime(CLOCK_MONOTONIC)` for better precision
+  - Unaffected by wall-clock adjustments
   
   **Conversion:**
   ```c
@@ -61,7 +61,7 @@
   ticks = (counter * 40500000) / frequency
   
   // Linux
-  ticks = (seconds * 40500000) + (microseconds * 40.5)
+  ticks = (seconds * 40500000) + (nanoseconds * 81 / 2000)
   ```
   
   CALENDAR TIME SYSTEM:
@@ -174,6 +174,25 @@ static OSTime s_startTime = 0;
 static OSTime s_systemTimeBase = 0;  /* Adjustment for system time */
 static BOOL s_timeInitialized = FALSE;
 
+#ifndef _WIN32
+/*---------------------------------------------------------------------------*
+  Name:         ReadMonotonicTicks (Internal)
+  
+  Description:  Reads CLOCK_MONOTONIC and converts it to 40.5 MHz ticks.
+                Nanosecond resolution keeps short intervals (e.g. timing a
+                single decoded audio block) meaningful, and the clock never
+                jumps when the wall clock is adjusted.
+  
+  Returns:      Monotonic time in 40.5 MHz ticks
+ *---------------------------------------------------------------------------*/
+static OSTime ReadMonotonicTicks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    /* 40.5 ticks per microsecond = 81 ticks per 2000 ns */
+    return (OSTime)ts.tv_sec * OS_TIMER_CLOCK + ((OSTime)ts.tv_nsec * 81) / 2000;
+}
+#endif
+
 /*---------------------------------------------------------------------------*
   Name:         __OSInitTime (Internal)
 
@@ -191,11 +210,7 @@ static void __OSInitTime(void) {
     /* Convert to 40.5 MHz ticks */
     s_startTime = (OSTime)((counter.QuadPart * OS_TIMER_CLOCK) / freq.QuadPart);
 #else
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    /* Convert to 40.5 MHz ticks */
-    s_startTime = (OSTime)(tv.tv_sec * OS_TIMER_CLOCK) + 
-                  (OSTime)(tv.tv_usec * (OS_TIMER_CLOCK / 1000000));
+    s_startTime = ReadMonotonicTicks();
 #endif
     
     s_systemTimeBase = 0;
@@ -231,11 +246,7 @@ OSTime OSGetTime(void) {
     OSTime currentTime = (OSTime)((counter.QuadPart * OS_TIMER_CLOCK) / freq.QuadPart);
     return currentTime - s_startTime;
 #else
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    OSTime currentTime = (OSTime)(tv.tv_sec * OS_TIMER_CLOCK) + 
-                         (OSTime)(tv.tv_usec * (OS_TIMER_CLOCK / 1000000));
-    return currentTime - s_startTime;
+    return ReadMonotonicTicks() - s_startTime;
 #endif
 }
 
@@ -19,13 +19,15 @@
   On PC (SDL2 Gamepad System):
   -----------------------------
   - Modern gamepads via SDL2 (Xbox, PlayStation, Switch Pro, etc.)
-  - Manual polling via SDL_GameControllerGetButton/GetAxis
-  - No hardware DMA - direct API calls
+  - A sampling thread polls SDL2 at the sampling rate (1ms default)
+  - No hardware DMA - the latest sample is kept in a seqlock
   - SDL2 handles device detection and hotplug
   - Analog values from SDL2 axes (-32768 to 32767)
   - No wireless pairing - OS handles Bluetooth
   - Origin calibration simulated in software
   - Keyboard fallback for Player 1 (no controller needed)
+  - Virtual controllers: channels can take frames from a test harness
+    instead (PADVirtual.c), with no SDL needed when all four do
   - Rumble via SDL2 Haptic API
   
   WHY THE DIFFERENCE:
@@ -44,11 +46,13 @@
   - Analog modes
   
   WHAT'S DIFFERENT:
-  - No SI hardware polling - we poll SDL2 in PADRead()
+  - No SI hardware polling - a thread polls SDL2 and PADRead() copies
+    the freshest sample, so it costs no SDL calls on the game thread
   - No hardware DMA - we fill PADStatus manually
   - Keyboard fallback option (original didn't have this)
   - SDL2 controller mapping (more flexible than SI)
-  - Rumble intensity/duration controlled via SDL2 Haptic
+  - Rumble via a worker thread holding the haptic devices open; motor
+    commands are queued and coalesced, so repeating one costs nothing
   - No wireless pairing commands (OS handles it)
   
   KEYBOARD FALLBACK:
@@ -61,12 +65,20 @@
  *---------------------------------------------------------------------------*/
 
 #include <dolphin/pad.h>
+#include <dolphin/pad_internal.h>
 #include <dolphin/PADConfig.h>
 #include <dolphin/os.h>
+#include <dolphin/atomic_internal.h>
 #include <string.h>
 #include <stdlib.h>
 #include <SDL.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 /*---------------------------------------------------------------------------*
     Internal State
  *---------------------------------------------------------------------------*/
@@ -85,20 +97,204 @@ static PADStatus s_origin[PAD_MAX_CONTROLLERS];
 static u32 s_enabled_bits = 0;          // OR-ed PAD_CHANn_BIT of enabled channels
 static u32 s_resetting_bits = 0;        // OR-ed PAD_CHANn_BIT of resetting channels
 static u32 s_waiting_bits = 0;          // OR-ed PAD_CHANn_BIT waiting for connection
+static u32 s_virtual_bits = 0;          // OR-ed PAD_CHANn_BIT reading PAD_SOURCE_VIRTUAL
 
 // Analog mode (controls which analog inputs are active)
 // Mode 3 (default) = full stick + triggers, no analog A/B
 static u32 s_analog_mode = PAD_MODE_3;
 
-// Sampling callback (called during PADRead)
+// Sampling callback (called on the sampling thread after each sample)
 static PADSamplingCallback s_sampling_callback = NULL;
 
+// Set while this thread runs the sampling callback. Its PADRead calls
+// follow the sampling rate, not the game, so input traces and latency
+// statistics skip them.
+#ifdef _MSC_VER
+static __declspec(thread) BOOL t_inCallback = FALSE;
+#else
+static __thread BOOL t_inCallback = FALSE;
+#endif
+
 // Keyboard fallback state (for channel 0 only)
 static struct {
     BOOL enabled;                        // TRUE if using keyboard
     const Uint8* keys;                   // Keyboard state array
 } s_keyboard;
 
+/*---------------------------------------------------------------------------*
+    Sampling Thread
+ *---------------------------------------------------------------------------*/
+
+#define SAMPLING_RATE_DEFAULT   1       // ms between samples
+#define SAMPLING_RATE_MAX       11      // ms, the SI limit
+#define SAMPLING_FIELD_US       16683   // Rate 0: once per (NTSC) field
+#define EVENT_ANALOG_DELTA      8       // Stick/trigger move that counts as input
+
+// Every channel as read at one instant
+typedef struct PADSample {
+    PADStatus status[PAD_MAX_CONTROLLERS];
+    u32       motor;                     // Channels with rumble (PADRead result)
+    OSTime    time;                      // OSGetTime() when sampled
+    u32       eventSeq;                  // Input events seen so far
+    OSTime    eventTime;                 // Sample time of the latest one
+    BOOL      keyboard;                  // Channel 0 read from the keyboard
+} PADSample;
+
+// Latest sample; s_sampleSeq is odd while the sampling thread writes it
+static PADSample s_sample;
+static volatile u32 s_sampleSeq = 0;
+
+// Input as of the latest event, per channel (sampling thread only)
+static PADStatus s_eventStatus[PAD_MAX_CONTROLLERS];
+static u32 s_eventSeq = 0;
+static OSTime s_eventTime = 0;
+
+static volatile u32 s_sampling_rate = SAMPLING_RATE_DEFAULT;
+static volatile BOOL s_samplingRunning = FALSE;
+
+#ifdef _WIN32
+static HANDLE s_samplingThread = NULL;
+#else
+static pthread_t s_samplingThread;
+#endif
+
+static __PADMutex s_padLock = __PAD_MUTEX_INIT;
+
+/*---------------------------------------------------------------------------*
+    Rumble
+ *---------------------------------------------------------------------------*/
+
+#define RUMBLE_QUEUE_SIZE   16          // Commands per channel (power of 2)
+
+// Motor commands of one channel. Any thread submits; the rumble worker
+// reads. A slot holds ((ticket + 1) << 8) | command, so the worker can
+// tell a written slot from one still being filled. A submitter that
+// laps the worker overwrites the oldest command, which coalescing would
+// have dropped anyway.
+typedef struct RumbleQueue {
+    volatile u32 tail;                   // Next ticket
+    u32          head;                   // Next ticket the worker reads
+    volatile u32 slots[RUMBLE_QUEUE_SIZE];
+} RumbleQueue;
+
+// Motor state, updated by the rumble worker. Every SDL_Haptic call is
+// made with LockPAD held: SDL needs the haptic closed before its
+// joystick, and the gamepad can be closed from any thread.
+typedef struct RumbleMotor {
+    SDL_Haptic* haptic;                  // Kept open while the pad is connected
+    u32         generation;              // s_padGeneration[chan] it was opened for
+    u32         command;                 // Latest command (PAD_MOTOR_*)
+    BOOL        on;                      // Motor running
+} RumbleMotor;
+
+static RumbleQueue s_rumbleQueue[PAD_MAX_CONTROLLERS];
+static RumbleMotor s_motor[PAD_MAX_CONTROLLERS];
+
+// Bumped whenever s_gamepads[chan] changes; the worker reopens haptics
+static volatile u32 s_padGeneration[PAD_MAX_CONTROLLERS];
+
+static volatile u32 s_rumbleIdle = 0;   // Worker is (about to be) waiting
+static volatile BOOL s_rumbleRunning = FALSE;
+static volatile BOOL s_rumbleStop = FALSE;
+
+#ifdef _WIN32
+static HANDLE s_rumbleThread = NULL;
+static CRITICAL_SECTION s_rumbleLock;
+static CONDITION_VARIABLE s_rumbleCond;
+static BOOL s_rumbleLockInit = FALSE;
+#else
+static pthread_t s_rumbleThread;
+static pthread_mutex_t s_rumbleLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_rumbleCond = PTHREAD_COND_INITIALIZER;
+#endif
+
+static void WakeRumble(void);
+static void CloseHaptic(s32 chan);
+static BOOL OnShutdown(BOOL final, u32 event);
+
+static OSShutdownFunctionInfo s_shutdownInfo = {
+    OnShutdown,
+    OS_SHUTDOWN_PRIO_PAD,
+    NULL,
+    NULL
+};
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADLock
+
+  Description:  Lock a PAD mutex. On Windows the first caller sets up the
+                critical section; callers racing it wait until it is
+                ready.
+
+  Arguments:    mutex    Mutex defined with __PAD_MUTEX_INIT
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __PADLock(__PADMutex* mutex) {
+#ifdef _WIN32
+    if (__AtomicLoad32(&mutex->state) != 2) {
+        if (__AtomicCompareSwap32(&mutex->state, 0, 1)) {
+            InitializeCriticalSection(&mutex->section);
+            __AtomicStore32(&mutex->state, 2);
+        }
+        while (__AtomicLoad32(&mutex->state) != 2) {
+            Sleep(0);
+        }
+    }
+    EnterCriticalSection(&mutex->section);
+#else
+    pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADUnlock
+
+  Description:  Unlock a PAD mutex locked by this thread.
+
+  Arguments:    mutex    Mutex to unlock
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __PADUnlock(__PADMutex* mutex) {
+#ifdef _WIN32
+    LeaveCriticalSection(&mutex->section);
+#else
+    pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
+
+// Guards the gamepad handles, origins and channel bits against the
+// sampling thread
+static void LockPAD(void) {
+    __PADLock(&s_padLock);
+}
+
+static void UnlockPAD(void) {
+    __PADUnlock(&s_padLock);
+}
+
+static void LockRumble(void) {
+#ifdef _WIN32
+    if (!s_rumbleLockInit) {
+        InitializeCriticalSection(&s_rumbleLock);
+        InitializeConditionVariable(&s_rumbleCond);
+        s_rumbleLockInit = TRUE;
+    }
+    EnterCriticalSection(&s_rumbleLock);
+#else
+    pthread_mutex_lock(&s_rumbleLock);
+#endif
+}
+
+static void UnlockRumble(void) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s_rumbleLock);
+#else
+    pthread_mutex_unlock(&s_rumbleLock);
+#endif
+}
+
 /*---------------------------------------------------------------------------*
     Keyboard Mapping (fallback for channel 0)
  *---------------------------------------------------------------------------*/
@@ -141,9 +337,6 @@ static BOOL InitSDL(void) {
         return TRUE;
     }
     
-    // Load configuration from pad_config.ini
-    PADLoadConfig();
-    
     // Try to initialize gamepad + haptic (rumble)
     if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER | SDL_INIT_HAPTIC) < 0) {
         OSReport("PAD: Failed to initialize SDL gamepad: %s\n", SDL_GetError());
@@ -181,7 +374,8 @@ static void OpenGamepad(s32 chan) {
         return;
     }
     
-    // Close existing gamepad (if unplugged/replaced)
+    // Close existing gamepad (if unplugged/replaced), its haptic first
+    CloseHaptic(chan);
     if (s_gamepads[chan]) {
         SDL_GameControllerClose(s_gamepads[chan]);
         s_gamepads[chan] = NULL;
@@ -193,6 +387,11 @@ static void OpenGamepad(s32 chan) {
         OSReport("PAD: Channel %d connected - %s\n", chan, 
                  SDL_GameControllerName(s_gamepads[chan]));
     }
+    
+    // Have the rumble worker (re)open the haptic device now, not on the
+    // first motor command
+    __AtomicAdd32(&s_padGeneration[chan], 1);
+    WakeRumble();
 }
 
 /*---------------------------------------------------------------------------*
@@ -212,8 +411,8 @@ static void ScanGamepads(void) {
     for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
         u32 chanBit = PAD_CHAN0_BIT >> chan;
         
-        // Skip if not enabled
-        if (!(s_enabled_bits & chanBit)) {
+        // Skip if not enabled or driven by a harness
+        if (!(s_enabled_bits & chanBit) || (s_virtual_bits & chanBit)) {
             continue;
         }
         
@@ -303,10 +502,6 @@ static void ReadKeyboard(PADStatus* status) {
         return;
     }
     
-    // Update keyboard state
-    SDL_PumpEvents();
-    s_keyboard.keys = SDL_GetKeyboardState(NULL);
-    
     // Clear status
     memset(status, 0, sizeof(PADStatus));
     status->err = PAD_ERR_NONE;
@@ -460,6 +655,596 @@ static void ReadGamepad(s32 chan, PADStatus* status) {
     }
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         SampleChannels
+
+  Description:  Read every channel into a sample. This is one SI poll.
+                
+                On GC/Wii: SI hardware polls each port at the sampling rate
+                On PC: Runs on the sampling thread; SDL's joystick lock keeps
+                       the video thread's event pump from updating the
+                       devices halfway through. Virtual channels take the
+                       latest harness frame; without SDL they are all
+                       there is.
+
+  Arguments:    sample    Sample to fill
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void SampleChannels(PADSample* sample) {
+    PADStatus virt[PAD_MAX_CONTROLLERS];
+    
+    LockPAD();
+    if (s_sdl_initialized) {
+        SDL_LockJoysticks();
+        SDL_GameControllerUpdate();
+    }
+    sample->time = OSGetTime();
+    
+    // Scan for new gamepads (hot-plug support)
+    if (s_sdl_initialized) {
+        ScanGamepads();
+    }
+    if (s_virtual_bits) {
+        __PADVirtualRead(virt);
+    }
+    
+    sample->motor = 0;
+    sample->keyboard = FALSE;
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        PADStatus* st = &sample->status[chan];
+        u32 chanBit = PAD_CHAN0_BIT >> chan;
+        
+        // Check if channel is enabled
+        if (!(s_enabled_bits & chanBit)) {
+            st->err = PAD_ERR_NO_CONTROLLER;
+            memset(st, 0, offsetof(PADStatus, err));
+            continue;
+        }
+        
+        // Check if resetting
+        if (s_resetting_bits & chanBit) {
+            st->err = PAD_ERR_NOT_READY;
+            memset(st, 0, offsetof(PADStatus, err));
+            continue;
+        }
+        
+        // Harness frames are taken as sent (no origin, no rumble)
+        if (s_virtual_bits & chanBit) {
+            *st = virt[chan];
+            continue;
+        }
+        
+        // Read input (keyboard for chan 0 if no gamepad, else SDL2 gamepad)
+        if (chan == 0 && s_keyboard.enabled && !s_gamepads[0]) {
+            ReadKeyboard(st);
+            sample->keyboard = TRUE;
+        } else {
+            ReadGamepad(chan, st);
+        }
+        
+        // Check if controller supports rumble
+        if (s_gamepads[chan]) {
+            SDL_Joystick* joy = SDL_GameControllerGetJoystick(s_gamepads[chan]);
+            if (joy && SDL_JoystickIsHaptic(joy)) {
+                sample->motor |= chanBit;
+            }
+        }
+    }
+    
+    if (s_sdl_initialized) {
+        SDL_UnlockJoysticks();
+    }
+    UnlockPAD();
+}
+
+// An analog value changed by enough to count as input
+static BOOL Moved(s32 a, s32 b) {
+    return abs(a - b) >= EVENT_ANALOG_DELTA;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StampEvents
+
+  Description:  Count an input event if any button changed or a stick or
+                trigger moved since the last event, and stamp the sample
+                with the latest event (for the latency statistics).
+
+  Arguments:    sample    Sample just taken
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StampEvents(PADSample* sample) {
+    BOOL changed = FALSE;
+    
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        const PADStatus* now = &sample->status[chan];
+        PADStatus* last = &s_eventStatus[chan];
+        
+        if (now->button != last->button ||
+            Moved(now->stickX, last->stickX) || Moved(now->stickY, last->stickY) ||
+            Moved(now->substickX, last->substickX) || Moved(now->substickY, last->substickY) ||
+            Moved(now->triggerLeft, last->triggerLeft) || Moved(now->triggerRight, last->triggerRight)) {
+            *last = *now;
+            changed = TRUE;
+        }
+    }
+    
+    if (changed) {
+        s_eventSeq++;
+        s_eventTime = sample->time;
+    }
+    sample->eventSeq = s_eventSeq;
+    sample->eventTime = s_eventTime;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PublishSample
+
+  Description:  Make a sample the latest one. Only the sampling thread
+                writes, so the sequence needs no read-modify-write.
+
+  Arguments:    sample    Sample to publish
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void PublishSample(const PADSample* sample) {
+    u32 seq = s_sampleSeq;
+    
+    __AtomicStore32(&s_sampleSeq, seq + 1);     // Odd: readers retry
+    __AtomicReleaseFence();
+    memcpy((void*)&s_sample, sample, sizeof(PADSample));
+    __AtomicStore32(&s_sampleSeq, seq + 2);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         CopySample
+
+  Description:  Copy the latest sample. Never blocks the sampling thread;
+                a copy that overlapped a write is taken again.
+
+  Arguments:    sample    Receives the sample
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void CopySample(PADSample* sample) {
+    u32 seq;
+    
+    do {
+        seq = __AtomicLoad32(&s_sampleSeq);
+        memcpy(sample, (const void*)&s_sample, sizeof(PADSample));
+        __AtomicFence();
+    } while ((seq & 1) || __AtomicLoad32(&s_sampleSeq) != seq);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         CallSamplingCallback
+
+  Description:  Call the sampling callback, if any, marking this thread as
+                inside it.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void CallSamplingCallback(void) {
+    PADSamplingCallback callback = s_sampling_callback;
+    
+    if (callback) {
+        t_inCallback = TRUE;
+        callback();
+        t_inCallback = FALSE;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         SamplingThread
+
+  Description:  Background thread standing in for SI polling: samples all
+                channels at the sampling rate, publishes each sample and
+                calls the sampling callback. Sample times stay on a fixed
+                grid; after a stall the thread resumes rather than
+                catching up with a burst.
+
+  Arguments:    arg  Unused
+
+  Returns:      0 (thread return)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI SamplingThread(LPVOID arg)
+#else
+static void* SamplingThread(void* arg)
+#endif
+{
+    (void)arg;
+    
+    OSTime next = OSGetTime();
+    PADSample sample;
+    
+    while (s_samplingRunning) {
+        SampleChannels(&sample);
+        StampEvents(&sample);
+        PublishSample(&sample);
+        CallSamplingCallback();
+        
+        u32 rate = s_sampling_rate;
+        next += rate ? OSMillisecondsToTicks(rate) : OSMicrosecondsToTicks(SAMPLING_FIELD_US);
+        
+        OSTime now = OSGetTime();
+        if (next > now) {
+            OSSleepTicks(next - now);
+        } else {
+            next = now;
+        }
+    }
+    
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StartSamplingThread
+
+  Description:  Take a first sample and start the sampling thread. If the
+                thread can't start, PADRead samples inline as before.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StartSamplingThread(void) {
+    PADSample sample;
+    
+    SampleChannels(&sample);
+    StampEvents(&sample);
+    PublishSample(&sample);
+    
+    s_samplingRunning = TRUE;
+    
+#ifdef _WIN32
+    s_samplingThread = CreateThread(NULL, 0, SamplingThread, NULL, 0, NULL);
+    if (!s_samplingThread) {
+        OSReport("PAD: Failed to create sampling thread\n");
+        s_samplingRunning = FALSE;
+    }
+#else
+    if (pthread_create(&s_samplingThread, NULL, SamplingThread, NULL) != 0) {
+        OSReport("PAD: Failed to create sampling thread\n");
+        s_samplingRunning = FALSE;
+    }
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         SubmitMotor
+
+  Description:  Queue a motor command for the rumble worker. Lock-free;
+                does not wake the worker.
+
+  Arguments:    chan       Channel number (0-3)
+                command    PAD_MOTOR_* command
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void SubmitMotor(s32 chan, u32 command) {
+    RumbleQueue* q = &s_rumbleQueue[chan];
+    u32 ticket = __AtomicAdd32(&q->tail, 1);
+    
+    __AtomicStore32(&q->slots[ticket & (RUMBLE_QUEUE_SIZE - 1)],
+                    ((ticket + 1) << 8) | (command & 0xFF));
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PopMotor
+
+  Description:  Take the oldest queued command of a channel (rumble worker
+                only). Commands overwritten by a lapping submitter are
+                skipped.
+
+  Arguments:    q          Channel queue
+                command    Receives the command
+
+  Returns:      TRUE if a command was taken
+ *---------------------------------------------------------------------------*/
+static BOOL PopMotor(RumbleQueue* q, u32* command) {
+    for (;;) {
+        u32 tail = __AtomicLoad32(&q->tail);
+        if (tail - q->head > RUMBLE_QUEUE_SIZE) {
+            q->head = tail - RUMBLE_QUEUE_SIZE;
+        }
+        if (q->head == tail) {
+            return FALSE;
+        }
+        
+        u32 value = __AtomicLoad32(&q->slots[q->head & (RUMBLE_QUEUE_SIZE - 1)]);
+        u32 expected = (q->head + 1) & 0xFFFFFF;
+        u32 ticket = value >> 8;
+        
+        if (ticket == expected) {
+            q->head++;
+            *command = value & 0xFF;
+            return TRUE;
+        }
+        if (((ticket - expected) & 0xFFFFFF) >= 0x800000) {
+            return FALSE;  // Older: the submitter hasn't stored it yet
+        }
+        // Newer: overwritten, the tail has moved on
+    }
+}
+
+static BOOL RumblePending(void) {
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        if (__AtomicLoad32(&s_rumbleQueue[chan].tail) != s_rumbleQueue[chan].head ||
+            __AtomicLoad32(&s_padGeneration[chan]) != s_motor[chan].generation) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         CloseHaptic
+
+  Description:  Stop the motor and close the haptic device of a channel.
+                Called with LockPAD held, before the gamepad is closed.
+
+  Arguments:    chan    Channel number (0-3)
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void CloseHaptic(s32 chan) {
+    RumbleMotor* m = &s_motor[chan];
+    
+    if (m->haptic) {
+        if (m->on) {
+            SDL_HapticRumbleStop(m->haptic);
+        }
+        SDL_HapticClose(m->haptic);
+        m->haptic = NULL;
+    }
+    m->on = FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OpenHaptic
+
+  Description:  (Re)open the haptic device of a channel's pad. The handle
+                stays open until the pad changes, so motor commands cost
+                one SDL call instead of an open/init/play/close round trip.
+                Called with LockPAD held.
+
+  Arguments:    chan    Channel number (0-3)
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void OpenHaptic(s32 chan) {
+    RumbleMotor* m = &s_motor[chan];
+    
+    CloseHaptic(chan);
+    
+    m->generation = __AtomicLoad32(&s_padGeneration[chan]);
+    SDL_GameController* pad = s_gamepads[chan];
+    SDL_Joystick* joy = pad ? SDL_GameControllerGetJoystick(pad) : NULL;
+    if (joy && SDL_JoystickIsHaptic(joy)) {
+        m->haptic = SDL_HapticOpenFromJoystick(joy);
+    }
+    
+    if (m->haptic && (!SDL_HapticRumbleSupported(m->haptic) ||
+                      SDL_HapticRumbleInit(m->haptic) < 0)) {
+        SDL_HapticClose(m->haptic);
+        m->haptic = NULL;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         ApplyRumble
+
+  Description:  Drain the motor queues and bring each motor to the latest
+                command. Commands in between are coalesced: a motor is only
+                started or stopped when its state actually changes.
+                
+                On GC/Wii: The motor bits ride along with the next SI poll
+                On PC: Runs on the rumble worker (or inline if it is not
+                       running), with LockPAD held so the pads cannot
+                       be closed under the haptic devices
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void ApplyRumble(void) {
+    LockPAD();
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        RumbleMotor* m = &s_motor[chan];
+        u32 command;
+        
+        while (PopMotor(&s_rumbleQueue[chan], &command)) {
+            m->command = command;
+        }
+        
+        if (m->generation != __AtomicLoad32(&s_padGeneration[chan])) {
+            OpenHaptic(chan);
+        }
+        if (!m->haptic) {
+            continue;
+        }
+        
+        // Rumble runs until stopped, as the motor does on the original
+        BOOL on = (m->command == PAD_MOTOR_RUMBLE);
+        if (on != m->on) {
+            if (on) {
+                SDL_HapticRumblePlay(m->haptic, PADGetRumbleIntensity(), SDL_HAPTIC_INFINITY);
+            } else {
+                SDL_HapticRumbleStop(m->haptic);  // STOP and STOP_HARD alike
+            }
+            m->on = on;
+        }
+    }
+    UnlockPAD();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         RumbleThread
+
+  Description:  Rumble worker: sleeps until commands are submitted (or a
+                pad changes), then applies them. Stops all motors and
+                closes the haptic devices on exit.
+
+  Arguments:    arg  Unused
+
+  Returns:      0 (thread return)
+ *---------------------------------------------------------------------------*/
+#ifdef _WIN32
+static DWORD WINAPI RumbleThread(LPVOID arg)
+#else
+static void* RumbleThread(void* arg)
+#endif
+{
+    (void)arg;
+    
+    while (!s_rumbleStop) {
+        ApplyRumble();
+        
+        // Announce idle, then look again: a submitter that missed the
+        // flag queued before the second look
+        LockRumble();
+        __AtomicStore32(&s_rumbleIdle, 1);
+        __AtomicFence();
+        if (RumblePending()) {
+            __AtomicStore32(&s_rumbleIdle, 0);
+        }
+        while (__AtomicLoad32(&s_rumbleIdle) && !s_rumbleStop) {
+#ifdef _WIN32
+            SleepConditionVariableCS(&s_rumbleCond, &s_rumbleLock, INFINITE);
+#else
+            pthread_cond_wait(&s_rumbleCond, &s_rumbleLock);
+#endif
+        }
+        UnlockRumble();
+    }
+    
+    LockPAD();
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        CloseHaptic(chan);
+    }
+    UnlockPAD();
+    
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         WakeRumble
+
+  Description:  Wake the rumble worker if it is waiting. Costs nothing
+                when it is already awake.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void WakeRumble(void) {
+    __AtomicFence();
+    if (__AtomicLoad32(&s_rumbleIdle) && __AtomicCompareSwap32(&s_rumbleIdle, 1, 0)) {
+        LockRumble();
+#ifdef _WIN32
+        WakeAllConditionVariable(&s_rumbleCond);
+#else
+        pthread_cond_broadcast(&s_rumbleCond);
+#endif
+        UnlockRumble();
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         StartRumbleThread
+
+  Description:  Start the rumble worker. If it can't start, motor commands
+                are applied inline.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void StartRumbleThread(void) {
+    s_rumbleStop = FALSE;
+    s_rumbleRunning = TRUE;
+    
+#ifdef _WIN32
+    LockRumble();  // Creates the lock before the worker uses it
+    UnlockRumble();
+    s_rumbleThread = CreateThread(NULL, 0, RumbleThread, NULL, 0, NULL);
+    if (!s_rumbleThread) {
+        OSReport("PAD: Failed to create rumble thread\n");
+        s_rumbleRunning = FALSE;
+    }
+#else
+    if (pthread_create(&s_rumbleThread, NULL, RumbleThread, NULL) != 0) {
+        OSReport("PAD: Failed to create rumble thread\n");
+        s_rumbleRunning = FALSE;
+    }
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         OnShutdown
+
+  Description:  Shutdown function: stops the sampling thread and the rumble
+                worker (which stops the motors, as the original does on
+                reset) so neither is left calling into SDL, and closes the
+                virtual controller socket or ring.
+
+  Arguments:    final    TRUE on the final pass
+                event    Shutdown event (unused)
+
+  Returns:      TRUE (ready)
+ *---------------------------------------------------------------------------*/
+static BOOL OnShutdown(BOOL final, u32 event) {
+    (void)event;
+    
+    if (final && s_samplingRunning) {
+        s_samplingRunning = FALSE;
+#ifdef _WIN32
+        WaitForSingleObject(s_samplingThread, INFINITE);
+        CloseHandle(s_samplingThread);
+        s_samplingThread = NULL;
+#else
+        pthread_join(s_samplingThread, NULL);
+#endif
+    }
+    
+    if (final && s_rumbleRunning) {
+        LockRumble();
+        s_rumbleStop = TRUE;
+#ifdef _WIN32
+        WakeAllConditionVariable(&s_rumbleCond);
+#else
+        pthread_cond_broadcast(&s_rumbleCond);
+#endif
+        UnlockRumble();
+#ifdef _WIN32
+        WaitForSingleObject(s_rumbleThread, INFINITE);
+        CloseHandle(s_rumbleThread);
+        s_rumbleThread = NULL;
+#else
+        pthread_join(s_rumbleThread, NULL);
+#endif
+        s_rumbleRunning = FALSE;
+    }
+    
+    if (final) {
+        PADStopRecording();
+        PADCloseVirtual();
+    }
+    return TRUE;
+}
+
 /*---------------------------------------------------------------------------*
   Name:         PADInit
 
@@ -469,12 +1254,17 @@ static void ReadGamepad(s32 chan, PADStatus* status) {
                 
                 On GC/Wii: Initializes SI hardware, sets sampling rate,
                            registers reset/shutdown callbacks
-                On PC: Initializes SDL2 gamepad system, scans for controllers
+                On PC: Initializes SDL2 gamepad system, scans for controllers,
+                       starts the sampling thread and the rumble worker.
+                       Starts the input trace replay or recording and the
+                       virtual controllers set in pad_config.ini; a replay,
+                       or four virtual channels, leave SDL out.
 
   Arguments:    None
 
   Returns:      TRUE if initialization succeeded
-                FALSE if SDL2 failed to initialize
+                FALSE if SDL2 failed to initialize and no channel is
+                virtual
  *---------------------------------------------------------------------------*/
 BOOL PADInit(void) {
     if (s_initialized) {
@@ -483,10 +1273,31 @@ BOOL PADInit(void) {
     
     OSReport("PAD: Initializing controller subsystem...\n");
     
-    // Initialize SDL
-    if (!InitSDL()) {
-        OSReport("PAD: Failed to initialize SDL\n");
-        return FALSE;
+    // Load configuration from pad_config.ini
+    PADLoadConfig();
+    
+    // A replay stands in for the controllers: no SDL
+    if (!__PADReplaying && PADGetTracePath(TRUE)) {
+        PADStartReplay(PADGetTracePath(TRUE));
+    }
+    
+    // Virtual channels from the config (set before PADInit is kept)
+    s_virtual_bits |= PADGetVirtualChannels();
+    if (PADGetVirtualPath(TRUE)) {
+        PADOpenVirtualRing(PADGetVirtualPath(TRUE));
+    } else if (PADGetVirtualPath(FALSE)) {
+        PADOpenVirtualSocket(PADGetVirtualPath(FALSE));
+    }
+    
+    // Initialize SDL; a harness driving every channel needs none, and
+    // one driving some keeps them running without it
+    u32 allBits = PAD_CHAN0_BIT | PAD_CHAN1_BIT | PAD_CHAN2_BIT | PAD_CHAN3_BIT;
+    if (!__PADReplaying && s_virtual_bits != allBits && !InitSDL()) {
+        if (!s_virtual_bits) {
+            OSReport("PAD: Failed to initialize SDL\n");
+            return FALSE;
+        }
+        OSReport("PAD: No SDL, using virtual controllers only\n");
     }
     
     // Clear state
@@ -501,7 +1312,17 @@ BOOL PADInit(void) {
     s_initialized = TRUE;
     
     // Reset all channels (equivalent to SIRefreshSamplingRate + PADReset in original)
-    return PADReset(PAD_CHAN0_BIT | PAD_CHAN1_BIT | PAD_CHAN2_BIT | PAD_CHAN3_BIT);
+    BOOL result = PADReset(allBits);
+    
+    if (!__PADReplaying) {
+        StartSamplingThread();
+        StartRumbleThread();
+        if (!__PADRecording && PADGetTracePath(FALSE)) {
+            PADStartRecording(PADGetTracePath(FALSE));
+        }
+    }
+    OSRegisterShutdownFunction(&s_shutdownInfo);
+    return result;
 }
 
 /*---------------------------------------------------------------------------*
@@ -522,7 +1343,7 @@ BOOL PADReset(u32 mask) {
         return FALSE;
     }
     
-    BOOL enabled = OSDisableInterrupts();
+    LockPAD();
     
     for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
         u32 chanBit = PAD_CHAN0_BIT >> chan;
@@ -535,8 +1356,10 @@ BOOL PADReset(u32 mask) {
             // Clear origin
             memset(&s_origin[chan], 0, sizeof(PADStatus));
             
-            // Try to open gamepad (skip Player 1 if keyboard fallback active)
-            if (!s_keyboard.enabled || chan != 0) {
+            // Try to open gamepad (skip Player 1 if keyboard fallback
+            // active, and channels driven by a harness)
+            if (s_sdl_initialized && !__PADReplaying && !(s_virtual_bits & chanBit) &&
+                (!s_keyboard.enabled || chan != 0)) {
                 OpenGamepad(chan);
             }
             
@@ -545,7 +1368,7 @@ BOOL PADReset(u32 mask) {
         }
     }
     
-    OSRestoreInterrupts(enabled);
+    UnlockPAD();
     return TRUE;
 }
 
@@ -570,7 +1393,7 @@ BOOL PADRecalibrate(u32 mask) {
     
     // For PC implementation, recalibration just resets the origin.
     // In original hardware, this sends a calibration command to the controller.
-    BOOL enabled = OSDisableInterrupts();
+    LockPAD();
     
     for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
         u32 chanBit = PAD_CHAN0_BIT >> chan;
@@ -581,7 +1404,7 @@ BOOL PADRecalibrate(u32 mask) {
         }
     }
     
-    OSRestoreInterrupts(enabled);
+    UnlockPAD();
     return TRUE;
 }
 
@@ -593,7 +1416,7 @@ BOOL PADRecalibrate(u32 mask) {
                 
                 On GC/Wii: Reads data from SI response buffer (filled by
                            hardware DMA during automatic polling)
-                On PC: Manually queries SDL2 for each controller's state
+                On PC: Copies the latest sample of the sampling thread
 
   Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
                           to fill in. Each err field indicates validity.
@@ -602,6 +1425,24 @@ BOOL PADRecalibrate(u32 mask) {
                 (PAD_CHANn_BIT for channels with rumble support)
  *---------------------------------------------------------------------------*/
 u32 PADRead(PADStatus* status) {
+    return PADReadEx(status, NULL);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADReadEx
+
+  Description:  PADRead that also returns when the status was sampled.
+                PC extension; with the default 1 ms sampling rate the
+                status is at most about 1 ms old.
+
+  Arguments:    status        Array of PAD_MAX_CONTROLLERS PADStatus
+                              structures to fill in
+                sampleTime    Receives the OSGetTime() of the sample
+                              (may be NULL)
+
+  Returns:      Bit mask of controllers that support rumble motors
+ *---------------------------------------------------------------------------*/
+u32 PADReadEx(PADStatus* status, OSTime* sampleTime) {
     if (!s_initialized || !status) {
         // Initialize status array to error state
         if (status) {
@@ -610,60 +1451,66 @@ u32 PADRead(PADStatus* status) {
                 memset(&status[i], 0, offsetof(PADStatus, err));
             }
         }
+        if (sampleTime) {
+            *sampleTime = 0;
+        }
         return 0;
     }
     
-    // Pump SDL events (updates gamepad state)
-    if (s_sdl_initialized) {
-        SDL_PumpEvents();
-    }
-    
-    // Scan for new gamepads (hot-plug support)
-    ScanGamepads();
-    
-    // Call sampling callback if registered
-    if (s_sampling_callback) {
-        s_sampling_callback();
+    if (__PADReplaying) {
+        // The recorded result stands in for the controllers. Without the
+        // sampling thread the callback runs here, as when sampling inline.
+        u32 motor;
+        if (t_inCallback) {
+            motor = __PADTraceLatest(status);
+        } else {
+            if (!s_samplingRunning) {
+                CallSamplingCallback();
+            }
+            motor = __PADTraceReplay(status);
+        }
+        if (sampleTime) {
+            *sampleTime = OSGetTime();
+        }
+        return motor;
     }
     
-    u32 motor = 0;  // Bitmask of controllers with rumble support
+    PADSample sample;
     
-    // Read each controller
-    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
-        PADStatus* st = &status[chan];
-        u32 chanBit = PAD_CHAN0_BIT >> chan;
-        
-        // Check if channel is enabled
-        if (!(s_enabled_bits & chanBit)) {
-            st->err = PAD_ERR_NO_CONTROLLER;
-            memset(st, 0, offsetof(PADStatus, err));
-            continue;
-        }
-        
-        // Check if resetting
-        if (s_resetting_bits & chanBit) {
-            st->err = PAD_ERR_NOT_READY;
-            memset(st, 0, offsetof(PADStatus, err));
-            continue;
+    if (s_samplingRunning) {
+        // Only the keyboard needs this thread: its state changes when
+        // events are pumped, which SDL does not allow on the sampling
+        // thread. It is read again right after pumping, or it would be a
+        // PADRead behind.
+        if (s_keyboard.enabled) {
+            SDL_PumpEvents();
         }
-        
-        // Read input (keyboard for chan 0 if no gamepad, else SDL2 gamepad)
-        if (chan == 0 && s_keyboard.enabled && !s_gamepads[0]) {
-            ReadKeyboard(st);
-        } else {
-            ReadGamepad(chan, st);
+        CopySample(&sample);
+        if (sample.keyboard) {
+            ReadKeyboard(&sample.status[0]);
         }
-        
-        // Check if controller supports rumble
-        if (s_gamepads[chan]) {
-            SDL_Joystick* joy = SDL_GameControllerGetJoystick(s_gamepads[chan]);
-            if (joy && SDL_JoystickIsHaptic(joy)) {
-                motor |= chanBit;
-            }
+    } else {
+        // No sampling thread: sample inline
+        if (s_sdl_initialized) {
+            SDL_PumpEvents();
         }
+        CallSamplingCallback();
+        SampleChannels(&sample);
+        StampEvents(&sample);
+    }
+    
+    if (__PADLatencyTracking && !t_inCallback) {
+        __PADLatencyRead(sample.time, sample.eventSeq, sample.eventTime);
     }
     
-    return motor;
+    memcpy(status, sample.status, sizeof(sample.status));
+    if (sampleTime) {
+        *sampleTime = sample.time;
+    }
+    if (__PADRecording && !t_inCallback) {
+        __PADTraceRecord(status, sample.motor);
+    }
+    return sample.motor;
 }
 
 /*---------------------------------------------------------------------------*
@@ -673,7 +1520,9 @@ u32 PADRead(PADStatus* status) {
                 
                 On GC/Wii: Sends motor control bits via SI command packet
                            (2 bits for dual motors on some controllers)
-                On PC: Uses SDL2 Haptic API for rumble effect
+                On PC: Queues the command for the rumble worker, which
+                       drives the SDL2 Haptic API. Repeating a command
+                       every frame costs no SDL calls.
 
   Arguments:    chan      Channel number (PAD_CHANn)
                 command   Motor command:
@@ -688,35 +1537,12 @@ void PADControlMotor(s32 chan, u32 command) {
         return;
     }
     
-    SDL_GameController* pad = s_gamepads[chan];
-    if (!pad) {
-        return;
-    }
-    
-    SDL_Joystick* joy = SDL_GameControllerGetJoystick(pad);
-    if (!joy || !SDL_JoystickIsHaptic(joy)) {
-        return;
-    }
-    
-    // Open haptic device temporarily
-    SDL_Haptic* haptic = SDL_HapticOpenFromJoystick(joy);
-    if (!haptic) {
-        return;
-    }
-    
-    if (command == PAD_MOTOR_RUMBLE) {
-        // Start rumble (intensity from config, 1000ms duration)
-        if (SDL_HapticRumbleSupported(haptic)) {
-            SDL_HapticRumbleInit(haptic);
-            float intensity = PADGetRumbleIntensity();
-            SDL_HapticRumblePlay(haptic, intensity, 1000);
-        }
+    SubmitMotor(chan, command);
+    if (s_rumbleRunning) {
+        WakeRumble();
     } else {
-        // Stop rumble (PAD_MOTOR_STOP or PAD_MOTOR_STOP_HARD)
-        SDL_HapticRumbleStop(haptic);
+        ApplyRumble();
     }
-    
-    SDL_HapticClose(haptic);
 }
 
 /*---------------------------------------------------------------------------*
@@ -726,7 +1552,8 @@ void PADControlMotor(s32 chan, u32 command) {
                 More efficient than calling PADControlMotor 4 times.
                 
                 On GC/Wii: Batches SI commands for all channels
-                On PC: Calls PADControlMotor for each channel
+                On PC: Queues all four commands, then wakes the rumble
+                       worker once
 
   Arguments:    commandArray    Array of PAD_MAX_CONTROLLERS motor commands
 
@@ -738,7 +1565,12 @@ void PADControlAllMotors(const u32* commandArray) {
     }
     
     for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
-        PADControlMotor(chan, commandArray[chan]);
+        SubmitMotor(chan, commandArray[chan]);
+    }
+    if (s_rumbleRunning) {
+        WakeRumble();
+    } else {
+        ApplyRumble();
     }
 }
 
@@ -823,19 +1655,20 @@ void PADSetAnalogMode(u32 mode) {
   Description:  Sets the controller sampling rate in milliseconds.
                 
                 On GC/Wii: Configures SI hardware polling rate (affects VI timing)
-                On PC: No-op - sampling rate is tied to PADRead() call frequency
-                
-                This function exists for API compatibility but has no effect
-                on PC. Games should call PADRead() once per frame.
+                On PC: Sets the period of the sampling thread, from the next
+                       sample on. 0 samples once per field; the default is
+                       1 ms so PADRead sees input at most ~1 ms old.
 
-  Arguments:    msec    Desired sampling rate in milliseconds (ignored on PC)
+  Arguments:    msec    Sampling period in milliseconds (0-11, larger
+                        values are clamped to 11)
 
   Returns:      None
  *---------------------------------------------------------------------------*/
 void PADSetSamplingRate(u32 msec) {
-    (void)msec;
-    // No-op on PC - sampling rate tied to PADRead() calls
-    // Original would configure SI SIPOLL register
+    if (msec > SAMPLING_RATE_MAX) {
+        msec = SAMPLING_RATE_MAX;
+    }
+    s_sampling_rate = msec;
 }
 
 /*---------------------------------------------------------------------------*
@@ -855,12 +1688,17 @@ void PADSetSpec(u32 spec) {
 /*---------------------------------------------------------------------------*
   Name:         PADSetSamplingCallback
 
-  Description:  Installs a callback function that is called during PADRead()
-                when controller data is sampled. Useful for custom input
+  Description:  Installs a callback function that is called each time
+                controller data is sampled. Useful for custom input
                 processing or recording.
                 
                 On GC/Wii: Called during SI polling interrupt
-                On PC: Called directly in PADRead()
+                On PC: Called on the sampling thread after each sample is
+                       published, so PADRead() in the callback returns it.
+                       PADRead() calls from the callback are not recorded;
+                       on replay they return the latest replayed result.
+                       A replay started before PADInit has no sampling
+                       thread: the callback runs before each replayed read.
 
   Arguments:    callback    Callback function pointer, or NULL to remove
 
@@ -871,3 +1709,55 @@ PADSamplingCallback PADSetSamplingCallback(PADSamplingCallback callback) {
     s_sampling_callback = callback;
     return prev;
 }
+
+/*---------------------------------------------------------------------------*
+  Name:         PADSetChannelSource
+
+  Description:  Select where a channel's input comes from. PC extension.
+                A channel switched to PAD_SOURCE_VIRTUAL gives up its
+                gamepad; one switched back picks a gamepad up on the next
+                scan.
+
+  Arguments:    chan      Channel number (PAD_CHANn)
+                source    PAD_SOURCE_DEFAULT or PAD_SOURCE_VIRTUAL
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADSetChannelSource(s32 chan, u32 source) {
+    if (chan < 0 || chan >= PAD_MAX_CONTROLLERS) {
+        return;
+    }
+    
+    u32 chanBit = PAD_CHAN0_BIT >> chan;
+    
+    LockPAD();
+    if (source == PAD_SOURCE_VIRTUAL) {
+        s_virtual_bits |= chanBit;
+        if (s_gamepads[chan]) {
+            CloseHaptic(chan);
+            SDL_GameControllerClose(s_gamepads[chan]);
+            s_gamepads[chan] = NULL;
+            __AtomicAdd32(&s_padGeneration[chan], 1);
+            WakeRumble();
+        }
+    } else {
+        s_virtual_bits &= ~chanBit;
+    }
+    UnlockPAD();
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADGetChannelSource
+
+  Description:  Get where a channel's input comes from. PC extension.
+
+  Arguments:    chan    Channel number (PAD_CHANn)
+
+  Returns:      PAD_SOURCE_DEFAULT or PAD_SOURCE_VIRTUAL
+ *---------------------------------------------------------------------------*/
+u32 PADGetChannelSource(s32 chan) {
+    if (chan < 0 || chan >= PAD_MAX_CONTROLLERS) {
+        return PAD_SOURCE_DEFAULT;
+    }
+    return (s_virtual_bits & (PAD_CHAN0_BIT >> chan)) ? PAD_SOURCE_VIRTUAL : PAD_SOURCE_DEFAULT;
+}
@@ -60,6 +60,29 @@
   PADClampCircle2() - Apply circular clamping with selectable parameters
   PADClampTrigger() - Apply only trigger clamping with selectable parameters
   
+  PADClampBatch() and the other *Batch functions do the same for an array
+  of any length (recorded inputs, AI simulation); the functions above
+  are the batch ones with PAD_MAX_CONTROLLERS.
+  
+  BATCH CLAMPING
+  ==============
+  
+  Four statuses go through one pass of SSE2 (x86) or NEON (ARM64) code,
+  chosen at compile time since both are baseline on their targets. The
+  region is looked up once per call, not per stick. Results are
+  bit-identical to the scalar code, which still handles the last
+  count % 4 statuses:
+  
+  - The stick math runs in 32-bit float lanes. Every product and sum is
+    an integer below 2^24, so it is exact; the two divisions (and the
+    square root) are correctly rounded, and their quotients are far
+    enough from the next integer that truncating gives the same result
+    as the integer division
+  - The branches become masks: dead zone as max(v - min, 0), the
+    octagon's two cases as max/min of |x| and |y|
+  - Triggers are one saturating byte subtract after a byte min
+  - Statuses with an error are left untouched, as before
+  
   USAGE
   =====
   
@@ -81,6 +104,18 @@
 #include <dolphin/pad.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLAMP_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CLAMP_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define CLAMP_BLOCK     4       // Statuses per vector pass
 
 /*---------------------------------------------------------------------------*
     Clamp Region Parameters
@@ -313,96 +348,356 @@ static void ClampTrigger(u8* trigger, u8 min, u8 max) {
     }
 }
 
+// What a clamp call does to each status
+typedef enum ClampStickMode {
+    STICK_NONE,
+    STICK_OCTA,
+    STICK_CIRCLE
+} ClampStickMode;
+
 /*---------------------------------------------------------------------------*
-  Name:         PADClamp
+  Name:         ClampOne
 
-  Description:  Clamp all controllers using standard GameCube parameters.
-                Applies octagonal clamping to sticks and dead zone/max to
-                triggers. This is the most common clamping function.
-                
-                Use this for most games to match original GameCube feel.
+  Description:  Scalar clamp of one status (the tail of a batch).
 
-  Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
+  Arguments:    status    Status to clamp
+                stkreg    Region for the sticks
+                mode      How to clamp the sticks
+                trgreg    Region for the triggers, or NULL to leave them
 
-  Returns:      None (modifies status array in place)
+  Returns:      None
  *---------------------------------------------------------------------------*/
-void PADClamp(PADStatus* status) {
-    if (!status) {
+static void ClampOne(PADStatus* status, const PADClampRegion* stkreg,
+                     ClampStickMode mode, const PADClampRegion* trgreg) {
+    if (status->err != PAD_ERR_NONE) {
         return;
     }
     
-    for (int i = 0; i < PAD_MAX_CONTROLLERS; i++, status++) {
-        // Skip if error (controller not connected or not ready)
-        if (status->err != PAD_ERR_NONE) {
-            continue;
-        }
-        
-        // Clamp main analog stick to octagon
+    if (mode == STICK_OCTA) {
         ClampStick(&status->stickX, &status->stickY,
-                   ClampRegion.maxStick,
-                   ClampRegion.xyStick,
-                   ClampRegion.minStick);
-        
-        // Clamp C-stick to octagon
+                   stkreg->maxStick, stkreg->xyStick, stkreg->minStick);
         ClampStick(&status->substickX, &status->substickY,
-                   ClampRegion.maxSubstick,
-                   ClampRegion.xySubstick,
-                   ClampRegion.minSubstick);
+                   stkreg->maxSubstick, stkreg->xySubstick, stkreg->minSubstick);
+    } else if (mode == STICK_CIRCLE) {
+        ClampCircle(&status->stickX, &status->stickY,
+                    stkreg->radStick, stkreg->minStick);
+        ClampCircle(&status->substickX, &status->substickY,
+                    stkreg->radSubstick, stkreg->minSubstick);
+    }
+    
+    if (trgreg) {
+        ClampTrigger(&status->triggerLeft, trgreg->minTrigger, trgreg->maxTrigger);
+        ClampTrigger(&status->triggerRight, trgreg->minTrigger, trgreg->maxTrigger);
+    }
+}
+
+#if defined(CLAMP_SSE2) || defined(CLAMP_NEON)
+/*---------------------------------------------------------------------------*
+    Vector Kernels
+
+    A block of four statuses is gathered into three vectors of one
+    32-bit lane per status:
+      sticks    stickX, stickY, substickX, substickY (a byte each)
+      triggers  triggerLeft, triggerRight, analogA, analogB
+      ok        all ones if err == PAD_ERR_NONE
+ *---------------------------------------------------------------------------*/
+
+// Region constants for one stick, as float lanes
+typedef struct StickParams {
+    s32 min;
+    float max;          // Octagon: xy * max
+    float xy;           // Octagon: xy
+    float rest;         // Octagon: max - xy
+    float rad;          // Circle: radius
+    float radSq;        // Circle: radius * radius
+} StickParams;
+
+static void MakeStickParams(StickParams* p, s8 min, s8 max, s8 xy, s8 rad) {
+    p->min = min;
+    p->max = (float)(xy * max);
+    p->xy = (float)xy;
+    p->rest = (float)(max - xy);
+    p->rad = (float)rad;
+    p->radSq = (float)(rad * rad);
+}
+#endif
+
+#if defined(CLAMP_SSE2)
+static inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// max(v - min, 0)
+static inline __m128i DeadZone(__m128i v, s32 min) {
+    __m128i t = _mm_sub_epi32(v, _mm_set1_epi32(min));
+    return _mm_and_si128(t, _mm_cmpgt_epi32(t, _mm_setzero_si128()));
+}
+
+// |v| and its sign (all ones if negative)
+static inline __m128i Abs(__m128i v, __m128i* sign) {
+    *sign = _mm_srai_epi32(v, 31);
+    return _mm_sub_epi32(_mm_xor_si128(v, *sign), *sign);
+}
+
+static inline __m128i ApplySign(__m128i v, __m128i sign) {
+    return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+
+// ClampStick on four sticks
+static void ClampStick4(__m128i* px, __m128i* py, const StickParams* p) {
+    __m128i sx, sy;
+    __m128i ax = DeadZone(Abs(*px, &sx), p->min);
+    __m128i ay = DeadZone(Abs(*py, &sy), p->min);
+    __m128 fx = _mm_cvtepi32_ps(ax);
+    __m128 fy = _mm_cvtepi32_ps(ay);
+    __m128 lim = _mm_set1_ps(p->max);
+    
+    // The dominant axis gets xy, the other max - xy
+    __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p->xy), _mm_max_ps(fx, fy)),
+                          _mm_mul_ps(_mm_set1_ps(p->rest), _mm_min_ps(fx, fy)));
+    __m128i outside = _mm_castps_si128(_mm_cmplt_ps(lim, d));
+    __m128i qx = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(lim, fx), d));
+    __m128i qy = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(lim, fy), d));
+    
+    *px = ApplySign(Select(outside, qx, ax), sx);
+    *py = ApplySign(Select(outside, qy, ay), sy);
+}
+
+// ClampCircle on four sticks
+static void ClampCircle4(__m128i* px, __m128i* py, const StickParams* p) {
+    __m128i sx, sy;
+    __m128i ax = DeadZone(Abs(*px, &sx), p->min);
+    __m128i ay = DeadZone(Abs(*py, &sy), p->min);
+    __m128i x = ApplySign(ax, sx);
+    __m128i y = ApplySign(ay, sy);
+    __m128 fx = _mm_cvtepi32_ps(x);
+    __m128 fy = _mm_cvtepi32_ps(y);
+    __m128 rad = _mm_set1_ps(p->rad);
+    
+    __m128 squared = _mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy));
+    __m128i outside = _mm_castps_si128(_mm_cmplt_ps(_mm_set1_ps(p->radSq), squared));
+    __m128 length = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_sqrt_ps(squared)));
+    __m128i qx = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(fx, rad), length));
+    __m128i qy = _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(fy, rad), length));
+    
+    *px = Select(outside, qx, x);
+    *py = Select(outside, qy, y);
+}
+
+static void ClampVector(u32* sticks, u32* triggers, const u32* ok,
+                        const StickParams* main, const StickParams* sub,
+                        ClampStickMode mode, const PADClampRegion* trgreg) {
+    __m128i mask = _mm_loadu_si128((const __m128i*)ok);
+    
+    if (mode != STICK_NONE) {
+        __m128i v = _mm_loadu_si128((const __m128i*)sticks);
+        __m128i x = _mm_srai_epi32(_mm_slli_epi32(v, 24), 24);
+        __m128i y = _mm_srai_epi32(_mm_slli_epi32(v, 16), 24);
+        __m128i cx = _mm_srai_epi32(_mm_slli_epi32(v, 8), 24);
+        __m128i cy = _mm_srai_epi32(v, 24);
+        
+        if (mode == STICK_OCTA) {
+            ClampStick4(&x, &y, main);
+            ClampStick4(&cx, &cy, sub);
+        } else {
+            ClampCircle4(&x, &y, main);
+            ClampCircle4(&cx, &cy, sub);
+        }
+        
+        const __m128i lo = _mm_set1_epi32(0xFF);
+        __m128i r = _mm_or_si128(_mm_and_si128(x, lo), _mm_slli_epi32(_mm_and_si128(y, lo), 8));
+        r = _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(cx, lo), 16));
+        r = _mm_or_si128(r, _mm_slli_epi32(cy, 24));
+        _mm_storeu_si128((__m128i*)sticks, Select(mask, r, v));
+    }
+    
+    if (trgreg) {
+        // Analog A/B pass through: min with 0xFF, minus 0
+        __m128i v = _mm_loadu_si128((const __m128i*)triggers);
+        __m128i max = _mm_set1_epi32((s32)(0xFFFF0000u | (trgreg->maxTrigger << 8) | trgreg->maxTrigger));
+        __m128i min = _mm_set1_epi32((trgreg->minTrigger << 8) | trgreg->minTrigger);
+        __m128i r = _mm_subs_epu8(_mm_min_epu8(v, max), min);
+        _mm_storeu_si128((__m128i*)triggers, Select(mask, r, v));
+    }
+}
+#elif defined(CLAMP_NEON)
+// max(v - min, 0)
+static inline int32x4_t DeadZone(int32x4_t v, s32 min) {
+    return vmaxq_s32(vsubq_s32(v, vdupq_n_s32(min)), vdupq_n_s32(0));
+}
+
+// v with the sign of s
+static inline int32x4_t ApplySign(int32x4_t v, int32x4_t s) {
+    return vbslq_s32(vcltq_s32(s, vdupq_n_s32(0)), vnegq_s32(v), v);
+}
+
+// ClampStick on four sticks
+static void ClampStick4(int32x4_t* px, int32x4_t* py, const StickParams* p) {
+    int32x4_t ax = DeadZone(vabsq_s32(*px), p->min);
+    int32x4_t ay = DeadZone(vabsq_s32(*py), p->min);
+    float32x4_t fx = vcvtq_f32_s32(ax);
+    float32x4_t fy = vcvtq_f32_s32(ay);
+    float32x4_t lim = vdupq_n_f32(p->max);
+    
+    // The dominant axis gets xy, the other max - xy
+    float32x4_t d = vaddq_f32(vmulq_n_f32(vmaxq_f32(fx, fy), p->xy),
+                              vmulq_n_f32(vminq_f32(fx, fy), p->rest));
+    uint32x4_t outside = vcltq_f32(lim, d);
+    int32x4_t qx = vcvtq_s32_f32(vdivq_f32(vmulq_f32(lim, fx), d));
+    int32x4_t qy = vcvtq_s32_f32(vdivq_f32(vmulq_f32(lim, fy), d));
+    
+    *px = ApplySign(vbslq_s32(outside, qx, ax), *px);
+    *py = ApplySign(vbslq_s32(outside, qy, ay), *py);
+}
+
+// ClampCircle on four sticks
+static void ClampCircle4(int32x4_t* px, int32x4_t* py, const StickParams* p) {
+    int32x4_t x = ApplySign(DeadZone(vabsq_s32(*px), p->min), *px);
+    int32x4_t y = ApplySign(DeadZone(vabsq_s32(*py), p->min), *py);
+    float32x4_t fx = vcvtq_f32_s32(x);
+    float32x4_t fy = vcvtq_f32_s32(y);
+    
+    float32x4_t squared = vaddq_f32(vmulq_f32(fx, fx), vmulq_f32(fy, fy));
+    uint32x4_t outside = vcltq_f32(vdupq_n_f32(p->radSq), squared);
+    float32x4_t length = vcvtq_f32_s32(vcvtq_s32_f32(vsqrtq_f32(squared)));
+    int32x4_t qx = vcvtq_s32_f32(vdivq_f32(vmulq_n_f32(fx, p->rad), length));
+    int32x4_t qy = vcvtq_s32_f32(vdivq_f32(vmulq_n_f32(fy, p->rad), length));
+    
+    *px = vbslq_s32(outside, qx, x);
+    *py = vbslq_s32(outside, qy, y);
+}
+
+static void ClampVector(u32* sticks, u32* triggers, const u32* ok,
+                        const StickParams* main, const StickParams* sub,
+                        ClampStickMode mode, const PADClampRegion* trgreg) {
+    uint32x4_t mask = vld1q_u32(ok);
+    
+    if (mode != STICK_NONE) {
+        int32x4_t v = vreinterpretq_s32_u32(vld1q_u32(sticks));
+        int32x4_t x = vshrq_n_s32(vshlq_n_s32(v, 24), 24);
+        int32x4_t y = vshrq_n_s32(vshlq_n_s32(v, 16), 24);
+        int32x4_t cx = vshrq_n_s32(vshlq_n_s32(v, 8), 24);
+        int32x4_t cy = vshrq_n_s32(v, 24);
         
-        // Clamp triggers
-        ClampTrigger(&status->triggerLeft,
-                     ClampRegion.minTrigger,
-                     ClampRegion.maxTrigger);
+        if (mode == STICK_OCTA) {
+            ClampStick4(&x, &y, main);
+            ClampStick4(&cx, &cy, sub);
+        } else {
+            ClampCircle4(&x, &y, main);
+            ClampCircle4(&cx, &cy, sub);
+        }
         
-        ClampTrigger(&status->triggerRight,
-                     ClampRegion.minTrigger,
-                     ClampRegion.maxTrigger);
+        const int32x4_t lo = vdupq_n_s32(0xFF);
+        int32x4_t r = vorrq_s32(vandq_s32(x, lo), vshlq_n_s32(vandq_s32(y, lo), 8));
+        r = vorrq_s32(r, vshlq_n_s32(vandq_s32(cx, lo), 16));
+        r = vorrq_s32(r, vshlq_n_s32(cy, 24));
+        vst1q_u32(sticks, vbslq_u32(mask, vreinterpretq_u32_s32(r), vreinterpretq_u32_s32(v)));
+    }
+    
+    if (trgreg) {
+        // Analog A/B pass through: min with 0xFF, minus 0
+        uint8x16_t v = vreinterpretq_u8_u32(vld1q_u32(triggers));
+        uint8x16_t max = vreinterpretq_u8_u32(
+            vdupq_n_u32(0xFFFF0000u | (trgreg->maxTrigger << 8) | trgreg->maxTrigger));
+        uint8x16_t min = vreinterpretq_u8_u32(
+            vdupq_n_u32((trgreg->minTrigger << 8) | trgreg->minTrigger));
+        uint8x16_t r = vqsubq_u8(vminq_u8(v, max), min);
+        vst1q_u32(triggers, vbslq_u32(mask, vreinterpretq_u32_u8(r), vreinterpretq_u32_u8(v)));
     }
 }
+#endif
 
 /*---------------------------------------------------------------------------*
-  Name:         PADClampCircle
+  Name:         ClampArray
 
-  Description:  Clamp all controllers using circular clamping for sticks.
-                Provides smoother 360° movement compared to octagonal clamping.
-                
-                Use this for games with circular movement (camera, aiming).
+  Description:  Clamp an array of statuses, four at a time in vector code
+                where there is one, the rest one at a time.
 
-  Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
+  Arguments:    status    Statuses to clamp
+                count     Number of statuses
+                stkreg    Region for the sticks
+                mode      How to clamp the sticks
+                trgreg    Region for the triggers, or NULL to leave them
 
   Returns:      None (modifies status array in place)
  *---------------------------------------------------------------------------*/
-void PADClampCircle(PADStatus* status) {
+static void ClampArray(PADStatus* status, u32 count, const PADClampRegion* stkreg,
+                       ClampStickMode mode, const PADClampRegion* trgreg) {
+    u32 i = 0;
+    
     if (!status) {
         return;
     }
     
-    for (int i = 0; i < PAD_MAX_CONTROLLERS; i++, status++) {
-        if (status->err != PAD_ERR_NONE) {
-            continue;
-        }
-        
-        // Clamp main analog stick to circle
-        ClampCircle(&status->stickX, &status->stickY,
-                    ClampRegion.radStick,
-                    ClampRegion.minStick);
+#if defined(CLAMP_SSE2) || defined(CLAMP_NEON)
+    StickParams main;
+    StickParams sub;
+    MakeStickParams(&main, stkreg->minStick, stkreg->maxStick,
+                    stkreg->xyStick, stkreg->radStick);
+    MakeStickParams(&sub, stkreg->minSubstick, stkreg->maxSubstick,
+                    stkreg->xySubstick, stkreg->radSubstick);
+    
+    for (; i + CLAMP_BLOCK <= count; i += CLAMP_BLOCK) {
+        PADStatus* block = status + i;
+        u32 sticks[CLAMP_BLOCK];
+        u32 triggers[CLAMP_BLOCK];
+        u32 ok[CLAMP_BLOCK];
         
-        // Clamp C-stick to circle
-        ClampCircle(&status->substickX, &status->substickY,
-                    ClampRegion.radSubstick,
-                    ClampRegion.minSubstick);
+        // The four stick bytes and the four trigger/analog bytes are
+        // contiguous in PADStatus
+        for (u32 j = 0; j < CLAMP_BLOCK; j++) {
+            memcpy(&sticks[j], (u8*)&block[j] + offsetof(PADStatus, stickX), 4);
+            memcpy(&triggers[j], (u8*)&block[j] + offsetof(PADStatus, triggerLeft), 4);
+            ok[j] = (block[j].err == PAD_ERR_NONE) ? 0xFFFFFFFF : 0;
+        }
         
-        // Clamp triggers (same as octagonal)
-        ClampTrigger(&status->triggerLeft,
-                     ClampRegion.minTrigger,
-                     ClampRegion.maxTrigger);
+        ClampVector(sticks, triggers, ok, &main, &sub, mode, trgreg);
         
-        ClampTrigger(&status->triggerRight,
-                     ClampRegion.minTrigger,
-                     ClampRegion.maxTrigger);
+        for (u32 j = 0; j < CLAMP_BLOCK; j++) {
+            memcpy((u8*)&block[j] + offsetof(PADStatus, stickX), &sticks[j], 4);
+            memcpy((u8*)&block[j] + offsetof(PADStatus, triggerLeft), &triggers[j], 4);
+        }
+    }
+#endif
+    
+    for (; i < count; i++) {
+        ClampOne(&status[i], stkreg, mode, trgreg);
     }
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         PADClamp
+
+  Description:  Clamp all controllers using standard GameCube parameters.
+                Applies octagonal clamping to sticks and dead zone/max to
+                triggers. This is the most common clamping function.
+                
+                Use this for most games to match original GameCube feel.
+
+  Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClamp(PADStatus* status) {
+    PADClampBatch(status, PAD_MAX_CONTROLLERS);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADClampCircle
+
+  Description:  Clamp all controllers using circular clamping for sticks.
+                Provides smoother 360° movement compared to octagonal clamping.
+                
+                Use this for games with circular movement (camera, aiming).
+
+  Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClampCircle(PADStatus* status) {
+    PADClampCircleBatch(status, PAD_MAX_CONTROLLERS);
+}
+
 /*---------------------------------------------------------------------------*
   Name:         PADClamp2
 
@@ -417,35 +712,7 @@ void PADClampCircle(PADStatus* status) {
   Returns:      None (modifies status array in place)
  *---------------------------------------------------------------------------*/
 void PADClamp2(PADStatus* status, u32 type) {
-    if (!status) {
-        return;
-    }
-    
-    const PADClampRegion* stkreg;
-    
-    // Select clamp region based on type
-    if (type == PAD_STICK_CLAMP_OCTA_WITH_MARGIN) {
-        stkreg = &ClampRegion2;      // Wider tolerance (Wii recommended)
-    } else {
-        stkreg = &ClampRegion2Ex;    // No dead zone (raw input)
-    }
-    
-    for (int i = 0; i < PAD_MAX_CONTROLLERS; i++, status++) {
-        if (status->err != PAD_ERR_NONE) {
-            continue;
-        }
-        
-        // Clamp sticks only (triggers not included in this function)
-        ClampStick(&status->stickX, &status->stickY,
-                   stkreg->maxStick,
-                   stkreg->xyStick,
-                   stkreg->minStick);
-        
-        ClampStick(&status->substickX, &status->substickY,
-                   stkreg->maxSubstick,
-                   stkreg->xySubstick,
-                   stkreg->minSubstick);
-    }
+    PADClamp2Batch(status, PAD_MAX_CONTROLLERS, type);
 }
 
 /*---------------------------------------------------------------------------*
@@ -462,10 +729,94 @@ void PADClamp2(PADStatus* status, u32 type) {
   Returns:      None (modifies status array in place)
  *---------------------------------------------------------------------------*/
 void PADClampCircle2(PADStatus* status, u32 type) {
-    if (!status) {
-        return;
+    PADClampCircle2Batch(status, PAD_MAX_CONTROLLERS, type);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADClampTrigger
+
+  Description:  Clamp only trigger values with selectable parameters.
+                Useful when you want to clamp triggers separately from sticks.
+
+  Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
+                type      Clamp type:
+                          PAD_TRIGGER_FIXED_BASE - Standard dead zone
+                          PAD_TRIGGER_OPEN_BASE - No dead zone
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClampTrigger(PADStatus* status, u32 type) {
+    PADClampTriggerBatch(status, PAD_MAX_CONTROLLERS, type);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADClampBatch
+
+  Description:  PADClamp for an array of any length, e.g. recorded inputs.
+                PC extension.
+
+  Arguments:    status    Array of PADStatus structures
+                count     Number of structures
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClampBatch(PADStatus* status, u32 count) {
+    ClampArray(status, count, &ClampRegion, STICK_OCTA, &ClampRegion);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADClampCircleBatch
+
+  Description:  PADClampCircle for an array of any length. PC extension.
+
+  Arguments:    status    Array of PADStatus structures
+                count     Number of structures
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClampCircleBatch(PADStatus* status, u32 count) {
+    ClampArray(status, count, &ClampRegion, STICK_CIRCLE, &ClampRegion);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADClamp2Batch
+
+  Description:  PADClamp2 for an array of any length. PC extension.
+
+  Arguments:    status    Array of PADStatus structures
+                count     Number of structures
+                type      PAD_STICK_CLAMP_OCTA_WITH_MARGIN or
+                          PAD_STICK_CLAMP_OCTA_NO_MARGIN
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClamp2Batch(PADStatus* status, u32 count, u32 type) {
+    const PADClampRegion* stkreg;
+    
+    // Select clamp region based on type
+    if (type == PAD_STICK_CLAMP_OCTA_WITH_MARGIN) {
+        stkreg = &ClampRegion2;      // Wider tolerance (Wii recommended)
+    } else {
+        stkreg = &ClampRegion2Ex;    // No dead zone (raw input)
     }
     
+    // Sticks only (triggers not included in this function)
+    ClampArray(status, count, stkreg, STICK_OCTA, NULL);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADClampCircle2Batch
+
+  Description:  PADClampCircle2 for an array of any length. PC extension.
+
+  Arguments:    status    Array of PADStatus structures
+                count     Number of structures
+                type      PAD_STICK_CLAMP_CIRCLE_WITH_MARGIN or
+                          PAD_STICK_CLAMP_CIRCLE_NO_MARGIN
+
+  Returns:      None (modifies status array in place)
+ *---------------------------------------------------------------------------*/
+void PADClampCircle2Batch(PADStatus* status, u32 count, u32 type) {
     const PADClampRegion* stkreg;
     
     // Select clamp region based on type
@@ -475,40 +826,21 @@ void PADClampCircle2(PADStatus* status, u32 type) {
         stkreg = &ClampRegion2Ex;    // No dead zone
     }
     
-    for (int i = 0; i < PAD_MAX_CONTROLLERS; i++, status++) {
-        if (status->err != PAD_ERR_NONE) {
-            continue;
-        }
-        
-        // Clamp sticks to circle
-        ClampCircle(&status->stickX, &status->stickY,
-                    stkreg->radStick,
-                    stkreg->minStick);
-        
-        ClampCircle(&status->substickX, &status->substickY,
-                    stkreg->radSubstick,
-                    stkreg->minSubstick);
-    }
+    ClampArray(status, count, stkreg, STICK_CIRCLE, NULL);
 }
 
 /*---------------------------------------------------------------------------*
-  Name:         PADClampTrigger
+  Name:         PADClampTriggerBatch
 
-  Description:  Clamp only trigger values with selectable parameters.
-                Useful when you want to clamp triggers separately from sticks.
+  Description:  PADClampTrigger for an array of any length. PC extension.
 
-  Arguments:    status    Array of PAD_MAX_CONTROLLERS PADStatus structures
-                type      Clamp type:
-                          PAD_TRIGGER_FIXED_BASE - Standard dead zone
-                          PAD_TRIGGER_OPEN_BASE - No dead zone
+  Arguments:    status    Array of PADStatus structures
+                count     Number of structures
+                type      PAD_TRIGGER_FIXED_BASE or PAD_TRIGGER_OPEN_BASE
 
   Returns:      None (modifies status array in place)
  *---------------------------------------------------------------------------*/
-void PADClampTrigger(PADStatus* status, u32 type) {
-    if (!status) {
-        return;
-    }
-    
+void PADClampTriggerBatch(PADStatus* status, u32 count, u32 type) {
     const PADClampRegion* stkreg;
     
     // Select clamp region based on type
@@ -518,18 +850,5 @@ void PADClampTrigger(PADStatus* status, u32 type) {
         stkreg = &ClampRegion2Ex;    // No dead zone (raw input)
     }
     
-    for (int i = 0; i < PAD_MAX_CONTROLLERS; i++, status++) {
-        if (status->err != PAD_ERR_NONE) {
-            continue;
-        }
-        
-        // Clamp both triggers
-        ClampTrigger(&status->triggerLeft,
-                     stkreg->minTrigger,
-                     stkreg->maxTrigger);
-        
-        ClampTrigger(&status->triggerRight,
-                     stkreg->minTrigger,
-                     stkreg->maxTrigger);
-    }
+    ClampArray(status, count, stkreg, STICK_NONE, stkreg);
 }
@@ -48,6 +48,20 @@
   c_stick_sensitivity=1.0
   rumble_intensity=0.5
   
+  [Trace]
+  ; Record every PADRead to a file, or replay one instead of reading
+  ; controllers (see PADStartRecording/PADStartReplay)
+  record=
+  replay=
+  
+  [Virtual]
+  ; Channels driven by a test harness instead of pads (see
+  ; PADSetChannelSource), and where its frames arrive: a Unix socket
+  ; path or a shared memory ring name
+  channels=0,1
+  socket=/tmp/porpoise_pad.sock
+  ring=
+ 
  *---------------------------------------------------------------------------*/
 
 #include <dolphin/pad.h>
@@ -104,6 +118,15 @@ typedef struct PADConfig {
     // Rumble intensity (0.0 to 1.0)
     float rumble_intensity;
     
+    // Input trace files (empty = off)
+    char record_path[256];
+    char replay_path[256];
+    
+    // Virtual controllers (empty = off)
+    u32  virtual_channels;                // OR-ed PAD_CHANn_BIT
+    char virtual_socket[108];             // sun_path limit
+    char virtual_ring[64];
+    
 } PADConfig;
 
 // Global configuration
@@ -215,6 +238,20 @@ static int GetButtonFromName(const char* name) {
     return -1;
 }
 
+/**
+ * @brief Parse a channel list ("0,2" or "0 1 2 3") into PAD_CHANn_BITs
+ */
+static u32 ParseChannels(const char* list) {
+    u32 bits = 0;
+    
+    for (; *list; list++) {
+        if (*list >= '0' && *list < '0' + PAD_MAX_CONTROLLERS) {
+            bits |= PAD_CHAN0_BIT >> (*list - '0');
+        }
+    }
+    return bits;
+}
+
 /*---------------------------------------------------------------------------*
   Name:         PADLoadConfig
 
@@ -304,6 +341,24 @@ BOOL PADLoadConfig(void) {
             else if (strcmp(key, "r") == 0) s_config.gp_r = button;
             else if (strcmp(key, "z") == 0) s_config.gp_z = button;
         }
+        // [Trace] section
+        else if (strcmp(section, "Trace") == 0) {
+            if (strcmp(key, "record") == 0) {
+                snprintf(s_config.record_path, sizeof(s_config.record_path), "%s", value);
+            } else if (strcmp(key, "replay") == 0) {
+                snprintf(s_config.replay_path, sizeof(s_config.replay_path), "%s", value);
+            }
+        }
+        // [Virtual] section
+        else if (strcmp(section, "Virtual") == 0) {
+            if (strcmp(key, "channels") == 0) {
+                s_config.virtual_channels = ParseChannels(value);
+            } else if (strcmp(key, "socket") == 0) {
+                snprintf(s_config.virtual_socket, sizeof(s_config.virtual_socket), "%s", value);
+            } else if (strcmp(key, "ring") == 0) {
+                snprintf(s_config.virtual_ring, sizeof(s_config.virtual_ring), "%s", value);
+            }
+        }
         // [Settings] section
         else if (strcmp(section, "Settings") == 0) {
             if (strcmp(key, "stick_deadzone") == 0) {
@@ -383,6 +438,23 @@ BOOL PADSaveConfig(void) {
     fprintf(file, "c_stick_sensitivity=%.2f\n", s_config.c_stick_sensitivity);
     fprintf(file, "rumble_intensity=%.2f\n", s_config.rumble_intensity);
     
+    if (s_config.record_path[0] || s_config.replay_path[0]) {
+        fprintf(file, "\n[Trace]\n");
+        fprintf(file, "record=%s\n", s_config.record_path);
+        fprintf(file, "replay=%s\n", s_config.replay_path);
+    }
+    
+    if (s_config.virtual_channels || s_config.virtual_socket[0] || s_config.virtual_ring[0]) {
+        fprintf(file, "\n[Virtual]\nchannels=");
+        for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+            if (s_config.virtual_channels & (PAD_CHAN0_BIT >> chan)) {
+                fprintf(file, "%d ", chan);
+            }
+        }
+        fprintf(file, "\nsocket=%s\n", s_config.virtual_socket);
+        fprintf(file, "ring=%s\n", s_config.virtual_ring);
+    }
+    
     fclose(file);
     OSReport("PAD: Configuration saved to pad_config.ini\n");
     return TRUE;
@@ -507,3 +579,48 @@ float PADGetRumbleIntensity(void) {
     return cfg->rumble_intensity;
 }
 
+/*---------------------------------------------------------------------------*
+  Name:         PADGetTracePath
+
+  Description:  Gets the configured input trace file.
+
+  Arguments:    replay    TRUE for the file to replay, FALSE for the file
+                          to record
+
+  Returns:      Path, or NULL if not configured
+ *---------------------------------------------------------------------------*/
+const char* PADGetTracePath(BOOL replay) {
+    const PADConfig* cfg = PADGetConfig();
+    const char* path = replay ? cfg->replay_path : cfg->record_path;
+    return path[0] ? path : NULL;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADGetVirtualChannels
+
+  Description:  Gets the channels configured as virtual controllers.
+
+  Arguments:    None
+
+  Returns:      OR-ed PAD_CHANn_BIT
+ *---------------------------------------------------------------------------*/
+u32 PADGetVirtualChannels(void) {
+    const PADConfig* cfg = PADGetConfig();
+    return cfg->virtual_channels;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADGetVirtualPath
+
+  Description:  Gets the configured virtual controller transport.
+
+  Arguments:    ring    TRUE for the shared memory ring name, FALSE for
+                        the socket path
+
+  Returns:      Name or path, or NULL if not configured
+ *---------------------------------------------------------------------------*/
+const char* PADGetVirtualPath(BOOL ring) {
+    const PADConfig* cfg = PADGetConfig();
+    const char* path = ring ? cfg->virtual_ring : cfg->virtual_socket;
+    return path[0] ? path : NULL;
+}
@@ -0,0 +1,315 @@
+/*---------------------------------------------------------------------------*
+  PADLatency.c - Input Latency Statistics
+  
+  Measures how old the input is that a frame acts on. PC extension, for
+  tuning the sampling rate and frame pacing.
+  
+  On GC/Wii: SI polls the controllers and PADRead returns the last poll;
+             the latency follows from the sampling rate and VI timing
+  On PC: The sampling thread timestamps every sample and every input
+         event (a button change or a stick/trigger move); PADRead and
+         VIFlush report here when a frame consumes them. PADRead calls
+         made by the sampling callback are not frame reads and are not
+         counted.
+  
+  MEASURES
+  ========
+  
+  input age       PADRead - time of the sample it returned
+  event to read   First PADRead returning an event - time of the event
+  event to flush  VIFlush (after the buffer swap) of that frame - time
+                  of the event
+  
+  An event is timed when the sampling thread first sees it, so the
+  measures leave out what comes before: up to one sampling period plus
+  the device and driver. When several events land between two reads,
+  the latest one is measured.
+  
+  Each measure keeps its last PAD_LATENCY_WINDOW values; PADGetLatencyStats
+  sorts a copy for the percentiles.
+  
+  CSV LOG
+  =======
+  
+  PADSetLatencyLog writes one row per VIFlush:
+  
+    frame,flush_us,reads,input_age_us,event_to_read_us,event_to_flush_us
+  
+  flush_us counts from when the log was opened. input_age_us is that of
+  the frame's last PADRead (empty if it made none); the event columns are
+  empty when the frame consumed no new event.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/pad.h>
+#include <dolphin/pad_internal.h>
+#include <dolphin/os.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*
+    Internal State
+ *---------------------------------------------------------------------------*/
+
+// Last PAD_LATENCY_WINDOW values of one measure, in microseconds
+typedef struct Window {
+    u32 values[PAD_LATENCY_WINDOW];
+    u32 count;                           // Values held
+    u32 next;                            // Slot for the next value
+} Window;
+
+volatile BOOL __PADLatencyTracking = FALSE;
+
+// Reads come from the game thread, flushes from VIFlush, summaries from
+// any thread. s_logLock serializes log writes, which are made after
+// s_lock is released; a writer takes it before letting go of s_lock, so
+// rows keep their order and PADSetLatencyLog can tell when the old file
+// is idle.
+static __PADMutex s_lock = __PAD_MUTEX_INIT;
+static __PADMutex s_logLock = __PAD_MUTEX_INIT;
+static __PADMutex s_summaryLock = __PAD_MUTEX_INIT;  // Serializes PADGetLatencyStats
+
+static Window s_inputAge;
+static Window s_eventToRead;
+static Window s_eventToFlush;
+static u32 s_frames = 0;
+
+static BOOL s_seqValid = FALSE;          // s_lastEventSeq set since tracking began
+static u32 s_lastEventSeq = 0;           // Latest event PADRead returned
+
+// Current frame (since the last VIFlush)
+static u32 s_frameReads = 0;
+static u32 s_frameAge = 0;
+static BOOL s_frameHasEvent = FALSE;
+static u32 s_frameEventToRead = 0;
+static OSTime s_frameEventTime = 0;
+
+static FILE* s_log = NULL;
+static OSTime s_logStart = 0;
+
+static u32 Microseconds(OSTime ticks) {
+    return ticks > 0 ? (u32)OSTicksToMicroseconds(ticks) : 0;
+}
+
+static void Push(Window* w, u32 us) {
+    w->values[w->next] = us;
+    w->next = (w->next + 1) % PAD_LATENCY_WINDOW;
+    if (w->count < PAD_LATENCY_WINDOW) {
+        w->count++;
+    }
+}
+
+static void Clear(void) {
+    memset(&s_inputAge, 0, sizeof(Window));
+    memset(&s_eventToRead, 0, sizeof(Window));
+    memset(&s_eventToFlush, 0, sizeof(Window));
+    s_frames = 0;
+    s_seqValid = FALSE;
+    s_frameReads = 0;
+    s_frameHasEvent = FALSE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADLatencyRead
+
+  Description:  Record a PADRead: the age of its sample, and the latency
+                of the latest input event if no earlier read returned it.
+
+  Arguments:    sampleTime    OSGetTime() of the sample returned
+                eventSeq      Input events counted when it was taken
+                eventTime     OSGetTime() of the latest event
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __PADLatencyRead(OSTime sampleTime, u32 eventSeq, OSTime eventTime) {
+    OSTime now = OSGetTime();
+    u32 age = Microseconds(now - sampleTime);
+    
+    __PADLock(&s_lock);
+    Push(&s_inputAge, age);
+    s_frameReads++;
+    s_frameAge = age;
+    
+    // The first read after tracking starts only learns the count
+    if (s_seqValid && eventSeq != s_lastEventSeq) {
+        u32 toRead = Microseconds(now - eventTime);
+        Push(&s_eventToRead, toRead);
+        s_frameHasEvent = TRUE;
+        s_frameEventToRead = toRead;
+        s_frameEventTime = eventTime;
+    }
+    s_lastEventSeq = eventSeq;
+    s_seqValid = TRUE;
+    __PADUnlock(&s_lock);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADLatencyFlush
+
+  Description:  End of a frame: record the event-to-flush latency of the
+                event the frame consumed and write the frame's log row.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __PADLatencyFlush(void) {
+    OSTime now = OSGetTime();
+    
+    __PADLock(&s_lock);
+    u32 toFlush = 0;
+    if (s_frameHasEvent) {
+        toFlush = Microseconds(now - s_frameEventTime);
+        Push(&s_eventToFlush, toFlush);
+    }
+    
+    // Take the row; it is written once s_lock is released
+    FILE* log = s_log;
+    u32 frame = s_frames;
+    u32 flushTime = Microseconds(now - s_logStart);
+    u32 reads = s_frameReads;
+    u32 age = s_frameAge;
+    BOOL hasEvent = s_frameHasEvent;
+    u32 toRead = s_frameEventToRead;
+    
+    s_frames++;
+    s_frameReads = 0;
+    s_frameHasEvent = FALSE;
+    if (log) {
+        __PADLock(&s_logLock);
+    }
+    __PADUnlock(&s_lock);
+    
+    if (log) {
+        fprintf(log, "%u,%u,%u,", frame, flushTime, reads);
+        if (reads) {
+            fprintf(log, "%u", age);
+        }
+        if (hasEvent) {
+            fprintf(log, ",%u,%u\n", toRead, toFlush);
+        } else {
+            fputs(",,\n", log);
+        }
+        __PADUnlock(&s_logLock);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADSetLatencyTracking
+
+  Description:  Turn latency tracking on or off. Turning it on clears the
+                statistics. Tracking costs one timestamp per PADRead and
+                VIFlush.
+
+  Arguments:    enable    TRUE to track
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADSetLatencyTracking(BOOL enable) {
+    __PADLock(&s_lock);
+    if (enable && !__PADLatencyTracking) {
+        Clear();
+    }
+    __PADLatencyTracking = enable;
+    __PADUnlock(&s_lock);
+}
+
+static int CompareU32(const void* a, const void* b) {
+    u32 x = *(const u32*)a;
+    u32 y = *(const u32*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentiles of a window
+static void Summarize(const Window* w, PADLatencyPercentiles* out) {
+    static u32 sorted[PAD_LATENCY_WINDOW];  // Caller holds s_summaryLock
+    u32 n;
+    
+    __PADLock(&s_lock);
+    n = w->count;
+    memcpy(sorted, w->values, n * sizeof(u32));
+    __PADUnlock(&s_lock);
+    
+    memset(out, 0, sizeof(PADLatencyPercentiles));
+    if (n == 0) {
+        return;
+    }
+    
+    qsort(sorted, n, sizeof(u32), CompareU32);
+    
+    u64 sum = 0;
+    for (u32 i = 0; i < n; i++) {
+        sum += sorted[i];
+    }
+    out->count = n;
+    out->mean = (u32)(sum / n);
+    out->p50 = sorted[(n * 50 + 99) / 100 - 1];
+    out->p90 = sorted[(n * 90 + 99) / 100 - 1];
+    out->p99 = sorted[(n * 99 + 99) / 100 - 1];
+    out->max = sorted[n - 1];
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADGetLatencyStats
+
+  Description:  Percentiles of the three latency measures over their
+                windows.
+
+  Arguments:    stats    Receives the statistics
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADGetLatencyStats(PADLatencyStats* stats) {
+    if (!stats) {
+        return;
+    }
+    
+    __PADLock(&s_summaryLock);
+    Summarize(&s_inputAge, &stats->inputAge);
+    Summarize(&s_eventToRead, &stats->eventToRead);
+    Summarize(&s_eventToFlush, &stats->eventToFlush);
+    __PADUnlock(&s_summaryLock);
+    
+    __PADLock(&s_lock);
+    stats->frames = s_frames;
+    __PADUnlock(&s_lock);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADSetLatencyLog
+
+  Description:  Start or stop the per-frame CSV log. Starting a log turns
+                tracking on; stopping it leaves tracking as it is.
+
+  Arguments:    path    File to create (replaced if it exists), or NULL
+                        to close the current log
+
+  Returns:      TRUE if the log was opened (or closed, for NULL)
+ *---------------------------------------------------------------------------*/
+BOOL PADSetLatencyLog(const char* path) {
+    FILE* file = NULL;
+    
+    if (path) {
+        file = fopen(path, "w");
+        if (!file) {
+            OSReport("PAD: Cannot create latency log %s\n", path);
+            return FALSE;
+        }
+        fputs("frame,flush_us,reads,input_age_us,event_to_read_us,event_to_flush_us\n", file);
+        PADSetLatencyTracking(TRUE);
+    }
+    
+    __PADLock(&s_lock);
+    FILE* old = s_log;
+    s_log = file;
+    s_logStart = OSGetTime();
+    __PADUnlock(&s_lock);
+    
+    if (old) {
+        // Wait out a flush still writing to it
+        __PADLock(&s_logLock);
+        __PADUnlock(&s_logLock);
+        fclose(old);
+    }
+    return TRUE;
+}
@@ -0,0 +1,583 @@
+/*---------------------------------------------------------------------------*
+  PADTrace.c - Input Recording and Replay
+  
+  Records every PADRead result and plays it back, so a benchmark run can
+  repeat the same gameplay exactly. PC extension.
+  
+  On GC/Wii: N/A (no equivalent in the SDK)
+  On PC: Recording hooks PADRead after it read the controllers; replay
+         replaces the read entirely. Replay started before PADInit never
+         initializes SDL, so it runs on machines without input devices
+         (CI).
+  
+  Replay is by call: the Nth PADRead returns the Nth recorded result,
+  whatever the timing of the run. Reads made by the sampling callback
+  run on their own schedule, so they are left out: they are not
+  recorded, and on replay they return the latest replayed result. The
+  VI retrace count of each result is kept so runs can be lined up frame
+  by frame (PADGetTraceInfo).
+  
+  FILE FORMAT
+  ===========
+  
+  Header (8 bytes): "PADT", version (1 byte), 3 reserved bytes
+  
+  Then one record per PADRead, holding only what changed since the
+  previous record (which starts out all zero):
+  
+    flags         1 byte
+                  bits 0-3  channel N changed: a field mask and the
+                            changed fields follow, in channel order
+                  bit 4     rumble mask changed: 1 byte follows
+                  bits 5-6  retrace delta: 0 = same retrace, 1 = next
+                            retrace, 2 = LEB128 delta follows
+    field mask    1 byte per changed channel
+                  0x01 button (2 bytes, little-endian)
+                  0x02 stickX, stickY
+                  0x04 substickX, substickY
+                  0x08 triggerLeft, triggerRight
+                  0x10 analogA, analogB
+                  0x20 err
+  
+  A frame with no input change costs 1 byte.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/pad.h>
+#include <dolphin/pad_internal.h>
+#include <dolphin/os.h>
+#include <dolphin/vi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*
+    Internal State
+ *---------------------------------------------------------------------------*/
+
+#define TRACE_MAGIC         "PADT"
+#define TRACE_VERSION       1
+#define TRACE_HEADER_SIZE   8
+
+// Record flags
+#define FLAG_MOTOR          0x10
+#define RETRACE_SHIFT       5
+#define RETRACE_SAME        0
+#define RETRACE_NEXT        1
+#define RETRACE_DELTA       2
+
+// Field mask
+#define FIELD_BUTTON        0x01
+#define FIELD_STICK         0x02
+#define FIELD_SUBSTICK      0x04
+#define FIELD_TRIGGER       0x08
+#define FIELD_ANALOG        0x10
+#define FIELD_ERR           0x20
+
+// The longest record: flags, 4 channels of mask + 10 bytes, motor, delta
+#define MAX_RECORD_SIZE     (1 + PAD_MAX_CONTROLLERS * 11 + 1 + 5)
+
+#define RECORD_BUFFER_SIZE  4096        // Records are written in blocks
+
+// Previous record, the base of the next delta
+typedef struct TraceState {
+    PADStatus status[PAD_MAX_CONTROLLERS];
+    u32       motor;
+    u32       retrace;
+} TraceState;
+
+volatile BOOL __PADRecording = FALSE;
+volatile BOOL __PADReplaying = FALSE;
+
+// Any thread may call PADRead. Blocks are written after s_lock is
+// released; s_fileLock, taken before letting go of s_lock, keeps them in
+// order and keeps the file open until the write is done.
+static __PADMutex s_lock = __PAD_MUTEX_INIT;
+static __PADMutex s_fileLock = __PAD_MUTEX_INIT;
+
+static FILE* s_recordFile = NULL;
+static TraceState s_record;
+static u32 s_recordReads = 0;
+static u8 s_recordBuffer[RECORD_BUFFER_SIZE];
+static u32 s_recordUsed = 0;            // Encoded bytes not yet written
+
+static u8* s_replayData = NULL;
+static u32 s_replaySize = 0;
+static u32 s_replayPos = 0;
+static TraceState s_replay;
+static u32 s_replayReads = 0;
+static BOOL s_replayEnded = FALSE;
+
+/*---------------------------------------------------------------------------*
+    Encoding
+ *---------------------------------------------------------------------------*/
+
+static u8 FieldMask(const PADStatus* now, const PADStatus* prev) {
+    u8 mask = 0;
+    
+    if (now->button != prev->button) {
+        mask |= FIELD_BUTTON;
+    }
+    if (now->stickX != prev->stickX || now->stickY != prev->stickY) {
+        mask |= FIELD_STICK;
+    }
+    if (now->substickX != prev->substickX || now->substickY != prev->substickY) {
+        mask |= FIELD_SUBSTICK;
+    }
+    if (now->triggerLeft != prev->triggerLeft || now->triggerRight != prev->triggerRight) {
+        mask |= FIELD_TRIGGER;
+    }
+    if (now->analogA != prev->analogA || now->analogB != prev->analogB) {
+        mask |= FIELD_ANALOG;
+    }
+    if (now->err != prev->err) {
+        mask |= FIELD_ERR;
+    }
+    return mask;
+}
+
+// Append a record for 'status' to buf; returns its size
+static u32 EncodeRecord(u8* buf, const PADStatus* status, u32 motor, u32 retrace) {
+    u8 masks[PAD_MAX_CONTROLLERS];
+    u32 delta = retrace - s_record.retrace;
+    u32 size = 1;
+    u8 flags = 0;
+    
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        masks[chan] = FieldMask(&status[chan], &s_record.status[chan]);
+        if (masks[chan]) {
+            flags |= (u8)(1 << chan);
+        }
+    }
+    if (motor != s_record.motor) {
+        flags |= FLAG_MOTOR;
+    }
+    if (delta == 0) {
+        flags |= RETRACE_SAME << RETRACE_SHIFT;
+    } else if (delta == 1) {
+        flags |= RETRACE_NEXT << RETRACE_SHIFT;
+    } else {
+        flags |= RETRACE_DELTA << RETRACE_SHIFT;
+    }
+    buf[0] = flags;
+    
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        const PADStatus* st = &status[chan];
+        u8 mask = masks[chan];
+        
+        if (!mask) {
+            continue;
+        }
+        buf[size++] = mask;
+        if (mask & FIELD_BUTTON) {
+            buf[size++] = (u8)(st->button & 0xFF);
+            buf[size++] = (u8)(st->button >> 8);
+        }
+        if (mask & FIELD_STICK) {
+            buf[size++] = (u8)st->stickX;
+            buf[size++] = (u8)st->stickY;
+        }
+        if (mask & FIELD_SUBSTICK) {
+            buf[size++] = (u8)st->substickX;
+            buf[size++] = (u8)st->substickY;
+        }
+        if (mask & FIELD_TRIGGER) {
+            buf[size++] = st->triggerLeft;
+            buf[size++] = st->triggerRight;
+        }
+        if (mask & FIELD_ANALOG) {
+            buf[size++] = st->analogA;
+            buf[size++] = st->analogB;
+        }
+        if (mask & FIELD_ERR) {
+            buf[size++] = (u8)st->err;
+        }
+    }
+    
+    if (flags & FLAG_MOTOR) {
+        buf[size++] = (u8)(motor >> 28);   // PAD_CHAN0_BIT..PAD_CHAN3_BIT
+    }
+    if (delta > 1) {
+        while (delta >= 0x80) {
+            buf[size++] = (u8)(delta | 0x80);
+            delta >>= 7;
+        }
+        buf[size++] = (u8)delta;
+    }
+    
+    memcpy(s_record.status, status, sizeof(s_record.status));
+    s_record.motor = motor;
+    s_record.retrace = retrace;
+    return size;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DecodeRecord
+
+  Description:  Decode the next replay record into s_replay.
+
+  Arguments:    None
+
+  Returns:      FALSE at the end of the data (or a truncated record)
+ *---------------------------------------------------------------------------*/
+static BOOL DecodeRecord(void) {
+    const u8* p = s_replayData + s_replayPos;
+    const u8* end = s_replayData + s_replaySize;
+    TraceState next = s_replay;
+    
+    if (p >= end) {
+        return FALSE;
+    }
+    u8 flags = *p++;
+    
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        PADStatus* st = &next.status[chan];
+        
+        if (!(flags & (1 << chan))) {
+            continue;
+        }
+        if (p >= end) {
+            return FALSE;
+        }
+        u8 mask = *p++;
+        u32 need = ((mask & FIELD_BUTTON) ? 2 : 0) + ((mask & FIELD_STICK) ? 2 : 0) +
+                   ((mask & FIELD_SUBSTICK) ? 2 : 0) + ((mask & FIELD_TRIGGER) ? 2 : 0) +
+                   ((mask & FIELD_ANALOG) ? 2 : 0) + ((mask & FIELD_ERR) ? 1 : 0);
+        if ((u32)(end - p) < need) {
+            return FALSE;
+        }
+        if (mask & FIELD_BUTTON) {
+            st->button = (u16)(p[0] | (p[1] << 8));
+            p += 2;
+        }
+        if (mask & FIELD_STICK) {
+            st->stickX = (s8)p[0];
+            st->stickY = (s8)p[1];
+            p += 2;
+        }
+        if (mask & FIELD_SUBSTICK) {
+            st->substickX = (s8)p[0];
+            st->substickY = (s8)p[1];
+            p += 2;
+        }
+        if (mask & FIELD_TRIGGER) {
+            st->triggerLeft = p[0];
+            st->triggerRight = p[1];
+            p += 2;
+        }
+        if (mask & FIELD_ANALOG) {
+            st->analogA = p[0];
+            st->analogB = p[1];
+            p += 2;
+        }
+        if (mask & FIELD_ERR) {
+            st->err = (s8)*p++;
+        }
+    }
+    
+    if (flags & FLAG_MOTOR) {
+        if (p >= end) {
+            return FALSE;
+        }
+        next.motor = (u32)(*p++ & 0xF) << 28;
+    }
+    
+    switch ((flags >> RETRACE_SHIFT) & 3) {
+        case RETRACE_SAME:
+            break;
+        case RETRACE_NEXT:
+            next.retrace++;
+            break;
+        default: {
+            u32 delta = 0;
+            for (u32 shift = 0; ; shift += 7) {
+                if (p >= end || shift > 28) {
+                    return FALSE;
+                }
+                u8 b = *p++;
+                delta |= (u32)(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    break;
+                }
+            }
+            next.retrace += delta;
+            break;
+        }
+    }
+    
+    s_replay = next;
+    s_replayPos = (u32)(p - s_replayData);
+    return TRUE;
+}
+
+// The current replay result; every channel reads PAD_ERR_NO_CONTROLLER
+// once the trace has ended
+static u32 CopyReplayed(PADStatus* status) {
+    if (s_replayEnded) {
+        memset(status, 0, sizeof(PADStatus) * PAD_MAX_CONTROLLERS);
+        for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+            status[chan].err = PAD_ERR_NO_CONTROLLER;
+        }
+        return 0;
+    }
+    memcpy(status, s_replay.status, sizeof(s_replay.status));
+    return s_replay.motor;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADTraceRecord
+
+  Description:  Append a PADRead result to the recording.
+
+  Arguments:    status    PAD_MAX_CONTROLLERS statuses returned
+                motor     Rumble mask returned
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __PADTraceRecord(const PADStatus* status, u32 motor) {
+    u8 block[RECORD_BUFFER_SIZE];
+    u32 blockSize = 0;
+    FILE* file = NULL;
+    u32 retrace = VIGetRetraceCount();
+    
+    __PADLock(&s_lock);
+    if (s_recordFile) {
+        s_recordUsed += EncodeRecord(s_recordBuffer + s_recordUsed, status, motor, retrace);
+        s_recordReads++;
+        if (s_recordUsed > RECORD_BUFFER_SIZE - MAX_RECORD_SIZE) {
+            file = s_recordFile;
+            blockSize = s_recordUsed;
+            memcpy(block, s_recordBuffer, blockSize);
+            s_recordUsed = 0;
+            __PADLock(&s_fileLock);
+        }
+    }
+    __PADUnlock(&s_lock);
+    
+    if (file) {
+        fwrite(block, 1, blockSize, file);
+        __PADUnlock(&s_fileLock);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADTraceReplay
+
+  Description:  Fill in the next replayed PADRead result. Past the end of
+                the trace, every channel reads PAD_ERR_NO_CONTROLLER.
+
+  Arguments:    status    PAD_MAX_CONTROLLERS statuses to fill in
+
+  Returns:      Rumble mask of the result
+ *---------------------------------------------------------------------------*/
+u32 __PADTraceReplay(PADStatus* status) {
+    BOOL ended = FALSE;
+    
+    __PADLock(&s_lock);
+    if (!s_replayEnded && s_replayData && DecodeRecord()) {
+        s_replayReads++;
+    } else if (!s_replayEnded) {
+        s_replayEnded = TRUE;
+        ended = TRUE;
+    }
+    u32 motor = CopyReplayed(status);
+    u32 reads = s_replayReads;
+    __PADUnlock(&s_lock);
+    
+    if (ended) {
+        OSReport("PAD: Replay ended after %u reads\n", reads);
+    }
+    return motor;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADTraceLatest
+
+  Description:  Fill in the latest replayed PADRead result again without
+                taking the next record. Reads made by the sampling
+                callback are not recorded, so they must not use up
+                records on replay either.
+
+  Arguments:    status    PAD_MAX_CONTROLLERS statuses to fill in
+
+  Returns:      Rumble mask of the result
+ *---------------------------------------------------------------------------*/
+u32 __PADTraceLatest(PADStatus* status) {
+    __PADLock(&s_lock);
+    u32 motor = CopyReplayed(status);
+    __PADUnlock(&s_lock);
+    return motor;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADStartRecording
+
+  Description:  Start recording every PADRead result. Not while replaying.
+
+  Arguments:    path    File to create (replaced if it exists)
+
+  Returns:      TRUE if recording started
+ *---------------------------------------------------------------------------*/
+BOOL PADStartRecording(const char* path) {
+    static const u8 header[TRACE_HEADER_SIZE] = { 'P', 'A', 'D', 'T', TRACE_VERSION, 0, 0, 0 };
+    
+    if (!path || __PADReplaying) {
+        return FALSE;
+    }
+    PADStopRecording();
+    
+    FILE* file = fopen(path, "wb");
+    if (!file || fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        OSReport("PAD: Cannot create input trace %s\n", path);
+        if (file) {
+            fclose(file);
+        }
+        return FALSE;
+    }
+    
+    __PADLock(&s_lock);
+    s_recordFile = file;
+    memset(&s_record, 0, sizeof(s_record));
+    s_recordReads = 0;
+    s_recordUsed = 0;
+    __PADRecording = TRUE;
+    __PADUnlock(&s_lock);
+    
+    OSReport("PAD: Recording input to %s\n", path);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADStopRecording
+
+  Description:  Stop recording and close the file.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADStopRecording(void) {
+    u8 block[RECORD_BUFFER_SIZE];
+    
+    __PADLock(&s_lock);
+    FILE* file = s_recordFile;
+    u32 blockSize = s_recordUsed;
+    u32 reads = s_recordReads;
+    memcpy(block, s_recordBuffer, blockSize);
+    s_recordFile = NULL;
+    s_recordUsed = 0;
+    __PADRecording = FALSE;
+    if (file) {
+        __PADLock(&s_fileLock);
+    }
+    __PADUnlock(&s_lock);
+    
+    if (file) {
+        fwrite(block, 1, blockSize, file);
+        fclose(file);
+        __PADUnlock(&s_fileLock);
+        OSReport("PAD: Recorded %u reads\n", reads);
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADStartReplay
+
+  Description:  Load a recorded trace and replay it through PADRead. Stops
+                any recording. Called before PADInit, SDL is never
+                initialized.
+
+  Arguments:    path    Recorded file
+
+  Returns:      TRUE if the trace was loaded
+ *---------------------------------------------------------------------------*/
+BOOL PADStartReplay(const char* path) {
+    u8 header[TRACE_HEADER_SIZE];
+    
+    if (!path) {
+        return FALSE;
+    }
+    
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        OSReport("PAD: Cannot open input trace %s\n", path);
+        return FALSE;
+    }
+    
+    BOOL ok = (fread(header, 1, sizeof(header), file) == sizeof(header) &&
+               memcmp(header, TRACE_MAGIC, 4) == 0 && header[4] == TRACE_VERSION);
+    long size = -1;
+    if (ok && fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file) - TRACE_HEADER_SIZE;
+    }
+    u8* data = (ok && size >= 0) ? (u8*)malloc(size > 0 ? (size_t)size : 1) : NULL;
+    if (data && (fseek(file, TRACE_HEADER_SIZE, SEEK_SET) != 0 ||
+                 fread(data, 1, (size_t)size, file) != (size_t)size)) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    
+    if (!data) {
+        OSReport("PAD: %s is not a readable input trace\n", path);
+        return FALSE;
+    }
+    
+    PADStopRecording();
+    PADStopReplay();
+    
+    __PADLock(&s_lock);
+    s_replayData = data;
+    s_replaySize = (u32)size;
+    s_replayPos = 0;
+    memset(&s_replay, 0, sizeof(s_replay));
+    s_replayReads = 0;
+    s_replayEnded = FALSE;
+    __PADReplaying = TRUE;
+    __PADUnlock(&s_lock);
+    
+    OSReport("PAD: Replaying input from %s\n", path);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADStopReplay
+
+  Description:  Stop replaying; PADRead reads the controllers again.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADStopReplay(void) {
+    __PADLock(&s_lock);
+    u8* data = s_replayData;
+    s_replayData = NULL;
+    s_replaySize = 0;
+    __PADReplaying = FALSE;
+    __PADUnlock(&s_lock);
+    
+    free(data);
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADGetTraceInfo
+
+  Description:  Get the recording/replay state.
+
+  Arguments:    info    Receives the state
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADGetTraceInfo(PADTraceInfo* info) {
+    if (!info) {
+        return;
+    }
+    
+    __PADLock(&s_lock);
+    info->recording = __PADRecording;
+    info->replaying = __PADReplaying;
+    info->ended = __PADReplaying && s_replayEnded;
+    info->reads = __PADReplaying ? s_replayReads : s_recordReads;
+    info->retrace = __PADReplaying ? s_replay.retrace : s_record.retrace;
+    __PADUnlock(&s_lock);
+}
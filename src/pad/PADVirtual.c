@@ -0,0 +1,322 @@
+/*---------------------------------------------------------------------------*
+  PADVirtual.c - Virtual Controllers
+  
+  Lets a local test harness drive channels instead of physical pads, so
+  automated runs need neither controllers nor a display server. PC
+  extension.
+  
+  On GC/Wii: N/A (no equivalent in the SDK)
+  On PC: The harness sends PADVirtualFrame records; each channel set to
+         PAD_SOURCE_VIRTUAL (PADSetChannelSource) reads the latest frame
+         sent for it. Two transports, one open at a time:
+  
+  SOCKET (Linux/macOS):
+  - A Unix-domain datagram socket bound at a path; each datagram holds
+    one or more frames
+  - A receiver thread waits on it, so neither the sampling thread nor
+    PADRead makes a system call for it
+  
+  SHARED MEMORY RING:
+  - A named PADVirtualRing (see pad.h) created by the PAD layer and
+    mapped by the harness; single writer, single reader
+  - The sampling thread drains it with plain loads; no thread, no
+    system calls, nothing for a harness-side delay to block
+  - A slot is valid when its seq matches its index + 1 before and after
+    the copy (the rumble queue in PAD.c works the same way); a writer
+    that laps the reader overwrites frames the reader would have
+    superseded anyway
+  
+  The ring is mapped with the OS layer's named shared memory helpers.
+ *---------------------------------------------------------------------------*/
+
+#include <dolphin/pad.h>
+#include <dolphin/pad_internal.h>
+#include <dolphin/os.h>
+#include <dolphin/os_internal.h>
+#include <dolphin/atomic_internal.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/*---------------------------------------------------------------------------*
+    Internal State
+ *---------------------------------------------------------------------------*/
+
+#define RING_MASK           (PAD_VIRTUAL_RING_ENTRIES - 1)
+#define RECV_BUFFER_SIZE    4096        // Frames per datagram: 256
+#define RECV_POLL_MS        100         // Receiver checks for close this often
+
+// Latest frame per channel
+static PADStatus s_latest[PAD_MAX_CONTROLLERS] = {
+    { .err = PAD_ERR_NO_CONTROLLER }, { .err = PAD_ERR_NO_CONTROLLER },
+    { .err = PAD_ERR_NO_CONTROLLER }, { .err = PAD_ERR_NO_CONTROLLER },
+};
+
+// Reads come from the sampling thread, frames from the receiver thread
+static __PADMutex s_lock = __PAD_MUTEX_INIT;
+
+// Ring transport
+static __OSNamedMemory s_ringMemory;
+static PADVirtualRing* s_ring = NULL;
+static u32 s_ringTail = 0;              // Frames read
+
+// Socket transport
+#ifndef _WIN32
+static int s_socket = -1;
+static char s_socketPath[sizeof(((struct sockaddr_un*)0)->sun_path)];
+static pthread_t s_recvThread;
+static volatile BOOL s_recvRunning = FALSE;
+#endif
+
+static void ClearLatest(void) {
+    memset(s_latest, 0, sizeof(s_latest));
+    for (s32 chan = 0; chan < PAD_MAX_CONTROLLERS; chan++) {
+        s_latest[chan].err = PAD_ERR_NO_CONTROLLER;
+    }
+}
+
+static void ApplyFrame(const PADVirtualFrame* frame) {
+    if (frame->chan < PAD_MAX_CONTROLLERS) {
+        s_latest[frame->chan] = frame->status;
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         DrainRing
+
+  Description:  Apply every frame written to the ring since the last
+                drain, oldest first. Called with the lock held.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+static void DrainRing(void) {
+    u32 head = __AtomicLoad32(&s_ring->head);
+    
+    if (head - s_ringTail > PAD_VIRTUAL_RING_ENTRIES) {
+        s_ringTail = head - PAD_VIRTUAL_RING_ENTRIES;
+    }
+    
+    for (; s_ringTail != head; s_ringTail++) {
+        PADVirtualSlot* slot = &s_ring->slots[s_ringTail & RING_MASK];
+        PADVirtualFrame frame;
+        
+        u32 seq = __AtomicLoad32(&slot->seq);
+        if (seq != s_ringTail + 1) {
+            continue;  // Being rewritten by a writer that lapped us
+        }
+        memcpy(&frame, (const void*)&slot->frame, sizeof(frame));
+        __AtomicFence();
+        if (__AtomicLoad32(&slot->seq) == seq) {
+            ApplyFrame(&frame);
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         __PADVirtualRead
+
+  Description:  Fill in the latest frame of every channel. Drains the ring
+                first, so a frame written before this call is returned.
+
+  Arguments:    status    PAD_MAX_CONTROLLERS statuses to fill in
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void __PADVirtualRead(PADStatus* status) {
+    __PADLock(&s_lock);
+    if (s_ring) {
+        DrainRing();
+    }
+    memcpy(status, s_latest, sizeof(s_latest));
+    __PADUnlock(&s_lock);
+}
+
+/*---------------------------------------------------------------------------*
+    Socket Transport
+ *---------------------------------------------------------------------------*/
+
+#ifndef _WIN32
+/*---------------------------------------------------------------------------*
+  Name:         ReceiveThread
+
+  Description:  Wait for datagrams and apply their frames. A trailing
+                partial frame is ignored.
+
+  Arguments:    arg  Unused
+
+  Returns:      NULL (thread return)
+ *---------------------------------------------------------------------------*/
+static void* ReceiveThread(void* arg) {
+    (void)arg;
+    
+    u8 buffer[RECV_BUFFER_SIZE];
+    struct pollfd pfd;
+    pfd.fd = s_socket;
+    pfd.events = POLLIN;
+    
+    while (s_recvRunning) {
+        if (poll(&pfd, 1, RECV_POLL_MS) <= 0) {
+            continue;
+        }
+        
+        ssize_t size;
+        while ((size = recv(s_socket, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            __PADLock(&s_lock);
+            for (ssize_t pos = 0; pos + (ssize_t)sizeof(PADVirtualFrame) <= size;
+                 pos += sizeof(PADVirtualFrame)) {
+                PADVirtualFrame frame;
+                memcpy(&frame, buffer + pos, sizeof(frame));
+                ApplyFrame(&frame);
+            }
+            __PADUnlock(&s_lock);
+        }
+    }
+    return NULL;
+}
+#endif
+
+/*---------------------------------------------------------------------------*
+  Name:         PADOpenVirtualSocket
+
+  Description:  Bind a datagram socket for harness frames and start the
+                receiver thread. Closes any open socket or ring.
+
+  Arguments:    path    Socket path; a file left there is replaced
+
+  Returns:      TRUE if the socket is bound
+ *---------------------------------------------------------------------------*/
+BOOL PADOpenVirtualSocket(const char* path) {
+#ifdef _WIN32
+    (void)path;
+    OSReport("PAD: Virtual controller sockets are not supported on Windows\n");
+    return FALSE;
+#else
+    struct sockaddr_un addr;
+    
+    if (!path || !path[0] || strlen(path) >= sizeof(addr.sun_path)) {
+        OSReport("PAD: PADOpenVirtualSocket: Invalid path\n");
+        return FALSE;
+    }
+    PADCloseVirtual();
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd >= 0) {
+        unlink(path);  // Left behind by a crashed run
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) {
+        OSReport("PAD: Cannot bind virtual controller socket %s\n", path);
+        return FALSE;
+    }
+    
+    __PADLock(&s_lock);
+    ClearLatest();
+    __PADUnlock(&s_lock);
+    
+    s_socket = fd;
+    strcpy(s_socketPath, path);
+    s_recvRunning = TRUE;
+    if (pthread_create(&s_recvThread, NULL, ReceiveThread, NULL) != 0) {
+        OSReport("PAD: Failed to create virtual controller thread\n");
+        s_recvRunning = FALSE;
+        close(fd);
+        unlink(path);
+        s_socket = -1;
+        return FALSE;
+    }
+    
+    OSReport("PAD: Virtual controllers on socket %s\n", path);
+    return TRUE;
+#endif
+}
+
+/*---------------------------------------------------------------------------*
+    Shared Memory Transport
+ *---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*
+  Name:         PADOpenVirtualRing
+
+  Description:  Create the shared-memory ring for harness frames. Closes
+                any open socket or ring.
+
+  Arguments:    name    Object name (e.g. "porpoise_pad"); an object left
+                        under this name is replaced (see
+                        __OSCreateNamedMemory)
+
+  Returns:      TRUE if the ring was created
+ *---------------------------------------------------------------------------*/
+BOOL PADOpenVirtualRing(const char* name) {
+    if (!name || !name[0]) {
+        OSReport("PAD: PADOpenVirtualRing: Invalid name\n");
+        return FALSE;
+    }
+    PADCloseVirtual();
+    
+    if (!__OSCreateNamedMemory(&s_ringMemory, name, sizeof(PADVirtualRing))) {
+        OSReport("PAD: Failed to create virtual controller ring '%s'\n", name);
+        return FALSE;
+    }
+    PADVirtualRing* ring = (PADVirtualRing*)s_ringMemory.base;
+    
+    // The magic is published last; the harness waits for it
+    ring->version = PAD_VIRTUAL_VERSION;
+    ring->entries = PAD_VIRTUAL_RING_ENTRIES;
+    __AtomicStore32((volatile u32*)&ring->magic, PAD_VIRTUAL_MAGIC);
+    
+    __PADLock(&s_lock);
+    ClearLatest();
+    s_ringTail = 0;
+    s_ring = ring;
+    __PADUnlock(&s_lock);
+    
+    OSReport("PAD: Virtual controllers on ring '%s'\n", s_ringMemory.name);
+    return TRUE;
+}
+
+/*---------------------------------------------------------------------------*
+  Name:         PADCloseVirtual
+
+  Description:  Stop receiving harness frames. Virtual channels read
+                PAD_ERR_NO_CONTROLLER from now on.
+
+  Arguments:    None
+
+  Returns:      None
+ *---------------------------------------------------------------------------*/
+void PADCloseVirtual(void) {
+#ifndef _WIN32
+    if (s_socket >= 0) {
+        s_recvRunning = FALSE;
+        pthread_join(s_recvThread, NULL);
+        close(s_socket);
+        unlink(s_socketPath);
+        s_socket = -1;
+    }
+#endif
+    
+    __PADLock(&s_lock);
+    PADVirtualRing* ring = s_ring;
+    s_ring = NULL;
+    ClearLatest();
+    __PADUnlock(&s_lock);
+    
+    if (ring) {
+        __OSCloseNamedMemory(&s_ringMemory);
+    }
+}
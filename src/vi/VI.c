@@ -48,6 +48,7 @@
 #include <dolphin/vi.h>
 #include <dolphin/VIConfig.h>
 #include <dolphin/os.h>
+#include <dolphin/pad_internal.h>
 #include <SDL.h>
 #include <string.h>
 
@@ -367,6 +368,11 @@ void VIFlush(void) {
     if (s_glContext) {
         SDL_GL_SwapWindow(s_window);
     }
+    
+    // End of frame for the input latency statistics
+    if (__PADLatencyTracking) {
+        __PADLatencyFlush();
+    }
 }
 
 /*---------------------------------------------------------------------------*